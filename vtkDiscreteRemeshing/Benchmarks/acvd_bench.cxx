@@ -0,0 +1,534 @@
+/*=========================================================================
+
+Program:   Remeshing benchmark
+Module:    acvd_bench.cxx
+Language:  C++
+Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+// .NAME acvd_bench
+// .SECTION Description
+// Times the remeshing pipeline for each metric, on deterministic synthetic
+// meshes and optional local files, and writes the results as JSON. The
+// clustering engine (sequential, threaded or Lloyd) is selected at compile
+// time, so that one executable is built for each engine. With DOstaticDispatch,
+// the remeshing classes are the statically dispatched
+// vtkStaticDiscreteRemeshing instances of the same metrics. When reference
+// results are given, the program exits with a non-zero status if a case is
+// slower than allowed or if its energy changed.
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <vtkOBJReader.h>
+#include <vtkPLYReader.h>
+#include <vtkPolyDataReader.h>
+#include <vtkSTLReader.h>
+#include <vtkTimerLog.h>
+
+#include "vtkAnisotropicDiscreteRemeshing.h"
+#include "vtkClusteringReport.h"
+#include "vtkDiscreteRemeshing.h"
+#include "vtkIsotropicDiscreteRemeshing.h"
+#include "vtkL21MetricForClustering.h"
+#include "vtkRandomTriangulation.h"
+#include "vtkStaticDiscreteRemeshing.h"
+#include "vtkVerticesProcessing.h"
+
+using namespace std;
+
+#if defined(DOmultithread)
+#define ACVD_BENCH_ENGINE "threaded"
+#elif defined(DOLloydClustering)
+#define ACVD_BENCH_ENGINE "lloyd"
+#else
+#define ACVD_BENCH_ENGINE "sequential"
+#endif
+
+#ifdef DOstaticDispatch
+static const char* EngineName = ACVD_BENCH_ENGINE "_static";
+
+typedef vtkStaticDiscreteRemeshing<vtkIsotropicMetricForClustering>
+    vtkBenchIsotropicRemeshing;
+typedef vtkStaticDiscreteRemeshing<vtkQEMetricForClustering>
+    vtkBenchQERemeshing;
+typedef vtkStaticDiscreteRemeshing<vtkQuadricAnisotropicMetricForClustering>
+    vtkBenchAnisotropicRemeshing;
+typedef vtkStaticDiscreteRemeshing<vtkL21MetricForClustering>
+    vtkBenchL21Remeshing;
+#else
+static const char* EngineName = ACVD_BENCH_ENGINE;
+
+typedef vtkIsotropicDiscreteRemeshing vtkBenchIsotropicRemeshing;
+typedef vtkQIsotropicDiscreteRemeshing vtkBenchQERemeshing;
+typedef vtkAnisotropicDiscreteRemeshing vtkBenchAnisotropicRemeshing;
+typedef vtkVerticesProcessing<vtkDiscreteRemeshing<vtkL21MetricForClustering>>
+    vtkBenchL21Remeshing;
+#endif
+
+// the measures of one case (one metric on one mesh)
+struct BenchmarkResult {
+    string Name;
+    string Metric;
+    string Mesh;
+    vtkIdType NumberOfFaces;
+    vtkIdType NumberOfVertices;
+    int NumberOfClusters;
+    double WallTime;
+    double CPUTime;
+    double PeakMemory;
+    double Energy;
+
+    // wall time of each stage, summed over the stages with the same name
+    map<string, double> Stages;
+
+    // empty when the case passes the thresholds
+    string Failure;
+};
+
+// the regression thresholds
+struct BenchmarkThresholds {
+    // maximum ratio between the time of a case and its reference time
+    double TimeTolerance;
+
+    // maximum relative difference between the energy of a case and its
+    // reference energy
+    double EnergyTolerance;
+
+    // maximum time of a case, in seconds (0 : no limit)
+    double MaximumTime;
+};
+
+template <class Remeshing>
+void RunRemeshing(
+    Remeshing* Remesh,
+    vtkSurface* Mesh,
+    int NumberOfClusters,
+    int NumberOfThreads,
+    vtkClusteringReport* Report,
+    BenchmarkResult& Result)
+{
+    Remesh->SetInput(Mesh);
+    Remesh->SetConsoleOutput(0);
+    Remesh->SetNumberOfClusters(NumberOfClusters);
+    if (NumberOfThreads)
+        Remesh->SetNumberOfThreads(NumberOfThreads);
+    Remesh->SetReport(Report);
+
+    double WallTime = vtkTimerLog::GetUniversalTime();
+    double CPUTime = vtkClusteringReport::GetCPUTime();
+    Remesh->Remesh();
+    Result.WallTime = vtkTimerLog::GetUniversalTime() - WallTime;
+    Result.CPUTime = vtkClusteringReport::GetCPUTime() - CPUTime;
+    Result.PeakMemory = vtkClusteringReport::GetPeakMemory();
+    Result.Energy = Remesh->GetFinalEnergy();
+    Remesh->Delete();
+}
+
+// reads a .ply, .stl, .obj or .vtk mesh. Returns 0 on failure
+vtkSurface* ReadMesh(const string& FileName)
+{
+    string Extension;
+    size_t Dot = FileName.find_last_of('.');
+    if (Dot != string::npos)
+        Extension = FileName.substr(Dot + 1);
+    for (size_t i = 0; i < Extension.size(); i++)
+        Extension[i] = tolower(Extension[i]);
+
+    vtkPolyDataAlgorithm* Reader;
+    if (Extension == "ply") {
+        vtkPLYReader* PLYReader = vtkPLYReader::New();
+        PLYReader->SetFileName(FileName.c_str());
+        Reader = PLYReader;
+    } else if (Extension == "stl") {
+        vtkSTLReader* STLReader = vtkSTLReader::New();
+        STLReader->SetFileName(FileName.c_str());
+        Reader = STLReader;
+    } else if (Extension == "obj") {
+        vtkOBJReader* OBJReader = vtkOBJReader::New();
+        OBJReader->SetFileName(FileName.c_str());
+        Reader = OBJReader;
+    } else {
+        vtkPolyDataReader* VTKReader = vtkPolyDataReader::New();
+        VTKReader->SetFileName(FileName.c_str());
+        Reader = VTKReader;
+    }
+    Reader->Update();
+
+    vtkSurface* Mesh = 0;
+    if (Reader->GetOutput()->GetNumberOfCells()) {
+        Mesh = vtkSurface::New();
+        Mesh->CreateFromPolyData(Reader->GetOutput());
+        Mesh->GetCellData()->Initialize();
+        Mesh->GetPointData()->Initialize();
+    }
+    Reader->Delete();
+    return (Mesh);
+}
+
+// runs one case Repetitions times, and keeps the fastest run
+void RunCase(
+    const string& Metric,
+    vtkSurface* Mesh,
+    const string& MeshName,
+    int NumberOfClusters,
+    int NumberOfThreads,
+    int Repetitions,
+    BenchmarkResult& Result)
+{
+    Result.Name = string(EngineName) + "/" + Metric + "/" + MeshName;
+    Result.Metric = Metric;
+    Result.Mesh = MeshName;
+    Result.NumberOfFaces = Mesh->GetNumberOfCells();
+    Result.NumberOfVertices = Mesh->GetNumberOfPoints();
+    Result.NumberOfClusters = NumberOfClusters;
+
+    for (int i = 0; i < Repetitions; i++) {
+        vtkClusteringReport Report;
+        BenchmarkResult Run;
+        if (Metric == "isotropic")
+            RunRemeshing(
+                vtkBenchIsotropicRemeshing::New(), Mesh, NumberOfClusters,
+                NumberOfThreads, &Report, Run);
+        else if (Metric == "qe") {
+            vtkBenchQERemeshing* Remesh = vtkBenchQERemeshing::New();
+            Remesh->SetConstrainedInitialization(1);
+            RunRemeshing(
+                Remesh, Mesh, NumberOfClusters, NumberOfThreads, &Report, Run);
+        } else if (Metric == "anisotropic")
+            RunRemeshing(
+                vtkBenchAnisotropicRemeshing::New(), Mesh,
+                NumberOfClusters, NumberOfThreads, &Report, Run);
+        else
+            RunRemeshing(
+                vtkBenchL21Remeshing::New(), Mesh, NumberOfClusters,
+                NumberOfThreads, &Report, Run);
+
+        if (i && (Run.WallTime >= Result.WallTime))
+            continue;
+        Result.WallTime = Run.WallTime;
+        Result.CPUTime = Run.CPUTime;
+        Result.PeakMemory = Run.PeakMemory;
+        Result.Energy = Run.Energy;
+        Result.Stages.clear();
+        for (int Stage = 0; Stage < Report.GetNumberOfStages(); Stage++)
+            Result.Stages[Report.GetStageName(Stage)] +=
+                Report.GetStageWallTime(Stage);
+    }
+}
+
+// reads the value following "Key": in Line. Returns false when absent
+bool GetJSONValue(const string& Line, const char* Key, string& Value)
+{
+    string Pattern = string("\"") + Key + "\": ";
+    size_t Position = Line.find(Pattern);
+    if (Position == string::npos)
+        return (false);
+    Position += Pattern.size();
+    if (Line[Position] == '"') {
+        size_t End = Line.find('"', Position + 1);
+        Value = Line.substr(Position + 1, End - Position - 1);
+    } else {
+        size_t End = Line.find_first_of(",}", Position);
+        Value = Line.substr(Position, End - Position);
+    }
+    return (true);
+}
+
+// loads reference results written by a previous run (one case per line)
+bool ReadBaseline(const char* FileName, map<string, BenchmarkResult>& Cases)
+{
+    ifstream File(FileName);
+    if (!File)
+        return (false);
+
+    string Line, Value;
+    while (getline(File, Line)) {
+        BenchmarkResult Reference;
+        if (!GetJSONValue(Line, "case", Reference.Name))
+            continue;
+        GetJSONValue(Line, "wall_time", Value);
+        Reference.WallTime = atof(Value.c_str());
+        GetJSONValue(Line, "energy", Value);
+        Reference.Energy = atof(Value.c_str());
+        Cases[Reference.Name] = Reference;
+    }
+    return (true);
+}
+
+void CheckThresholds(
+    BenchmarkResult& Result,
+    map<string, BenchmarkResult>& Baseline,
+    BenchmarkThresholds& Thresholds)
+{
+    char Text[500];
+    if ((Thresholds.MaximumTime > 0) &&
+        (Result.WallTime > Thresholds.MaximumTime)) {
+        snprintf(
+            Text, sizeof(Text), "time %g s above the limit of %g s",
+            Result.WallTime, Thresholds.MaximumTime);
+        Result.Failure = Text;
+        return;
+    }
+
+    map<string, BenchmarkResult>::iterator Reference =
+        Baseline.find(Result.Name);
+    if (Reference == Baseline.end())
+        return;
+
+    BenchmarkResult& Base = Reference->second;
+    if (Result.WallTime > Thresholds.TimeTolerance * Base.WallTime) {
+        snprintf(
+            Text, sizeof(Text), "time %g s above %g x the reference %g s",
+            Result.WallTime, Thresholds.TimeTolerance, Base.WallTime);
+        Result.Failure = Text;
+    } else if (
+        fabs(Result.Energy - Base.Energy) >
+        Thresholds.EnergyTolerance * fabs(Base.Energy)) {
+        snprintf(
+            Text, sizeof(Text), "energy %.15g differs from the reference %.15g",
+            Result.Energy, Base.Energy);
+        Result.Failure = Text;
+    }
+}
+
+void WriteResults(
+    ostream& Stream,
+    vector<BenchmarkResult>& Results,
+    int NumberOfThreads)
+{
+    Stream.precision(15);
+    Stream << "{\n  \"benchmark\": \"acvd_bench\",\n  \"engine\": \""
+           << EngineName << "\",\n  \"threads\": " << NumberOfThreads
+           << ",\n  \"cases\": [";
+
+    // one case per line, as expected by ReadBaseline()
+    for (size_t i = 0; i < Results.size(); i++) {
+        BenchmarkResult& R = Results[i];
+        Stream << (i ? ",\n" : "\n") << "    {\"case\": \"" << R.Name
+               << "\", \"metric\": \"" << R.Metric << "\", \"mesh\": \""
+               << R.Mesh << "\", \"faces\": " << R.NumberOfFaces
+               << ", \"vertices\": " << R.NumberOfVertices
+               << ", \"clusters\": " << R.NumberOfClusters
+               << ", \"wall_time\": " << R.WallTime
+               << ", \"cpu_time\": " << R.CPUTime
+               << ", \"peak_memory_kb\": " << R.PeakMemory
+               << ", \"energy\": " << R.Energy << ", \"stages\": {";
+        map<string, double>::iterator Stage;
+        for (Stage = R.Stages.begin(); Stage != R.Stages.end(); Stage++)
+            Stream << (Stage == R.Stages.begin() ? "" : ", ") << "\""
+                   << Stage->first << "\": " << Stage->second;
+        Stream << "}, \"status\": \""
+               << (R.Failure.empty() ? "ok" : "regression") << "\"}";
+    }
+    Stream << "\n  ]\n}\n";
+}
+
+int main(int argc, char* argv[])
+{
+    vector<int> SyntheticSizes;
+    vector<char*> InputFiles;
+    string Metrics = "isotropic,qe,anisotropic,l21";
+    int FacesPerCluster = 40;
+    int Repetitions = 1;
+    int NumberOfThreads = 0;
+    const char* OutputFile = "acvd_bench.json";
+    const char* BaselineFile = 0;
+
+    BenchmarkThresholds Thresholds;
+    Thresholds.TimeTolerance = 1.5;
+    Thresholds.EnergyTolerance = 0.02;
+    Thresholds.MaximumTime = 0;
+
+    if ((argc % 2) == 0) {
+        cout << "Usage : acvd_bench [options]" << endl;
+        cout << "Engine : " << EngineName << endl;
+        cout << "-f faces : adds a synthetic mesh (bumpy torus) with about "
+                "faces faces. Can be repeated (default : 10000 and 100000)"
+             << endl;
+        cout << "-i file : adds a mesh file, e.g. a local scan. Can be "
+                "repeated"
+             << endl;
+        cout << "-m metrics : comma-separated list of metrics among "
+                "isotropic, qe, anisotropic and l21 (default : all)"
+             << endl;
+        cout << "-r ratio : number of input faces per output vertex "
+                "(default : 40)"
+             << endl;
+        cout << "-n repetitions : runs each case n times and keeps the "
+                "fastest run (default : 1)"
+             << endl;
+        cout << "-np threads : sets the number of threads" << endl;
+        cout << "-o file : writes the results to file (default : "
+                "acvd_bench.json)"
+             << endl;
+        cout << "-b file : compares the results with the reference results "
+                "in file"
+             << endl;
+        cout << "-tt ratio : maximum ratio between the time of a case and "
+                "its reference time (default : 1.5)"
+             << endl;
+        cout << "-et ratio : maximum relative difference between the energy "
+                "of a case and its reference energy (default : 0.02)"
+             << endl;
+        cout << "-mt seconds : maximum time of a case (default : 0, no limit)"
+             << endl;
+        return (1);
+    }
+
+    // Parse optionnal arguments
+    int ArgumentsIndex = 1;
+    while (ArgumentsIndex < argc) {
+        char* key = argv[ArgumentsIndex];
+        char* value = argv[ArgumentsIndex + 1];
+
+        if (strcmp(key, "-f") == 0)
+            SyntheticSizes.push_back(atoi(value));
+
+        if (strcmp(key, "-i") == 0)
+            InputFiles.push_back(value);
+
+        if (strcmp(key, "-m") == 0)
+            Metrics = value;
+
+        if (strcmp(key, "-r") == 0)
+            FacesPerCluster = atoi(value);
+
+        if (strcmp(key, "-n") == 0)
+            Repetitions = atoi(value);
+
+        if (strcmp(key, "-np") == 0)
+            NumberOfThreads = atoi(value);
+
+        if (strcmp(key, "-o") == 0)
+            OutputFile = value;
+
+        if (strcmp(key, "-b") == 0)
+            BaselineFile = value;
+
+        if (strcmp(key, "-tt") == 0)
+            Thresholds.TimeTolerance = atof(value);
+
+        if (strcmp(key, "-et") == 0)
+            Thresholds.EnergyTolerance = atof(value);
+
+        if (strcmp(key, "-mt") == 0)
+            Thresholds.MaximumTime = atof(value);
+
+        ArgumentsIndex += 2;
+    }
+
+    if (SyntheticSizes.empty() && InputFiles.empty()) {
+        SyntheticSizes.push_back(10000);
+        SyntheticSizes.push_back(100000);
+    }
+
+    vector<string> MetricsList;
+    size_t Start = 0;
+    while (Start <= Metrics.size()) {
+        size_t End = Metrics.find(',', Start);
+        if (End == string::npos)
+            End = Metrics.size();
+        string Metric = Metrics.substr(Start, End - Start);
+        if ((Metric == "isotropic") || (Metric == "qe") ||
+            (Metric == "anisotropic") || (Metric == "l21"))
+            MetricsList.push_back(Metric);
+        else
+            cout << "Unknown metric : " << Metric << endl;
+        Start = End + 1;
+    }
+
+    map<string, BenchmarkResult> Baseline;
+    if (BaselineFile && !ReadBaseline(BaselineFile, Baseline)) {
+        cout << "Cannot read reference results " << BaselineFile << endl;
+        return (1);
+    }
+
+    vector<vtkSurface*> Meshes;
+    vector<string> MeshNames;
+    for (size_t i = 0; i < SyntheticSizes.size(); i++) {
+        Meshes.push_back(vtkRandomTriangulation::BuildRandomTriangulation(
+            SyntheticSizes[i] / 2, 8));
+        MeshNames.push_back("torus_" + to_string(SyntheticSizes[i]));
+    }
+    for (size_t i = 0; i < InputFiles.size(); i++) {
+        vtkSurface* Mesh = ReadMesh(InputFiles[i]);
+        if (!Mesh) {
+            cout << "Cannot read " << InputFiles[i] << endl;
+            return (1);
+        }
+        string Name = InputFiles[i];
+        size_t Slash = Name.find_last_of("/\\");
+        if (Slash != string::npos)
+            Name = Name.substr(Slash + 1);
+        Meshes.push_back(Mesh);
+        MeshNames.push_back(Name);
+    }
+
+    vector<BenchmarkResult> Results;
+    int NumberOfFailures = 0;
+    for (size_t i = 0; i < Meshes.size(); i++) {
+        int NumberOfClusters =
+            (int)(Meshes[i]->GetNumberOfCells() / FacesPerCluster);
+        if (NumberOfClusters < 10)
+            NumberOfClusters = 10;
+
+        for (size_t j = 0; j < MetricsList.size(); j++) {
+            BenchmarkResult Result;
+            RunCase(
+                MetricsList[j], Meshes[i], MeshNames[i], NumberOfClusters,
+                NumberOfThreads, Repetitions, Result);
+            CheckThresholds(Result, Baseline, Thresholds);
+            cout << Result.Name << " : " << Result.WallTime
+                 << " s, energy : " << Result.Energy;
+            if (!Result.Failure.empty()) {
+                cout << " REGRESSION (" << Result.Failure << ")";
+                NumberOfFailures++;
+            }
+            cout << endl;
+            Results.push_back(Result);
+        }
+        Meshes[i]->Delete();
+    }
+
+    ofstream File(OutputFile);
+    WriteResults(File, Results, NumberOfThreads);
+    if (!File) {
+        cout << "Cannot write results to " << OutputFile << endl;
+        return (1);
+    }
+
+    if (NumberOfFailures)
+        cout << NumberOfFailures << " regressions" << endl;
+    return (NumberOfFailures ? 1 : 0);
+}
@@ -0,0 +1,418 @@
+/*=========================================================================
+
+Program:   Metric kernels microbenchmark
+Module:    metric_bench.cxx
+Language:  C++
+Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+// .NAME metric_bench
+// .SECTION Description
+// Times the kernels evaluated for each candidate move of the clustering
+// (Sub, Add, ComputeClusterCentroid and ComputeClusterEnergy) for every
+// metric, in isolation from the rest of the clustering. The items are built
+// by the metrics themselves from a deterministic synthetic mesh, and the
+// candidate moves are the items lying on the boundaries of a fixed
+// clustering, as during a real minimization loop. Moves are evaluated but
+// never applied, so that all the runs see the same data.
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <vtkDataArrayCollection.h>
+#include <vtkTimerLog.h>
+
+#include "vtkAnisotropicMetricForClustering.h"
+#include "vtkCurvatureMeasure.h"
+#include "vtkIsotropicMetricForClustering.h"
+#include "vtkItemReal.h"
+#include "vtkL21MetricForClustering.h"
+#include "vtkQEMetricForClustering.h"
+#include "vtkQuadricAnisotropicMetricForClustering.h"
+#include "vtkRandomTriangulation.h"
+
+using namespace std;
+
+// the timings of one metric, in nanoseconds per call
+struct KernelTimings {
+    string Metric;
+    int OptimizationLevel;
+    vtkIdType NumberOfMoves;
+
+    // the memory used by each item, in bytes
+    int ItemSize;
+
+    double Sub;
+    double Add;
+    double Centroid;
+    double Energy;
+
+    // a complete candidate move : two Sub/Add, two centroids, two energies
+    double Move;
+
+    // sum of the evaluated energies, to check that runs are comparable
+    double Checksum;
+};
+
+// a candidate move of Item from cluster From to cluster To
+struct CandidateMove {
+    vtkIdType Item;
+    int From;
+    int To;
+};
+
+// the clustering used to generate the candidate moves
+struct BenchmarkClustering {
+    int ClusteringType;
+    int NumberOfClusters;
+    vector<int> Clustering;
+    vector<CandidateMove> Moves;
+};
+
+// splits the items into NumberOfClusters contiguous blocks of ids, which are
+// spatially coherent on the synthetic grids, and collects the candidate
+// moves along the clusters boundaries
+void BuildClustering(
+    vtkSurface* Mesh,
+    int ClusteringType,
+    int NumberOfClusters,
+    vtkIdType NumberOfMoves,
+    BenchmarkClustering& C)
+{
+    vtkIdType NumberOfItems = ClusteringType ? Mesh->GetNumberOfPoints()
+                                             : Mesh->GetNumberOfCells();
+    C.ClusteringType = ClusteringType;
+    C.NumberOfClusters = NumberOfClusters;
+    C.Clustering.resize(NumberOfItems);
+    for (vtkIdType i = 0; i < NumberOfItems; i++)
+        C.Clustering[i] = (int)(i * NumberOfClusters / NumberOfItems);
+
+    vector<CandidateMove> Boundary;
+    for (vtkIdType Edge = 0; Edge < Mesh->GetNumberOfEdges(); Edge++) {
+        vtkIdType I1, I2;
+        if (ClusteringType)
+            Mesh->GetEdgeVertices(Edge, I1, I2);
+        else
+            Mesh->GetEdgeFaces(Edge, I1, I2);
+        if ((I2 < 0) || (C.Clustering[I1] == C.Clustering[I2]))
+            continue;
+        CandidateMove Move1 = {I1, C.Clustering[I1], C.Clustering[I2]};
+        CandidateMove Move2 = {I2, C.Clustering[I2], C.Clustering[I1]};
+        Boundary.push_back(Move1);
+        Boundary.push_back(Move2);
+    }
+
+    // cycle through the boundary when more moves are wanted
+    C.Moves.clear();
+    for (vtkIdType i = 0; i < NumberOfMoves && !Boundary.empty(); i++)
+        C.Moves.push_back(Boundary[i % Boundary.size()]);
+}
+
+// returns the minimum duration of Repetitions runs of Pass, in seconds
+template <class Function>
+double TimePass(Function Pass, int Repetitions)
+{
+    double Best = 0;
+    for (int i = 0; i < Repetitions; i++) {
+        double Start = vtkTimerLog::GetUniversalTime();
+        Pass();
+        double Duration = vtkTimerLog::GetUniversalTime() - Start;
+        if (!i || (Duration < Best))
+            Best = Duration;
+    }
+    return (Best);
+}
+
+template <class Metric>
+void TimeMetric(
+    Metric& M,
+    vtkSurface* Mesh,
+    BenchmarkClustering& C,
+    int Repetitions,
+    KernelTimings& Timings)
+{
+    typedef typename Metric::Cluster Cluster;
+
+    if (M.IsCurvatureIndicatorNeeded()) {
+        vtkCurvatureMeasure* Curvature = vtkCurvatureMeasure::New();
+        Curvature->SetInputData(Mesh);
+        Curvature->SetComputationMethod(1);
+        Curvature->SetElementsType(C.ClusteringType);
+        Curvature->SetComputePrincipalDirections(
+            M.IsPrincipalDirectionsNeeded());
+        M.SetCurvatureInfo(Curvature->GetCurvatureIndicator());
+        Curvature->Delete();
+    }
+
+    Cluster* Clusters;
+    M.BuildMetric(Clusters, Mesh, C.NumberOfClusters, C.ClusteringType);
+    M.SetConstrainedClustering(1);
+    for (size_t i = 0; i < C.Clustering.size(); i++)
+        M.AddItemToCluster(i, Clusters + C.Clustering[i]);
+    for (int i = 0; i < C.NumberOfClusters; i++) {
+        M.ComputeClusterCentroid(Clusters + i);
+        M.ComputeClusterEnergy(Clusters + i);
+    }
+
+    // the results are written to a small ring of clusters, which stays in
+    // cache and prevents the compiler from discarding the kernels
+    const size_t RingSize = 1024;
+    vector<Cluster> Ring(RingSize);
+    vector<CandidateMove>& Moves = C.Moves;
+    size_t NumberOfMoves = Moves.size();
+    double Checksum = 0;
+
+    double SubTime = TimePass(
+        [&]() {
+            for (size_t i = 0; i < NumberOfMoves; i++)
+                M.Sub(
+                    Clusters + Moves[i].From, Moves[i].Item,
+                    &Ring[i % RingSize]);
+        },
+        Repetitions);
+
+    double AddTime = TimePass(
+        [&]() {
+            for (size_t i = 0; i < NumberOfMoves; i++)
+                M.Add(
+                    Clusters + Moves[i].To, Moves[i].Item,
+                    &Ring[i % RingSize]);
+        },
+        Repetitions);
+
+    double CentroidTime = TimePass(
+        [&]() {
+            for (size_t i = 0; i < NumberOfMoves; i++)
+                M.ComputeClusterCentroid(&Ring[i % RingSize]);
+        },
+        Repetitions);
+
+    double EnergyTime = TimePass(
+        [&]() {
+            for (size_t i = 0; i < NumberOfMoves; i++)
+                M.ComputeClusterEnergy(&Ring[i % RingSize]);
+        },
+        Repetitions);
+
+    double MoveTime = TimePass(
+        [&]() {
+            Checksum = 0;
+            Cluster* From = &Ring[0];
+            Cluster* To = &Ring[1];
+            for (size_t i = 0; i < NumberOfMoves; i++) {
+                M.Sub(Clusters + Moves[i].From, Moves[i].Item, From);
+                M.Add(Clusters + Moves[i].To, Moves[i].Item, To);
+                M.ComputeClusterCentroid(From);
+                M.ComputeClusterCentroid(To);
+                M.ComputeClusterEnergy(From);
+                M.ComputeClusterEnergy(To);
+                Checksum += M.GetClusterEnergy(From) + M.GetClusterEnergy(To);
+            }
+        },
+        Repetitions);
+
+    double Scale = NumberOfMoves ? 1e9 / NumberOfMoves : 0;
+    Timings.NumberOfMoves = NumberOfMoves;
+    Timings.Sub = SubTime * Scale;
+    Timings.Add = AddTime * Scale;
+    Timings.Centroid = CentroidTime * Scale;
+    Timings.Energy = EnergyTime * Scale;
+    Timings.Move = MoveTime * Scale;
+    Timings.Checksum = Checksum;
+    delete[] Clusters;
+}
+
+template <class Metric>
+void RunMetric(
+    const char* Name,
+    int OptimizationLevel,
+    Metric& M,
+    vtkSurface* Mesh,
+    BenchmarkClustering& C,
+    int Repetitions,
+    vector<KernelTimings>& Results)
+{
+    KernelTimings Timings;
+    Timings.Metric = Name;
+    Timings.OptimizationLevel = OptimizationLevel;
+    Timings.ItemSize = (int)sizeof(typename Metric::Item);
+    TimeMetric(M, Mesh, C, Repetitions, Timings);
+    cout << Name;
+    if (OptimizationLevel)
+        cout << " (level " << OptimizationLevel << ")";
+    cout << " : " << Timings.Move << " ns per move (sub " << Timings.Sub
+         << ", add " << Timings.Add << ", centroid " << Timings.Centroid
+         << ", energy " << Timings.Energy << ")" << endl;
+    Results.push_back(Timings);
+}
+
+void WriteResults(
+    ostream& Stream,
+    vector<KernelTimings>& Results,
+    vtkSurface* Mesh,
+    BenchmarkClustering& C)
+{
+    Stream.precision(15);
+    Stream << "{\n  \"benchmark\": \"metric_bench\",\n  \"faces\": "
+           << Mesh->GetNumberOfCells()
+           << ",\n  \"vertices\": " << Mesh->GetNumberOfPoints()
+           << ",\n  \"clustering_type\": " << C.ClusteringType
+           << ",\n  \"clusters\": " << C.NumberOfClusters
+           << ",\n  \"item_real_bytes\": " << sizeof(vtkItemReal)
+           << ",\n  \"cases\": [";
+    for (size_t i = 0; i < Results.size(); i++) {
+        KernelTimings& T = Results[i];
+        Stream << (i ? ",\n" : "\n") << "    {\"metric\": \"" << T.Metric
+               << "\", \"level\": " << T.OptimizationLevel
+               << ", \"moves\": " << T.NumberOfMoves
+               << ", \"item_bytes\": " << T.ItemSize
+               << ", \"sub_ns\": " << T.Sub << ", \"add_ns\": " << T.Add
+               << ", \"centroid_ns\": " << T.Centroid
+               << ", \"energy_ns\": " << T.Energy
+               << ", \"move_ns\": " << T.Move
+               << ", \"checksum\": " << T.Checksum << "}";
+    }
+    Stream << "\n  ]\n}\n";
+}
+
+int main(int argc, char* argv[])
+{
+    int NumberOfFaces = 200000;
+    int FacesPerCluster = 40;
+    int ClusteringType = 1;
+    vtkIdType NumberOfMoves = 1000000;
+    int Repetitions = 5;
+    double Gradation = 0;
+    const char* OutputFile = 0;
+
+    if ((argc % 2) == 0) {
+        cout << "Usage : metric_bench [options]" << endl;
+        cout << "-f faces : number of faces of the synthetic mesh (default : "
+                "200000)"
+             << endl;
+        cout << "-r ratio : number of faces per cluster (default : 40)"
+             << endl;
+        cout << "-t 0/1 : items are faces (0) or vertices (1) (default : 1)"
+             << endl;
+        cout << "-n moves : number of candidate moves per pass (default : "
+                "1000000)"
+             << endl;
+        cout << "-rep repetitions : runs each pass n times and keeps the "
+                "fastest run (default : 5)"
+             << endl;
+        cout << "-g gradation : gradation of the metrics (default : 0)"
+             << endl;
+        cout << "-o file : writes the results to file (JSON)" << endl;
+        return (1);
+    }
+
+    // Parse optionnal arguments
+    int ArgumentsIndex = 1;
+    while (ArgumentsIndex < argc) {
+        char* key = argv[ArgumentsIndex];
+        char* value = argv[ArgumentsIndex + 1];
+
+        if (strcmp(key, "-f") == 0)
+            NumberOfFaces = atoi(value);
+
+        if (strcmp(key, "-r") == 0)
+            FacesPerCluster = atoi(value);
+
+        if (strcmp(key, "-t") == 0)
+            ClusteringType = atoi(value);
+
+        if (strcmp(key, "-n") == 0)
+            NumberOfMoves = atol(value);
+
+        if (strcmp(key, "-rep") == 0)
+            Repetitions = atoi(value);
+
+        if (strcmp(key, "-g") == 0)
+            Gradation = atof(value);
+
+        if (strcmp(key, "-o") == 0)
+            OutputFile = value;
+
+        ArgumentsIndex += 2;
+    }
+
+    vtkSurface* Mesh =
+        vtkRandomTriangulation::BuildRandomTriangulation(NumberOfFaces / 2, 8);
+    int NumberOfClusters = Mesh->GetNumberOfCells() / FacesPerCluster;
+    if (NumberOfClusters < 2)
+        NumberOfClusters = 2;
+
+    BenchmarkClustering C;
+    BuildClustering(Mesh, ClusteringType, NumberOfClusters, NumberOfMoves, C);
+    cout << Mesh->GetNumberOfCells() << " faces, " << NumberOfClusters
+         << " clusters, " << C.Moves.size() << " moves per pass" << endl;
+
+    vector<KernelTimings> Results;
+    {
+        vtkIsotropicMetricForClustering M;
+        M.SetGradation(Gradation);
+        RunMetric("isotropic", 0, M, Mesh, C, Repetitions, Results);
+    }
+    for (int Level = 1; Level <= 3; Level++) {
+        vtkQEMetricForClustering M;
+        M.SetGradation(Gradation);
+        M.SetQuadricsOptimizationLevel(Level);
+        RunMetric("qe", Level, M, Mesh, C, Repetitions, Results);
+    }
+    {
+        vtkAnisotropicMetricForClustering M;
+        M.SetGradation(Gradation);
+        RunMetric("anisotropic", 0, M, Mesh, C, Repetitions, Results);
+    }
+    for (int Level = 1; Level <= 3; Level++) {
+        vtkQuadricAnisotropicMetricForClustering M;
+        M.SetGradation(Gradation);
+        M.SetQuadricsOptimizationLevel(Level);
+        RunMetric(
+            "quadric_anisotropic", Level, M, Mesh, C, Repetitions, Results);
+    }
+    {
+        vtkL21MetricForClustering M;
+        M.SetGradation(Gradation);
+        RunMetric("l21", 0, M, Mesh, C, Repetitions, Results);
+    }
+
+    int Status = 0;
+    if (OutputFile) {
+        ofstream File(OutputFile);
+        WriteResults(File, Results, Mesh, C);
+        if (!File) {
+            cout << "Cannot write results to " << OutputFile << endl;
+            Status = 1;
+        }
+    }
+    Mesh->Delete();
+    return (Status);
+}
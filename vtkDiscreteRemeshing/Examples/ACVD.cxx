@@ -70,6 +70,16 @@ int main(int argc, char* argv[])
     char* OutputDirectory = 0;
     char outputfile[500];
 
+    // the timings and counters report, written when -w is set
+    char* ReportFile = 0;
+    vtkClusteringReport Report;
+
+#ifdef DOmultithread
+    // the timeline of the threads, written when -tr is set
+    char* TraceFile = 0;
+    vtkClusteringTrace Trace;
+#endif
+
     strcpy(outputfile, "simplification.ply");
 
     if (argc > 3) {
@@ -92,6 +102,13 @@ int main(int argc, char* argv[])
         cout << "-of file : sets the output file name " << endl;
         cout << " of vertices is above nvertices*threshold (default=10)"
              << endl;
+        cout << "-as 0/1 : only subdivide the regions of the input which are "
+                "too coarse (default : 0)"
+             << endl;
+        cout << "-r 0/1/2/3 : reorders the input before clustering (0 : off, "
+                "1 : Morton curve, 2 : Hilbert curve, 3 : reverse "
+                "Cuthill-McKee) (default : 0)"
+             << endl;
         cout << "-d 0/1/2 : enables display (default : 0)" << endl;
         cout << "-l ratio : split the edges longer than ( averageLength * "
                 "ratio )"
@@ -112,6 +129,32 @@ int main(int argc, char* argv[])
         cout << "-sc number_of_spare_clusters : sets the number of spare "
                 "clusters"
              << endl;
+        cout << "-det 0/1 : deterministic clustering, independent of the "
+                "number of threads (default : 0)"
+             << endl;
+        cout << "-w file : writes the timings and counters of each stage to "
+                "file (JSON)"
+             << endl;
+#ifdef DOmultithread
+        cout << "-tr file : writes the timeline of the threads to file "
+                "(Chrome trace format)"
+             << endl;
+#endif
+        cout << "-ck file : periodically saves the clustering state to file, "
+                "and resumes from it when it exists"
+             << endl;
+        cout << "-cki seconds : sets the delay between two checkpoints "
+                "(default : 60)"
+             << endl;
+        cout << "-cc directory : caches the curvature of the inputs in "
+                "directory, to skip its computation when remeshing them again"
+             << endl;
+        cout << "-tb seconds : time budget of the clustering. When exhausted, "
+                "the current clustering is used (default : 0, no budget)"
+             << endl;
+        cout << "-eb ratio : stops the clustering when a loop improves the "
+                "energy by less than ratio (default : 0)"
+             << endl;
         return (0);
     }
 
@@ -140,6 +183,16 @@ int main(int argc, char* argv[])
             cout << "Subsampling Threshold=" << SubsamplingThreshold << endl;
         }
 
+        if (strcmp(key, "-as") == 0) {
+            cout << "Setting adaptive subsampling to : " << value << endl;
+            Remesh->SetAdaptiveSubsampling(atoi(value));
+        }
+
+        if (strcmp(key, "-r") == 0) {
+            cout << "Setting input reordering to : " << value << endl;
+            Remesh->SetInputReordering(atoi(value));
+        }
+
         if (strcmp(key, "-d") == 0) {
             Display = atoi(value);
             cout << "Display=" << Display << endl;
@@ -150,6 +203,12 @@ int main(int argc, char* argv[])
             cout << "Number of threads=" << NumberOfThreads << endl;
             Remesh->SetNumberOfThreads(NumberOfThreads);
         }
+
+        if (strcmp(key, "-tr") == 0) {
+            cout << "Writing threads timeline to " << value << endl;
+            TraceFile = value;
+            Remesh->SetTrace(&Trace);
+        }
 #endif
 
         if (strcmp(key, "-o") == 0) {
@@ -170,9 +229,9 @@ int main(int argc, char* argv[])
         }
 
         if (strcmp(key, "-w") == 0) {
-            cout << "Setting writing energy log file to " << atoi(value)
-                 << endl;
-            Remesh->SetWriteToGlobalEnergyLog(atoi(value));
+            cout << "Writing timings and counters to " << value << endl;
+            ReportFile = value;
+            Remesh->SetReport(&Report);
         }
 
         if (strcmp(key, "-q") == 0) {
@@ -216,6 +275,38 @@ int main(int argc, char* argv[])
             cout << "Setting boundary fixing to : " << value << endl;
             Remesh->SetBoundaryFixing(atoi(value));
         }
+
+        if (strcmp(key, "-det") == 0) {
+            cout << "Setting deterministic mode to : " << value << endl;
+            Remesh->SetDeterministic(atoi(value));
+        }
+
+        if (strcmp(key, "-ck") == 0) {
+            cout << "Setting checkpoint file to : " << value << endl;
+            Remesh->SetCheckpointFile(value);
+            Remesh->SetResumeFromCheckpoint(1);
+        }
+
+        if (strcmp(key, "-cki") == 0) {
+            cout << "Setting checkpoint interval to : " << value << endl;
+            Remesh->SetCheckpointInterval(atof(value));
+        }
+
+        if (strcmp(key, "-cc") == 0) {
+            cout << "Setting curvature cache directory to : " << value << endl;
+            Remesh->SetCurvatureCacheDirectory(value);
+        }
+
+        if (strcmp(key, "-tb") == 0) {
+            cout << "Setting time budget to : " << value << endl;
+            Remesh->SetMaximumTime(atof(value));
+        }
+
+        if (strcmp(key, "-eb") == 0) {
+            cout << "Setting minimum energy improvement to : " << value
+                 << endl;
+            Remesh->SetMinimumEnergyImprovement(atof(value));
+        }
         ArgumentsIndex += 2;
     }
 
@@ -243,6 +334,7 @@ int main(int argc, char* argv[])
     Remesh->Remesh();
 
     if (QuadricsOptimizationLevel != 0) {
+        Report.StartStage("quadric placement");
         // Note : this is an adaptation of Siggraph 2000 Paper :
         // Out-of-core simplification of large polygonal models
         vtkIntArray* Clustering = Remesh->GetClustering();
@@ -309,6 +401,7 @@ int main(int argc, char* argv[])
 
         Mesh->GetPoints()->Modified();
 
+        Report.StopStage();
         cout << "After Quadrics Post-processing : " << endl;
         Remesh->GetOutput()->DisplayMeshProperties();
 
@@ -335,6 +428,14 @@ int main(int argc, char* argv[])
 
     Remesh->GetOutput()->WriteToFile(REALFILE);
 
+    if (ReportFile && !Report.WriteJSON(ReportFile))
+        cout << "Could not write " << ReportFile << endl;
+
+#ifdef DOmultithread
+    if (TraceFile && !Trace.WriteJSON(TraceFile))
+        cout << "Could not write " << TraceFile << endl;
+#endif
+
     Remesh->Delete();
     Mesh->Delete();
     if (Display) {
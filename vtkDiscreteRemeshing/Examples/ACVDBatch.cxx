@@ -0,0 +1,149 @@
+/*=========================================================================
+
+Program:   Aproximated Centroidal Voronoi Diagrams
+Module:    ACVDBatch.cxx
+Language:  C++
+Date:      2026/10
+Author:   Sebastien Valette
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+// .NAME ACVDBatch
+// .SECTION Description
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vtkTimerLog.h>
+
+#include "vtkBatchRemeshing.h"
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// ACVDBatch program:
+//
+// Uniform or adaptive coarsening of many meshes listed in a manifest file,
+// sharing one pool of threads (see vtkBatchRemeshing)
+/////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        cout << "Usage : ACVDBatch manifest [options]" << endl;
+        cout << "each line of the manifest is : input_file output_file "
+                "nvertices [gradation]"
+             << endl;
+        cout << endl << "Optionnal arguments : " << endl;
+        cout << "-np number : sets the number of threads (default : auto)"
+             << endl;
+        cout << "-mem megabytes : sets the memory limit used to schedule the "
+                "jobs (default : 0, no limit)"
+             << endl;
+        cout << "-vt number : sets the number of vertices per thread within "
+                "a job (default : 200000)"
+             << endl;
+        cout << "-g gradation : sets the gradation of the jobs which do not "
+                "give one (default : 0)"
+             << endl;
+        cout << "-s threshold : sets the subsampling threshold (default=10)"
+             << endl;
+        cout << "-cc directory : caches the curvature of the inputs in "
+                "directory"
+             << endl;
+        cout << "-r 0/1/2/3 : reorders the inputs before clustering (0 : off, "
+                "1 : Morton curve, 2 : Hilbert curve, 3 : reverse "
+                "Cuthill-McKee) (default : 0)"
+             << endl;
+        return (0);
+    }
+
+    vtkBatchRemeshing Batch;
+
+    // Parse optionnal arguments
+    int ArgumentsIndex = 2;
+    while (ArgumentsIndex < argc - 1) {
+        char* key = argv[ArgumentsIndex];
+        char* value = argv[ArgumentsIndex + 1];
+
+        if (strcmp(key, "-np") == 0) {
+            cout << "Number of threads=" << atoi(value) << endl;
+            Batch.SetNumberOfThreads(atoi(value));
+        }
+
+        if (strcmp(key, "-mem") == 0) {
+            cout << "Memory limit=" << atof(value) << "MB" << endl;
+            Batch.SetMemoryLimit(atof(value));
+        }
+
+        if (strcmp(key, "-vt") == 0) {
+            cout << "Vertices per thread=" << atoi(value) << endl;
+            Batch.SetVerticesPerThread(atoi(value));
+        }
+
+        if (strcmp(key, "-g") == 0) {
+            cout << "Gradation=" << atof(value) << endl;
+            Batch.SetGradation(atof(value));
+        }
+
+        if (strcmp(key, "-s") == 0) {
+            cout << "Subsampling Threshold=" << atoi(value) << endl;
+            Batch.SetSubsamplingThreshold(atoi(value));
+        }
+
+        if (strcmp(key, "-cc") == 0) {
+            cout << "Curvature cache directory=" << value << endl;
+            Batch.SetCurvatureCacheDirectory(value);
+        }
+
+        if (strcmp(key, "-r") == 0) {
+            cout << "Input reordering=" << atoi(value) << endl;
+            Batch.SetInputReordering(atoi(value));
+        }
+        ArgumentsIndex += 2;
+    }
+
+    if (!Batch.ReadManifest(argv[1]))
+        return (1);
+    cout << Batch.GetNumberOfJobs() << " jobs" << endl;
+
+    double StartTime = vtkTimerLog::GetUniversalTime();
+    int NumberOfFailedJobs = Batch.Run();
+    cout << "Batch processed in " << vtkTimerLog::GetUniversalTime() - StartTime
+         << "s" << endl;
+
+    if (NumberOfFailedJobs) {
+        cout << NumberOfFailedJobs << " jobs failed :" << endl;
+        for (int Id = 0; Id < Batch.GetNumberOfJobs(); Id++) {
+            const vtkBatchRemeshing::Job& J = Batch.GetJob(Id);
+            if (J.Status == vtkBatchRemeshing::JOB_FAILED)
+                cout << J.InputFile << endl;
+        }
+        return (1);
+    }
+    return (0);
+}
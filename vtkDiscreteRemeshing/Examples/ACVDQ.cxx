@@ -90,6 +90,8 @@ int main(int argc, char* argv[])
             // other appropriates values range between 0 and 2
     int SubsamplingThreshold = 10;
     char* OutputDirectory = 0;  // the output directory
+    char* ReportFile = 0;       // the timings and counters report
+    vtkClusteringReport Report;
     //*******************************************************************************************
 
     char filename[500];
@@ -127,6 +129,12 @@ int main(int argc, char* argv[])
         cout << "-m 0/1 : enforce a manifold output ON/OFF (default : 0)"
              << endl;
         cout << "-sf spare_factor : sets the spare factor" << endl;
+        cout << "-w file : writes the timings and counters of each stage to "
+                "file (JSON)"
+             << endl;
+        cout << "-cc directory : caches the curvature of the inputs in "
+                "directory, to skip its computation when remeshing them again"
+             << endl;
         return (0);
     }
 
@@ -196,10 +204,14 @@ int main(int argc, char* argv[])
             cout << "Splitting edges longer than " << atof(value)
                  << " times the average edge length" << endl;
         }
+        if (strcmp(key, "-cc") == 0) {
+            cout << "Setting curvature cache directory to : " << value << endl;
+            Remesh->SetCurvatureCacheDirectory(value);
+        }
         if (strcmp(key, "-w") == 0) {
-            cout << "Setting writing energy log file to " << atoi(value)
-                 << endl;
-            Remesh->SetWriteToGlobalEnergyLog(atoi(value));
+            cout << "Writing timings and counters to " << value << endl;
+            ReportFile = value;
+            Remesh->SetReport(&Report);
         }
 #ifdef DOmultithread
         if (strcmp(key, "-p") == 0) {
@@ -293,6 +305,10 @@ int main(int argc, char* argv[])
     plyWriter->SetFileName(REALFILE);
     plyWriter->Write();
     plyWriter->Delete();
+
+    if (ReportFile && !Report.WriteJSON(ReportFile))
+        cout << "Could not write " << ReportFile << endl;
+
     Remesh->Delete();
     Mesh->Delete();
     if (Display != 0)
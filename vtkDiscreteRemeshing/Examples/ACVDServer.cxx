@@ -0,0 +1,314 @@
+/*=========================================================================
+
+Program:   Aproximated Centroidal Voronoi Diagrams
+Module:    ACVDServer.cxx
+Language:  C++
+Date:      2026/10
+Author:   Sebastien Valette
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+// .NAME ACVDServer
+// .SECTION Description
+
+#include <iostream>
+#include <signal.h>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+#include <vtkTimerLog.h>
+
+#include "vtkIsotropicDiscreteRemeshing.h"
+#include "vtkRemeshingCache.h"
+
+using namespace std;
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// ACVDServer program:
+//
+// Serves remeshing requests on a Unix domain socket, keeping the parsed
+// inputs and their curvature in a cache (see vtkRemeshingCache), so that
+// remeshing the same input again only costs the clustering. Each request is
+// a line, and gets a line as answer :
+//
+// remesh input output nvertices [gradation]
+//   -> ok nvertices nfaces seconds
+//   when output is '-', the mesh is sent back instead of being written :
+//   -> mesh nvertices ntriangles, followed by nvertices x 3 doubles and
+//      ntriangles x 3 64 bits integers, in the byte order of the server
+// stats
+//   -> ok entries megabytes hits misses
+// quit
+//   -> ok, and the server stops
+//
+// Errors are answered with a line starting with 'error'.
+/////////////////////////////////////////////////////////////////////////////////////////
+
+struct ServerSettings
+{
+    int NumberOfThreads;
+    int Reordering;
+    int SubsamplingThreshold;
+};
+
+static bool ReadLine(int Socket, string& Line)
+{
+    Line.clear();
+    char Character;
+    while (Line.size() < 4096) {
+        if (read(Socket, &Character, 1) != 1)
+            return (false);
+        if (Character == '\n')
+            return (true);
+        if (Character != '\r')
+            Line += Character;
+    }
+    return (false);
+}
+
+static bool WriteAll(int Socket, const void* Data, size_t Size)
+{
+    const char* Bytes = (const char*)Data;
+    while (Size > 0) {
+        ssize_t Written = write(Socket, Bytes, Size);
+        if (Written <= 0)
+            return (false);
+        Bytes += Written;
+        Size -= Written;
+    }
+    return (true);
+}
+
+static bool Answer(int Socket, const string& Text)
+{
+    string Line = Text + "\n";
+    return (WriteAll(Socket, Line.c_str(), Line.size()));
+}
+
+// sends the remeshed surface, polygons being split in fans
+static bool SendMesh(int Socket, vtkSurface* Mesh)
+{
+    vtkIdType NumberOfPoints = Mesh->GetNumberOfPoints();
+    vtkIdType NumberOfFaceVertices, *FaceVertices;
+    vector<vtkTypeInt64> Triangles;
+    for (vtkIdType Face = 0; Face < Mesh->GetNumberOfCells(); Face++) {
+        if (!Mesh->IsFaceActive(Face))
+            continue;
+        Mesh->GetFaceVertices(Face, NumberOfFaceVertices, FaceVertices);
+        for (vtkIdType j = 1; j < NumberOfFaceVertices - 1; j++) {
+            Triangles.push_back(FaceVertices[0]);
+            Triangles.push_back(FaceVertices[j]);
+            Triangles.push_back(FaceVertices[j + 1]);
+        }
+    }
+
+    vector<double> Points(3 * NumberOfPoints);
+    for (vtkIdType Vertex = 0; Vertex < NumberOfPoints; Vertex++)
+        Mesh->GetPoint(Vertex, Points.data() + 3 * Vertex);
+
+    ostringstream Header;
+    Header << "mesh " << NumberOfPoints << " " << Triangles.size() / 3;
+    return (
+        Answer(Socket, Header.str()) &&
+        WriteAll(Socket, Points.data(), Points.size() * sizeof(double)) &&
+        WriteAll(
+            Socket, Triangles.data(), Triangles.size() * sizeof(vtkTypeInt64)));
+}
+
+static bool ProcessRemeshing(
+    int Socket,
+    istringstream& Fields,
+    vtkRemeshingCache& Cache,
+    ServerSettings& Settings)
+{
+    string InputFile, OutputFile;
+    int NumberOfVertices = 0;
+    double Gradation = 0;
+    if (!(Fields >> InputFile >> OutputFile >> NumberOfVertices) ||
+        (NumberOfVertices < 1))
+        return (Answer(
+            Socket, "error expected 'remesh input output nvertices "
+                    "[gradation]'"));
+    Fields >> Gradation;
+
+    double StartTime = vtkTimerLog::GetUniversalTime();
+    unsigned long long Key;
+    vtkSurface* Mesh =
+        Cache.GetMesh(InputFile.c_str(), Settings.Reordering, Key);
+    if (!Mesh)
+        return (Answer(Socket, "error could not read " + InputFile));
+
+    // the input is already reordered in the cache
+    vtkIsotropicDiscreteRemeshing* Remesh =
+        vtkIsotropicDiscreteRemeshing::New();
+    Remesh->SetInput(Mesh);
+    Remesh->SetNumberOfClusters(NumberOfVertices);
+    Remesh->SetConsoleOutput(0);
+    Remesh->SetSubsamplingThreshold(Settings.SubsamplingThreshold);
+    if (Settings.NumberOfThreads > 0)
+        Remesh->SetNumberOfThreads(Settings.NumberOfThreads);
+    Remesh->GetMetric()->SetGradation(Gradation);
+    int ClusteringType = Remesh->GetClusteringType();
+    Remesh->SetInputCurvature(
+        Cache.GetCurvature(Key, Settings.Reordering, ClusteringType, 0));
+    Remesh->Remesh();
+    Cache.SetCurvature(
+        Key, Settings.Reordering, ClusteringType, 0,
+        Remesh->GetInputCurvature());
+
+    bool Success;
+    vtkSurface* Output = Remesh->GetOutput();
+    if (OutputFile == "-")
+        Success = SendMesh(Socket, Output);
+    else {
+        Output->WriteToFile(OutputFile.c_str());
+        ostringstream Text;
+        Text << "ok " << Output->GetNumberOfPoints() << " "
+             << Output->GetNumberOfCells() << " "
+             << vtkTimerLog::GetUniversalTime() - StartTime;
+        Success = Answer(Socket, Text.str());
+    }
+    Remesh->Delete();
+    return (Success);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        cout << "Usage : ACVDServer socket [options]" << endl;
+        cout << "Serves remeshing requests on the Unix domain socket" << endl;
+        cout << endl << "Optionnal arguments : " << endl;
+        cout << "-np number : sets the number of threads (default : auto)"
+             << endl;
+        cout << "-c megabytes : sets the size of the cache (default : 1024)"
+             << endl;
+        cout << "-s threshold : sets the subsampling threshold (default=10)"
+             << endl;
+        cout << "-r 0/1/2/3 : reorders the inputs before clustering (0 : off, "
+                "1 : Morton curve, 2 : Hilbert curve, 3 : reverse "
+                "Cuthill-McKee) (default : 0)"
+             << endl;
+        return (0);
+    }
+
+    vtkRemeshingCache Cache;
+    ServerSettings Settings;
+    Settings.NumberOfThreads = 0;
+    Settings.Reordering = vtkSurface::NO_REORDERING;
+    Settings.SubsamplingThreshold = 10;
+
+    // Parse optionnal arguments
+    int ArgumentsIndex = 2;
+    while (ArgumentsIndex < argc - 1) {
+        char* key = argv[ArgumentsIndex];
+        char* value = argv[ArgumentsIndex + 1];
+
+        if (strcmp(key, "-np") == 0) {
+            cout << "Number of threads=" << atoi(value) << endl;
+            Settings.NumberOfThreads = atoi(value);
+        }
+
+        if (strcmp(key, "-c") == 0) {
+            cout << "Cache size=" << atof(value) << "MB" << endl;
+            Cache.SetMaximumSize(atof(value));
+        }
+
+        if (strcmp(key, "-s") == 0) {
+            cout << "Subsampling Threshold=" << atoi(value) << endl;
+            Settings.SubsamplingThreshold = atoi(value);
+        }
+
+        if (strcmp(key, "-r") == 0) {
+            cout << "Input reordering=" << atoi(value) << endl;
+            Settings.Reordering = atoi(value);
+        }
+        ArgumentsIndex += 2;
+    }
+
+    sockaddr_un Address;
+    memset(&Address, 0, sizeof(Address));
+    Address.sun_family = AF_UNIX;
+    if (strlen(argv[1]) >= sizeof(Address.sun_path)) {
+        cout << "Socket path too long : " << argv[1] << endl;
+        return (1);
+    }
+    strcpy(Address.sun_path, argv[1]);
+
+    int Server = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(argv[1]);
+    if ((Server < 0) ||
+        (bind(Server, (sockaddr*)&Address, sizeof(Address)) != 0) ||
+        (listen(Server, 16) != 0)) {
+        cout << "Could not listen on " << argv[1] << endl;
+        return (1);
+    }
+
+    // a client closing its connection early must not stop the server
+    signal(SIGPIPE, SIG_IGN);
+    cout << "Listening on " << argv[1] << endl;
+
+    // the requests are processed one at a time, each using all the threads
+    bool Running = true;
+    while (Running) {
+        int Client = accept(Server, 0, 0);
+        if (Client < 0)
+            continue;
+
+        string Line;
+        while (Running && ReadLine(Client, Line)) {
+            istringstream Fields(Line);
+            string Command;
+            Fields >> Command;
+            bool Connected;
+            if (Command == "remesh")
+                Connected = ProcessRemeshing(Client, Fields, Cache, Settings);
+            else if (Command == "stats") {
+                ostringstream Text;
+                Text << "ok " << Cache.GetNumberOfEntries() << " "
+                     << Cache.GetSize() << " " << Cache.GetNumberOfHits()
+                     << " " << Cache.GetNumberOfMisses();
+                Connected = Answer(Client, Text.str());
+            } else if (Command == "quit") {
+                Connected = Answer(Client, "ok");
+                Running = false;
+            } else
+                Connected = Answer(Client, "error unknown command " + Command);
+            if (!Connected)
+                break;
+        }
+        close(Client);
+    }
+
+    close(Server);
+    unlink(argv[1]);
+    return (0);
+}
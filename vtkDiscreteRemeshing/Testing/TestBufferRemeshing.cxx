@@ -0,0 +1,232 @@
+/*=========================================================================
+
+Program:   Raw-buffer remeshing test
+Module:    TestBufferRemeshing.cxx
+Language:  C++
+Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+// .NAME TestBufferRemeshing
+// .SECTION Description
+// Checks that vtkBufferRemeshing rejects triangles referencing missing
+// points, that the clustering of the output maps each input point to a
+// nearby output vertex, with and without subdivision and reordering, and
+// that GetOutput() copies the output block into the caller's buffers.
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "vtkBufferRemeshing.h"
+#include "vtkRandomTriangulation.h"
+
+using namespace std;
+
+// returns 1 if Remesh() accepts one of the invalid inputs
+static int CheckValidation(
+    const vector<double>& Points, const vector<vtkIdType>& Triangles)
+{
+    vtkIdType NumberOfPoints = Points.size() / 3;
+    vtkIdType NumberOfTriangles = Triangles.size() / 3;
+    vtkBufferRemeshing Remeshing;
+    if (Remeshing.Remesh()) {
+        cout << "A remeshing without input succeeded" << endl;
+        return (1);
+    }
+
+    Remeshing.SetInputPoints(Points.data(), NumberOfPoints);
+    vtkIdType InvalidIds[2] = {-1, NumberOfPoints};
+    for (int i = 0; i < 2; i++) {
+        vector<vtkIdType> IdTriangles(Triangles);
+        vector<int> IntTriangles(Triangles.begin(), Triangles.end());
+        IdTriangles[3 * NumberOfTriangles / 2 + 1] = InvalidIds[i];
+        IntTriangles[3 * NumberOfTriangles / 2 + 1] = (int)InvalidIds[i];
+
+        Remeshing.SetInputTriangles(IdTriangles.data(), NumberOfTriangles);
+        if (Remeshing.Remesh()) {
+            cout << "The vertex Id " << InvalidIds[i] << " was accepted"
+                 << endl;
+            return (1);
+        }
+        Remeshing.SetInputTriangles(IntTriangles.data(), NumberOfTriangles);
+        if (Remeshing.Remesh()) {
+            cout << "The vertex Id " << InvalidIds[i]
+                 << " was accepted in an int buffer" << endl;
+            return (1);
+        }
+    }
+    return (0);
+}
+
+// returns 1 if an input point is mapped to a missing or distant output
+// vertex. The distance is compared with the average length of the output
+// edges, which is close to the size of the clusters
+static int CheckClustering(
+    const vector<double>& Points, const vtkBufferRemeshing::OutputBlock& Output)
+{
+    vtkIdType NumberOfInputPoints = Points.size() / 3;
+    if ((Output.NumberOfPoints == 0) || (Output.NumberOfTriangles == 0) ||
+        (Output.NumberOfInputPoints != NumberOfInputPoints)) {
+        cout << "Empty or truncated output" << endl;
+        return (1);
+    }
+
+    double Length = 0;
+    for (vtkIdType Triangle = 0; Triangle < Output.NumberOfTriangles;
+         Triangle++) {
+        const vtkIdType* Vertices = Output.Triangles + 3 * Triangle;
+        for (int j = 0; j < 3; j++) {
+            if ((Vertices[j] < 0) || (Vertices[j] >= Output.NumberOfPoints)) {
+                cout << "Triangle " << Triangle << " references a missing "
+                     << "vertex" << endl;
+                return (1);
+            }
+        }
+        for (int j = 0; j < 3; j++) {
+            const double* P1 = Output.Points + 3 * Vertices[j];
+            const double* P2 = Output.Points + 3 * Vertices[(j + 1) % 3];
+            double Distance = 0;
+            for (int k = 0; k < 3; k++)
+                Distance += (P1[k] - P2[k]) * (P1[k] - P2[k]);
+            Length += sqrt(Distance);
+        }
+    }
+    Length /= 3 * Output.NumberOfTriangles;
+
+    for (vtkIdType Point = 0; Point < NumberOfInputPoints; Point++) {
+        vtkIdType Vertex = Output.Clustering[Point];
+        if (Vertex == -1)
+            continue;
+        if ((Vertex < 0) || (Vertex >= Output.NumberOfPoints)) {
+            cout << "Point " << Point << " is mapped to the missing vertex "
+                 << Vertex << endl;
+            return (1);
+        }
+        double Distance = 0;
+        for (int k = 0; k < 3; k++) {
+            double Difference =
+                Points[3 * Point + k] - Output.Points[3 * Vertex + k];
+            Distance += Difference * Difference;
+        }
+        if (sqrt(Distance) > 4 * Length) {
+            cout << "Point " << Point << " is mapped to the distant vertex "
+                 << Vertex << endl;
+            return (1);
+        }
+    }
+    return (0);
+}
+
+// returns 1 if GetOutput() accepts short buffers, or copies values which
+// differ from the output block
+static int CheckCopy(vtkBufferRemeshing& Remeshing)
+{
+    const vtkBufferRemeshing::OutputBlock& Output = Remeshing.GetOutputBlock();
+    vector<float> Points(3 * Output.NumberOfPoints);
+    vector<int> Triangles(3 * Output.NumberOfTriangles);
+    vector<int> Clustering(Output.NumberOfInputPoints);
+
+    if (Remeshing.GetOutput(
+            Points.data(), Points.size() - 1, Triangles.data(),
+            Triangles.size(), Clustering.data(), Clustering.size()) ||
+        Remeshing.GetOutput(
+            Points.data(), Points.size(), Triangles.data(),
+            Triangles.size(), Clustering.data(), Clustering.size() - 1)) {
+        cout << "GetOutput() accepted a short buffer" << endl;
+        return (1);
+    }
+
+    if (!Remeshing.GetOutput(
+            Points.data(), Points.size(), Triangles.data(), Triangles.size(),
+            Clustering.data(), Clustering.size())) {
+        cout << "GetOutput() rejected buffers of the right length" << endl;
+        return (1);
+    }
+    for (size_t i = 0; i < Points.size(); i++) {
+        if (Points[i] != (float)Output.Points[i]) {
+            cout << "Coordinate " << i << " was not copied" << endl;
+            return (1);
+        }
+    }
+    for (size_t i = 0; i < Triangles.size(); i++) {
+        if (Triangles[i] != Output.Triangles[i]) {
+            cout << "Vertex Id " << i << " was not copied" << endl;
+            return (1);
+        }
+    }
+    for (size_t i = 0; i < Clustering.size(); i++) {
+        if (Clustering[i] != Output.Clustering[i]) {
+            cout << "Cluster " << i << " was not copied" << endl;
+            return (1);
+        }
+    }
+    return (0);
+}
+
+int main()
+{
+    vtkSurface* Mesh = vtkRandomTriangulation::BuildRandomTriangulation(
+        3000, 8);
+    vector<double> Points(3 * Mesh->GetNumberOfPoints());
+    for (vtkIdType Vertex = 0; Vertex < Mesh->GetNumberOfPoints(); Vertex++)
+        Mesh->GetPoint(Vertex, Points.data() + 3 * Vertex);
+    vector<vtkIdType> Triangles;
+    vtkIdType NumberOfFaceVertices, *FaceVertices;
+    for (vtkIdType Face = 0; Face < Mesh->GetNumberOfCells(); Face++) {
+        Mesh->GetFaceVertices(Face, NumberOfFaceVertices, FaceVertices);
+        Triangles.insert(
+            Triangles.end(), FaceVertices, FaceVertices + NumberOfFaceVertices);
+    }
+    Mesh->Delete();
+
+    int Failed = CheckValidation(Points, Triangles);
+
+    // 1000 vertices need a subdivision of the input
+    int NumberOfVertices[2] = {300, 1000};
+    int Reordering[2] = {vtkSurface::NO_REORDERING, vtkSurface::HILBERT_ORDER};
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++) {
+            vtkBufferRemeshing Remeshing;
+            Remeshing.SetInputPoints(Points.data(), Points.size() / 3);
+            Remeshing.SetInputTriangles(
+                Triangles.data(), Triangles.size() / 3);
+            Remeshing.SetNumberOfVertices(NumberOfVertices[i]);
+            Remeshing.SetInputReordering(Reordering[j]);
+            if (!Remeshing.Remesh()) {
+                cout << "The remeshing of a valid input failed" << endl;
+                Failed = 1;
+                continue;
+            }
+            Failed |= CheckClustering(Points, Remeshing.GetOutputBlock());
+            Failed |= CheckCopy(Remeshing);
+        }
+    }
+
+    if (!Failed)
+        cout << "The buffer remeshing validates its input and maps its "
+             << "output" << endl;
+    return (Failed);
+}
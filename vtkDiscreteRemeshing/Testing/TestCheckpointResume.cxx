@@ -0,0 +1,119 @@
+/*=========================================================================
+
+Program:   Checkpoint and resume test
+Module:    TestCheckpointResume.cxx
+Language:  C++
+Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+// .NAME TestCheckpointResume
+// .SECTION Description
+// Interrupts a threaded clustering after a few loops, resumes it from its
+// checkpoint, and checks that the result is the one of an uninterrupted
+// run. Usage : TestCheckpointResume [directory]
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "vtkIsotropicDiscreteRemeshing.h"
+#include "vtkRandomTriangulation.h"
+
+using namespace std;
+
+// remeshes Mesh with 4 threads in deterministic mode, and stores the
+// clustering. When Checkpoint is given, the state is saved before each
+// loop, and the minimization is stopped after MaxNumberOfLoops loops when
+// it is not 0
+static void RunClustering(
+    vtkSurface* Mesh,
+    const char* Checkpoint,
+    int MaxNumberOfLoops,
+    int Resume,
+    vector<int>& Clustering)
+{
+    vtkIsotropicDiscreteRemeshing* Remesh =
+        vtkIsotropicDiscreteRemeshing::New();
+    Remesh->SetInput(Mesh);
+    Remesh->SetConsoleOutput(0);
+    Remesh->SetNumberOfClusters(500);
+    Remesh->SetNumberOfThreads(4);
+    Remesh->SetDeterministic(1);
+    if (Checkpoint) {
+        Remesh->SetCheckpointFile(Checkpoint);
+        Remesh->SetCheckpointInterval(0);
+        Remesh->SetResumeFromCheckpoint(Resume);
+    }
+    if (MaxNumberOfLoops)
+        Remesh->SetMaxNumberOfLoops(MaxNumberOfLoops);
+    Remesh->Remesh();
+
+    vtkIntArray* Values = Remesh->GetClustering();
+    Clustering.resize(Values->GetNumberOfTuples());
+    for (vtkIdType i = 0; i < Values->GetNumberOfTuples(); i++)
+        Clustering[i] = Values->GetValue(i);
+    Remesh->Delete();
+}
+
+int main(int argc, char* argv[])
+{
+    string Checkpoint = argc > 1 ? argv[1] : ".";
+    Checkpoint += "/TestCheckpointResume.ckpt";
+    remove(Checkpoint.c_str());
+
+    vtkSurface* Mesh = vtkRandomTriangulation::BuildRandomTriangulation(
+        10000, 8);
+
+    vector<int> Reference, Interrupted, Resumed;
+    RunClustering(Mesh, 0, 0, 0, Reference);
+    RunClustering(Mesh, Checkpoint.c_str(), 3, 0, Interrupted);
+
+    FILE* File = fopen(Checkpoint.c_str(), "rb");
+    if (!File) {
+        cout << "No checkpoint was written to " << Checkpoint << endl;
+        Mesh->Delete();
+        return (1);
+    }
+    fclose(File);
+
+    RunClustering(Mesh, Checkpoint.c_str(), 0, 1, Resumed);
+    remove(Checkpoint.c_str());
+    Mesh->Delete();
+
+    if (Resumed != Reference) {
+        vtkIdType Differences = 0;
+        for (size_t i = 0; i < Reference.size(); i++)
+            if ((i >= Resumed.size()) || (Resumed[i] != Reference[i]))
+                Differences++;
+        cout << "The resumed clustering differs from the uninterrupted one ("
+             << Differences << " items)" << endl;
+        return (1);
+    }
+
+    cout << "The resumed clustering matches the uninterrupted one" << endl;
+    return (0);
+}
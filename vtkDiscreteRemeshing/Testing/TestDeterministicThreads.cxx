@@ -0,0 +1,88 @@
+/*=========================================================================
+
+Program:   Deterministic clustering test
+Module:    TestDeterministicThreads.cxx
+Language:  C++
+Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+// .NAME TestDeterministicThreads
+// .SECTION Description
+// Runs the threaded clustering in deterministic mode with 1 and with 4
+// threads, and checks that both give the same clustering. The input is
+// large enough for the deferred edges to be processed in reservation rounds.
+
+#include <iostream>
+#include <vector>
+
+#include "vtkIsotropicDiscreteRemeshing.h"
+#include "vtkRandomTriangulation.h"
+
+using namespace std;
+
+// remeshes Mesh in deterministic mode and stores the clustering
+static void RunClustering(
+    vtkSurface* Mesh, int NumberOfThreads, vector<int>& Clustering)
+{
+    vtkIsotropicDiscreteRemeshing* Remesh =
+        vtkIsotropicDiscreteRemeshing::New();
+    Remesh->SetInput(Mesh);
+    Remesh->SetConsoleOutput(0);
+    Remesh->SetNumberOfClusters(5000);
+    Remesh->SetNumberOfThreads(NumberOfThreads);
+    Remesh->SetDeterministic(1);
+    Remesh->Remesh();
+
+    vtkIntArray* Values = Remesh->GetClustering();
+    Clustering.resize(Values->GetNumberOfTuples());
+    for (vtkIdType i = 0; i < Values->GetNumberOfTuples(); i++)
+        Clustering[i] = Values->GetValue(i);
+    Remesh->Delete();
+}
+
+int main()
+{
+    vtkSurface* Mesh = vtkRandomTriangulation::BuildRandomTriangulation(
+        50000, 8);
+
+    vector<int> Serial, Parallel;
+    RunClustering(Mesh, 1, Serial);
+    RunClustering(Mesh, 4, Parallel);
+    Mesh->Delete();
+
+    if (Serial != Parallel) {
+        vtkIdType Differences = 0;
+        for (size_t i = 0; i < Serial.size(); i++)
+            if ((i >= Parallel.size()) || (Parallel[i] != Serial[i]))
+                Differences++;
+        cout << "The clusterings with 1 and 4 threads differ ("
+             << Differences << " items)" << endl;
+        return (1);
+    }
+
+    cout << "The clusterings with 1 and 4 threads match" << endl;
+    return (0);
+}
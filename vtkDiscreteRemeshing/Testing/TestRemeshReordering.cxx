@@ -0,0 +1,98 @@
+/*=========================================================================
+
+Program:   Input reordering test
+Module:    TestRemeshReordering.cxx
+Language:  C++
+Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+// .NAME TestRemeshReordering
+// .SECTION Description
+// Remeshes the same input twice with a reordering, with and without
+// subdivision, and checks after each remeshing that the permutation maps the
+// vertices of the clustered mesh to the vertices of the mesh given to
+// SetInput().
+
+#include <iostream>
+
+#include "vtkIsotropicDiscreteRemeshing.h"
+#include "vtkRandomTriangulation.h"
+
+using namespace std;
+
+// returns 1 if the permutation of Remesh does not map its input to Mesh
+static int CheckPermutation(
+    vtkIsotropicDiscreteRemeshing* Remesh, vtkSurface* Mesh, int Run)
+{
+    vtkIdTypeArray* Permutation = Remesh->GetInputPermutation();
+    vtkSurface* Input = Remesh->GetInput();
+    vtkIdType NumberOfPoints = Mesh->GetNumberOfPoints();
+    if (!Permutation || (Permutation->GetNumberOfTuples() != NumberOfPoints) ||
+        (Input->GetNumberOfPoints() < NumberOfPoints)) {
+        cout << "Run " << Run << " : missing or truncated permutation" << endl;
+        return (1);
+    }
+
+    double P1[3], P2[3];
+    for (vtkIdType Vertex = 0; Vertex < NumberOfPoints; Vertex++) {
+        Input->GetPoint(Vertex, P1);
+        Mesh->GetPoint(Permutation->GetValue(Vertex), P2);
+        if ((P1[0] != P2[0]) || (P1[1] != P2[1]) || (P1[2] != P2[2])) {
+            cout << "Run " << Run << " : vertex " << Vertex
+                 << " is not mapped to its original vertex" << endl;
+            return (1);
+        }
+    }
+    return (0);
+}
+
+int main()
+{
+    vtkSurface* Mesh = vtkRandomTriangulation::BuildRandomTriangulation(
+        3000, 8);
+    int Failed = 0;
+
+    // 1000 clusters need a subdivision of the input
+    int NumberOfClusters[2] = {200, 1000};
+    for (int i = 0; i < 2; i++) {
+        vtkIsotropicDiscreteRemeshing* Remesh =
+            vtkIsotropicDiscreteRemeshing::New();
+        Remesh->SetInput(Mesh);
+        Remesh->SetConsoleOutput(0);
+        Remesh->SetNumberOfClusters(NumberOfClusters[i]);
+        Remesh->SetInputReordering(vtkSurface::HILBERT_ORDER);
+        for (int Run = 0; Run < 2; Run++) {
+            Remesh->Remesh();
+            Failed |= CheckPermutation(Remesh, Mesh, Run);
+        }
+        Remesh->Delete();
+    }
+    Mesh->Delete();
+
+    if (!Failed)
+        cout << "The permutations map the inputs to the given mesh" << endl;
+    return (Failed);
+}
@@ -0,0 +1,135 @@
+/*=========================================================================
+
+Program:   Static dispatch test
+Module:    TestStaticDispatch.cxx
+Language:  C++
+Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+// .NAME TestStaticDispatch
+// .SECTION Description
+// Remeshes the same input with vtkIsotropicDiscreteRemeshing and with its
+// statically dispatched counterpart vtkStaticDiscreteRemeshing, and checks
+// that both give the same clustering and the same output mesh.
+
+#include <iostream>
+
+#include "vtkIsotropicDiscreteRemeshing.h"
+#include "vtkRandomTriangulation.h"
+#include "vtkStaticDiscreteRemeshing.h"
+
+using namespace std;
+
+typedef vtkStaticDiscreteRemeshing<vtkIsotropicMetricForClustering>
+    vtkStaticIsotropicRemeshing;
+
+// remeshes Mesh in deterministic mode, so that the threaded engine gives
+// reproducible results too
+template <class Remeshing>
+static void RunRemeshing(Remeshing* Remesh, vtkSurface* Mesh)
+{
+    Remesh->SetInput(Mesh);
+    Remesh->SetConsoleOutput(0);
+    Remesh->SetNumberOfClusters(500);
+    Remesh->SetDeterministic(1);
+    Remesh->Remesh();
+}
+
+// returns 1 if the clusterings or the output meshes differ
+static int CompareRemeshings(
+    vtkIsotropicDiscreteRemeshing* Virtual,
+    vtkStaticIsotropicRemeshing* Static)
+{
+    vtkIntArray* Clustering1 = Virtual->GetClustering();
+    vtkIntArray* Clustering2 = Static->GetClustering();
+    if (Clustering1->GetNumberOfTuples() != Clustering2->GetNumberOfTuples()) {
+        cout << "The clusterings have different sizes" << endl;
+        return (1);
+    }
+    for (vtkIdType i = 0; i < Clustering1->GetNumberOfTuples(); i++) {
+        if (Clustering1->GetValue(i) != Clustering2->GetValue(i)) {
+            cout << "The clusterings differ at item " << i << endl;
+            return (1);
+        }
+    }
+
+    vtkSurface* Output1 = Virtual->GetOutput();
+    vtkSurface* Output2 = Static->GetOutput();
+    if ((Output1->GetNumberOfPoints() != Output2->GetNumberOfPoints()) ||
+        (Output1->GetNumberOfCells() != Output2->GetNumberOfCells())) {
+        cout << "The output meshes have different sizes" << endl;
+        return (1);
+    }
+
+    double P1[3], P2[3];
+    for (vtkIdType Vertex = 0; Vertex < Output1->GetNumberOfPoints();
+         Vertex++) {
+        Output1->GetPoint(Vertex, P1);
+        Output2->GetPoint(Vertex, P2);
+        if ((P1[0] != P2[0]) || (P1[1] != P2[1]) || (P1[2] != P2[2])) {
+            cout << "The output vertices " << Vertex << " differ" << endl;
+            return (1);
+        }
+    }
+
+    vtkIdType V1[3], V2[3];
+    for (vtkIdType Face = 0; Face < Output1->GetNumberOfCells(); Face++) {
+        Output1->GetFaceVertices(Face, V1[0], V1[1], V1[2]);
+        Output2->GetFaceVertices(Face, V2[0], V2[1], V2[2]);
+        if ((V1[0] != V2[0]) || (V1[1] != V2[1]) || (V1[2] != V2[2])) {
+            cout << "The output faces " << Face << " differ" << endl;
+            return (1);
+        }
+    }
+
+    if (Virtual->GetFinalEnergy() != Static->GetFinalEnergy()) {
+        cout << "The final energies differ" << endl;
+        return (1);
+    }
+    return (0);
+}
+
+int main()
+{
+    vtkSurface* Mesh = vtkRandomTriangulation::BuildRandomTriangulation(
+        5000, 8);
+
+    vtkIsotropicDiscreteRemeshing* Virtual =
+        vtkIsotropicDiscreteRemeshing::New();
+    vtkStaticIsotropicRemeshing* Static = vtkStaticIsotropicRemeshing::New();
+    RunRemeshing(Virtual, Mesh);
+    RunRemeshing(Static, Mesh);
+
+    int Failed = CompareRemeshings(Virtual, Static);
+    Virtual->Delete();
+    Static->Delete();
+    Mesh->Delete();
+
+    if (!Failed)
+        cout << "The static and virtual dispatches give the same remeshing"
+             << endl;
+    return (Failed);
+}
@@ -0,0 +1,167 @@
+/*=========================================================================
+
+Program:   Thread budget test of the batch remeshing
+Module:    TestThreadBudget.cxx
+Language:  C++
+Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+
+// .NAME TestThreadBudget
+// .SECTION Description
+// Runs batches on a pool of 3 threads while a monitor thread samples the
+// number of threads of the process, and checks that it never exceeds the
+// pool and the monitor. The first batch has one job, which gets all the
+// threads of the pool, and the second one job per thread, each with one
+// thread, so that no worker of the pool is idle. Skipped where
+// /proc/self/status is not available. Usage : TestThreadBudget [directory]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "vtkBatchRemeshing.h"
+#include "vtkRandomTriangulation.h"
+
+using namespace std;
+
+// the size of the pool
+static const int PoolSize = 3;
+
+// returns the number of threads of the process, or -1 if it is unknown
+static int GetNumberOfThreads()
+{
+    ifstream File("/proc/self/status");
+    string Line;
+    while (getline(File, Line)) {
+        if (Line.compare(0, 8, "Threads:") == 0) {
+            istringstream Value(Line.substr(8));
+            int Threads;
+            if (Value >> Threads)
+                return (Threads);
+        }
+    }
+    return (-1);
+}
+
+// the state shared with the monitor thread
+struct Monitor
+{
+    std::atomic<bool> Stop;
+    std::atomic<int> MaximumNumberOfThreads;
+};
+
+static VTK_THREAD_RETURN_TYPE MonitorThreads(void* arg)
+{
+    vtkMultiThreader::ThreadInfo* Info = (vtkMultiThreader::ThreadInfo*)arg;
+    Monitor* M = (Monitor*)Info->UserData;
+    while (!M->Stop) {
+        int Threads = GetNumberOfThreads();
+        if (Threads > M->MaximumNumberOfThreads)
+            M->MaximumNumberOfThreads = Threads;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return (VTK_THREAD_RETURN_VALUE);
+}
+
+// remeshes Input NumberOfJobs times with the given number of vertices per
+// thread, and returns 1 if a job fails or if the process runs more threads
+// than the pool and the monitor
+static int RunBatch(
+    const string& Input,
+    const string& Directory,
+    int NumberOfJobs,
+    vtkIdType VerticesPerThread)
+{
+    vtkBatchRemeshing Batch;
+    Batch.SetNumberOfThreads(PoolSize);
+    Batch.SetVerticesPerThread(VerticesPerThread);
+    Batch.SetConsoleOutput(0);
+    Batch.SetInputReordering(vtkSurface::HILBERT_ORDER);
+    for (int i = 0; i < NumberOfJobs; i++) {
+        ostringstream Output;
+        Output << Directory << "/TestThreadBudget" << i << ".vtk";
+        Batch.AddJob(Input.c_str(), Output.str().c_str(), 1000, 0);
+    }
+
+    Monitor M;
+    M.Stop = false;
+    M.MaximumNumberOfThreads = GetNumberOfThreads();
+    vtkMultiThreader* Threader = vtkMultiThreader::New();
+    int MonitorId = Threader->SpawnThread(MonitorThreads, (void*)&M);
+    if (MonitorId < 0) {
+        cout << "The monitor thread could not be started" << endl;
+        Threader->Delete();
+        return (1);
+    }
+
+    int Failures = Batch.Run();
+    M.Stop = true;
+    Threader->TerminateThread(MonitorId);
+    Threader->Delete();
+
+    for (int i = 0; i < NumberOfJobs; i++)
+        remove(Batch.GetJob(i).OutputFile.c_str());
+
+    if (Failures) {
+        cout << Failures << " job(s) failed" << endl;
+        return (1);
+    }
+
+    // the pool, whose first worker is the main thread, and the monitor
+    int Budget = PoolSize + 1;
+    cout << NumberOfJobs << " job(s) with "
+         << Batch.GetJob(0).NumberOfThreads << " thread(s) each : at most "
+         << M.MaximumNumberOfThreads << " threads, for a budget of " << Budget
+         << endl;
+    return (M.MaximumNumberOfThreads > Budget ? 1 : 0);
+}
+
+int main(int argc, char* argv[])
+{
+    if (GetNumberOfThreads() < 1) {
+        cout << "/proc/self/status is not available : test skipped" << endl;
+        return (0);
+    }
+
+    // the input is subdivided before the clustering
+    string Directory = argc > 1 ? argv[1] : ".";
+    string Input = Directory + "/TestThreadBudget.vtk";
+    vtkSurface* Mesh = vtkRandomTriangulation::BuildRandomTriangulation(
+        5000, 8);
+    Mesh->WriteToFile(Input.c_str());
+    Mesh->Delete();
+
+    int Failures = RunBatch(Input, Directory, 1, 1000);
+    Failures += RunBatch(Input, Directory, PoolSize, 1000000);
+    remove(Input.c_str());
+    return (Failures ? 1 : 0);
+}
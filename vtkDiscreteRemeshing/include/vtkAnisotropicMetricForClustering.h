@@ -36,6 +36,8 @@
 
 #include <vtkFloatArray.h>
 #include <vtkTriangle.h>
+#include "vtkFaceQuantities.h"
+#include "vtkParallelFor.h"
 #include "vtkSurface.h"
 
 class vtkAnisotropicMetricForClustering
@@ -268,148 +270,207 @@ public:
         Cluster*& Clusters,
         vtkSurface* Mesh,
         int NumberOfClusters,
-        int ClusteringType)
+        int ClusteringType,
+        int NumberOfThreads = 0)
     {
-
+        typedef vtkAnisotropicMetricForClustering Self;
         vtkIdType i;
         // Build the clusters
         Clusters = new Cluster[NumberOfClusters];
         for (i = 0; i < NumberOfClusters; i++)
             this->ResetCluster(Clusters + i);
 
-        int NumberOfElements;
+        // the area of an item, before weighting and clamping
+        struct ItemAreas
+        {
+            int ClusteringType;
+            vtkFaceQuantities* Faces;
+            double* VerticesAreas;
+
+            double GetArea(vtkIdType i)
+            {
+                return (
+                    this->ClusteringType == 0 ? this->Faces->GetArea(i)
+                                              : this->VerticesAreas[i]);
+            }
+        };
 
         // Build the items
-
+        vtkIdType NumberOfItems;
+        vtkFaceQuantities Faces;
+        ItemAreas Areas;
+        Areas.ClusteringType = ClusteringType;
+        Areas.Faces = &Faces;
+        Areas.VerticesAreas = 0;
         if (ClusteringType == 0) {
             // Items are triangles
-            vtkIdType v1, v2, v3;
-            double P1[3], P2[3], P3[3];
-            NumberOfElements = Mesh->GetNumberOfCells();
-            Items = new Item[Mesh->GetNumberOfCells()];
-            for (i = 0; i < Mesh->GetNumberOfCells(); i++) {
-                Mesh->GetFaceVertices(i, v1, v2, v3);
-                Mesh->GetPoint(v1, P1);
-                Mesh->GetPoint(v2, P2);
-                Mesh->GetPoint(v3, P3);
-                if (Gradation == 0)
-                    Items[i].Weight = vtkTriangle::TriangleArea(P1, P2, P3);
-                else
-                    Items[i].Weight =
-                        vtkTriangle::TriangleArea(P1, P2, P3) *
-                        pow(CustomWeights->GetValue(i), Gradation);
-                Items[i].Value[0] = (P1[0] + P2[0] + P3[0]) / 3.0;
-                Items[i].Value[1] = (P1[1] + P2[1] + P3[1]) / 3.0;
-                Items[i].Value[2] = (P1[2] + P2[2] + P3[2]) / 3.0;
-            }
+            NumberOfItems = Mesh->GetNumberOfCells();
+            Faces.Compute(Mesh, false, false, NumberOfThreads);
         } else {
             // Items are vertices
-            NumberOfElements = Mesh->GetNumberOfPoints();
-            double Point[3];
-
-            Items = new Item[Mesh->GetNumberOfPoints()];
-            for (i = 0; i < Mesh->GetNumberOfPoints(); i++) {
-                if (Gradation == 0)
-                    Items[i].Weight = Mesh->GetVertexArea(i);
-                else
-                    Items[i].Weight =
-                        Mesh->GetVertexArea(i) *
-                        pow(CustomWeights->GetValue(i), Gradation);
-
-                Mesh->GetPoint(i, Point);
-                Items[i].Value[0] = Point[0];
-                Items[i].Value[1] = Point[1];
-                Items[i].Value[2] = Point[2];
-            }
+            NumberOfItems = Mesh->GetNumberOfPoints();
+            Areas.VerticesAreas =
+                Mesh->GetVerticesAreas(NumberOfThreads)->GetPointer(0);
         }
+        this->Items = new Item[NumberOfItems];
+
+        struct ItemsBuilding
+        {
+            Self* Metric;
+            vtkSurface* Mesh;
+            ItemAreas Areas;
+
+            void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+            {
+                Item* Items = this->Metric->Items;
+                vtkDoubleArray* Weights = this->Metric->CustomWeights;
+                double Gradation = this->Metric->Gradation;
+                vtkIdType v1, v2, v3;
+                double P1[3], P2[3], P3[3];
+                for (vtkIdType i = Begin; i < End; i++) {
+                    if (this->Areas.ClusteringType == 0) {
+                        this->Mesh->GetFaceVertices(i, v1, v2, v3);
+                        this->Mesh->GetPoint(v1, P1);
+                        this->Mesh->GetPoint(v2, P2);
+                        this->Mesh->GetPoint(v3, P3);
+                        Items[i].Value[0] = (P1[0] + P2[0] + P3[0]) / 3.0;
+                        Items[i].Value[1] = (P1[1] + P2[1] + P3[1]) / 3.0;
+                        Items[i].Value[2] = (P1[2] + P2[2] + P3[2]) / 3.0;
+                    } else {
+                        this->Mesh->GetPoint(i, P1);
+                        Items[i].Value[0] = P1[0];
+                        Items[i].Value[1] = P1[1];
+                        Items[i].Value[2] = P1[2];
+                    }
+                    if (Gradation == 0)
+                        Items[i].Weight = this->Areas.GetArea(i);
+                    else
+                        Items[i].Weight = this->Areas.GetArea(i) *
+                            pow(Weights->GetValue(i), Gradation);
+                }
+            }
+        };
+
+        ItemsBuilding BuildItems;
+        BuildItems.Metric = this;
+        BuildItems.Mesh = Mesh;
+        BuildItems.Areas = Areas;
+        vtkParallelFor::Execute(NumberOfItems, BuildItems, NumberOfThreads);
+
+        this->ClampWeights(this->Items, NumberOfItems, 100000, NumberOfThreads);
+
+        // the tensors are written in place in the principal directions array
+        struct TensorsBuilding
+        {
+            Self* Metric;
+            ItemAreas Areas;
+
+            void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+            {
+                Item* Items = this->Metric->Items;
+                vtkFloatArray* Directions = this->Metric->PrincipalDirections;
+                for (vtkIdType i = Begin; i < End; i++) {
+                    // Compute the tensor in compact form
+                    double Area = this->Areas.GetArea(i);
+                    double PrincipalDirections[6];
+                    int j;
+                    for (j = 0; j < 6; j++)
+                        PrincipalDirections[j] =
+                            Directions->GetValue(i * 6 + j);
+
+                    Items[i].Tensor = Directions->GetPointer(i * 6);
+
+                    Items[i].Tensor[0] =
+                        Area * PrincipalDirections[0] * PrincipalDirections[0] +
+                        Area * PrincipalDirections[3] * PrincipalDirections[3];
+
+                    Items[i].Tensor[1] =
+                        Area * PrincipalDirections[0] * PrincipalDirections[1] +
+                        Area * PrincipalDirections[3] * PrincipalDirections[4];
+
+                    Items[i].Tensor[2] =
+                        Area * PrincipalDirections[0] * PrincipalDirections[2] +
+                        Area * PrincipalDirections[3] * PrincipalDirections[5];
+
+                    Items[i].Tensor[3] =
+                        Area * PrincipalDirections[1] * PrincipalDirections[1] +
+                        Area * PrincipalDirections[5] * PrincipalDirections[5];
+
+                    Items[i].Tensor[4] =
+                        Area * PrincipalDirections[1] * PrincipalDirections[2] +
+                        Area * PrincipalDirections[4] * PrincipalDirections[5];
+
+                    Items[i].Tensor[5] =
+                        Area * PrincipalDirections[2] * PrincipalDirections[2] +
+                        Area * PrincipalDirections[5] * PrincipalDirections[5];
+
+                    // Compute the TensorXCentroid vector
+
+                    Items[i].TensorXCentroid[0] =
+                        Items[i].Tensor[0] * Items[i].Value[0] +
+                        Items[i].Tensor[1] * Items[i].Value[1] +
+                        Items[i].Tensor[2] * Items[i].Value[2];
+
+                    Items[i].TensorXCentroid[1] =
+                        Items[i].Tensor[1] * Items[i].Value[0] +
+                        Items[i].Tensor[3] * Items[i].Value[1] +
+                        Items[i].Tensor[4] * Items[i].Value[2];
+
+                    Items[i].TensorXCentroid[2] =
+                        Items[i].Tensor[2] * Items[i].Value[0] +
+                        Items[i].Tensor[4] * Items[i].Value[1] +
+                        Items[i].Tensor[5] * Items[i].Value[2];
+
+                    Items[i].Value[0] *= Items[i].Weight;
+                    Items[i].Value[1] *= Items[i].Weight;
+                    Items[i].Value[2] *= Items[i].Weight;
+                }
+            }
+        };
 
-        this->ClampWeights(Items, NumberOfElements, 100000);
-
-        for (i = 0; i < NumberOfElements; i++) {
-
-            // Compute the tensor in compact form
-
-            //			Items[i].PrincipalDirections=this->PrincipalDirections->GetPointer(i*8);
-
-            double Area;
-
-            if (ClusteringType == 0)
-                Area = Mesh->GetFaceArea(i);
-            else
-                Area = Mesh->GetVertexArea(i);
-
-            double PrincipalDirections[6];  //=Items[i].PrincipalDirections;
-            int j;
-            for (j = 0; j < 6; j++)
-                PrincipalDirections[j] =
-                    this->PrincipalDirections->GetValue(i * 6 + j);
-
-            Items[i].Tensor = this->PrincipalDirections->GetPointer(i * 6);
-
-            Items[i].Tensor[0] =
-                Area * PrincipalDirections[0] * PrincipalDirections[0] +
-                Area * PrincipalDirections[3] * PrincipalDirections[3];
-
-            Items[i].Tensor[1] =
-                Area * PrincipalDirections[0] * PrincipalDirections[1] +
-                Area * PrincipalDirections[3] * PrincipalDirections[4];
-
-            Items[i].Tensor[2] =
-                Area * PrincipalDirections[0] * PrincipalDirections[2] +
-                Area * PrincipalDirections[3] * PrincipalDirections[5];
-
-            Items[i].Tensor[3] =
-                Area * PrincipalDirections[1] * PrincipalDirections[1] +
-                Area * PrincipalDirections[5] * PrincipalDirections[5];
-
-            Items[i].Tensor[4] =
-                Area * PrincipalDirections[1] * PrincipalDirections[2] +
-                Area * PrincipalDirections[4] * PrincipalDirections[5];
-
-            Items[i].Tensor[5] =
-                Area * PrincipalDirections[2] * PrincipalDirections[2] +
-                Area * PrincipalDirections[5] * PrincipalDirections[5];
-
-            // Compute the TensorXCentroid vector
-
-            Items[i].TensorXCentroid[0] =
-                Items[i].Tensor[0] * Items[i].Value[0] +
-                Items[i].Tensor[1] * Items[i].Value[1] +
-                Items[i].Tensor[2] * Items[i].Value[2];
-
-            Items[i].TensorXCentroid[1] =
-                Items[i].Tensor[1] * Items[i].Value[0] +
-                Items[i].Tensor[3] * Items[i].Value[1] +
-                Items[i].Tensor[4] * Items[i].Value[2];
-
-            Items[i].TensorXCentroid[2] =
-                Items[i].Tensor[2] * Items[i].Value[0] +
-                Items[i].Tensor[4] * Items[i].Value[1] +
-                Items[i].Tensor[5] * Items[i].Value[2];
-
-            Items[i].Value[0] *= Items[i].Weight;
-            Items[i].Value[1] *= Items[i].Weight;
-            Items[i].Value[2] *= Items[i].Weight;
-        }
+        TensorsBuilding BuildTensors;
+        BuildTensors.Metric = this;
+        BuildTensors.Areas = Areas;
+        vtkParallelFor::Execute(NumberOfItems, BuildTensors, NumberOfThreads);
     }
     // this method clamps the weights between AverageValue/Ratio and
-    // AverageValue*Ratio
-    static void ClampWeights(Item* Items, int NumberOfValues, double Ratio)
+    // AverageValue*Ratio. The average is summed sequentially so that it does
+    // not depend on the number of threads
+    static void ClampWeights(
+        Item* Items,
+        vtkIdType NumberOfValues,
+        double Ratio,
+        int NumberOfThreads = 0)
     {
         double Average = 0;
-        int i;
+        vtkIdType i;
         for (i = 0; i < NumberOfValues; i++) {
             Average += Items[i].Weight;
         }
         Average = Average / (double)NumberOfValues;
-        double Min = Average / Ratio;
-        double Max = Average * Ratio;
-        for (i = 0; i < NumberOfValues; i++) {
-            if (Items[i].Weight > Max)
-                Items[i].Weight = Max;
-            if (Items[i].Weight < Min)
-                Items[i].Weight = Min;
-        }
+
+        struct Clamping
+        {
+            Item* Items;
+            double Min;
+            double Max;
+
+            void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+            {
+                for (vtkIdType j = Begin; j < End; j++) {
+                    if (this->Items[j].Weight > this->Max)
+                        this->Items[j].Weight = this->Max;
+                    if (this->Items[j].Weight < this->Min)
+                        this->Items[j].Weight = this->Min;
+                }
+            }
+        };
+
+        Clamping Clamp;
+        Clamp.Items = Items;
+        Clamp.Min = Average / Ratio;
+        Clamp.Max = Average * Ratio;
+        vtkParallelFor::Execute(NumberOfValues, Clamp, NumberOfThreads);
     }
 
 private:
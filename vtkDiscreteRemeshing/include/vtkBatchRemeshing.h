@@ -0,0 +1,175 @@
+/*=========================================================================
+
+  Program:   Batch remeshing of many meshes on a shared thread pool
+  Module:    vtkBatchRemeshing.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#ifndef _VTKBATCHREMESHING_H_
+#define _VTKBATCHREMESHING_H_
+
+#include <string>
+#include <vector>
+
+#include <vtkMultiThreader.h>
+#include <vtkType.h>
+
+/// Isotropic remeshing (as vtkIsotropicDiscreteRemeshing) of a list of mesh
+/// files, each with its own target number of vertices. All the jobs share
+/// one pool of threads :
+///
+/// - each job gets one thread per VerticesPerThread estimated vertices (at
+///   least one, at most all the threads), so that small meshes are remeshed
+///   concurrently, one thread each, and large meshes use the parallel parts
+///   of the clustering. Every parallel loop of a job (curvature, metric,
+///   attributes, subdivision, reordering and clustering) is run with its
+///   number of threads, so that the computing threads never outnumber the
+///   pool. The threads writing the curvature cache files in the background
+///   are not counted.
+/// - each job reserves its estimated memory footprint, and is only started
+///   when the reservations of the running jobs leave room for it under the
+///   memory limit. A job larger than the limit runs alone.
+/// - the jobs are started by decreasing footprint, so that the largest ones
+///   do not end the batch. An idle thread takes the first waiting job which
+///   fits in the free threads and memory.
+///
+/// The list of jobs is given with AddJob(), or read from a manifest file
+/// with one job per line :
+///
+///   input_file output_file number_of_vertices [gradation]
+///
+/// Empty lines and lines starting with '#' are ignored.
+class vtkBatchRemeshing
+{
+public:
+    enum JobStatus
+    {
+        JOB_PENDING = 0,
+        JOB_DONE,
+        JOB_FAILED
+    };
+
+    /// A remeshing job, and its outcome once Run() has returned
+    struct Job
+    {
+        std::string InputFile;
+        std::string OutputFile;
+        int NumberOfVertices;
+        double Gradation;
+
+        /// the estimated memory footprint, in bytes
+        double EstimatedMemory;
+
+        /// the number of threads used by the job
+        int NumberOfThreads;
+
+        /// the status, and the processing time in seconds
+        int Status;
+        double Time;
+    };
+
+    vtkBatchRemeshing();
+
+    /// Adds a job
+    void AddJob(
+        const char* InputFile,
+        const char* OutputFile,
+        int NumberOfVertices,
+        double Gradation);
+
+    /// Adds the jobs listed in a manifest file. Lines without a gradation
+    /// use the value given by SetGradation(). Returns false if the file
+    /// cannot be read or if a line is malformed, in which case no job is
+    /// added.
+    bool ReadManifest(const char* FileName);
+
+    int GetNumberOfJobs() { return ((int)this->Jobs.size()); }
+    const Job& GetJob(int Id) { return (this->Jobs[Id]); }
+
+    /// Sets the size of the thread pool. Default : the number of CPUs
+    void SetNumberOfThreads(int N) { this->NumberOfThreads = N; }
+
+    /// Sets the memory limit, in megabytes. Default : 0 (no limit)
+    void SetMemoryLimit(double M) { this->MemoryLimit = M; }
+
+    /// Sets the number of estimated vertices handled by one thread within a
+    /// job. Default : 200000
+    void SetVerticesPerThread(vtkIdType N) { this->VerticesPerThread = N; }
+
+    /// Sets the gradation of the manifest lines which do not give one.
+    /// Default : 0
+    void SetGradation(double G) { this->Gradation = G; }
+
+    /// Sets the subsampling threshold, as
+    /// vtkDiscreteRemeshing::SetSubsamplingThreshold(). Default value: 10
+    void SetSubsamplingThreshold(int T) { this->SubsamplingThreshold = T; }
+
+    /// Sets the reordering of the inputs, as
+    /// vtkDiscreteRemeshing::SetInputReordering(). Default value:
+    /// vtkSurface::NO_REORDERING
+    void SetInputReordering(int R) { this->InputReordering = R; }
+
+    /// Sets the directory where the curvature of the inputs is cached, as
+    /// vtkDiscreteRemeshing::SetCurvatureCacheDirectory(). Default : none
+    void SetCurvatureCacheDirectory(const char* Directory)
+    {
+        this->CurvatureCacheDirectory = Directory ? Directory : "";
+    }
+
+    /// Sets the console output level (0 : silent, 1 : one line per finished
+    /// job). Default : 1
+    void SetConsoleOutput(int C) { this->ConsoleOutput = C; }
+
+    /// Processes all the pending jobs. Returns the number of failed jobs.
+    int Run();
+
+private:
+    std::vector<Job> Jobs;
+
+    // the parameters
+    int NumberOfThreads;
+    double MemoryLimit;
+    vtkIdType VerticesPerThread;
+    double Gradation;
+    int SubsamplingThreshold;
+    int InputReordering;
+    int ConsoleOutput;
+    std::string CurvatureCacheDirectory;
+
+    // the state of the pool during Run(), defined in the source file
+    struct Pool;
+
+    // estimates the footprint and the number of threads of a job
+    void EstimateJob(Job& J, int PoolSize);
+
+    // remeshes the input of a job and writes its output
+    bool ProcessJob(Job& J);
+
+    static VTK_THREAD_RETURN_TYPE Worker(void* arg);
+};
+
+#endif
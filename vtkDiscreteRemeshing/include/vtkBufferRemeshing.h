@@ -0,0 +1,188 @@
+/*=========================================================================
+
+  Program:   Remeshing of meshes stored in raw buffers
+  Module:    vtkBufferRemeshing.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#ifndef _VTKBUFFERREMESHING_H_
+#define _VTKBUFFERREMESHING_H_
+
+#include <vector>
+
+#include <vtkPoints.h>
+#include <vtkType.h>
+
+/// Isotropic remeshing (as vtkIsotropicDiscreteRemeshing) of a triangle mesh
+/// given as raw buffers, for applications which do not store their meshes
+/// in VTK objects. The input points buffer is wrapped without copy, and the
+/// triangles are read directly into the mesh, without vtkPolyData nor
+/// triangulation filter. The output is stored in a single contiguous block,
+/// which can be read in place or copied into buffers owned by the caller:
+///
+///   vtkBufferRemeshing Remeshing;
+///   Remeshing.SetInputPoints(Points, NumberOfPoints);
+///   Remeshing.SetInputTriangles(Triangles, NumberOfTriangles);
+///   Remeshing.SetNumberOfVertices(5000);
+///   if (Remeshing.Remesh()) {
+///       const vtkBufferRemeshing::OutputBlock& Output =
+///           Remeshing.GetOutputBlock();
+///       ...
+///   }
+class vtkBufferRemeshing
+{
+public:
+    /// The output of the remeshing, stored contiguously
+    struct OutputBlock
+    {
+        /// NumberOfPoints x 3 coordinates
+        const double* Points;
+        vtkIdType NumberOfPoints;
+
+        /// NumberOfTriangles x 3 vertex Ids
+        const vtkIdType* Triangles;
+        vtkIdType NumberOfTriangles;
+
+        /// the output vertex (i.e. the cluster) of each input point, -1 for
+        /// points in no cluster
+        const vtkIdType* Clustering;
+        vtkIdType NumberOfInputPoints;
+    };
+
+    vtkBufferRemeshing();
+    ~vtkBufferRemeshing();
+
+    /// Sets the input points, as NumberOfPoints x 3 coordinates. The buffer
+    /// is used in place : it is never written, and must remain valid and
+    /// unchanged until Remesh() returns.
+    void SetInputPoints(const float* Points, vtkIdType NumberOfPoints);
+    void SetInputPoints(const double* Points, vtkIdType NumberOfPoints);
+
+    /// Sets the input triangles, as NumberOfTriangles x 3 vertex Ids. The
+    /// buffer must remain valid until Remesh() returns.
+    void SetInputTriangles(const int* Triangles, vtkIdType NumberOfTriangles);
+    void SetInputTriangles(
+        const vtkIdType* Triangles, vtkIdType NumberOfTriangles);
+
+    /// Sets the number of vertices of the output. Default value: 1000
+    void SetNumberOfVertices(int N) { this->NumberOfVertices = N; }
+
+    /// Sets the gradation parameter (0 : uniform remeshing, larger values
+    /// adapt the sampling to the curvature). Default value: 0
+    void SetGradation(double G) { this->Gradation = G; }
+
+    /// Sets the subsampling threshold, as
+    /// vtkDiscreteRemeshing::SetSubsamplingThreshold(). Default value: 10
+    void SetSubsamplingThreshold(int T) { this->SubsamplingThreshold = T; }
+
+    /// Sets the reordering of the input, as
+    /// vtkDiscreteRemeshing::SetInputReordering(). Default value:
+    /// vtkSurface::NO_REORDERING
+    void SetInputReordering(int R) { this->InputReordering = R; }
+
+    /// Sets the console output level. Default value: 0 (silent)
+    void SetConsoleOutput(int C) { this->ConsoleOutput = C; }
+
+    /// Remeshes the input. Returns false if the input is incomplete or if a
+    /// triangle references a missing point.
+    bool Remesh();
+
+    /// Returns the output of the last Remesh(). The block belongs to this
+    /// object, and remains valid until the next Remesh() or the destruction
+    /// of this object.
+    const OutputBlock& GetOutputBlock() { return this->Output; }
+
+    /// Copies the output of the last Remesh() into buffers owned by the
+    /// caller, whose lengths are given in numbers of values : 3 x
+    /// NumberOfPoints coordinates, 3 x NumberOfTriangles vertex Ids, and
+    /// NumberOfInputPoints clusters. Each buffer may be null. Returns false,
+    /// without copying anything, if a buffer is too short.
+    template <class PointType, class IdType>
+    bool GetOutput(
+        PointType* Points,
+        vtkIdType PointsLength,
+        IdType* Triangles,
+        vtkIdType TrianglesLength,
+        IdType* Clustering,
+        vtkIdType ClusteringLength);
+
+private:
+    // the input
+    vtkPoints* InputPoints;
+    const int* IntTriangles;
+    const vtkIdType* IdTriangles;
+    vtkIdType NumberOfInputTriangles;
+
+    // the parameters
+    int NumberOfVertices;
+    double Gradation;
+    int SubsamplingThreshold;
+    int InputReordering;
+    int ConsoleOutput;
+
+    // the output, and the memory holding it
+    OutputBlock Output;
+    std::vector<char> Block;
+
+    void SetInputCoordinates(vtkDataArray* Coordinates);
+
+    // returns true if all the triangles reference existing points
+    template <class IdType>
+    bool CheckTriangles(const IdType* Triangles);
+};
+
+template <class PointType, class IdType>
+bool vtkBufferRemeshing::GetOutput(
+    PointType* Points,
+    vtkIdType PointsLength,
+    IdType* Triangles,
+    vtkIdType TrianglesLength,
+    IdType* Clustering,
+    vtkIdType ClusteringLength)
+{
+    const OutputBlock& Output = this->Output;
+    if ((Points && (PointsLength < 3 * Output.NumberOfPoints)) ||
+        (Triangles && (TrianglesLength < 3 * Output.NumberOfTriangles)) ||
+        (Clustering && (ClusteringLength < Output.NumberOfInputPoints)))
+        return (false);
+
+    if (Points) {
+        for (vtkIdType i = 0; i < 3 * Output.NumberOfPoints; i++)
+            Points[i] = (PointType)Output.Points[i];
+    }
+    if (Triangles) {
+        for (vtkIdType i = 0; i < 3 * Output.NumberOfTriangles; i++)
+            Triangles[i] = (IdType)Output.Triangles[i];
+    }
+    if (Clustering) {
+        for (vtkIdType i = 0; i < Output.NumberOfInputPoints; i++)
+            Clustering[i] = (IdType)Output.Clustering[i];
+    }
+    return (true);
+}
+
+#endif
@@ -30,11 +30,17 @@
 *  knowledge of the CeCILL-B license and that you accept its terms.
 * ------------------------------------------------------------------------ */
 
+#include <cstdio>
+#include <string>
+
 #include <vtkDoubleArray.h>
 #include <vtkIntArray.h>
 #include <vtkObjectFactory.h>
 
+#include "vtkClusteringCheckpoint.h"
+#include "vtkContentHash.h"
 #include "vtkCurvatureMeasure.h"
+#include "vtkFaceQuantities.h"
 #include "vtkSurface.h"
 #include "vtkSurfaceClustering.h"
 #include "vtkTag.h"
@@ -44,13 +50,24 @@
 // class, as proposed in : " Approximated Centroidal Voronoi Diagrams for
 // Uniform Polygonal Mesh Coarsening", Valette & Chassery, Eurographics 2004
 
-template <class Metric>
-class vtkDiscreteRemeshing : public vtkSurfaceClustering<Metric>
+template <class Metric, class Derived = void>
+class vtkDiscreteRemeshing : public vtkSurfaceClustering<Metric, Derived>
 {
 public:
     /// returns the coarsened model.
     vtkSurface* GetOutput() { return this->Output; }
 
+    /// Sets the mesh to remesh. The curvature given by SetInputCurvature()
+    /// or computed for the previous input, and the reordered copy of the
+    /// previous input, are released
+    void SetInput(vtkSurface* Input)
+    {
+        this->SetInputCurvature(0);
+        this->RestoreUnsubdividedInput();
+        this->RestoreUnreorderedInput();
+        this->vtkSurfaceClustering<Metric, Derived>::SetInput(Input);
+    }
+
     // process the remeshing
     virtual void Remesh();
 
@@ -59,6 +76,62 @@ public:
     /// 10
     void SetSubsamplingThreshold(int T) { this->SubsamplingThreshold = T; }
 
+    /// Sets On/Off the adaptive subdivision : instead of subdividing the whole
+    /// mesh, only the faces too large to fit SubsamplingThreshold items in a
+    /// cluster are subdivided. Default value: 0 (Off)
+    void SetAdaptiveSubsampling(int A) { this->AdaptiveSubsamplingFlag = A; }
+
+    /// Sets the order (vtkSurface::ReorderingMethod) applied to a copy of the
+    /// input before subdivision and clustering, to improve the memory
+    /// locality of the clustering. GetInput() then returns the reordered
+    /// mesh. Default value: vtkSurface::NO_REORDERING
+    void SetInputReordering(int R)
+    {
+        // the curvature of the input in another order does not match it
+        if (R != this->InputReordering)
+            this->SetInputCurvature(0);
+        this->InputReordering = R;
+    }
+
+    /// Returns, for each item (vertex or face) of the reordered copy of the
+    /// input, before any subdivision, its Id in the mesh given to
+    /// SetInput(). Returns 0 if the input was not reordered
+    vtkIdTypeArray* GetInputPermutation() { return this->InputPermutation; }
+
+    /// Sets the curvature of the input, as computed by vtkCurvatureMeasure
+    /// for the clustering items, e.g. by a previous remeshing of the same
+    /// input (see GetInputCurvature()). It is used instead of computing the
+    /// curvature when it matches the input, after its reordering and before
+    /// its subdivision. The arrays are never modified. Only the number of
+    /// items is checked, so it must be set after SetInput() and
+    /// SetInputReordering(), which release it.
+    void SetInputCurvature(vtkDataArrayCollection* Curvature)
+    {
+        if (Curvature)
+            Curvature->Register(this);
+        if (this->InputCurvature)
+            this->InputCurvature->UnRegister(this);
+        this->InputCurvature = Curvature;
+    }
+
+    /// Returns the curvature of the input used by the last Remesh(), given
+    /// by SetInputCurvature() or computed. Returns 0 when the metric does
+    /// not need the curvature
+    vtkDataArrayCollection* GetInputCurvature()
+    {
+        return this->InputCurvature;
+    }
+
+    /// Sets the directory where the curvature of the inputs is cached. The
+    /// curvature is stored in a binary file named after the hash of the
+    /// input geometry, and read back instead of being computed when the
+    /// same input is remeshed again, e.g. with another number of vertices.
+    /// Default : none (no cache)
+    void SetCurvatureCacheDirectory(const char* Directory)
+    {
+        this->CurvatureCacheDirectory = Directory ? Directory : "";
+    }
+
     // Sets On/Off the Edges optimization scheme (still experimental)
     void SetEdgesOptimization(int S) { this->EdgeOptimizationFlag = S; }
 
@@ -108,11 +181,38 @@ protected:
     /// clustering
     void CheckSubsamplingRatio();
 
+    /// Subdivides only the faces of the input which are too large compared to
+    /// the area of a cluster
+    void SubdivideAdaptively();
+
+    /// Replaces the input by a reordered copy of the mesh given to
+    /// SetInput(), if InputReordering is set. Nothing is done when the input
+    /// already is its copy reordered with InputReordering
+    void ReorderInput();
+
+    /// Replaces the subdivided input by the mesh before its subdivision
+    void RestoreUnsubdividedInput();
+
+    /// Replaces the reordered input by the mesh given to SetInput()
+    void RestoreUnreorderedInput();
+
     /// Checks whether every output vertex is manifold
     /// the non-conforming clusters while have their items density multiplied by
     /// Factor. returns the number of vertices with issues.
     int DetectNonManifoldOutputVertices(double Factor);
 
+    /// adds the subdivision level to the checkpoint signature : a
+    /// checkpoint can only be resumed on the same subdivided input
+    void GetCheckpointSignature(std::vector<vtkTypeInt64>& Signature)
+    {
+        vtkSurfaceClustering<Metric, Derived>::GetCheckpointSignature(
+            Signature);
+        Signature.push_back(this->NumberOfSubdivisionsBeforeClustering);
+        Signature.push_back(this->AdaptiveSubsamplingFlag);
+        Signature.push_back(this->ClusteringType);
+        Signature.push_back(this->InputReordering);
+    }
+
     /// the parameter storing the minimun subsampling ratio.
     /// if the actual subsampling ration is below, the input mesh will be
     /// subdivided accordingly default value is 10
@@ -122,9 +222,49 @@ protected:
     /// clustering
     vtkSurface* OriginalInput;
 
-    /// this value stores the number of processed subdivisions
+    /// this value stores the number of processed subdivisions (1 when the
+    /// mesh was subdivided adaptively)
     int NumberOfSubdivisionsBeforeClustering;
 
+    /// flag enabling the adaptive subdivision
+    int AdaptiveSubsamplingFlag;
+
+    /// the order applied to the input before clustering
+    int InputReordering;
+
+    /// the Ids of the input items before reordering
+    vtkIdTypeArray* InputPermutation;
+
+    /// the order of the input when it is a reordered copy (NO_REORDERING
+    /// otherwise)
+    int InputPermutationOrder;
+
+    /// the mesh given to SetInput() when the input is its reordered copy
+    vtkSurface* UnreorderedInput;
+
+    /// the curvature of the input items, before subdivision
+    vtkDataArrayCollection* InputCurvature;
+
+    /// returns true when InputCurvature matches the input and the metric
+    bool IsInputCurvatureValid();
+
+    /// the directory of the curvature cache, empty when disabled
+    std::string CurvatureCacheDirectory;
+
+    /// the buffer used to read and write the curvature cache files
+    vtkClusteringCheckpoint CurvatureCacheBuffer;
+
+    /// returns the hash of the input geometry (before subdivision) and of
+    /// the curvature settings, which identifies its curvature cache file
+    unsigned long long GetCurvatureCacheKey();
+
+    /// reads InputCurvature from the cache file. Returns false when the file
+    /// does not exist or does not match the input
+    bool LoadCachedCurvature(const std::string& FileName);
+
+    /// writes InputCurvature to the cache file, in the background
+    void SaveCachedCurvature(const std::string& FileName);
+
     /// this array stores the parent-child informations (2 ints for each vertex:
     /// its two parents) it is used only when the mesh is bubdivided before
     /// simplification, to interpolate the
@@ -132,6 +272,10 @@ protected:
     vtkIntArray* VerticesParent1;
     vtkIntArray* VerticesParent2;
 
+    /// when the mesh is subdivided adaptively and the items are faces, this
+    /// array stores the input face containing each face
+    vtkIntArray* FacesParent;
+
     // Experimental (Nevermind)
     void OptimizeOutputEdges();
 
@@ -148,8 +292,9 @@ protected:
     bool ForceManifold;
 };
 
-template <class Metric>
-int vtkDiscreteRemeshing<Metric>::DetectNonManifoldOutputVertices(double Factor)
+template <class Metric, class Derived>
+int vtkDiscreteRemeshing<Metric, Derived>::DetectNonManifoldOutputVertices(
+    double Factor)
 {
     vtkIdType RealNumberOfClusters =
         this->NumberOfClusters - this->NumberOfSpareClusters;
@@ -289,13 +434,13 @@ int vtkDiscreteRemeshing<Metric>::DetectNonManifoldOutputVertices(double Factor)
     return NumberOfTopologyIssues;
 }
 
-template <class Metric>
-void vtkDiscreteRemeshing<Metric>::FixClusteringToVoronoi()
+template <class Metric, class Derived>
+void vtkDiscreteRemeshing<Metric, Derived>::FixClusteringToVoronoi()
 {
 }
 
-template <class Metric>
-void vtkDiscreteRemeshing<Metric>::FixMeshBoundaries()
+template <class Metric, class Derived>
+void vtkDiscreteRemeshing<Metric, Derived>::FixMeshBoundaries()
 {
     // until now, this method works only when clustering vertices
     if (this->ClusteringType == 0)
@@ -421,8 +566,8 @@ void vtkDiscreteRemeshing<Metric>::FixMeshBoundaries()
     delete[] EdgesNewPoint;
 }
 
-template <class Metric>
-void vtkDiscreteRemeshing<Metric>::SamplingPreProcessing()
+template <class Metric, class Derived>
+void vtkDiscreteRemeshing<Metric, Derived>::SamplingPreProcessing()
 {
     int i;
     vtkDoubleArray* CellsIndicators;
@@ -430,25 +575,53 @@ void vtkDiscreteRemeshing<Metric>::SamplingPreProcessing()
     CustomIndicatorColors->SetNumberOfValues(this->GetNumberOfItems());
 
     if (this->MetricContext.IsCurvatureIndicatorNeeded() == 1) {
-        vtkPolyData* PrincipalDirectionsPolyData = nullptr;
-        vtkDataArrayCollection* CurvatureCollection = nullptr;
-
-        auto Curvature = vtkCurvatureMeasure::New();
-        if (this->OriginalInput)
-            Curvature->SetInputData(this->OriginalInput);
-        else
-            Curvature->SetInputData(this->Input);
+        std::string CacheFile;
+        if (!this->IsInputCurvatureValid() &&
+            !this->CurvatureCacheDirectory.empty()) {
+            char Name[32];
+            snprintf(
+                Name, sizeof(Name), "%016llx.curv",
+                this->GetCurvatureCacheKey());
+            CacheFile = this->CurvatureCacheDirectory + "/" + Name;
+            if (this->LoadCachedCurvature(CacheFile) && this->ConsoleOutput)
+                cout << "Curvature read from " << CacheFile << endl;
+        }
 
-        Curvature->SetComputationMethod(1);
-        Curvature->SetElementsType(this->ClusteringType);
-        Curvature->SetComputePrincipalDirections(
-            this->MetricContext.IsPrincipalDirectionsNeeded());
+        if (!this->IsInputCurvatureValid()) {
+            auto Curvature = vtkCurvatureMeasure::New();
+            if (this->OriginalInput)
+                Curvature->SetInputData(this->OriginalInput);
+            else
+                Curvature->SetInputData(this->Input);
+
+            Curvature->SetComputationMethod(1);
+            Curvature->SetNumberOfThreads(this->NumberOfThreads);
+            Curvature->SetElementsType(this->ClusteringType);
+            Curvature->SetComputePrincipalDirections(
+                this->MetricContext.IsPrincipalDirectionsNeeded());
+            this->SetInputCurvature(Curvature->GetCurvatureIndicator());
+            Curvature->Delete();
+            if (!CacheFile.empty())
+                this->SaveCachedCurvature(CacheFile);
+        } else if (this->ConsoleOutput && CacheFile.empty()) {
+            cout << "Using the given curvature" << endl;
+        }
 
-        CurvatureCollection = Curvature->GetCurvatureIndicator();
-        CurvatureCollection->Register(this);
+        // the indicators are only read, but the anisotropic metrics write
+        // their tensors in the principal directions array : the metric gets
+        // a copy of it
+        vtkDataArrayCollection* CurvatureCollection =
+            vtkDataArrayCollection::New();
+        CurvatureCollection->AddItem(this->InputCurvature->GetItem(0));
+        for (i = 1; i < this->InputCurvature->GetNumberOfItems(); i++) {
+            vtkDataArray* Array = this->InputCurvature->GetItem(i);
+            vtkDataArray* Copy = Array->NewInstance();
+            Copy->DeepCopy(Array);
+            CurvatureCollection->AddItem(Copy);
+            Copy->Delete();
+        }
 
         CellsIndicators = (vtkDoubleArray*)CurvatureCollection->GetItem(0);
-        Curvature->Delete();
 
         // now we have to interpolate the curvature measure when the input mesh
         // was subdivided
@@ -457,7 +630,21 @@ void vtkDiscreteRemeshing<Metric>::SamplingPreProcessing()
             vtkDoubleArray* CellsIndicators2 = vtkDoubleArray::New();
             CellsIndicators2->SetNumberOfValues(this->GetNumberOfItems());
 
-            if (this->ClusteringType == 0) {
+            if ((this->ClusteringType == 0) && this->FacesParent) {
+                // Interpolating faces indicators after an adaptive
+                // subdivision : each face gets the share of its parent
+                // indicator corresponding to its area
+                for (i = 0; i < this->Input->GetNumberOfCells(); i++) {
+                    int Parent = this->FacesParent->GetValue(i);
+                    double ParentArea =
+                        this->OriginalInput->GetFaceArea(Parent);
+                    double Ratio = 1;
+                    if (ParentArea > 0)
+                        Ratio = this->Input->GetFaceArea(i) / ParentArea;
+                    CellsIndicators2->SetValue(
+                        i, CellsIndicators->GetValue(Parent) * Ratio);
+                }
+            } else if (this->ClusteringType == 0) {
                 // Interpolating faces indicators
                 int NumberOfChildrenFacesPerFace;
                 NumberOfChildrenFacesPerFace =
@@ -528,8 +715,164 @@ void vtkDiscreteRemeshing<Metric>::SamplingPreProcessing()
     CustomIndicatorColors->Delete();
 }
 
-template <class Metric>
-void vtkDiscreteRemeshing<Metric>::CheckSubsamplingRatio()
+template <class Metric, class Derived>
+bool vtkDiscreteRemeshing<Metric, Derived>::IsInputCurvatureValid()
+{
+    if (!this->InputCurvature || !this->InputCurvature->GetNumberOfItems())
+        return (false);
+
+    vtkSurface* Mesh = this->OriginalInput ? this->OriginalInput : this->Input;
+    vtkIdType NumberOfItems = this->ClusteringType == 0
+                                  ? Mesh->GetNumberOfCells()
+                                  : Mesh->GetNumberOfPoints();
+    vtkDataArray* Indicators = this->InputCurvature->GetItem(0);
+    if (!vtkDoubleArray::SafeDownCast(Indicators) ||
+        (Indicators->GetNumberOfTuples() != NumberOfItems))
+        return (false);
+
+    if (this->MetricContext.IsPrincipalDirectionsNeeded()) {
+        vtkDataArray* Directions = this->InputCurvature->GetItem(1);
+        if (!vtkFloatArray::SafeDownCast(Directions) ||
+            (Directions->GetNumberOfTuples() *
+                 Directions->GetNumberOfComponents() !=
+             6 * NumberOfItems))
+            return (false);
+    }
+    return (true);
+}
+
+template <class Metric, class Derived>
+unsigned long long
+vtkDiscreteRemeshing<Metric, Derived>::GetCurvatureCacheKey()
+{
+    vtkSurface* Mesh = this->OriginalInput ? this->OriginalInput : this->Input;
+    vtkContentHash Hash;
+
+    // the settings of vtkCurvatureMeasure in SamplingPreProcessing()
+    int PrincipalDirections = this->MetricContext.IsPrincipalDirectionsNeeded();
+    Hash.AddValue((vtkTypeInt32)this->ClusteringType);
+    Hash.AddValue((vtkTypeInt32)PrincipalDirections);
+    Hash.AddValue((vtkTypeInt32)1);
+
+    vtkIdType NumberOfPoints = Mesh->GetNumberOfPoints();
+    Hash.AddValue((vtkTypeInt64)NumberOfPoints);
+    double P[3];
+    for (vtkIdType Vertex = 0; Vertex < NumberOfPoints; Vertex++) {
+        Mesh->GetPoint(Vertex, P);
+        Hash.Add(P, sizeof(P));
+    }
+
+    vtkIdType NumberOfFaces = Mesh->GetNumberOfCells();
+    Hash.AddValue((vtkTypeInt64)NumberOfFaces);
+    vtkIdType NumberOfFaceVertices, *FaceVertices;
+    for (vtkIdType Face = 0; Face < NumberOfFaces; Face++) {
+        if (!Mesh->IsFaceActive(Face)) {
+            Hash.AddValue((vtkTypeInt64)-1);
+            continue;
+        }
+        Mesh->GetFaceVertices(Face, NumberOfFaceVertices, FaceVertices);
+        Hash.AddValue((vtkTypeInt64)NumberOfFaceVertices);
+        for (vtkIdType j = 0; j < NumberOfFaceVertices; j++)
+            Hash.AddValue((vtkTypeInt64)FaceVertices[j]);
+    }
+    return (Hash.Get());
+}
+
+template <class Metric, class Derived>
+bool vtkDiscreteRemeshing<Metric, Derived>::LoadCachedCurvature(
+    const std::string& FileName)
+{
+    vtkClusteringCheckpoint& Buffer = this->CurvatureCacheBuffer;
+    Buffer.Wait();
+    if (!Buffer.ReadFile(FileName.c_str()))
+        return (false);
+
+    vtkSurface* Mesh = this->OriginalInput ? this->OriginalInput : this->Input;
+    vtkIdType NumberOfItems = this->ClusteringType == 0
+                                  ? Mesh->GetNumberOfCells()
+                                  : Mesh->GetNumberOfPoints();
+    int NumberOfArrays =
+        this->MetricContext.IsPrincipalDirectionsNeeded() ? 2 : 1;
+
+    char Magic[8];
+    vtkTypeInt32 Version, FileNumberOfArrays;
+    vtkTypeInt64 FileNumberOfItems;
+    unsigned long long Checksum;
+    if (!Buffer.Read(Magic, 8) || strncmp(Magic, "ACVDCURV", 8) ||
+        !Buffer.Read(Version) || (Version != 1) ||
+        !Buffer.Read(FileNumberOfItems) ||
+        (FileNumberOfItems != NumberOfItems) ||
+        !Buffer.Read(FileNumberOfArrays) ||
+        (FileNumberOfArrays != NumberOfArrays)) {
+        Buffer.Clear();
+        return (false);
+    }
+
+    // the checksum detects files truncated or mixed by concurrent writers
+    vtkDoubleArray* Indicators = vtkDoubleArray::New();
+    Indicators->SetNumberOfValues(NumberOfItems);
+    vtkFloatArray* Directions = 0;
+    bool Success = Buffer.Read(Indicators->GetPointer(0), NumberOfItems);
+    vtkContentHash Hash;
+    Hash.Add(Indicators->GetPointer(0), NumberOfItems * sizeof(double));
+    if (Success && (NumberOfArrays == 2)) {
+        Directions = vtkFloatArray::New();
+        Directions->SetNumberOfValues(6 * NumberOfItems);
+        Success = Buffer.Read(Directions->GetPointer(0), 6 * NumberOfItems);
+        Hash.Add(Directions->GetPointer(0), 6 * NumberOfItems * sizeof(float));
+    }
+    Success = Success && Buffer.Read(Checksum) && (Checksum == Hash.Get());
+    Buffer.Clear();
+
+    if (Success) {
+        vtkDataArrayCollection* Curvature = vtkDataArrayCollection::New();
+        Curvature->AddItem(Indicators);
+        if (Directions)
+            Curvature->AddItem(Directions);
+        this->SetInputCurvature(Curvature);
+        Curvature->Delete();
+    }
+    Indicators->Delete();
+    if (Directions)
+        Directions->Delete();
+    return (Success);
+}
+
+template <class Metric, class Derived>
+void vtkDiscreteRemeshing<Metric, Derived>::SaveCachedCurvature(
+    const std::string& FileName)
+{
+    vtkDoubleArray* Indicators =
+        vtkDoubleArray::SafeDownCast(this->InputCurvature->GetItem(0));
+    vtkFloatArray* Directions = 0;
+    if (this->InputCurvature->GetNumberOfItems() > 1)
+        Directions =
+            vtkFloatArray::SafeDownCast(this->InputCurvature->GetItem(1));
+    if (!Indicators)
+        return;
+
+    vtkClusteringCheckpoint& Buffer = this->CurvatureCacheBuffer;
+    Buffer.Wait();
+    Buffer.Clear();
+    vtkIdType NumberOfItems = Indicators->GetNumberOfTuples();
+    Buffer.Write("ACVDCURV", 8);
+    Buffer.Write((vtkTypeInt32)1);
+    Buffer.Write((vtkTypeInt64)NumberOfItems);
+    Buffer.Write((vtkTypeInt32)(Directions ? 2 : 1));
+
+    vtkContentHash Hash;
+    Buffer.Write(Indicators->GetPointer(0), NumberOfItems);
+    Hash.Add(Indicators->GetPointer(0), NumberOfItems * sizeof(double));
+    if (Directions) {
+        Buffer.Write(Directions->GetPointer(0), 6 * NumberOfItems);
+        Hash.Add(Directions->GetPointer(0), 6 * NumberOfItems * sizeof(float));
+    }
+    Buffer.Write(Hash.Get());
+    Buffer.WriteInBackground(FileName.c_str());
+}
+
+template <class Metric, class Derived>
+void vtkDiscreteRemeshing<Metric, Derived>::CheckSubsamplingRatio()
 {
     vtkSurface* Levels[100];
     Levels[0] = this->Input;
@@ -542,6 +885,11 @@ void vtkDiscreteRemeshing<Metric>::CheckSubsamplingRatio()
             this->VerticesParent2 = vtkIntArray::New();
     }
 
+    if (this->AdaptiveSubsamplingFlag) {
+        this->SubdivideAdaptively();
+        return;
+    }
+
     while (Levels[NumberOfSubdivisionsBeforeClustering]->GetNumberOfPoints() <
            this->SubsamplingThreshold *
                (this->NumberOfClusters - this->NumberOfSpareClusters)) {
@@ -549,7 +897,8 @@ void vtkDiscreteRemeshing<Metric>::CheckSubsamplingRatio()
             cout << "Subdividing mesh" << endl;
         Levels[NumberOfSubdivisionsBeforeClustering + 1] =
             Levels[NumberOfSubdivisionsBeforeClustering]->Subdivide(
-                this->VerticesParent1, this->VerticesParent2);
+                this->VerticesParent1, this->VerticesParent2,
+                this->NumberOfThreads);
         NumberOfSubdivisionsBeforeClustering++;
     }
 
@@ -563,11 +912,120 @@ void vtkDiscreteRemeshing<Metric>::CheckSubsamplingRatio()
     }
 }
 
-template <class Metric>
-void vtkDiscreteRemeshing<Metric>::Remesh()
+template <class Metric, class Derived>
+void vtkDiscreteRemeshing<Metric, Derived>::SubdivideAdaptively()
 {
+    if (this->ClusteringType == 0) {
+        if (!this->FacesParent)
+            this->FacesParent = vtkIntArray::New();
+    }
+
+    // the area that a cluster should cover
+    vtkFaceQuantities Faces;
+    Faces.Compute(this->Input, false, false, this->NumberOfThreads);
+    double Area = 0;
+    vtkIdType i;
+    for (i = 0; i < this->Input->GetNumberOfCells(); i++)
+        Area += Faces.GetArea(i);
+    Area /= (double)(this->NumberOfClusters - this->NumberOfSpareClusters);
+
+    // each cluster should contain at least SubsamplingThreshold items. On
+    // a triangle mesh, there are about twice as many faces as vertices, so
+    // that the area of a vertex item is about twice the area of a face
+    double MaximumArea = Area / (double)this->SubsamplingThreshold;
+    if (this->ClusteringType == 1)
+        MaximumArea *= 0.5;
+
+    vtkSurface* Subdivided = this->Input->SubdivideAdaptively(
+        MaximumArea, this->VerticesParent1, this->VerticesParent2,
+        this->FacesParent);
+    if (Subdivided->GetNumberOfCells() == this->Input->GetNumberOfCells()) {
+        Subdivided->Delete();
+        return;
+    }
+
+    if (this->ConsoleOutput)
+        cout << "Adaptive subdivision : " << this->Input->GetNumberOfCells()
+             << " -> " << Subdivided->GetNumberOfCells() << " faces" << endl;
+    this->OriginalInput = this->Input;
+    this->Input = Subdivided;
+    this->NumberOfSubdivisionsBeforeClustering = 1;
+}
+
+template <class Metric, class Derived>
+void vtkDiscreteRemeshing<Metric, Derived>::RestoreUnsubdividedInput()
+{
+    if (this->OriginalInput) {
+        this->Input->UnRegister(this);
+        this->Input = this->OriginalInput;
+        this->OriginalInput = 0;
+    }
+    this->NumberOfSubdivisionsBeforeClustering = 0;
+}
+
+template <class Metric, class Derived>
+void vtkDiscreteRemeshing<Metric, Derived>::RestoreUnreorderedInput()
+{
+    if (this->UnreorderedInput) {
+        this->Input->UnRegister(this);
+        this->Input = this->UnreorderedInput;
+        this->UnreorderedInput = 0;
+    }
+    if (this->InputPermutation) {
+        this->InputPermutation->Delete();
+        this->InputPermutation = 0;
+    }
+    this->InputPermutationOrder = vtkSurface::NO_REORDERING;
+}
+
+template <class Metric, class Derived>
+void vtkDiscreteRemeshing<Metric, Derived>::ReorderInput()
+{
+    if (this->InputReordering == this->InputPermutationOrder)
+        return;
+
+    // the input belongs to the caller : a copy is reordered, and the input
+    // is kept so that the next reordering starts from it too
+    this->RestoreUnreorderedInput();
+    if (this->InputReordering == vtkSurface::NO_REORDERING)
+        return;
+
+    vtkSurface* Reordered = vtkSurface::New();
+    Reordered->CreateFromPolyData(this->Input);
+    this->InputPermutation = vtkIdTypeArray::New();
+    if (this->ClusteringType == 0)
+        Reordered->Reorder(
+            this->InputReordering, 0, this->InputPermutation,
+            this->NumberOfThreads);
+    else
+        Reordered->Reorder(
+            this->InputReordering, this->InputPermutation, 0,
+            this->NumberOfThreads);
+    this->UnreorderedInput = this->Input;
+    this->Input = Reordered;
+    this->InputPermutationOrder = this->InputReordering;
+}
+
+template <class Metric, class Derived>
+void vtkDiscreteRemeshing<Metric, Derived>::Remesh()
+{
+    this->StartStage("remesh");
+
+    // a previous remeshing subdivided the input : start again from the mesh
+    // before its subdivision
+    this->RestoreUnsubdividedInput();
+
+    this->StartStage("reordering");
+    this->ReorderInput();
+    this->StopStage();
+    this->StartStage("subdivision");
     this->CheckSubsamplingRatio();
+    this->SetStageCounter(
+        "subdivisions", this->NumberOfSubdivisionsBeforeClustering);
+    this->StopStage();
+    this->StartStage("curvature");
     this->SamplingPreProcessing();
+    this->StopStage();
 
     if (this->ConsoleOutput) {
         cout << "Input mesh: " << this->GetInput()->GetNumberOfPoints()
@@ -577,22 +1035,36 @@ void vtkDiscreteRemeshing<Metric>::Remesh()
 
     this->ProcessClustering();
 
+    this->StartStage("delaunay");
     this->BuildDelaunayTriangulation();
+    this->StopStage();
     double Factor = 2;
     if (this->ForceManifold) {
+        this->StartStage("manifold repair");
+        int NumberOfRestarts = 0;
         int NumberOfIssues = this->DetectNonManifoldOutputVertices(Factor);
-        while (NumberOfIssues != 0) {
+        while ((NumberOfIssues != 0) && !this->BudgetExhausted) {
             cout << NumberOfIssues
                  << " topology issues, restarting minimization" << endl;
             this->ConnexityConstraint = 0;
             this->MinimizeEnergy();
             this->BuildDelaunayTriangulation();
             NumberOfIssues = this->DetectNonManifoldOutputVertices(Factor);
+            NumberOfRestarts++;
         }
+
+        // no time left for more restarts : return the mesh as is
+        if (NumberOfIssues != 0)
+            cout << NumberOfIssues
+                 << " topology issues left, the budget is exhausted" << endl;
+        this->SetStageCounter("restarts", NumberOfRestarts);
+        this->SetStageCounter("issues_left", NumberOfIssues);
+        this->StopStage();
     }
+    this->StopStage();
 }
-template <class Metric>
-void vtkDiscreteRemeshing<Metric>::GetDualItemNeighbourClusters(
+template <class Metric, class Derived>
+void vtkDiscreteRemeshing<Metric, Derived>::GetDualItemNeighbourClusters(
     vtkIdType Item, vtkIdList* List)
 {
     if (this->ClusteringType == 0) {
@@ -618,8 +1090,8 @@ void vtkDiscreteRemeshing<Metric>::GetDualItemNeighbourClusters(
     }
 }
 
-template <class Metric>
-vtkIdType vtkDiscreteRemeshing<Metric>::AddFace(
+template <class Metric, class Derived>
+vtkIdType vtkDiscreteRemeshing<Metric, Derived>::AddFace(
     vtkIdType v1, vtkIdType v2, vtkIdType v3)
 {
     if ((v1 == v2) || (v1 == v3) || (v2 == v3))
@@ -631,8 +1103,8 @@ vtkIdType vtkDiscreteRemeshing<Metric>::AddFace(
         return (-1);
 }
 
-template <class Metric>
-void vtkDiscreteRemeshing<Metric>::BuildDelaunayTriangulation()
+template <class Metric, class Derived>
+void vtkDiscreteRemeshing<Metric, Derived>::BuildDelaunayTriangulation()
 {
 
     vtkIdType i, j;
@@ -758,8 +1230,8 @@ void vtkDiscreteRemeshing<Metric>::BuildDelaunayTriangulation()
     }
 }
 
-template <class Metric>
-void vtkDiscreteRemeshing<Metric>::AdjustRemeshedGeometry()
+template <class Metric, class Derived>
+void vtkDiscreteRemeshing<Metric, Derived>::AdjustRemeshedGeometry()
 {
     int i, Cluster;
     vtkMath* Math = vtkMath::New();
@@ -790,19 +1262,26 @@ void vtkDiscreteRemeshing<Metric>::AdjustRemeshedGeometry()
     Points->Delete();
 }
 
-template <class Metric>
-void vtkDiscreteRemeshing<Metric>::OptimizeOutputEdges()
+template <class Metric, class Derived>
+void vtkDiscreteRemeshing<Metric, Derived>::OptimizeOutputEdges()
 {
 }
 
-template <class Metric>
-vtkDiscreteRemeshing<Metric>::vtkDiscreteRemeshing()
+template <class Metric, class Derived>
+vtkDiscreteRemeshing<Metric, Derived>::vtkDiscreteRemeshing()
 {
     this->BoundaryFixingFlag = 0;
     this->EdgeOptimizationFlag = 0;
     this->OriginalInput = 0;
     this->VerticesParent1 = 0;
     this->VerticesParent2 = 0;
+    this->FacesParent = 0;
+    this->AdaptiveSubsamplingFlag = 0;
+    this->InputReordering = vtkSurface::NO_REORDERING;
+    this->InputPermutation = 0;
+    this->InputPermutationOrder = vtkSurface::NO_REORDERING;
+    this->UnreorderedInput = 0;
+    this->InputCurvature = 0;
     this->SubsamplingThreshold = 10;
     this->NumberOfSubdivisionsBeforeClustering = 0;
     this->MaxCustomDensity = 1;
@@ -812,8 +1291,8 @@ vtkDiscreteRemeshing<Metric>::vtkDiscreteRemeshing()
     this->ForceManifold = false;
 }
 
-template <class Metric>
-vtkDiscreteRemeshing<Metric>::~vtkDiscreteRemeshing()
+template <class Metric, class Derived>
+vtkDiscreteRemeshing<Metric, Derived>::~vtkDiscreteRemeshing()
 {
     if (this->OriginalInput)
         this->OriginalInput->Delete();
@@ -826,4 +1305,15 @@ vtkDiscreteRemeshing<Metric>::~vtkDiscreteRemeshing()
 
     if (this->VerticesParent2)
         this->VerticesParent2->Delete();
+
+    if (this->FacesParent)
+        this->FacesParent->Delete();
+
+    if (this->InputPermutation)
+        this->InputPermutation->Delete();
+
+    if (this->UnreorderedInput)
+        this->UnreorderedInput->UnRegister(this);
+
+    this->SetInputCurvature(0);
 }
@@ -33,6 +33,8 @@ Auteur:    Sebastien VALETTE
 
 #include <vtkDataArrayCollection.h>
 #include <vtkTriangle.h>
+#include "vtkItemReal.h"
+#include "vtkParallelFor.h"
 #include "vtkSurface.h"
 
 class vtkIsotropicMetricForClustering
@@ -72,8 +74,8 @@ public:
     double GetGradation() { return this->Gradation; }
 
     struct Item {
-        double Value[3];
-        double Weight;
+        vtkItemReal Value[3];
+        vtkItemReal Weight;
     };
 
     void ResetItem(Item* I)
@@ -197,8 +199,10 @@ public:
         Cluster*& Clusters,
         vtkSurface* Mesh,
         vtkIdType NumberOfClusters,
-        int ClusteringType)
+        int ClusteringType,
+        int NumberOfThreads = 0)
     {
+        typedef vtkIsotropicMetricForClustering Self;
         vtkIdType i;
         // Build the clusters
         Clusters = new Cluster[NumberOfClusters];
@@ -207,72 +211,146 @@ public:
         }
 
         // Build the items
+        vtkIdType NumberOfItems;
         if (ClusteringType == 0) {
             // Items are triangles
-            vtkIdType v1, v2, v3;
-            double P1[3], P2[3], P3[3];
-            Items = new Item[Mesh->GetNumberOfCells()];
-            for (i = 0; i < Mesh->GetNumberOfCells(); i++) {
-                Mesh->GetFaceVertices(i, v1, v2, v3);
-                Mesh->GetPoint(v1, P1);
-                Mesh->GetPoint(v2, P2);
-                Mesh->GetPoint(v3, P3);
-                if (CustomWeights == 0)
-                    Items[i].Weight = vtkTriangle::TriangleArea(P1, P2, P3);
-                else
-                    Items[i].Weight =
-                        vtkTriangle::TriangleArea(P1, P2, P3) *
-                        pow(CustomWeights->GetValue(i), Gradation);
-                Items[i].Value[0] = (P1[0] + P2[0] + P3[0]) / 3.0;
-                Items[i].Value[1] = (P1[1] + P2[1] + P3[1]) / 3.0;
-                Items[i].Value[2] = (P1[2] + P2[2] + P3[2]) / 3.0;
-            }
-            this->ClampWeights(Items, Mesh->GetNumberOfCells(), 100000);
-            for (i = 0; i < Mesh->GetNumberOfCells(); i++) {
-                Items[i].Value[0] *= Items[i].Weight;
-                Items[i].Value[1] *= Items[i].Weight;
-                Items[i].Value[2] *= Items[i].Weight;
-            }
+            NumberOfItems = Mesh->GetNumberOfCells();
+            this->Items = new Item[NumberOfItems];
+
+            struct TrianglesBuilding
+            {
+                Self* Metric;
+                vtkSurface* Mesh;
+
+                void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+                {
+                    Item* Items = this->Metric->Items;
+                    vtkDoubleArray* Weights = this->Metric->CustomWeights;
+                    vtkIdType v1, v2, v3;
+                    double P1[3], P2[3], P3[3];
+                    for (vtkIdType i = Begin; i < End; i++) {
+                        this->Mesh->GetFaceVertices(i, v1, v2, v3);
+                        this->Mesh->GetPoint(v1, P1);
+                        this->Mesh->GetPoint(v2, P2);
+                        this->Mesh->GetPoint(v3, P3);
+                        double Area = vtkTriangle::TriangleArea(P1, P2, P3);
+                        if (Weights == 0)
+                            Items[i].Weight = Area;
+                        else
+                            Items[i].Weight = Area *
+                                pow(Weights->GetValue(i),
+                                    this->Metric->Gradation);
+                        Items[i].Value[0] = (P1[0] + P2[0] + P3[0]) / 3.0;
+                        Items[i].Value[1] = (P1[1] + P2[1] + P3[1]) / 3.0;
+                        Items[i].Value[2] = (P1[2] + P2[2] + P3[2]) / 3.0;
+                    }
+                }
+            };
+
+            TrianglesBuilding BuildTriangles;
+            BuildTriangles.Metric = this;
+            BuildTriangles.Mesh = Mesh;
+            vtkParallelFor::Execute(
+                NumberOfItems, BuildTriangles, NumberOfThreads);
         } else {
             // Items are vertices
-            Items = new Item[Mesh->GetNumberOfPoints()];
-            vtkDoubleArray* VerticesAreas = Mesh->GetVerticesAreas();
-            for (i = 0; i < Mesh->GetNumberOfPoints(); i++) {
-                if (CustomWeights == 0)
-                    Items[i].Weight = VerticesAreas->GetValue(i);
-                else
-                    Items[i].Weight =
-                        VerticesAreas->GetValue(i) *
-                        pow(CustomWeights->GetValue(i), Gradation);
-
-                Mesh->GetPoint(i, Items[i].Value);
-            }
-            this->ClampWeights(Items, Mesh->GetNumberOfPoints(), 100000);
-            for (i = 0; i < Mesh->GetNumberOfPoints(); i++) {
-                Items[i].Value[0] *= Items[i].Weight;
-                Items[i].Value[1] *= Items[i].Weight;
-                Items[i].Value[2] *= Items[i].Weight;
-            }
+            NumberOfItems = Mesh->GetNumberOfPoints();
+            this->Items = new Item[NumberOfItems];
+
+            struct VerticesBuilding
+            {
+                Self* Metric;
+                vtkSurface* Mesh;
+                double* VerticesAreas;
+
+                void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+                {
+                    Item* Items = this->Metric->Items;
+                    vtkDoubleArray* Weights = this->Metric->CustomWeights;
+                    double P[3];
+                    for (vtkIdType i = Begin; i < End; i++) {
+                        if (Weights == 0)
+                            Items[i].Weight = this->VerticesAreas[i];
+                        else
+                            Items[i].Weight = this->VerticesAreas[i] *
+                                pow(Weights->GetValue(i),
+                                    this->Metric->Gradation);
+
+                        this->Mesh->GetPoint(i, P);
+                        Items[i].Value[0] = P[0];
+                        Items[i].Value[1] = P[1];
+                        Items[i].Value[2] = P[2];
+                    }
+                }
+            };
+
+            VerticesBuilding BuildVertices;
+            BuildVertices.Metric = this;
+            BuildVertices.Mesh = Mesh;
+            BuildVertices.VerticesAreas =
+                Mesh->GetVerticesAreas(NumberOfThreads)->GetPointer(0);
+            vtkParallelFor::Execute(
+                NumberOfItems, BuildVertices, NumberOfThreads);
         }
+
+        this->ClampWeights(this->Items, NumberOfItems, 100000, NumberOfThreads);
+
+        struct Weighting
+        {
+            Item* Items;
+
+            void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+            {
+                for (vtkIdType i = Begin; i < End; i++) {
+                    this->Items[i].Value[0] *= this->Items[i].Weight;
+                    this->Items[i].Value[1] *= this->Items[i].Weight;
+                    this->Items[i].Value[2] *= this->Items[i].Weight;
+                }
+            }
+        };
+
+        Weighting Weight;
+        Weight.Items = this->Items;
+        vtkParallelFor::Execute(NumberOfItems, Weight, NumberOfThreads);
     }
     // this method clamps the weights between AverageValue/Ratio and
-    // AverageValue*Ratio
-    static void ClampWeights(Item* Items, int NumberOfValues, double Ratio)
+    // AverageValue*Ratio. The average is summed sequentially so that it does
+    // not depend on the number of threads
+    static void ClampWeights(
+        Item* Items,
+        vtkIdType NumberOfValues,
+        double Ratio,
+        int NumberOfThreads = 0)
     {
         double Average = 0;
-        int i;
+        vtkIdType i;
         for (i = 0; i < NumberOfValues; i++) {
             Average += Items[i].Weight;
         }
         Average = Average / (double)NumberOfValues;
-        double Min = Average / Ratio;
-        double Max = Average * Ratio;
-        for (i = 0; i < NumberOfValues; i++) {
-            if (Items[i].Weight > Max)
-                Items[i].Weight = Max;
-            if (Items[i].Weight < Min)
-                Items[i].Weight = Min;
-        }
+
+        struct Clamping
+        {
+            Item* Items;
+            double Min;
+            double Max;
+
+            void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+            {
+                for (vtkIdType j = Begin; j < End; j++) {
+                    if (this->Items[j].Weight > this->Max)
+                        this->Items[j].Weight = this->Max;
+                    if (this->Items[j].Weight < this->Min)
+                        this->Items[j].Weight = this->Min;
+                }
+            }
+        };
+
+        Clamping Clamp;
+        Clamp.Items = Items;
+        Clamp.Min = Average / Ratio;
+        Clamp.Max = Average * Ratio;
+        vtkParallelFor::Execute(NumberOfValues, Clamp, NumberOfThreads);
     }
 
 private:
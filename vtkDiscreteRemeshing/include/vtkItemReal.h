@@ -0,0 +1,48 @@
+/*=========================================================================
+
+  Program:   Precision of the items of the clustering metrics
+  Module:    vtkItemReal.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#ifndef _VTKITEMREAL_H_
+#define _VTKITEMREAL_H_
+
+/// Type of the values stored in the items of the clustering metrics.
+/// Items outnumber clusters by one or two orders of magnitude, so that
+/// storing them in single precision (DOfloatItems, set by the
+/// USE_FLOAT_ITEMS CMake option) roughly halves the memory used by the
+/// metrics. Item values are computed in double precision before being
+/// stored, and the cluster sums, centroids and energies remain in double
+/// precision in both modes.
+#ifdef DOfloatItems
+typedef float vtkItemReal;
+#else
+typedef double vtkItemReal;
+#endif
+
+#endif
@@ -31,9 +31,13 @@ Auteur:    Sebastien VALETTE
 *  knowledge of the CeCILL-B license and that you accept its terms.
 * ------------------------------------------------------------------------ */
 
+#include <vtkDataArrayCollection.h>
 #include <vtkIdList.h>
 #include <vtkMath.h>
 #include <vtkTriangle.h>
+#include "vtkFaceQuantities.h"
+#include "vtkItemReal.h"
+#include "vtkParallelFor.h"
 #include "vtkSurface.h"
 
 // This metric is defined in the paper "Variationnal shape Approximation",
@@ -42,11 +46,35 @@ Auteur:    Sebastien VALETTE
 class vtkL21MetricForClustering
 {
 public:
-    int IsCurvatureIndicatorNeeded() { return (0); }
+    // this method is empty as there is no constraint for this metric
+    void SetConstrainedClustering(int C) {}
 
-    void SetCustomWeights(vtkDoubleArray* Weights)
+    void MultiplyItemWeight(vtkIdType ItemId, double Factor)
     {
-        this->CustomWeights = Weights;
+        for (int i = 0; i < 3; i++) {
+            this->Items[ItemId].Value[i] *= Factor;
+            this->Items[ItemId].Normal[i] *= Factor;
+        }
+        this->Items[ItemId].Weight *= Factor;
+    }
+
+    int IsCurvatureIndicatorNeeded()
+    {
+        if (this->Gradation > 0) {
+            return 1;
+        } else {
+            return 0;
+        }
+    }
+
+    int IsPrincipalDirectionsNeeded() { return 0; }
+
+    void SetCurvatureInfo(vtkDataArrayCollection* Info)
+    {
+        if (this->CustomWeights)
+            this->CustomWeights->Delete();
+        this->CustomWeights = (vtkDoubleArray*)Info->GetItem(0);
+        this->CustomWeights->Register(this->Object);
     }
 
     void SetGradation(double Gradation) { this->Gradation = Gradation; }
@@ -56,13 +84,13 @@ public:
     // each item is represented by a quadric matrix
     struct Item {
         // the item normal vector, wheighted by its area
-        double Normal[3];
+        vtkItemReal Normal[3];
 
         // the barycenter (multiplied by its weight)
-        double Value[3];
+        vtkItemReal Value[3];
 
         // the weight
-        double Weight;
+        vtkItemReal Weight;
     };
 
     void ResetItem(Item* I)
@@ -75,7 +103,10 @@ public:
         I->Weight = 0;
     }
 
-    double GetItemWeight(Item* I) { return I->Weight; }
+    double GetItemWeight(vtkIdType ItemId)
+    {
+        return this->Items[ItemId].Weight;
+    }
 
     struct Cluster {
         // Value of the energy term for this cluster (cached to increase speed
@@ -92,7 +123,9 @@ public:
         double SWeight;
     };
 
-    double GetClusterEnergy(Cluster* C)
+    double GetClusterEnergy(Cluster* C) { return C->EnergyValue; }
+
+    void ComputeClusterEnergy(Cluster* C)
     {
         C->EnergyValue =
             (-C->SNormal[0] * C->SNormal[0] - C->SNormal[1] * C->SNormal[1] -
@@ -101,12 +134,9 @@ public:
                  (C->SValue[0] * C->SValue[0] + C->SValue[1] * C->SValue[1] +
                   C->SValue[2] * C->SValue[2])) /
             C->SWeight;
-
-        return C->EnergyValue;
     }
 
     int GetClusterRankDeficiency(Cluster* C) { return (0); }
-    void ComputeClusterEnergy(Cluster* C) {}
 
     double ComputeDistanceBetweenItemAndCluster(Item* I, Cluster* C)
     {
@@ -147,8 +177,15 @@ public:
         Destination->EnergyValue = Source->EnergyValue;
     }
 
-    void AddItemToCluster(Item* I, Cluster* C)
+    void Add(Cluster* Source, vtkIdType ItemId, Cluster* Destination)
+    {
+        this->DeepCopy(Source, Destination);
+        this->AddItemToCluster(ItemId, Destination);
+    }
+
+    void AddItemToCluster(vtkIdType ItemId, Cluster* C)
     {
+        Item* I = &this->Items[ItemId];
         int i;
         for (i = 0; i < 3; i++) {
             C->SValue[i] += I->Value[i];
@@ -157,8 +194,15 @@ public:
         C->SWeight += I->Weight;
     }
 
-    void SubstractItemFromCluster(Item* I, Cluster* C)
+    void Sub(Cluster* Source, vtkIdType ItemId, Cluster* Destination)
     {
+        this->DeepCopy(Source, Destination);
+        this->SubstractItemFromCluster(ItemId, Destination);
+    }
+
+    void SubstractItemFromCluster(vtkIdType ItemId, Cluster* C)
+    {
+        Item* I = &this->Items[ItemId];
         int i;
         for (i = 0; i < 3; i++) {
             C->SValue[i] -= I->Value[i];
@@ -190,19 +234,29 @@ public:
     {
         this->CustomWeights = 0;
         this->Gradation = 0;
+        this->Object = vtkObject::New();
+        this->Items = 0;
+    }
+
+    ~vtkL21MetricForClustering()
+    {
+        this->Object->Delete();
+        if (this->CustomWeights)
+            this->CustomWeights->Delete();
+        if (this->Items)
+            delete[] this->Items;
     }
-    ~vtkL21MetricForClustering() {}
 
     void BuildMetric(
-        Item*& Items,
         Cluster*& Clusters,
         vtkSurface* Mesh,
-        int NumberOfClusters,
-        int ClusteringType)
+        vtkIdType NumberOfClusters,
+        int ClusteringType,
+        int NumberOfThreads = 0)
     {
-        vtkIdType i, j;
-        vtkIdType v1, v2, v3;
-        double P1[3], P2[3], P3[3];
+        typedef vtkL21MetricForClustering Self;
+        vtkIdType i;
+        double P1[3], P2[3];
 
         // Build the clusters
         Clusters = new Cluster[NumberOfClusters];
@@ -226,98 +280,187 @@ public:
 
         Factor = 0;  // 0.0001/vtkMath::Distance2BetweenPoints(P1,P2);
 
+        vtkIdType NumberOfItems;
         if (ClusteringType == 0) {
             // Items are triangles
-            Items = new Item[Mesh->GetNumberOfCells()];
-            for (i = 0; i < Mesh->GetNumberOfCells(); i++) {
-                this->ResetItem(Items + i);
-                Mesh->GetFaceVertices(i, v1, v2, v3);
-                Mesh->GetPoint(v1, P1);
-                Mesh->GetPoint(v2, P2);
-                Mesh->GetPoint(v3, P3);
-                if (CustomWeights == 0)
-                    Items[i].Weight = vtkTriangle::TriangleArea(P1, P2, P3);
-                else
-                    Items[i].Weight =
-                        vtkTriangle::TriangleArea(P1, P2, P3) *
-                        pow(CustomWeights->GetValue(i), Gradation);
-                Items[i].Value[0] = (P1[0] + P2[0] + P3[0]) / 3.0;
-                Items[i].Value[1] = (P1[1] + P2[1] + P3[1]) / 3.0;
-                Items[i].Value[2] = (P1[2] + P2[2] + P3[2]) / 3.0;
-
-                vtkTriangle::ComputeNormal(P1, P2, P3, Items[i].Normal);
-            }
-            this->ClampWeights(Items, Mesh->GetNumberOfCells(), 10000);
-            for (i = 0; i < Mesh->GetNumberOfCells(); i++) {
-                for (j = 0; j < 3; j++) {
-                    Items[i].Value[j] *= Items[i].Weight;
-                    Items[i].Normal[j] *= Items[i].Weight;
+            NumberOfItems = Mesh->GetNumberOfCells();
+            this->Items = new Item[NumberOfItems];
+
+            struct TrianglesBuilding
+            {
+                Self* Metric;
+                vtkSurface* Mesh;
+
+                void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+                {
+                    Item* Items = this->Metric->Items;
+                    vtkDoubleArray* Weights = this->Metric->CustomWeights;
+                    vtkIdType v1, v2, v3;
+                    double P1[3], P2[3], P3[3], N[3];
+                    for (vtkIdType i = Begin; i < End; i++) {
+                        this->Metric->ResetItem(Items + i);
+                        this->Mesh->GetFaceVertices(i, v1, v2, v3);
+                        this->Mesh->GetPoint(v1, P1);
+                        this->Mesh->GetPoint(v2, P2);
+                        this->Mesh->GetPoint(v3, P3);
+                        double Area = vtkTriangle::TriangleArea(P1, P2, P3);
+                        if (Weights == 0)
+                            Items[i].Weight = Area;
+                        else
+                            Items[i].Weight = Area *
+                                pow(Weights->GetValue(i),
+                                    this->Metric->Gradation);
+                        Items[i].Value[0] = (P1[0] + P2[0] + P3[0]) / 3.0;
+                        Items[i].Value[1] = (P1[1] + P2[1] + P3[1]) / 3.0;
+                        Items[i].Value[2] = (P1[2] + P2[2] + P3[2]) / 3.0;
+
+                        vtkTriangle::ComputeNormal(P1, P2, P3, N);
+                        Items[i].Normal[0] = N[0];
+                        Items[i].Normal[1] = N[1];
+                        Items[i].Normal[2] = N[2];
+                    }
                 }
-            }
+            };
+
+            TrianglesBuilding BuildTriangles;
+            BuildTriangles.Metric = this;
+            BuildTriangles.Mesh = Mesh;
+            vtkParallelFor::Execute(
+                NumberOfItems, BuildTriangles, NumberOfThreads);
         } else {
             // Items are vertices
-            vtkIdList* FList = vtkIdList::New();
-            double N[3];
-
-            Items = new Item[Mesh->GetNumberOfPoints()];
-            vtkDoubleArray* VerticesAreas = Mesh->GetVerticesAreas();
-            for (i = 0; i < Mesh->GetNumberOfPoints(); i++) {
-                this->ResetItem(Items + i);
-
-                if (CustomWeights == 0)
-                    Items[i].Weight = VerticesAreas->GetValue(i);
-                else
-                    Items[i].Weight =
-                        VerticesAreas->GetValue(i) *
-                        pow(CustomWeights->GetValue(i), Gradation);
-
-                Mesh->GetVertexNeighbourFaces(i, FList);
-                Mesh->GetPointCoordinates(i, Items[i].Value);
-                for (j = 0; j < FList->GetNumberOfIds(); j++) {
-                    Mesh->GetFaceVertices(FList->GetId(j), v1, v2, v3);
-                    Mesh->GetPoint(v1, P1);
-                    Mesh->GetPoint(v2, P2);
-                    Mesh->GetPoint(v3, P3);
-                    double TriangleArea = vtkTriangle::TriangleArea(P1, P2, P3);
-                    vtkTriangle::ComputeNormalDirection(P1, P2, P3, N);
-                    Items[i].Normal[0] += N[0] * TriangleArea;
-                    Items[i].Normal[1] += N[1] * TriangleArea;
-                    Items[i].Normal[2] += N[2] * TriangleArea;
+            NumberOfItems = Mesh->GetNumberOfPoints();
+            this->Items = new Item[NumberOfItems];
+            vtkFaceQuantities Faces;
+            Faces.Compute(Mesh, true, false, NumberOfThreads);
+
+            struct VerticesBuilding
+            {
+                Self* Metric;
+                vtkSurface* Mesh;
+                double* VerticesAreas;
+                vtkFaceQuantities* Faces;
+
+                void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+                {
+                    Item* Items = this->Metric->Items;
+                    vtkDoubleArray* Weights = this->Metric->CustomWeights;
+                    vtkIdList* FList = vtkIdList::New();
+                    double P[3], Normal[3];
+                    for (vtkIdType i = Begin; i < End; i++) {
+                        this->Metric->ResetItem(Items + i);
+
+                        if (Weights == 0)
+                            Items[i].Weight = this->VerticesAreas[i];
+                        else
+                            Items[i].Weight = this->VerticesAreas[i] *
+                                pow(Weights->GetValue(i),
+                                    this->Metric->Gradation);
+
+                        // the face normals are weighted by their squared
+                        // areas, i.e. their non-normalized normals weighted
+                        // by their areas, up to a factor 2
+                        this->Mesh->GetVertexNeighbourFaces(i, FList);
+                        this->Mesh->GetPointCoordinates(i, P);
+                        Normal[0] = Normal[1] = Normal[2] = 0;
+                        for (vtkIdType j = 0; j < FList->GetNumberOfIds();
+                             j++) {
+                            vtkIdType Face = FList->GetId(j);
+                            double Area = this->Faces->GetArea(Face);
+                            double* N = this->Faces->GetNormal(Face);
+                            Normal[0] += N[0] * Area * Area;
+                            Normal[1] += N[1] * Area * Area;
+                            Normal[2] += N[2] * Area * Area;
+                        }
+                        vtkMath::Normalize(Normal);
+                        for (int j = 0; j < 3; j++) {
+                            Items[i].Value[j] = P[j];
+                            Items[i].Normal[j] = Normal[j];
+                        }
+                    }
+                    FList->Delete();
                 }
-                vtkMath::Normalize(Items[i].Normal);
-            }
-            FList->Delete();
-            this->ClampWeights(Items, Mesh->GetNumberOfPoints(), 10000);
-            for (i = 0; i < Mesh->GetNumberOfPoints(); i++) {
-                for (j = 0; j < 3; j++) {
-                    Items[i].Value[j] *= Items[i].Weight;
-                    Items[i].Normal[j] *= Items[i].Weight;
+            };
+
+            VerticesBuilding BuildVertices;
+            BuildVertices.Metric = this;
+            BuildVertices.Mesh = Mesh;
+            BuildVertices.VerticesAreas =
+                Mesh->GetVerticesAreas(NumberOfThreads)->GetPointer(0);
+            BuildVertices.Faces = &Faces;
+            vtkParallelFor::Execute(
+                NumberOfItems, BuildVertices, NumberOfThreads);
+        }
+
+        this->ClampWeights(this->Items, NumberOfItems, 10000, NumberOfThreads);
+
+        struct Weighting
+        {
+            Item* Items;
+
+            void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+            {
+                for (vtkIdType i = Begin; i < End; i++) {
+                    for (int j = 0; j < 3; j++) {
+                        this->Items[i].Value[j] *= this->Items[i].Weight;
+                        this->Items[i].Normal[j] *= this->Items[i].Weight;
+                    }
                 }
             }
-        }
+        };
+
+        Weighting Weight;
+        Weight.Items = this->Items;
+        vtkParallelFor::Execute(NumberOfItems, Weight, NumberOfThreads);
     }
     // this method clamps the weights between AverageValue/Ratio and
-    // AverageValue*Ratio
-    void ClampWeights(Item* Items, int NumberOfValues, double Ratio)
+    // AverageValue*Ratio. The average is summed sequentially so that it does
+    // not depend on the number of threads
+    void ClampWeights(
+        Item* Items,
+        vtkIdType NumberOfValues,
+        double Ratio,
+        int NumberOfThreads = 0)
     {
         double Average = 0;
-        int i;
+        vtkIdType i;
         for (i = 0; i < NumberOfValues; i++) {
             Average += Items[i].Weight;
         }
         Average = Average / (double)NumberOfValues;
-        double Min = Average / Ratio;
-        double Max = Average * Ratio;
-        for (i = 0; i < NumberOfValues; i++) {
-            if (Items[i].Weight > Max)
-                Items[i].Weight = Max;
-            if (Items[i].Weight < Min)
-                Items[i].Weight = Min;
-        }
+
+        struct Clamping
+        {
+            Item* Items;
+            double Min;
+            double Max;
+
+            void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+            {
+                for (vtkIdType j = Begin; j < End; j++) {
+                    if (this->Items[j].Weight > this->Max)
+                        this->Items[j].Weight = this->Max;
+                    if (this->Items[j].Weight < this->Min)
+                        this->Items[j].Weight = this->Min;
+                }
+            }
+        };
+
+        Clamping Clamp;
+        Clamp.Items = Items;
+        Clamp.Min = Average / Ratio;
+        Clamp.Max = Average * Ratio;
+        vtkParallelFor::Execute(NumberOfValues, Clamp, NumberOfThreads);
     }
 
 private:
     vtkDoubleArray* CustomWeights;
+
+    // Dummy object used for registering the curvature indicators
+    vtkObject* Object;
     double Factor;
     double Gradation;
+
+    // The array storing items
+    Item* Items;
 };
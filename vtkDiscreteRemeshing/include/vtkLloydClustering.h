@@ -40,8 +40,9 @@ class STDPriorityQueue;
 // typedef vtkPriorityQueue MyPriorityQueue;
 typedef STDPriorityQueue MyPriorityQueue;
 
-template <class Metric>
-class vtkLloydClustering : public vtkUniformClustering<Metric>
+template <class Metric, class Derived = void>
+class vtkLloydClustering
+    : public vtkUniformClustering<Metric, vtkIdType, Derived>
 {
 protected:
     virtual int ProcessOneLoop();
@@ -105,10 +106,10 @@ protected:
     ~vtkLloydClustering();
 };
 
-template <class Metric>
-void vtkLloydClustering<Metric>::PushItemRing(int Item)
+template <class Metric, class Derived>
+void vtkLloydClustering<Metric, Derived>::PushItemRing(int Item)
 {
-    int I1, I2;
+    vtkIdType I1, I2;
     int Edge;
     double P1[3], P2[3];
 
@@ -120,7 +121,7 @@ void vtkLloydClustering<Metric>::PushItemRing(int Item)
     int i;
     for (i = 0; i < EList->GetNumberOfIds(); i++) {
         Edge = EList->GetId(i);
-        this->GetEdgeItems(Edge, I1, I2);
+        this->DispatchGetEdgeItems(Edge, I1, I2);
         if (I2 == Item) {
             I2 = I1;
         }
@@ -135,8 +136,8 @@ void vtkLloydClustering<Metric>::PushItemRing(int Item)
     EList->Delete();
 }
 
-template <class Metric>
-int vtkLloydClustering<Metric>::ProcessOneLoop()
+template <class Metric, class Derived>
+int vtkLloydClustering<Metric, Derived>::ProcessOneLoop()
 {
     int Item;
     int Cluster;
@@ -179,11 +180,11 @@ int vtkLloydClustering<Metric>::ProcessOneLoop()
     }
 
     // create the Voronoi diagram with the priority queue
-    int TempItem;
+    vtkIdType TempItem;
     while (this->PriorityQueue->GetNumberOfItems()) {
-        int I1, I2;
+        vtkIdType I1, I2;
         Edge = this->PriorityQueue->Pop();
-        this->GetEdgeItems(Edge, I1, I2);
+        this->DispatchGetEdgeItems(Edge, I1, I2);
         if (this->ItemsLastVisitTime->GetValue(I2) == this->NumberOfLoops) {
             TempItem = I1;
             I1 = I2;
@@ -209,10 +210,10 @@ int vtkLloydClustering<Metric>::ProcessOneLoop()
     return (NumberOfModifications);
 }
 
-template <class Metric>
-void vtkLloydClustering<Metric>::Init()
+template <class Metric, class Derived>
+void vtkLloydClustering<Metric, Derived>::Init()
 {
-    vtkUniformClustering<Metric>::Init();
+    vtkUniformClustering<Metric, vtkIdType, Derived>::Init();
     this->ClustersClosestItemDistance->SetNumberOfValues(
         this->NumberOfClusters);
     this->ClustersClosestItem->SetNumberOfValues(this->NumberOfClusters);
@@ -225,8 +226,8 @@ void vtkLloydClustering<Metric>::Init()
     this->PriorityQueue->Allocate(2 * this->GetNumberOfEdges());
 }
 
-template <class Metric>
-vtkLloydClustering<Metric>::vtkLloydClustering()
+template <class Metric, class Derived>
+vtkLloydClustering<Metric, Derived>::vtkLloydClustering()
 {
     this->ItemsLastVisitTime = vtkIntArray::New();
     this->ClustersClosestItem = vtkIntArray::New();
@@ -234,8 +235,8 @@ vtkLloydClustering<Metric>::vtkLloydClustering()
     this->PriorityQueue = LloydPriorityQueue::New();
 }
 
-template <class Metric>
-vtkLloydClustering<Metric>::~vtkLloydClustering()
+template <class Metric, class Derived>
+vtkLloydClustering<Metric, Derived>::~vtkLloydClustering()
 {
     this->ItemsLastVisitTime->Delete();
     this->ClustersClosestItem->Delete();
@@ -40,6 +40,9 @@ Auteur:    Sebastien VALETTE
 #include <vtkDataArrayCollection.h>
 #include <vtkMath.h>
 #include <vtkTriangle.h>
+#include "vtkFaceQuantities.h"
+#include "vtkItemReal.h"
+#include "vtkParallelFor.h"
 #include "vtkSurface.h"
 
 #include "vtkQuadricTools.h"
@@ -90,13 +93,13 @@ public:
     // each item is represented by a quadric matrix
     struct Item {
         // the 4x4 quadric in compact form, without the 10th useless coefficient
-        double Quadric[9];
+        vtkItemReal Quadric[9];
 
         // the barycenter (multiplied by its weight)
-        double Value[3];
+        vtkItemReal Value[3];
 
         // the weight
-        double Weight;
+        vtkItemReal Weight;
     };
 
     struct Cluster {
@@ -137,30 +140,34 @@ public:
         return this->Items[ItemId].Weight;
     }
 
+    // the quadric of a vertex is gathered from the precomputed quadrics of
+    // its adjacent faces. FList is a work list
     void ComputeVertexQuadric(
-        Item* I, vtkSurface* Mesh, int Vertex, double Weight)
+        Item* I,
+        vtkSurface* Mesh,
+        vtkIdType Vertex,
+        double Weight,
+        vtkFaceQuantities& Faces,
+        vtkIdList* FList)
     {
-        this->ResetItem(I);
-        int i;
-        vtkIdList* FList = vtkIdList::New();
-        Mesh->GetVertexNeighbourFaces(Vertex, FList);
+        double Quadric[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+        Faces.AddVertexQuadric(Mesh, Vertex, FList, Quadric);
 
-        for (i = 0; i < FList->GetNumberOfIds(); i++)
-            vtkQuadricTools::AddTriangleQuadric(
-                I->Quadric, Mesh, FList->GetId(i), false);
-
-        Mesh->GetPoint(Vertex, I->Value);
+        double Value[3];
+        Mesh->GetPoint(Vertex, Value);
+        int i;
+        for (i = 0; i < 9; i++)
+            I->Quadric[i] = Quadric[i];
         for (i = 0; i < 3; i++)
-            I->Value[i] = I->Value[i] * Weight;
+            I->Value[i] = Value[i] * Weight;
         I->Weight = Weight;
-        FList->Delete();
     }
 
     void ComputeTriangleQuadric(
-        Item* I, vtkSurface* Mesh, int Face, double Weight)
+        Item* I, vtkSurface* Mesh, vtkIdType Face, double Weight)
     {
-        this->ResetItem(I);
-        vtkQuadricTools::AddTriangleQuadric(I->Quadric, Mesh, Face, false);
+        double Quadric[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+        vtkQuadricTools::AddTriangleQuadric(Quadric, Mesh, Face, false);
 
         double x1[3], x2[3], x3[3];
         vtkIdType V1, V2, V3;
@@ -169,6 +176,8 @@ public:
         Mesh->GetPointCoordinates(V2, x2);
         Mesh->GetPointCoordinates(V3, x3);
         int i;
+        for (i = 0; i < 9; i++)
+            I->Quadric[i] = Quadric[i];
         for (i = 0; i < 3; i++) {
             I->Value[i] = Weight * (x1[i] + x2[i] + x3[i]) / 3.0;
         }
@@ -274,73 +283,178 @@ public:
         Cluster*& Clusters,
         vtkSurface* Mesh,
         vtkIdType NumberOfClusters,
-        int ClusteringType)
+        int ClusteringType,
+        int NumberOfThreads = 0)
     {
+        typedef vtkQEMetricForClustering Self;
         vtkIdType i;
         // Build the clusters
         Clusters = new Cluster[NumberOfClusters];
         for (i = 0; i < NumberOfClusters; i++)
             this->ResetCluster(Clusters + i);
 
+        vtkIdType NumberOfItems;
         if (ClusteringType == 0) {
             // Items are triangles
-            vtkIdType v1, v2, v3;
-            double P1[3], P2[3], P3[3];
-            Items = new Item[Mesh->GetNumberOfCells()];
-            for (i = 0; i < Mesh->GetNumberOfCells(); i++) {
-                Mesh->GetFaceVertices(i, v1, v2, v3);
-                Mesh->GetPoint(v1, P1);
-                Mesh->GetPoint(v2, P2);
-                Mesh->GetPoint(v3, P3);
-                if (Gradation == 0)
-                    Items[i].Weight = vtkTriangle::TriangleArea(P1, P2, P3);
-                else
-                    Items[i].Weight =
-                        vtkTriangle::TriangleArea(P1, P2, P3) *
-                        pow(CustomWeights->GetValue(i), Gradation);
-            }
-            this->ClampWeights(Items, Mesh->GetNumberOfCells(), 10000);
-            for (i = 0; i < Mesh->GetNumberOfCells(); i++) {
-                this->ComputeTriangleQuadric(
-                    Items + i, Mesh, i, Items[i].Weight);
-            }
+            NumberOfItems = Mesh->GetNumberOfCells();
+            this->Items = new Item[NumberOfItems];
+
+            struct TrianglesWeighting
+            {
+                Self* Metric;
+                vtkSurface* Mesh;
+
+                void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+                {
+                    Item* Items = this->Metric->Items;
+                    vtkDoubleArray* Weights = this->Metric->CustomWeights;
+                    double Gradation = this->Metric->Gradation;
+                    vtkIdType v1, v2, v3;
+                    double P1[3], P2[3], P3[3];
+                    for (vtkIdType i = Begin; i < End; i++) {
+                        this->Mesh->GetFaceVertices(i, v1, v2, v3);
+                        this->Mesh->GetPoint(v1, P1);
+                        this->Mesh->GetPoint(v2, P2);
+                        this->Mesh->GetPoint(v3, P3);
+                        double Area = vtkTriangle::TriangleArea(P1, P2, P3);
+                        if (Gradation == 0)
+                            Items[i].Weight = Area;
+                        else
+                            Items[i].Weight =
+                                Area * pow(Weights->GetValue(i), Gradation);
+                    }
+                }
+            };
+
+            TrianglesWeighting WeightTriangles;
+            WeightTriangles.Metric = this;
+            WeightTriangles.Mesh = Mesh;
+            vtkParallelFor::Execute(
+                NumberOfItems, WeightTriangles, NumberOfThreads);
+            this->ClampWeights(
+                this->Items, NumberOfItems, 10000, NumberOfThreads);
+
+            struct TrianglesBuilding
+            {
+                Self* Metric;
+                vtkSurface* Mesh;
+
+                void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+                {
+                    Item* Items = this->Metric->Items;
+                    for (vtkIdType i = Begin; i < End; i++)
+                        this->Metric->ComputeTriangleQuadric(
+                            Items + i, this->Mesh, i, Items[i].Weight);
+                }
+            };
+
+            TrianglesBuilding BuildTriangles;
+            BuildTriangles.Metric = this;
+            BuildTriangles.Mesh = Mesh;
+            vtkParallelFor::Execute(
+                NumberOfItems, BuildTriangles, NumberOfThreads);
 
         } else {
             // Items are vertices
-            Items = new Item[Mesh->GetNumberOfPoints()];
-            vtkDoubleArray* VerticesAreas = Mesh->GetVerticesAreas();
-            for (i = 0; i < Mesh->GetNumberOfPoints(); i++) {
-                if (Gradation == 0)
-                    Items[i].Weight = VerticesAreas->GetValue(i);
-                else
-                    Items[i].Weight =
-                        VerticesAreas->GetValue(i) *
-                        pow(CustomWeights->GetValue(i), Gradation);
-            }
-            this->ClampWeights(Items, Mesh->GetNumberOfPoints(), 10000);
-            for (i = 0; i < Mesh->GetNumberOfPoints(); i++) {
-                this->ComputeVertexQuadric(Items + i, Mesh, i, Items[i].Weight);
-            }
+            NumberOfItems = Mesh->GetNumberOfPoints();
+            this->Items = new Item[NumberOfItems];
+
+            struct VerticesWeighting
+            {
+                Self* Metric;
+                double* VerticesAreas;
+
+                void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+                {
+                    Item* Items = this->Metric->Items;
+                    vtkDoubleArray* Weights = this->Metric->CustomWeights;
+                    double Gradation = this->Metric->Gradation;
+                    for (vtkIdType i = Begin; i < End; i++) {
+                        if (Gradation == 0)
+                            Items[i].Weight = this->VerticesAreas[i];
+                        else
+                            Items[i].Weight = this->VerticesAreas[i] *
+                                pow(Weights->GetValue(i), Gradation);
+                    }
+                }
+            };
+
+            VerticesWeighting WeightVertices;
+            WeightVertices.Metric = this;
+            WeightVertices.VerticesAreas =
+                Mesh->GetVerticesAreas(NumberOfThreads)->GetPointer(0);
+            vtkParallelFor::Execute(
+                NumberOfItems, WeightVertices, NumberOfThreads);
+            this->ClampWeights(
+                this->Items, NumberOfItems, 10000, NumberOfThreads);
+
+            vtkFaceQuantities Faces;
+            Faces.Compute(Mesh, false, true, NumberOfThreads);
+
+            struct VerticesBuilding
+            {
+                Self* Metric;
+                vtkSurface* Mesh;
+                vtkFaceQuantities* Faces;
+
+                void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+                {
+                    Item* Items = this->Metric->Items;
+                    vtkIdList* FList = vtkIdList::New();
+                    for (vtkIdType i = Begin; i < End; i++)
+                        this->Metric->ComputeVertexQuadric(
+                            Items + i, this->Mesh, i, Items[i].Weight,
+                            *this->Faces, FList);
+                    FList->Delete();
+                }
+            };
+
+            VerticesBuilding BuildVertices;
+            BuildVertices.Metric = this;
+            BuildVertices.Mesh = Mesh;
+            BuildVertices.Faces = &Faces;
+            vtkParallelFor::Execute(
+                NumberOfItems, BuildVertices, NumberOfThreads);
         }
     }
     // this method clamps the weights between AverageValue/Ratio and
-    // AverageValue*Ratio
-    void ClampWeights(Item* Items, int NumberOfValues, double Ratio)
+    // AverageValue*Ratio. The average is summed sequentially so that it does
+    // not depend on the number of threads
+    void ClampWeights(
+        Item* Items,
+        vtkIdType NumberOfValues,
+        double Ratio,
+        int NumberOfThreads = 0)
     {
         double Average = 0;
-        int i;
+        vtkIdType i;
         for (i = 0; i < NumberOfValues; i++) {
             Average += Items[i].Weight;
         }
         Average = Average / (double)NumberOfValues;
-        double Min = Average / Ratio;
-        double Max = Average * Ratio;
-        for (i = 0; i < NumberOfValues; i++) {
-            if (Items[i].Weight > Max)
-                Items[i].Weight = Max;
-            if (Items[i].Weight < Min)
-                Items[i].Weight = Min;
-        }
+
+        struct Clamping
+        {
+            Item* Items;
+            double Min;
+            double Max;
+
+            void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+            {
+                for (vtkIdType j = Begin; j < End; j++) {
+                    if (this->Items[j].Weight > this->Max)
+                        this->Items[j].Weight = this->Max;
+                    if (this->Items[j].Weight < this->Min)
+                        this->Items[j].Weight = this->Min;
+                }
+            }
+        };
+
+        Clamping Clamp;
+        Clamp.Items = Items;
+        Clamp.Min = Average / Ratio;
+        Clamp.Max = Average * Ratio;
+        vtkParallelFor::Execute(NumberOfValues, Clamp, NumberOfThreads);
     }
 
     vtkQEMetricForClustering()
@@ -0,0 +1,153 @@
+/*=========================================================================
+
+  Program:   Cache of the inputs of repeated remeshings
+  Module:    vtkRemeshingCache.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#ifndef _VTKREMESHINGCACHE_H_
+#define _VTKREMESHINGCACHE_H_
+
+#include <list>
+#include <map>
+
+#include <vtkDataArrayCollection.h>
+
+#include "vtkSurface.h"
+
+/// Keeps the meshes read from files, with their topology, and their
+/// curvature, so that remeshing the same input again (e.g. with another
+/// number of vertices) skips the parsing, the topology building and the
+/// curvature computation. Entries are keyed by the hash of the content of
+/// the files, so that a modified file is read again, and the least recently
+/// used entries are released when the cache grows beyond its maximum size.
+///
+/// The cache is not thread-safe. The objects it returns belong to it, and
+/// may be released by the next call which adds an entry : callers keeping
+/// them longer must Register() them.
+class vtkRemeshingCache
+{
+public:
+    vtkRemeshingCache();
+    ~vtkRemeshingCache();
+
+    /// Sets the maximum size of the cache, in megabytes. Default : 1024
+    void SetMaximumSize(double M);
+
+    /// Returns the mesh stored in FileName, reordered with Reordering
+    /// (vtkSurface::ReorderingMethod). Key receives the hash identifying
+    /// the content of the file, used to get the curvature of the mesh.
+    /// Returns 0 if the file cannot be read.
+    vtkSurface* GetMesh(
+        const char* FileName, int Reordering, unsigned long long& Key);
+
+    /// Returns the curvature of mesh Key for the clustering type (0 : faces,
+    /// 1 : vertices) and with or without principal directions, as stored by
+    /// SetCurvature(). Returns 0 when it is not in the cache.
+    vtkDataArrayCollection* GetCurvature(
+        unsigned long long Key,
+        int Reordering,
+        int ClusteringType,
+        int PrincipalDirections);
+
+    /// Stores the curvature of mesh Key
+    void SetCurvature(
+        unsigned long long Key,
+        int Reordering,
+        int ClusteringType,
+        int PrincipalDirections,
+        vtkDataArrayCollection* Curvature);
+
+    /// Releases all the entries
+    void Clear();
+
+    /// Returns the statistics of the cache
+    int GetNumberOfEntries() { return ((int)this->Entries.size()); }
+    double GetSize() { return (this->Size / 1048576.0); }
+    int GetNumberOfHits() { return (this->NumberOfHits); }
+    int GetNumberOfMisses() { return (this->NumberOfMisses); }
+
+private:
+    enum EntryType
+    {
+        MESH_ENTRY = 0,
+        CURVATURE_ENTRY
+    };
+
+    struct EntryKey
+    {
+        unsigned long long Hash;
+        int Type;
+        int Parameters;
+
+        bool operator<(const EntryKey& K) const
+        {
+            if (this->Hash != K.Hash)
+                return (this->Hash < K.Hash);
+            if (this->Type != K.Type)
+                return (this->Type < K.Type);
+            return (this->Parameters < K.Parameters);
+        }
+    };
+
+    struct Entry
+    {
+        EntryKey Key;
+        vtkObject* Object;
+
+        // the estimated memory used by the object, in bytes
+        double Size;
+    };
+
+    // the entries, from the most to the least recently used
+    std::list<Entry> Entries;
+    std::map<EntryKey, std::list<Entry>::iterator> Index;
+
+    double MaximumSize;
+    double Size;
+    int NumberOfHits;
+    int NumberOfMisses;
+
+    // returns the object of an entry, and marks it as the most recently
+    // used. Returns 0 if it is not in the cache
+    vtkObject* Find(const EntryKey& Key);
+
+    // adds an entry (the cache keeps a reference to Object), and releases
+    // the least recently used entries in excess
+    void Insert(const EntryKey& Key, vtkObject* Object, double Size);
+
+    // releases the least recently used entries in excess
+    void Trim();
+
+    static EntryKey GetCurvatureKey(
+        unsigned long long Key,
+        int Reordering,
+        int ClusteringType,
+        int PrincipalDirections);
+};
+
+#endif
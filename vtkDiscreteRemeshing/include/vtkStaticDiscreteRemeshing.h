@@ -0,0 +1,76 @@
+/*=========================================================================
+
+  Program:   Statically dispatched discrete remeshing
+  Module:    vtkStaticDiscreteRemeshing.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#ifndef _VTKSTATICDISCRETEREMESHING_H_
+#define _VTKSTATICDISCRETEREMESHING_H_
+
+#include "vtkDiscreteRemeshing.h"
+#include "vtkTrianglesProcessing.h"
+#include "vtkVerticesProcessing.h"
+
+/**
+ * A discrete remeshing class where the metric (Metric), the type of items
+ * (Items : vtkVerticesProcessing or vtkTrianglesProcessing) and the
+ * clustering engine are resolved at compile time. The engine is the one
+ * selected for vtkSurfaceClustering (sequential, threaded or Lloyd).
+ * The class is passed as the Derived parameter of the clustering chain, so
+ * that the minimization loops call the topology queries of Items without
+ * virtual calls, letting the compiler inline them.
+ *
+ * The class is final: the virtual methods used in the minimization loops
+ * cannot be overridden. Derive from the non-static classes (e.g.
+ * vtkIsotropicDiscreteRemeshing) when custom queries are needed.
+ *
+ * Example :
+ * typedef vtkStaticDiscreteRemeshing<vtkIsotropicMetricForClustering> Remesh;
+ * Remesh* Remesher = Remesh::New();
+ */
+
+template <class Metric, template <class> class Items = vtkVerticesProcessing>
+class vtkStaticDiscreteRemeshing final
+    : public Items<vtkDiscreteRemeshing<
+          Metric,
+          vtkStaticDiscreteRemeshing<Metric, Items>>>
+{
+public:
+    // No factory override here : an overriding class would not be the
+    // statically dispatched type
+    static vtkStaticDiscreteRemeshing* New()
+    {
+        return (new vtkStaticDiscreteRemeshing);
+    }
+
+protected:
+    vtkStaticDiscreteRemeshing() {}
+    ~vtkStaticDiscreteRemeshing() {}
+};
+
+#endif
@@ -42,15 +42,16 @@
  */
 
 #ifdef DOmultithread
-template <class Metric>
-class vtkSurfaceClustering : public vtkThreadedClustering<Metric>
+template <class Metric, class Derived = void>
+class vtkSurfaceClustering : public vtkThreadedClustering<Metric, Derived>
 #else
 #ifdef DOLloydClustering
-template <class Metric>
-class vtkSurfaceClustering : public vtkLloydClustering<Metric>
+template <class Metric, class Derived = void>
+class vtkSurfaceClustering : public vtkLloydClustering<Metric, Derived>
 #else
-template <class Metric>
-class vtkSurfaceClustering : public vtkUniformClustering<Metric>
+template <class Metric, class Derived = void>
+class vtkSurfaceClustering
+    : public vtkUniformClustering<Metric, vtkIdType, Derived>
 #endif
 #endif
 {
@@ -93,16 +94,16 @@ protected:
     vtkSurface* Input;
 };
 
-template <class Metric>
-void vtkSurfaceClustering<Metric>::BuildMetric()
+template <class Metric, class Derived>
+void vtkSurfaceClustering<Metric, Derived>::BuildMetric()
 {
     this->MetricContext.BuildMetric(
         this->Clusters, this->Input, this->NumberOfClusters,
-        this->ClusteringType);
+        this->ClusteringType, this->NumberOfThreads);
 }
 
-template <class Metric>
-void vtkSurfaceClustering<Metric>::SetInput(vtkSurface* Input)
+template <class Metric, class Derived>
+void vtkSurfaceClustering<Metric, Derived>::SetInput(vtkSurface* Input)
 {
     if (this->Input)
         this->Input->UnRegister(this);
@@ -135,14 +136,14 @@ void vtkSurfaceClustering<Metric>::SetInput(vtkSurface* Input)
         this->Input->Register(this);
 }
 
-template <class Metric>
-vtkSurfaceClustering<Metric>::vtkSurfaceClustering()
+template <class Metric, class Derived>
+vtkSurfaceClustering<Metric, Derived>::vtkSurfaceClustering()
 {
     this->Input = 0;
 }
 
-template <class Metric>
-vtkSurfaceClustering<Metric>::~vtkSurfaceClustering()
+template <class Metric, class Derived>
+vtkSurfaceClustering<Metric, Derived>::~vtkSurfaceClustering()
 {
     if (this->Input)
         this->Input->Delete();
@@ -39,70 +39,55 @@ Auteur:    Sebastien VALETTE
 #include <vtkPriorityQueue.h>
 #include <vtkTimerLog.h>
 
+#include "vtkClusteringTrace.h"
 #include "vtkUniformClustering.h"
 
-// define our derived class, with TryLock() method
-class VTK_EXPORT vtkMySimpleCriticalSection : public vtkSimpleCriticalSection
-{
-public:
-    static vtkMySimpleCriticalSection* New()
-    {
-        return new vtkMySimpleCriticalSection;
-    }
-
-    // Description:
-    // Unlock the vtkCriticalSection
-    int TryLock()
-    {
-#ifdef VTK_USE_PTHREADS
-        return pthread_mutex_trylock(&this->CritSec);
-#else
-        return 0;
-#endif
-
-        //// TODO : other architectures (Win32 etc...)
-    }
-
-    void Delete() { delete this; }
-    vtkMySimpleCriticalSection() {}
-    virtual ~vtkMySimpleCriticalSection() {}
-};
-
 // Class derived from vtkUniformClustering
-
-// this switch enables/disable the use of mutexes to ensure thread safety
-// although the risk of collision is very low when processing large meshes with
-// a low number of threads, this switch should be ALWAYS ON
-#define THREADSAFECLUSTERING
-
-template <class Metric>
-class vtkThreadedClustering : public vtkUniformClustering<Metric>
+//
+// The edges of the frontier are split between the processes of a pool. A
+// process only modifies the clusters it owns, i.e. the clusters which are not
+// adjacent to the edges of other processes. The other edges are deferred, and
+// processed after the pool in rounds : in each round, the edges reserve their
+// two clusters with a fixed priority, and the edges which got both clusters
+// are processed in parallel. No lock is needed on the clusters.
+
+template <class Metric, class Derived = void>
+class vtkThreadedClustering
+    : public vtkUniformClustering<Metric, vtkIdType, Derived>
 {
 public:
-    /// Sets the number of desired threads for multithreading.
-    /// by default, the number of threads is the number of CPUS
-    void SetNumberOfThreads(int N) { this->NumberOfThreads = N; }
-
-    /// returns the number of threads used for the clustering.
-    int GetNumberOfThreads() { return (this->NumberOfThreads); }
-
     /// sets the pooling ratio (the number of pool jobs will be equal to
     /// NumberOfThreads*PoolingRatio+1 default value : 5
     void SetPoolingRatio(int Ratio) { this->PoolingRatio = Ratio; }
 
+    /// sets the number of pool jobs in deterministic mode (see
+    /// SetDeterministic()). It replaces NumberOfThreads*PoolingRatio+1 so that
+    /// the partition does not depend on the number of threads.
+    /// default value : 129
+    void SetDeterministicPoolSize(int Size)
+    {
+        this->DeterministicPoolSize = Size;
+    }
+
+    /// Sets the trace where the execution of the pool processes, the
+    /// deferred edges rounds and the queues sizes are recorded for each loop.
+    /// The trace is not owned by the clustering. Default : 0 (no trace)
+    void SetTrace(vtkClusteringTrace* Trace) { this->Trace = Trace; }
+
     virtual vtkIntArray* ProcessClustering(vtkIdList* List = 0)
     {
-        this->vtkUniformClustering<Metric>::ProcessClustering();
-        int NumberOfLockingCollisions = 0;
-        for (int i = 0; i < this->NumberOfThreads + 1; i++) {
-            NumberOfModifications += this->NumberOfModifications[i];
-            NumberOfLockingCollisions += this->NumberOfLockingCollisions[i];
+        this->vtkUniformClustering<Metric, vtkIdType, Derived>::
+            ProcessClustering(List);
+        if (this->ConsoleOutput) {
+            int NumberOfModifications = 0;
+            for (int i = 0; i < this->NumberOfThreads + 1; i++)
+                NumberOfModifications += this->NumberOfModifications[i];
+            cout << NumberOfModifications
+                 << " modifications during the last loop, "
+                 << this->NumberOfDeferredEdges
+                 << " deferred edges processed in " << this->NumberOfRounds
+                 << " rounds" << endl;
         }
-        if (NumberOfLockingCollisions != 0)
-            cout << NumberOfLockingCollisions << " locking collisions detected"
-                 << endl;
-        else
-            cout << "No locking collision detected" << endl;
         return (this->Clustering);
     }
 
@@ -115,7 +100,39 @@ protected:
 
     // Executes one process from the Thread pool
     void ExecuteProcess(int Process, int Thread);
-    void ExecuteProcessWithDistances(int Process, int Thread);
+
+    // Processes the edges [Begin, End). The edges to process during the next
+    // loop are pushed to the buffer of Process. When Defer is true, the edges
+    // adjacent to a cluster not owned by Process are deferred
+    void ExecuteEdges(
+        const vtkIdType* Begin,
+        const vtkIdType* End,
+        int Process,
+        int Thread,
+        bool Defer);
+    void ExecuteEdgesWithEnergy(
+        const vtkIdType* Begin,
+        const vtkIdType* End,
+        int Process,
+        int Thread,
+        bool Defer);
+    void ExecuteEdgesWithDistances(
+        const vtkIdType* Begin,
+        const vtkIdType* End,
+        int Process,
+        int Thread,
+        bool Defer);
+
+    // Returns 1 if the edge has to be deferred (i.e. one of its clusters is
+    // not owned by Process), 0 otherwise
+    int DeferEdge(vtkIdType Edge, int Val1, int Val2, int Process, bool Defer);
+
+    // computes the owner of each cluster : the only process whose edges are
+    // adjacent to it, or -2 when several processes share the cluster
+    void ComputeClustersOwners();
+
+    // processes the deferred edges and the edges of the last process
+    void ProcessDeferredEdges();
 
     // The static function used for clustering
     static VTK_THREAD_RETURN_TYPE MyMainForClustering(void* arg);
@@ -143,6 +160,26 @@ protected:
         return this->ConnexityConstraintProblem(Item, Edge, Cluster2, Cluster1);
     }
 
+    // statically dispatched versions of the two methods above (see the
+    // Derived parameter of vtkUniformClustering)
+    void DispatchAddItemRingToProcess(
+        vtkIdType Item, int ProcessId, int Thread)
+    {
+        this->DispatchAddItemRingToProcess(
+            Item, ProcessId, Thread, (Derived*)0);
+    }
+
+    int DispatchConnexityConstraintProblem(
+        vtkIdType Item,
+        vtkIdType Edge,
+        vtkIdType Cluster2,
+        vtkIdType Cluster1,
+        int Thread)
+    {
+        return this->DispatchConnexityConstraintProblem(
+            Item, Edge, Cluster2, Cluster1, Thread, (Derived*)0);
+    }
+
     // allocates and initializes memory for the threaded clustering
     // (queues, timings)
     virtual void Init();
@@ -158,19 +195,20 @@ protected:
     // a sub-part of edges layout computation
     void ComputeMeshSlices(int NumberOfSlices, vtkIntArray* Clustering);
 
-    /// this method replaces the AddEdgeToProcess in a multithreaded context
+    /// this method replaces the AddEdgeToProcess in a multithreaded context.
+    /// Each process pushes to its own buffer, the edges are dispatched to
+    /// their processes when swapping queues
     virtual void AddEdgeToProcess(vtkIdType Edge, int ProcessId)
     {
-        this->ProcessesPushQueues[this->EdgesProcess[Edge]][ProcessId].push(
-            Edge);
+        this->Frontier.Push(Edge, ProcessId);
     }
 
-    /// The number of threads
-    int NumberOfThreads;
-
     /// The size of the pool
     int PoolSize;
 
+    /// The size of the pool in deterministic mode
+    int DeterministicPoolSize;
+
     // Parameter defining the number of thread jobs :
     // NThreadJobs=NumberOfThreads*PoolingRatio+1
     int PoolingRatio;
@@ -190,6 +228,13 @@ protected:
     // refills the queues according to a possibly updated clustering
     void FillQueuesFromClustering();
 
+    // puts all the pool processes but the last one in the pool queue
+    void FillPoolQueue();
+
+    // restores the state saved by SaveCheckpoint(). The pool queue is
+    // refilled, as FillQueuesFromClustering() is not called when resuming
+    int LoadCheckpoint();
+
     // Context for Clustering
     // *******************************************
     int* EdgesProcess;
@@ -198,82 +243,137 @@ protected:
     int* PreviousNumberOfIterations;
     int* NumberOfIterations;
     int* NumberOfModifications;
-    int* NumberOfLockingCollisions;
+
+    // the skipped edges and rejected moves of each thread during the current
+    // loop
+    vtkIdType* SkippedEdges;
+    vtkIdType* ConnexityRejects;
 
     // Context for time measures
     // ************************************
     double* StartTimes;
     double* StopTimes;
 
-#ifdef THREADSAFECLUSTERING
-    // one mutex for each cluster to ensure thread-safety
-    vtkMySimpleCriticalSection** ClustersLocks;
-#endif
+    // Context for clusters ownership
+    // ******************************
+    // the owner process of each cluster
+    std::atomic<int>* ClustersOwners;
+
+    // for each cluster, the deferred edge which reserved it in the current
+    // round (the smallest position wins)
+    std::atomic<vtkIdType>* ClustersReservations;
+
+    // the edges deferred by each process
+    std::vector<std::vector<vtkIdType>> DeferredEdges;
+
+    // the total number of deferred edges and of reservation rounds
+    vtkIdType NumberOfDeferredEdges;
+    int NumberOfRounds;
+
+    // the timeline trace, possibly null
+    vtkClusteringTrace* Trace;
 
     // Context used to allocate processes in the pool
     // **********************************************
     vtkSimpleCriticalSection *PoolAllocationLock, *PoolAllocationLock2;
     vtkPriorityQueue *PoolQueue1, *PoolQueue2;
 
-    // The push and pop queues used to track the edges laying between different
-    // clusters
-    std::queue<int>** ProcessesQueues1;
-    std::queue<int>** ProcessesQueues2;
-
-    std::queue<int>** ProcessesPushQueues;
-    std::queue<int>** ProcessesPopQueues;
-
     vtkIdList** ThreadsLists;
 
-    // this method swaps the pop queues with the push queues.
+    // this method makes the pushed edges available to their processes
     void SwapQueues();
+
+private:
+    void DispatchAddItemRingToProcess(
+        vtkIdType Item, int ProcessId, int Thread, void*)
+    {
+        this->AddItemRingToProcess(Item, ProcessId, Thread);
+    }
+
+    int DispatchConnexityConstraintProblem(
+        vtkIdType Item,
+        vtkIdType Edge,
+        vtkIdType Cluster2,
+        vtkIdType Cluster1,
+        int Thread,
+        void*)
+    {
+        return this->ThreadedConnexityConstraintProblem(
+            Item, Edge, Cluster2, Cluster1, Thread);
+    }
+
+    template <class D>
+    void DispatchAddItemRingToProcess(
+        vtkIdType Item, int ProcessId, int Thread, D*)
+    {
+        static_cast<D*>(this)->D::AddItemRingToProcess(
+            Item, ProcessId, Thread);
+    }
+
+    template <class D>
+    int DispatchConnexityConstraintProblem(
+        vtkIdType Item,
+        vtkIdType Edge,
+        vtkIdType Cluster2,
+        vtkIdType Cluster1,
+        int Thread,
+        D*)
+    {
+        return static_cast<D*>(this)->D::ThreadedConnexityConstraintProblem(
+            Item, Edge, Cluster2, Cluster1, Thread);
+    }
 };
 
-template <class Metric>
-void vtkThreadedClustering<Metric>::FillQueuesFromClustering()
+template <class Metric, class Derived>
+void vtkThreadedClustering<Metric, Derived>::FillQueuesFromClustering()
 {
-    int i, j;
+    int i;
     vtkIdType I1, I2;
-    std::queue<int>* PQueue;
-    vtkIdType Edge;
-
-    // empty the pushing queues
-    for (i = 0; i < this->PoolSize; i++) {
-        for (j = 0; j < this->PoolSize; j++) {
-            PQueue = &this->ProcessesPushQueues[i][j];
-            while (PQueue->size() != 0) {
-                Edge = PQueue->front();
-                PQueue->pop();
-            }
-        }
-    }
 
-    // fill the pushqueues depending on the clustering
+    // empty the frontier
+    this->Frontier.Clear();
+
+    // fill the frontier depending on the clustering
     for (i = 0; i < this->GetNumberOfEdges(); i++) {
         this->GetEdgeItems(i, I1, I2);
         if (I2 >= 0) {
             if (this->Clustering->GetValue(I1) !=
                 this->Clustering->GetValue(I2)) {
-                this->ProcessesPushQueues[this->EdgesProcess[i]]
-                                         [this->EdgesProcess[i]]
-                                             .push(i);
+                this->Frontier.Push(i, this->EdgesProcess[i]);
             }
         }
     }
 
-    // fill the thread pool queue
-    for (i = 0; i < this->PoolSize - 1; i++)
+    this->FillPoolQueue();
+}
+
+template <class Metric, class Derived>
+void vtkThreadedClustering<Metric, Derived>::FillPoolQueue()
+{
+    for (int i = 0; i < this->PoolSize - 1; i++)
         this->PoolQueue1->Insert(i, i);
 }
 
-template <class Metric>
-VTK_THREAD_RETURN_TYPE vtkThreadedClustering<Metric>::MyMainForClustering(
-    void* arg)
+template <class Metric, class Derived>
+int vtkThreadedClustering<Metric, Derived>::LoadCheckpoint()
+{
+    if (!this->vtkUniformClustering<Metric, vtkIdType, Derived>::
+            LoadCheckpoint())
+        return (0);
+
+    // the restored edges are split between the processes by SwapQueues()
+    this->FillPoolQueue();
+    return (1);
+}
+
+template <class Metric, class Derived>
+VTK_THREAD_RETURN_TYPE
+vtkThreadedClustering<Metric, Derived>::MyMainForClustering(void* arg)
 {
     vtkMultiThreader::ThreadInfo* Info = (vtkMultiThreader::ThreadInfo*)arg;
 
-    vtkThreadedClustering<Metric>* Clustering =
-        (vtkThreadedClustering<Metric>*)Info->UserData;
+    vtkThreadedClustering<Metric, Derived>* Clustering =
+        (vtkThreadedClustering<Metric, Derived>*)Info->UserData;
 
     int MyId = Info->ThreadID;
 
@@ -287,16 +387,25 @@ VTK_THREAD_RETURN_TYPE vtkThreadedClustering<Metric>::MyMainForClustering(
         if ((Process < 0))
             break;
 
-        double Time;
+        double Start = Clustering->Timer->GetUniversalTime();
+        Clustering->ExecuteProcess(Process, MyId);
+        double Stop = Clustering->Timer->GetUniversalTime();
+
+        vtkClusteringTrace* Trace = Clustering->Trace;
+        if (Trace) {
+            Trace->AddSpan(
+                MyId, "process", Start, Stop, "process", Process, "edges",
+                Clustering->Frontier.End(Process) -
+                    Clustering->Frontier.Begin(Process));
+
+            // the edges which conflict with other processes
+            vtkIdType Deferred = Clustering->DeferredEdges[Process].size();
+            if (Deferred)
+                Trace->AddMarker(MyId, "deferred", "edges", Deferred);
+        }
 
-        Time = Clustering->Timer->GetUniversalTime();
-        if (Clustering->MinimizeUsingEnergy)
-            Clustering->ExecuteProcess(Process, MyId);
-        else
-            Clustering->ExecuteProcessWithDistances(Process, MyId);
-        Time = Clustering->Timer->GetUniversalTime() - Time;
         Clustering->PoolAllocationLock2->Lock();
-        Clustering->PoolQueue2->Insert(-Time, Process);
+        Clustering->PoolQueue2->Insert(Start - Stop, Process);
         Clustering->PoolAllocationLock2->Unlock();
     }
 
@@ -304,8 +413,291 @@ VTK_THREAD_RETURN_TYPE vtkThreadedClustering<Metric>::MyMainForClustering(
     return VTK_THREAD_RETURN_VALUE;
 }
 
-template <class Metric>
-void vtkThreadedClustering<Metric>::ExecuteProcess(int Process, int Thread)
+template <class Metric, class Derived>
+int vtkThreadedClustering<Metric, Derived>::DeferEdge(
+    vtkIdType Edge, int Val1, int Val2, int Process, bool Defer)
+{
+    if (!Defer)
+        return (0);
+
+    // the NULL cluster has no statistics : it can be shared
+    int Owner1 = (Val1 == this->NumberOfClusters)
+        ? Process
+        : this->ClustersOwners[Val1].load(std::memory_order_relaxed);
+    int Owner2 = (Val2 == this->NumberOfClusters)
+        ? Process
+        : this->ClustersOwners[Val2].load(std::memory_order_relaxed);
+    if ((Owner1 == Process) && (Owner2 == Process))
+        return (0);
+
+    this->DeferredEdges[Process].push_back(Edge);
+    return (1);
+}
+
+template <class Metric, class Derived>
+void vtkThreadedClustering<Metric, Derived>::ComputeClustersOwners()
+{
+    typedef vtkThreadedClustering<Metric, Derived> Self;
+    for (int i = 0; i < this->NumberOfClusters; i++)
+        this->ClustersOwners[i].store(-1, std::memory_order_relaxed);
+
+    // The result does not depend on the order of the marks
+    struct Marking
+    {
+        Self* Clustering;
+        const vtkIdType* Edges;
+
+        void Mark(int Cluster, int Process)
+        {
+            if (Cluster == this->Clustering->NumberOfClusters)
+                return;
+            int Owner = -1;
+            if (!this->Clustering->ClustersOwners[Cluster]
+                     .compare_exchange_strong(Owner, Process) &&
+                (Owner != Process))
+                this->Clustering->ClustersOwners[Cluster].store(-2);
+        }
+
+        void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+        {
+            vtkIdType I1, I2;
+            int* Values = this->Clustering->Clustering->GetPointer(0);
+            for (vtkIdType i = Begin; i < End; i++) {
+                vtkIdType Edge = this->Edges[i];
+                this->Clustering->DispatchGetEdgeItems(Edge, I1, I2);
+                if ((I2 < 0) || (Values[I1] == Values[I2]))
+                    continue;
+                int Process = this->Clustering->EdgesProcess[Edge];
+                this->Mark(Values[I1], Process);
+                this->Mark(Values[I2], Process);
+            }
+        }
+    };
+
+    // the edges of all the processes but the last one are contiguous
+    Marking Mark;
+    Mark.Clustering = this;
+    Mark.Edges = this->Frontier.Begin(0);
+    vtkParallelFor::Execute(
+        this->Frontier.End(this->PoolSize - 2) - this->Frontier.Begin(0),
+        Mark,
+        this->NumberOfThreads);
+}
+
+template <class Metric, class Derived>
+void vtkThreadedClustering<Metric, Derived>::ProcessDeferredEdges()
+{
+    typedef vtkThreadedClustering<Metric, Derived> Self;
+
+    // the edges to process, by decreasing priority : the edges deferred by
+    // each process, then the edges of the last process
+    std::vector<vtkIdType> Edges;
+    for (int i = 0; i < this->PoolSize - 1; i++)
+        Edges.insert(
+            Edges.end(), this->DeferredEdges[i].begin(),
+            this->DeferredEdges[i].end());
+    this->NumberOfDeferredEdges += Edges.size();
+    Edges.insert(
+        Edges.end(), this->Frontier.Begin(this->PoolSize - 1),
+        this->Frontier.End(this->PoolSize - 1));
+
+    struct Reservation
+    {
+        Self* Clustering;
+        vtkIdType* Edges;
+
+        // the two clusters of each edge when the round starts
+        int* Values;
+
+        // 0 : read the clusters and reset their reservations
+        // 1 : reserve the clusters
+        // 2 : process the edges which got both their clusters
+        int Step;
+
+        // for each chunk, the edges processed, kept for the next round, and
+        // adjacent to the NULL cluster
+        std::vector<vtkIdType>* ChunksWinners;
+        std::vector<vtkIdType>* ChunksLosers;
+        std::vector<vtkIdType>* ChunksNull;
+
+        void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+        {
+            Self* C = this->Clustering;
+            std::atomic<vtkIdType>* Reservations = C->ClustersReservations;
+            int* Clusters = C->Clustering->GetPointer(0);
+            int NullCluster = C->NumberOfClusters;
+            vtkIdType I1, I2;
+
+            switch (this->Step) {
+                case 0:
+                    for (vtkIdType i = Begin; i < End; i++) {
+                        int* Values = this->Values + 2 * i;
+                        C->DispatchGetEdgeItems(this->Edges[i], I1, I2);
+                        Values[0] = Clusters[I1];
+                        Values[1] = (I2 < 0) ? Values[0] : Clusters[I2];
+                        if ((Values[0] == Values[1]) ||
+                            (Values[0] == NullCluster) ||
+                            (Values[1] == NullCluster))
+                            continue;
+                        Reservations[Values[0]].store(
+                            VTK_ID_MAX, std::memory_order_relaxed);
+                        Reservations[Values[1]].store(
+                            VTK_ID_MAX, std::memory_order_relaxed);
+                    }
+                    break;
+
+                case 1:
+                    for (vtkIdType i = Begin; i < End; i++) {
+                        int* Values = this->Values + 2 * i;
+                        if ((Values[0] == Values[1]) ||
+                            (Values[0] == NullCluster) ||
+                            (Values[1] == NullCluster))
+                            continue;
+                        for (int j = 0; j < 2; j++) {
+                            std::atomic<vtkIdType>& Owner =
+                                Reservations[Values[j]];
+                            vtkIdType Current = Owner.load();
+                            while ((i < Current) &&
+                                   !Owner.compare_exchange_weak(Current, i))
+                                ;
+                        }
+                    }
+                    break;
+
+                case 2:
+                default: {
+                    std::vector<vtkIdType>& Winners =
+                        this->ChunksWinners[Chunk];
+                    std::vector<vtkIdType>& Losers = this->ChunksLosers[Chunk];
+                    std::vector<vtkIdType>& Null = this->ChunksNull[Chunk];
+                    Winners.clear();
+                    Losers.clear();
+                    Null.clear();
+                    for (vtkIdType i = Begin; i < End; i++) {
+                        int* Values = this->Values + 2 * i;
+                        if (Values[0] == Values[1])
+                            continue;
+                        if ((Values[0] == NullCluster) ||
+                            (Values[1] == NullCluster))
+                            Null.push_back(this->Edges[i]);
+                        else if (
+                            (Reservations[Values[0]].load() == i) &&
+                            (Reservations[Values[1]].load() == i))
+                            Winners.push_back(this->Edges[i]);
+                        else
+                            Losers.push_back(this->Edges[i]);
+                    }
+
+                    // the clusters of the winners are not used by any other
+                    // edge during this round
+                    C->ExecuteEdges(
+                        Winners.data(), Winners.data() + Winners.size(), Chunk,
+                        Chunk, false);
+                    break;
+                }
+            }
+        }
+    };
+
+    // the chunks push their edges to the buffers of the first processes
+    int NumberOfThreads = this->NumberOfThreads;
+    if (NumberOfThreads > this->PoolSize)
+        NumberOfThreads = this->PoolSize;
+
+    std::vector<vtkIdType> NullEdges;
+    std::vector<int> Values;
+    std::vector<std::vector<vtkIdType>> ChunksWinners, ChunksLosers,
+        ChunksNull;
+    Reservation Reserve;
+    Reserve.Clustering = this;
+
+    // in deterministic mode, the rounds stop at a fixed number of edges
+    // rather than when the edges cannot be split between the threads, so that
+    // the processing order does not depend on the number of threads
+    const vtkIdType DeterministicRoundsMinimumSize = 2048;
+
+    while (true) {
+        vtkIdType NumberOfEdges = Edges.size();
+        int NumberOfChunks =
+            vtkParallelFor::GetNumberOfChunks(NumberOfEdges, NumberOfThreads);
+        if (this->Deterministic
+                ? (NumberOfEdges < DeterministicRoundsMinimumSize)
+                : (NumberOfChunks == 1))
+            break;
+
+        Values.resize(2 * NumberOfEdges);
+        ChunksWinners.resize(NumberOfChunks);
+        ChunksLosers.resize(NumberOfChunks);
+        ChunksNull.resize(NumberOfChunks);
+        Reserve.Edges = Edges.data();
+        Reserve.Values = Values.data();
+        Reserve.ChunksWinners = ChunksWinners.data();
+        Reserve.ChunksLosers = ChunksLosers.data();
+        Reserve.ChunksNull = ChunksNull.data();
+
+        double Start = vtkClusteringTrace::GetTime();
+        for (Reserve.Step = 0; Reserve.Step < 3; Reserve.Step++)
+            vtkParallelFor::Execute(NumberOfEdges, Reserve, NumberOfThreads);
+        this->NumberOfRounds++;
+
+        // the remaining edges keep their order
+        Edges.clear();
+        for (int i = 0; i < NumberOfChunks; i++) {
+            Edges.insert(
+                Edges.end(), ChunksLosers[i].begin(), ChunksLosers[i].end());
+            NullEdges.insert(
+                NullEdges.end(), ChunksNull[i].begin(), ChunksNull[i].end());
+        }
+
+        if (this->Trace)
+            this->Trace->AddSpan(
+                this->NumberOfThreads, "round", Start,
+                vtkClusteringTrace::GetTime(), "edges", NumberOfEdges,
+                "conflicts", Edges.size());
+    }
+
+    // the few remaining edges are processed sequentially
+    double Start = vtkClusteringTrace::GetTime();
+    Edges.insert(Edges.end(), NullEdges.begin(), NullEdges.end());
+    this->ExecuteEdges(
+        Edges.data(), Edges.data() + Edges.size(), this->PoolSize - 1,
+        this->NumberOfThreads, false);
+    if (this->Trace)
+        this->Trace->AddSpan(
+            this->NumberOfThreads, "serial tail", Start,
+            vtkClusteringTrace::GetTime(), "edges", Edges.size());
+}
+
+template <class Metric, class Derived>
+void vtkThreadedClustering<Metric, Derived>::ExecuteProcess(
+    int Process, int Thread)
+{
+    this->ExecuteEdges(
+        this->Frontier.Begin(Process), this->Frontier.End(Process), Process,
+        Thread, true);
+}
+
+template <class Metric, class Derived>
+void vtkThreadedClustering<Metric, Derived>::ExecuteEdges(
+    const vtkIdType* Begin,
+    const vtkIdType* End,
+    int Process,
+    int Thread,
+    bool Defer)
+{
+    if (this->MinimizeUsingEnergy)
+        this->ExecuteEdgesWithEnergy(Begin, End, Process, Thread, Defer);
+    else
+        this->ExecuteEdgesWithDistances(Begin, End, Process, Thread, Defer);
+}
+
+template <class Metric, class Derived>
+void vtkThreadedClustering<Metric, Derived>::ExecuteEdgesWithEnergy(
+    const vtkIdType* Begin,
+    const vtkIdType* End,
+    int Process,
+    int Thread,
+    bool Defer)
 {
     vtkIdType Edge, I1, I2;
     int Val1, Val2, *Size1, *Size2;
@@ -323,56 +715,20 @@ void vtkThreadedClustering<Metric>::ExecuteProcess(int Process, int Thread)
     Cluster22 = new typename Metric::Cluster;
     Cluster31 = new typename Metric::Cluster;
     Cluster32 = new typename Metric::Cluster;
+    vtkIdType NumberOfSkippedEdges = 0;
+    vtkIdType NumberOfConnexityRejects = 0;
+
+    // the frontier contains no duplicates, so each edge is visited once
+    for (const vtkIdType* It = Begin; It != End; It++) {
+        Edge = *It;
+        {
+            this->DispatchGetEdgeItems(Edge, I1, I2);
 
-    std::queue<int>* Queue;
-    for (int CurrentQueue = 0; CurrentQueue < this->PoolSize; CurrentQueue++) {
-        Queue = &this->ProcessesPopQueues[Process][CurrentQueue];
-        while (!Queue->empty()) {
-            // the queue is not empty : let's use it
-            Edge = Queue->front();
-            Queue->pop();
-            this->GetEdgeItems(Edge, I1, I2);
-
-            if ((this->EdgesLastLoop[Edge] != this->RelativeNumberOfLoops) &&
-                (I2 >= 0)) {
-                this->EdgesLastLoop[Edge] = this->RelativeNumberOfLoops;
+            if (I2 >= 0) {
                 Val1 = this->Clustering->GetValue(I1);
                 Val2 = this->Clustering->GetValue(I2);
-                if (Val2 != Val1) {
-#ifdef THREADSAFECLUSTERING
-                    // get the lock on the clusters
-                    if (Val1 < Val2) {
-#ifdef VTK_USE_PTHREADS
-                        if (this->ClustersLocks[Val1]->TryLock() != 0) {
-                            this->NumberOfLockingCollisions[Thread]++;
-                            this->ClustersLocks[Val1]->Lock();
-                        }
-                        if (this->ClustersLocks[Val2]->TryLock() != 0) {
-                            this->NumberOfLockingCollisions[Thread]++;
-                            this->ClustersLocks[Val2]->Lock();
-                        }
-#else
-                        this->ClustersLocks[Val1]->Lock();
-                        this->ClustersLocks[Val2]->Lock();
-#endif
-                    } else {
-#ifdef VTK_USE_PTHREADS
-                        if (this->ClustersLocks[Val2]->TryLock() != 0) {
-                            this->NumberOfLockingCollisions[Thread]++;
-                            this->ClustersLocks[Val2]->Lock();
-                        }
-                        if (this->ClustersLocks[Val1]->TryLock() != 0) {
-                            this->NumberOfLockingCollisions[Thread]++;
-                            this->ClustersLocks[Val1]->Lock();
-                        }
-#else
-                        this->ClustersLocks[Val2]->Lock();
-                        this->ClustersLocks[Val1]->Lock();
-#endif
-                    }
-
-#endif
-
+                if ((Val2 != Val1) &&
+                    !this->DeferEdge(Edge, Val1, Val2, Process, Defer)) {
                     this->NumberOfIterations[Thread]++;
                     if (Val1 == this->NumberOfClusters) {
                         // I1 is not associated. Give it to the same cluster as
@@ -385,7 +741,7 @@ void vtkThreadedClustering<Metric>::ExecuteProcess(int Process, int Thread)
                             this->Clusters + Val2);
 
                         (*this->ClustersSizes->GetPointer(Val2))++;
-                        this->AddItemRingToProcess(I1, Process, Thread);
+                        this->DispatchAddItemRingToProcess(I1, Process, Thread);
                         this->Clustering->SetValue(I1, Val2);
                         this->NumberOfModifications[Thread]++;
                     } else if (Val2 == this->NumberOfClusters) {
@@ -398,7 +754,7 @@ void vtkThreadedClustering<Metric>::ExecuteProcess(int Process, int Thread)
                         this->MetricContext.ComputeClusterEnergy(
                             this->Clusters + Val1);
                         (*this->ClustersSizes->GetPointer(Val1))++;
-                        this->AddItemRingToProcess(I2, Process, Thread);
+                        this->DispatchAddItemRingToProcess(I2, Process, Thread);
                         this->Clustering->SetValue(I2, Val1);
                         this->NumberOfModifications[Thread]++;
                     } else {
@@ -431,10 +787,11 @@ void vtkThreadedClustering<Metric>::ExecuteProcess(int Process, int Thread)
                             // Compute the energy when setting
                             // I1 to the same cluster as I2;
                             if ((*Size1 == 1) ||
-                                (this->ThreadedConnexityConstraintProblem(
-                                     I1, Edge, Val1, Val2, Thread) == 1))
+                                (this->DispatchConnexityConstraintProblem(
+                                     I1, Edge, Val1, Val2, Thread) == 1)) {
                                 Try2 = 100000000.0;
-                            else {
+                                NumberOfConnexityRejects++;
+                            } else {
                                 this->MetricContext.DeepCopy(
                                     Cluster1, Cluster21);
                                 this->MetricContext.DeepCopy(
@@ -462,10 +819,11 @@ void vtkThreadedClustering<Metric>::ExecuteProcess(int Process, int Thread)
                             // Compute the energy when setting
                             // I2 to the same cluster as I1;
                             if ((*Size2 == 1) ||
-                                (this->ThreadedConnexityConstraintProblem(
-                                     I2, Edge, Val2, Val1, Thread) == 1))
+                                (this->DispatchConnexityConstraintProblem(
+                                     I2, Edge, Val2, Val1, Thread) == 1)) {
                                 Try3 = 1000000000.0;
-                            else {
+                                NumberOfConnexityRejects++;
+                            } else {
                                 this->MetricContext.DeepCopy(
                                     Cluster1, Cluster31);
                                 this->MetricContext.DeepCopy(
@@ -497,6 +855,7 @@ void vtkThreadedClustering<Metric>::ExecuteProcess(int Process, int Thread)
                                 Result = 3;
                         } else {
                             Result = 1;
+                            NumberOfSkippedEdges++;
                         }
 
                         switch (Result) {
@@ -514,7 +873,8 @@ void vtkThreadedClustering<Metric>::ExecuteProcess(int Process, int Thread)
                                     Cluster21, Cluster1);
                                 this->MetricContext.DeepCopy(
                                     Cluster22, Cluster2);
-                                this->AddItemRingToProcess(I1, Process, Thread);
+                                this->DispatchAddItemRingToProcess(
+                                    I1, Process, Thread);
                                 this->NumberOfModifications[Thread]++;
                                 this->ClustersLastModification[Val1] =
                                     this->NumberOfLoops;
@@ -531,7 +891,8 @@ void vtkThreadedClustering<Metric>::ExecuteProcess(int Process, int Thread)
                                     Cluster31, Cluster1);
                                 this->MetricContext.DeepCopy(
                                     Cluster32, Cluster2);
-                                this->AddItemRingToProcess(I2, Process, Thread);
+                                this->DispatchAddItemRingToProcess(
+                                    I2, Process, Thread);
                                 this->NumberOfModifications[Thread]++;
                                 this->ClustersLastModification[Val1] =
                                     this->NumberOfLoops;
@@ -539,11 +900,6 @@ void vtkThreadedClustering<Metric>::ExecuteProcess(int Process, int Thread)
                                     this->NumberOfLoops;
                         }
                     }
-#ifdef THREADSAFECLUSTERING
-                    // release the lock on the clusters
-                    this->ClustersLocks[Val1]->Unlock();
-                    this->ClustersLocks[Val2]->Unlock();
-#endif
                 }
             }
         }
@@ -552,65 +908,36 @@ void vtkThreadedClustering<Metric>::ExecuteProcess(int Process, int Thread)
     delete Cluster22;
     delete Cluster31;
     delete Cluster32;
+    this->SkippedEdges[Thread] += NumberOfSkippedEdges;
+    this->ConnexityRejects[Thread] += NumberOfConnexityRejects;
 }
 
-template <class Metric>
-void vtkThreadedClustering<Metric>::ExecuteProcessWithDistances(
-    int Process, int Thread)
+template <class Metric, class Derived>
+void vtkThreadedClustering<Metric, Derived>::ExecuteEdgesWithDistances(
+    const vtkIdType* Begin,
+    const vtkIdType* End,
+    int Process,
+    int Thread,
+    bool Defer)
 {
     vtkIdType Edge, I1, I2;
     int Val1, Val2, *Size1, *Size2;
 
     typename Metric::Cluster *Cluster1, *Cluster2;
-    std::queue<int>* Queue;
-    for (int CurrentQueue = 0; CurrentQueue < this->PoolSize; CurrentQueue++) {
-        Queue = &this->ProcessesPopQueues[Process][CurrentQueue];
-        while (!Queue->empty()) {
-            // the queue is not empty : let's use it
-            Edge = Queue->front();
-            Queue->pop();
-            this->GetEdgeItems(Edge, I1, I2);
-
-            if ((this->EdgesLastLoop[Edge] != this->RelativeNumberOfLoops) &&
-                (I2 >= 0)) {
-                this->EdgesLastLoop[Edge] = this->RelativeNumberOfLoops;
-                Val1 = this->Clustering->GetValue(I1);
-                Val2 = this->Clustering->GetValue(I2);
-                if (Val2 != Val1) {
-#ifdef THREADSAFECLUSTERING
-                    // get the lock on the clusters
-                    if (Val1 < Val2) {
-#ifdef VTK_USE_PTHREADS
-                        if (this->ClustersLocks[Val1]->TryLock() != 0) {
-                            this->NumberOfLockingCollisions[Thread]++;
-                            this->ClustersLocks[Val1]->Lock();
-                        }
-                        if (this->ClustersLocks[Val2]->TryLock() != 0) {
-                            this->NumberOfLockingCollisions[Thread]++;
-                            this->ClustersLocks[Val2]->Lock();
-                        }
-#else
-                        this->ClustersLocks[Val1]->Lock();
-                        this->ClustersLocks[Val2]->Lock();
-#endif
-                    } else {
-#ifdef VTK_USE_PTHREADS
-                        if (this->ClustersLocks[Val2]->TryLock() != 0) {
-                            this->NumberOfLockingCollisions[Thread]++;
-                            this->ClustersLocks[Val2]->Lock();
-                        }
-                        if (this->ClustersLocks[Val1]->TryLock() != 0) {
-                            this->NumberOfLockingCollisions[Thread]++;
-                            this->ClustersLocks[Val1]->Lock();
-                        }
-#else
-                        this->ClustersLocks[Val2]->Lock();
-                        this->ClustersLocks[Val1]->Lock();
-#endif
-                    }
+    vtkIdType NumberOfSkippedEdges = 0;
+    vtkIdType NumberOfConnexityRejects = 0;
 
-#endif
+    // the frontier contains no duplicates, so each edge is visited once
+    for (const vtkIdType* It = Begin; It != End; It++) {
+        Edge = *It;
+        {
+            this->DispatchGetEdgeItems(Edge, I1, I2);
 
+            if (I2 >= 0) {
+                Val1 = this->Clustering->GetValue(I1);
+                Val2 = this->Clustering->GetValue(I2);
+                if ((Val2 != Val1) &&
+                    !this->DeferEdge(Edge, Val1, Val2, Process, Defer)) {
                     this->NumberOfIterations[Thread]++;
                     if (Val1 == this->NumberOfClusters) {
                         // I1 is not associated. Give it to the same cluster as
@@ -623,7 +950,7 @@ void vtkThreadedClustering<Metric>::ExecuteProcessWithDistances(
                             this->Clusters + Val2);
 
                         (*this->ClustersSizes->GetPointer(Val2))++;
-                        this->AddItemRingToProcess(I1, Process, Thread);
+                        this->DispatchAddItemRingToProcess(I1, Process, Thread);
                         this->Clustering->SetValue(I1, Val2);
                         this->NumberOfModifications[Thread]++;
                     } else if (Val2 == this->NumberOfClusters) {
@@ -636,11 +963,11 @@ void vtkThreadedClustering<Metric>::ExecuteProcessWithDistances(
                         this->MetricContext.ComputeClusterEnergy(
                             this->Clusters + Val1);
                         (*this->ClustersSizes->GetPointer(Val1))++;
-                        this->AddItemRingToProcess(I2, Process, Thread);
+                        this->DispatchAddItemRingToProcess(I2, Process, Thread);
                         this->Clustering->SetValue(I2, Val1);
                         this->NumberOfModifications[Thread]++;
                     } else {
-                        int Result;
+                        int Result = 1;
 
                         // determine whether one of	the	two	adjacent clusters
                         // was modified, or whether any of the clusters is
@@ -670,7 +997,7 @@ void vtkThreadedClustering<Metric>::ExecuteProcessWithDistances(
                             // Compute the energy when setting I1 to the same
                             // cluster as I2;
                             if ((*Size1 != 1) &&
-                                (this->ThreadedConnexityConstraintProblem(
+                                (this->DispatchConnexityConstraintProblem(
                                      I1, Edge, Val1, Val2, Thread) == 0)) {
                                 //		this->MetricContext.GetItemCoordinates(I1,P);
                                 this->GetItemCoordinates(I1, P);
@@ -684,7 +1011,7 @@ void vtkThreadedClustering<Metric>::ExecuteProcessWithDistances(
                                         I1, Cluster2);
                                     this->MetricContext
                                         .SubstractItemFromCluster(I1, Cluster1);
-                                    this->AddItemRingToProcess(
+                                    this->DispatchAddItemRingToProcess(
                                         I1, Process, Thread);
                                     this->NumberOfModifications[Thread]++;
                                     this->ClustersLastModification[Val1] =
@@ -692,9 +1019,10 @@ void vtkThreadedClustering<Metric>::ExecuteProcessWithDistances(
                                     this->ClustersLastModification[Val2] =
                                         this->NumberOfLoops;
                                 }
-                            }
+                            } else
+                                NumberOfConnexityRejects++;
                             if ((*Size2 != 1) &&
-                                (this->ThreadedConnexityConstraintProblem(
+                                (this->DispatchConnexityConstraintProblem(
                                      I2, Edge, Val2, Val1, Thread) == 0) &&
                                 (Result != 2)) {
                                 // Compute the energy when setting I2 to the
@@ -711,7 +1039,7 @@ void vtkThreadedClustering<Metric>::ExecuteProcessWithDistances(
                                         I2, Cluster1);
                                     this->MetricContext
                                         .SubstractItemFromCluster(I2, Cluster2);
-                                    this->AddItemRingToProcess(
+                                    this->DispatchAddItemRingToProcess(
                                         I2, Process, Thread);
                                     this->NumberOfModifications[Thread]++;
                                     this->ClustersLastModification[Val1] =
@@ -719,40 +1047,53 @@ void vtkThreadedClustering<Metric>::ExecuteProcessWithDistances(
                                     this->ClustersLastModification[Val2] =
                                         this->NumberOfLoops;
                                 }
-                            }
+                            } else if (Result != 2)
+                                NumberOfConnexityRejects++;
                         } else {
                             Result = 1;
+                            NumberOfSkippedEdges++;
                         }
 
                         if (Result == 1)
                             this->AddEdgeToProcess(Edge, Process);
                     }
-#ifdef THREADSAFECLUSTERING
-                    // release the lock on the clusters
-                    this->ClustersLocks[Val1]->Unlock();
-                    this->ClustersLocks[Val2]->Unlock();
-#endif
                 }
             }
         }
     }
+    this->SkippedEdges[Thread] += NumberOfSkippedEdges;
+    this->ConnexityRejects[Thread] += NumberOfConnexityRejects;
 }
 
-template <class Metric>
-int vtkThreadedClustering<Metric>::ProcessOneLoop()
+template <class Metric, class Derived>
+int vtkThreadedClustering<Metric, Derived>::ProcessOneLoop()
 {
     int i;
     vtkMultiThreader* Threader = vtkMultiThreader::New();
     Threader->SetSingleMethod(MyMainForClustering, (void*)this);
     Threader->SetNumberOfThreads(this->NumberOfThreads);
 
-    for (i = 0; i < this->NumberOfThreads + 1; i++)
+    for (i = 0; i < this->NumberOfThreads + 1; i++) {
         this->NumberOfModifications[i] = 0;
+        this->SkippedEdges[i] = 0;
+        this->ConnexityRejects[i] = 0;
+    }
+    vtkIdType NumberOfDeferredEdges = this->NumberOfDeferredEdges;
+    int NumberOfRounds = this->NumberOfRounds;
+    double Start = vtkClusteringTrace::GetTime();
+    if (this->Trace)
+        this->Trace->AddCounter(
+            this->NumberOfThreads, "frontier", "edges",
+            this->Frontier.GetNumberOfPoppedEdges());
+
+    this->ComputeClustersOwners();
+    for (i = 0; i < this->PoolSize; i++)
+        this->DeferredEdges[i].clear();
 
     Threader->SingleMethodExecute();
 
     this->StartTimes[this->NumberOfThreads] = this->Timer->GetUniversalTime();
-    this->ExecuteProcess(this->PoolSize - 1, this->NumberOfThreads);
+    this->ProcessDeferredEdges();
     this->StopTimes[this->NumberOfThreads] = this->Timer->GetUniversalTime();
 
     vtkPriorityQueue* Queue = this->PoolQueue1;
@@ -761,15 +1102,33 @@ int vtkThreadedClustering<Metric>::ProcessOneLoop()
     Threader->Delete();
 
     int NumberOfModifications = 0;
-    for (i = 0; i < this->NumberOfThreads + 1; i++)
+    for (i = 0; i < this->NumberOfThreads + 1; i++) {
         NumberOfModifications += this->NumberOfModifications[i];
+        this->NumberOfSkippedEdges += this->SkippedEdges[i];
+        this->NumberOfConnexityRejects += this->ConnexityRejects[i];
+    }
+
+    // the deferred edges are the contention points between threads
+    this->SetStageCounter(
+        "deferred_edges", this->NumberOfDeferredEdges - NumberOfDeferredEdges);
+    this->SetStageCounter("rounds", this->NumberOfRounds - NumberOfRounds);
+
+    if (this->Trace) {
+        this->Trace->AddCounter(
+            this->NumberOfThreads, "deferred", "edges",
+            this->NumberOfDeferredEdges - NumberOfDeferredEdges);
+        this->Trace->AddSpan(
+            this->NumberOfThreads, "loop", Start, vtkClusteringTrace::GetTime(),
+            "loop", this->NumberOfLoops, "modifications",
+            NumberOfModifications);
+    }
 
     this->DisplayThreadsTimings();
     return (NumberOfModifications);
 }
 
-template <class Metric>
-void vtkThreadedClustering<Metric>::DisplayThreadsTimings()
+template <class Metric, class Derived>
+void vtkThreadedClustering<Metric, Derived>::DisplayThreadsTimings()
 {
     int i;
     if (this->DisplayThreadsTimingsFlag) {
@@ -777,7 +1136,7 @@ void vtkThreadedClustering<Metric>::DisplayThreadsTimings()
         double LatestStop = this->StopTimes[0];
         double MeasuredTime;
         double GlobalDuration;
-        for (i = 0; i < NumberOfThreads + 1; i++) {
+        for (i = 0; i < this->NumberOfThreads + 1; i++) {
             MeasuredTime = this->StartTimes[i];
             if (MeasuredTime < EarliestStart)
                 EarliestStart = MeasuredTime;
@@ -789,21 +1148,21 @@ void vtkThreadedClustering<Metric>::DisplayThreadsTimings()
         cout << "Threads duration:" << GlobalDuration << " seconds" << endl;
 
         cout << "Starts    (relative):";
-        for (i = 0; i < NumberOfThreads + 1; i++)
+        for (i = 0; i < this->NumberOfThreads + 1; i++)
             cout
                 << (int)(100.0 * (this->StartTimes[i] - EarliestStart) / GlobalDuration)
                 << " ";
 
         cout << endl;
         cout << "Duration  (relative):";
-        for (i = 0; i < NumberOfThreads + 1; i++)
+        for (i = 0; i < this->NumberOfThreads + 1; i++)
             cout
                 << (int)(100.0 * (this->StopTimes[i] - this->StartTimes[i]) / GlobalDuration)
                 << " ";
 
         cout << endl;
         cout << "Stops     (relative):";
-        for (i = 0; i < NumberOfThreads + 1; i++)
+        for (i = 0; i < this->NumberOfThreads + 1; i++)
             cout
                 << (int)(100.0 * (this->StopTimes[i] - EarliestStart) / GlobalDuration)
                 << " ";
@@ -815,7 +1174,7 @@ void vtkThreadedClustering<Metric>::DisplayThreadsTimings()
             this->NumberOfIterations[0] - this->PreviousNumberOfIterations[0];
         int InstantNumber;
         int InstantNumberOfIeration = 0;
-        for (i = 0; i < NumberOfThreads + 1; i++) {
+        for (i = 0; i < this->NumberOfThreads + 1; i++) {
             InstantNumber = this->NumberOfIterations[i] -
                             this->PreviousNumberOfIterations[i];
             if (InstantNumber > MaxInstantNumberofIterations)
@@ -825,83 +1184,89 @@ void vtkThreadedClustering<Metric>::DisplayThreadsTimings()
         }
         if (1) {
             cout << "Iterations(relative):";
-            for (i = 0; i < NumberOfThreads + 1; i++)
+            for (i = 0; i < this->NumberOfThreads + 1; i++)
                 cout
                     << (int)(100.0 * ((double)(this->NumberOfIterations[i] - this->PreviousNumberOfIterations[i]) / ((double)InstantNumberOfIeration)))
                     << " ";
             cout << endl;
             cout << "Iterations          :";
-            for (i = 0; i < NumberOfThreads + 1; i++)
+            for (i = 0; i < this->NumberOfThreads + 1; i++)
                 cout << this->NumberOfIterations[i] << " ";
             cout << endl;
             cout << "Modifications       :";
-            for (i = 0; i < NumberOfThreads + 1; i++)
+            for (i = 0; i < this->NumberOfThreads + 1; i++)
                 cout << this->NumberOfModifications[i] << " ";
             cout << endl;
         }
 
-        for (i = 0; i < NumberOfThreads + 1; i++)
+        for (i = 0; i < this->NumberOfThreads + 1; i++)
             this->PreviousNumberOfIterations[i] = this->NumberOfIterations[i];
     }
 }
 
-template <class Metric>
-void vtkThreadedClustering<Metric>::SwapQueues()
+template <class Metric, class Derived>
+void vtkThreadedClustering<Metric, Derived>::SwapQueues()
 {
-    std::queue<int>** Temp = this->ProcessesPopQueues;
-    this->ProcessesPopQueues = this->ProcessesPushQueues;
-    this->ProcessesPushQueues = Temp;
+    this->Frontier.Swap(this->EdgesProcess, this->PoolSize);
 }
 
-template <class Metric>
-void vtkThreadedClustering<Metric>::Init()
+template <class Metric, class Derived>
+void vtkThreadedClustering<Metric, Derived>::Init()
 {
-    vtkUniformClustering<Metric>::Init();
+    vtkUniformClustering<Metric, vtkIdType, Derived>::Init();
     int i;
 
-    this->PoolSize = this->PoolingRatio * NumberOfThreads + 1;
+    if (this->Deterministic)
+        this->PoolSize = this->DeterministicPoolSize;
+    else
+        this->PoolSize = this->PoolingRatio * this->NumberOfThreads + 1;
+    this->StartStage("layout");
     this->ComputeEdgesLayout();
+    this->StopStage();
 
     // allocate statistics arrays
     this->PreviousNumberOfIterations = new int[this->NumberOfThreads + 1];
     this->NumberOfIterations = new int[this->NumberOfThreads + 1];
     this->NumberOfModifications = new int[this->NumberOfThreads + 1];
-    this->NumberOfLockingCollisions = new int[this->NumberOfThreads + 1];
+    this->SkippedEdges = new vtkIdType[this->NumberOfThreads + 1];
+    this->ConnexityRejects = new vtkIdType[this->NumberOfThreads + 1];
     this->StartTimes = new double[this->NumberOfThreads + 1];
     this->StopTimes = new double[this->NumberOfThreads + 1];
 
     this->ThreadsLists = new vtkIdList*[this->NumberOfThreads + 1];
 
-    for (i = 0; i < NumberOfThreads + 1; i++) {
+    for (i = 0; i < this->NumberOfThreads + 1; i++) {
         this->NumberOfIterations[i] = 0;
         this->PreviousNumberOfIterations[i] = 0;
         this->NumberOfModifications[i] = 0;
-        this->NumberOfLockingCollisions[i] = 0;
         this->ThreadsLists[i] = vtkIdList::New();
     }
 
-    // allocate queues
-    this->ProcessesQueues1 = new std::queue<int>*[this->PoolSize];
-    this->ProcessesQueues2 = new std::queue<int>*[this->PoolSize];
-    for (i = 0; i < this->PoolSize; i++) {
-        this->ProcessesQueues1[i] = new std::queue<int>[this->PoolSize];
-        this->ProcessesQueues2[i] = new std::queue<int>[this->PoolSize];
+    // one push buffer for each process
+    this->Frontier.Allocate(this->GetNumberOfEdges(), this->PoolSize);
+
+    // the deferred edges are processed in parallel, their pushing order
+    // depends on the number of threads
+    if (this->Deterministic)
+        this->Frontier.SetSortEdges(true);
+
+    this->ClustersOwners = new std::atomic<int>[this->NumberOfClusters];
+    this->ClustersReservations =
+        new std::atomic<vtkIdType>[this->NumberOfClusters];
+    this->DeferredEdges.resize(this->PoolSize);
+    this->NumberOfDeferredEdges = 0;
+    this->NumberOfRounds = 0;
+
+    if (this->Trace) {
+        this->Trace->Allocate(this->NumberOfThreads + 1);
+        for (i = 0; i < this->NumberOfThreads; i++)
+            this->Trace->SetThreadName(i, "worker");
+        this->Trace->SetThreadName(this->NumberOfThreads, "main");
     }
-
-    // set initial queues state
-    this->ProcessesPushQueues = this->ProcessesQueues1;
-    this->ProcessesPopQueues = this->ProcessesQueues2;
-
-#ifdef THREADSAFECLUSTERING
-    this->ClustersLocks =
-        new vtkMySimpleCriticalSection*[this->NumberOfClusters + 1];
-    for (i = 0; i < this->NumberOfClusters + 1; i++)
-        this->ClustersLocks[i] = vtkMySimpleCriticalSection::New();
-#endif
 }
 
-template <class Metric>
-void vtkThreadedClustering<Metric>::ComputeEdgesLayout()
+template <class Metric, class Derived>
+void vtkThreadedClustering<Metric, Derived>::ComputeEdgesLayout()
 {
     vtkIntArray* TempClustering = 0;
     vtkTimerLog* Timer = vtkTimerLog::New();
@@ -984,8 +1349,8 @@ void vtkThreadedClustering<Metric>::ComputeEdgesLayout()
     TempClustering->Delete();
 }
 
-template <class Metric>
-void vtkThreadedClustering<Metric>::ComputeMeshSlices(
+template <class Metric, class Derived>
+void vtkThreadedClustering<Metric, Derived>::ComputeMeshSlices(
     int NumberOfSlices, vtkIntArray* Clustering)
 {
     int i, j;
@@ -1073,8 +1438,8 @@ void vtkThreadedClustering<Metric>::ComputeMeshSlices(
     delete[] Weights;
 }
 
-template <class Metric>
-vtkThreadedClustering<Metric>::vtkThreadedClustering()
+template <class Metric, class Derived>
+vtkThreadedClustering<Metric, Derived>::vtkThreadedClustering()
 {
     this->EdgesLayoutComputingType = 1;
     this->DisplayThreadsTimingsFlag = 0;
@@ -1084,28 +1449,29 @@ vtkThreadedClustering<Metric>::vtkThreadedClustering()
     this->PoolAllocationLock2 = new vtkSimpleCriticalSection;
     this->EdgesProcess = 0;
 
-#ifdef THREADSAFECLUSTERING
-    this->ClustersLocks = 0;
-#endif
-
     // autoset the number of threads depending on the number of processors
     vtkMultiThreader* Threader = vtkMultiThreader::New();
     this->SetNumberOfThreads(Threader->GetNumberOfThreads());
     Threader->Delete();
 
     this->PoolingRatio = 5;
+    this->DeterministicPoolSize = 129;
+    this->ClustersOwners = 0;
+    this->ClustersReservations = 0;
+    this->NumberOfDeferredEdges = 0;
+    this->NumberOfRounds = 0;
+    this->Trace = 0;
 
     this->PoolQueue1 = vtkPriorityQueue::New();
     this->PoolQueue2 = vtkPriorityQueue::New();
 
-    this->ProcessesQueues1 = 0;
-    this->ProcessesQueues2 = 0;
+    this->ThreadsLists = 0;
 
     this->NumberOfClusters = 0;
 }
 
-template <class Metric>
-vtkThreadedClustering<Metric>::~vtkThreadedClustering()
+template <class Metric, class Derived>
+vtkThreadedClustering<Metric, Derived>::~vtkThreadedClustering()
 {
     this->Timer->Delete();
     delete this->PoolAllocationLock;
@@ -1116,35 +1482,25 @@ vtkThreadedClustering<Metric>::~vtkThreadedClustering()
     if (this->EdgesProcess)
         delete[] this->EdgesProcess;
 
-    if (this->ProcessesQueues1) {
-        for (int i = 0; i < PoolSize; i++) {
-            delete[] this->ProcessesQueues1[i];
-            delete[] this->ProcessesQueues2[i];
-        }
-        delete[] this->ProcessesQueues1;
-        delete[] this->ProcessesQueues2;
+    if (this->ClustersOwners) {
+        delete[] this->ClustersOwners;
+        delete[] this->ClustersReservations;
+    }
 
+    if (this->ThreadsLists) {
         // delete statistics arrays
         delete[] this->PreviousNumberOfIterations;
         delete[] this->NumberOfIterations;
         delete[] this->NumberOfModifications;
-        delete[] this->NumberOfLockingCollisions;
+        delete[] this->SkippedEdges;
+        delete[] this->ConnexityRejects;
         delete[] this->StartTimes;
         delete[] this->StopTimes;
 
-        for (int i = 0; i < NumberOfThreads + 1; i++)
+        for (int i = 0; i < this->NumberOfThreads + 1; i++)
             this->ThreadsLists[i]->Delete();
         delete[] this->ThreadsLists;
     }
-
-#ifdef THREADSAFECLUSTERING
-    if (this->ClustersLocks) {
-        int i;
-        for (i = 0; i < this->NumberOfClusters + 1; i++)
-            this->ClustersLocks[i]->Delete();
-        delete[] this->ClustersLocks;
-    }
-#endif
 }
 
 #endif
@@ -55,6 +55,15 @@ public:
     };
 
 protected:
+    // the clustering engines call the methods below directly when they are
+    // statically dispatched (see vtkStaticDiscreteRemeshing)
+    template <class, typename, class>
+    friend class vtkUniformClustering;
+#ifdef DOmultithread
+    template <class, class>
+    friend class vtkThreadedClustering;
+#endif
+
     int GetNumberOfDualItems() { return (this->Input->GetNumberOfPoints()); };
 
     vtkTrianglesProcessing()
@@ -145,7 +154,7 @@ protected:
 #ifdef DOmultithread
     /// adds the Item three adjacent edges to the list of edges to process.
     /// This is the method for multithreaded clustering
-    void AddItemRingToProcess(vtkIdType Item, int ProcessId)
+    void AddItemRingToProcess(vtkIdType Item, int ProcessId, int Thread)
     {
         int v1, v2, v3;
         this->GetInput()->GetFaceVertices(Item, v1, v2, v3);
@@ -173,7 +182,8 @@ protected:
 
     /// check if moving the face Item from Cluster will not make Cluster
     /// non-connex
-    int ConnexityConstraintProblem(vtkIdType Item, int Edge, int Cluster)
+    int ConnexityConstraintProblem(
+        vtkIdType Item, vtkIdType Edge, vtkIdType Cluster, vtkIdType Cluster2)
     {
         int f1, f2, v1, v2, v3, v4, i, Cluster1;
         int NumberOfEdges, *Edges;
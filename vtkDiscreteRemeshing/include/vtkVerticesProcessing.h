@@ -34,6 +34,7 @@
 #define _VTKVERTICESPROCESSING_H_
 
 #include "vtkObjectFactory.h"
+#include "vtkSurfaceIterators.h"
 
 /**
  *  This class derives from vtkUniformClustering. It is aimed at constructing
@@ -59,6 +60,15 @@ public:
     int GetNumberOfItems() { return (this->GetInput()->GetNumberOfPoints()); };
 
 protected:
+    // the clustering engines call the methods below directly when they are
+    // statically dispatched (see vtkStaticDiscreteRemeshing)
+    template <class, typename, class>
+    friend class vtkUniformClustering;
+#ifdef DOmultithread
+    template <class, class>
+    friend class vtkThreadedClustering;
+#endif
+
     vtkVerticesProcessing()
     {
         this->ClusteringType = 1;
@@ -109,9 +119,9 @@ protected:
         this->Processing::Init();
     };
 
-    void AddItemRingToProcess(vtkIdType Item, int ProcessId)
+    void AddItemRingToProcess(vtkIdType Item, int ProcessId, int Thread)
     {
-        int NumberOfEdges, *Edges, i;
+        vtkIdType NumberOfEdges, *Edges, i;
         this->GetInput()->GetVertexNeighbourEdges(Item, NumberOfEdges, Edges);
         for (i = 0; i < NumberOfEdges; i++)
             this->AddEdgeToProcess(Edges[i], ProcessId);
@@ -143,7 +153,7 @@ private:
         vtkIdType NumberOfEdges, *Edges, i;
         this->GetInput()->GetVertexNeighbourEdges(Item, NumberOfEdges, Edges);
         for (i = 0; i < NumberOfEdges; i++)
-            this->EdgeQueue.push(Edges[i]);
+            this->Frontier.Push(Edges[i]);
     };
 
     void GetEdgeItems(vtkIdType Item, vtkIdType& I1, vtkIdType& I2)
@@ -165,8 +175,61 @@ private:
             Item, Edge, Cluster, this->VList, this->VQueue);
     };
 
-    /// check if moving the face Item from Cluster will not make Cluster
-    /// non-connex
+    /// returns the number of runs of consecutive vertices belonging to
+    /// Cluster in the oriented one-ring of Item, or -1 when the one-ring is
+    /// not a single closed fan (boundary or non-manifold vertex)
+    int GetNumberOfClusterRunsInRing(vtkIdType Item, vtkIdType Cluster)
+    {
+        vtkSurface* Input = this->GetInput();
+        vtkIdType NumberOfEdges, *Edges, i;
+        Input->GetVertexNeighbourEdges(Item, NumberOfEdges, Edges);
+        if (NumberOfEdges < 3)
+            return (-1);
+        for (i = 0; i < NumberOfEdges; i++) {
+            if (!Input->IsEdgeManifold(Edges[i]))
+                return (-1);
+        }
+
+        vtkSurfaceVertexRingOrientedIterator Iterator;
+        Iterator.SetInputData(Input);
+        Iterator.InitTraversal(Item);
+
+        vtkIdType FirstVertex = Iterator.GetVertex();
+        bool FirstIn = (this->Clustering->GetValue(FirstVertex) == Cluster);
+        bool PreviousIn = FirstIn;
+        vtkIdType NumberOfVisitedVertices = 1;
+        int NumberOfRuns = 0;
+
+        while (true) {
+            vtkIdType Vertex = Iterator.GetNextVertex();
+            if (Vertex < 0)
+                return (-1);
+            if (Vertex == FirstVertex)
+                break;
+
+            // the fan should not have more vertices than edges
+            if (++NumberOfVisitedVertices > NumberOfEdges)
+                return (-1);
+            bool In = (this->Clustering->GetValue(Vertex) == Cluster);
+            if (In && !PreviousIn)
+                NumberOfRuns++;
+            PreviousIn = In;
+        }
+
+        // several fans sharing the same vertex
+        if (NumberOfVisitedVertices != NumberOfEdges)
+            return (-1);
+
+        if (FirstIn && (!PreviousIn || (NumberOfRuns == 0)))
+            NumberOfRuns++;
+        return (NumberOfRuns);
+    }
+
+    /// check if moving the vertex Item from Cluster will not make Cluster
+    /// non-connex. When the cluster vertices of the one-ring form a single
+    /// run, the answer is immediate. Otherwise (or for boundary and
+    /// non-manifold vertices), a breadth-first search through the one-ring
+    /// edges is performed.
     int ConnexityConstraintProblemLocal(
         vtkIdType Item,
         vtkIdType Edge,
@@ -177,6 +240,10 @@ private:
         if (!this->ConnexityConstraint)
             return (0);
 
+        int NumberOfRuns = this->GetNumberOfClusterRunsInRing(Item, Cluster);
+        if ((NumberOfRuns == 0) || (NumberOfRuns == 1))
+            return (0);
+
         VList->Reset();
         while (VQueue.size())
             VQueue.pop();
@@ -0,0 +1,296 @@
+/*=========================================================================
+
+  Program:   Batch remeshing of many meshes on a shared thread pool
+  Module:    vtkBatchRemeshing.cxx
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+#include <vtkCellData.h>
+#include <vtkTimerLog.h>
+
+#include "vtkBatchRemeshing.h"
+#include "vtkIsotropicDiscreteRemeshing.h"
+
+// rough sizes used to estimate the footprint of a job before reading its
+// input : the number of bytes of a mesh file per vertex (binary files are
+// smaller, so that the estimate is conservative for them), and the number
+// of bytes per vertex of a vtkSurface with its edges, rings and clustering
+// arrays
+static const double FileBytesPerVertex = 32;
+static const double MemoryBytesPerVertex = 512;
+
+struct vtkBatchRemeshing::Pool
+{
+    vtkBatchRemeshing* Batch;
+
+    std::mutex Mutex;
+    std::condition_variable JobFinished;
+
+    // the waiting jobs, by decreasing footprint
+    std::vector<int> Waiting;
+
+    // the resources not reserved by the running jobs
+    int FreeThreads;
+    double FreeMemory;
+    int NumberOfRunningJobs;
+    int NumberOfFinishedJobs;
+
+    // returns true when the running jobs leave room for J
+    bool Fits(const Job& J)
+    {
+        if (J.NumberOfThreads > this->FreeThreads)
+            return (false);
+        if ((this->NumberOfRunningJobs == 0) || (this->Batch->MemoryLimit <= 0))
+            return (true);
+        return (J.EstimatedMemory <= this->FreeMemory);
+    }
+};
+
+vtkBatchRemeshing::vtkBatchRemeshing()
+{
+    this->NumberOfThreads = 0;
+    this->MemoryLimit = 0;
+    this->VerticesPerThread = 200000;
+    this->Gradation = 0;
+    this->SubsamplingThreshold = 10;
+    this->InputReordering = vtkSurface::NO_REORDERING;
+    this->ConsoleOutput = 1;
+}
+
+void vtkBatchRemeshing::AddJob(
+    const char* InputFile,
+    const char* OutputFile,
+    int NumberOfVertices,
+    double Gradation)
+{
+    Job J;
+    J.InputFile = InputFile;
+    J.OutputFile = OutputFile;
+    J.NumberOfVertices = NumberOfVertices;
+    J.Gradation = Gradation;
+    J.EstimatedMemory = 0;
+    J.NumberOfThreads = 1;
+    J.Status = JOB_PENDING;
+    J.Time = 0;
+    this->Jobs.push_back(J);
+}
+
+bool vtkBatchRemeshing::ReadManifest(const char* FileName)
+{
+    std::ifstream File(FileName);
+    if (!File.is_open()) {
+        cout << "Could not open manifest " << FileName << endl;
+        return (false);
+    }
+
+    std::vector<Job> Jobs;
+    std::string Line;
+    int LineNumber = 0;
+    while (std::getline(File, Line)) {
+        LineNumber++;
+        std::istringstream Fields(Line);
+        std::string InputFile, OutputFile;
+        if (!(Fields >> InputFile) || (InputFile[0] == '#'))
+            continue;
+
+        Job J;
+        J.Gradation = this->Gradation;
+        if (!(Fields >> OutputFile >> J.NumberOfVertices) ||
+            (J.NumberOfVertices < 1)) {
+            cout << FileName << ", line " << LineNumber
+                 << " : expected 'input output number_of_vertices "
+                    "[gradation]'"
+                 << endl;
+            return (false);
+        }
+        double Gradation;
+        if (Fields >> Gradation)
+            J.Gradation = Gradation;
+        J.InputFile = InputFile;
+        J.OutputFile = OutputFile;
+        J.EstimatedMemory = 0;
+        J.NumberOfThreads = 1;
+        J.Status = JOB_PENDING;
+        J.Time = 0;
+        Jobs.push_back(J);
+    }
+
+    this->Jobs.insert(this->Jobs.end(), Jobs.begin(), Jobs.end());
+    return (true);
+}
+
+void vtkBatchRemeshing::EstimateJob(Job& J, int PoolSize)
+{
+    // the input mesh, and the mesh actually clustered, which is subdivided
+    // up to NumberOfVertices x SubsamplingThreshold vertices
+    std::ifstream File(J.InputFile.c_str(), std::ios::binary | std::ios::ate);
+    double FileSize = File.is_open() ? (double)File.tellg() : 0;
+    double InputVertices = FileSize / FileBytesPerVertex;
+    double ClusteredVertices = std::max(
+        InputVertices, (double)J.NumberOfVertices * this->SubsamplingThreshold);
+    J.EstimatedMemory =
+        (InputVertices + ClusteredVertices) * MemoryBytesPerVertex;
+
+    double Threads = 1;
+    if (this->VerticesPerThread > 0)
+        Threads = std::ceil(ClusteredVertices / this->VerticesPerThread);
+    J.NumberOfThreads = (int)std::min(std::max(Threads, 1.0), (double)PoolSize);
+}
+
+bool vtkBatchRemeshing::ProcessJob(Job& J)
+{
+    std::ifstream File(J.InputFile.c_str());
+    if (!File.is_open())
+        return (false);
+    File.close();
+
+    vtkSurface* Mesh = vtkSurface::New();
+    Mesh->CreateFromFile(J.InputFile.c_str());
+    Mesh->GetCellData()->Initialize();
+    if ((Mesh->GetNumberOfPoints() == 0) || (Mesh->GetNumberOfCells() == 0)) {
+        Mesh->Delete();
+        return (false);
+    }
+
+    vtkIsotropicDiscreteRemeshing* Remesh =
+        vtkIsotropicDiscreteRemeshing::New();
+    Remesh->SetInput(Mesh);
+    Mesh->Delete();
+    Remesh->SetNumberOfClusters(J.NumberOfVertices);
+    Remesh->SetConsoleOutput(0);
+    Remesh->SetSubsamplingThreshold(this->SubsamplingThreshold);
+    Remesh->SetInputReordering(this->InputReordering);
+    Remesh->SetNumberOfThreads(J.NumberOfThreads);
+    if (!this->CurvatureCacheDirectory.empty())
+        Remesh->SetCurvatureCacheDirectory(
+            this->CurvatureCacheDirectory.c_str());
+    Remesh->GetMetric()->SetGradation(J.Gradation);
+    Remesh->Remesh();
+
+    bool Success = Remesh->GetOutput()->GetNumberOfPoints() > 0;
+    if (Success)
+        Remesh->GetOutput()->WriteToFile(J.OutputFile.c_str());
+    Remesh->Delete();
+    return (Success);
+}
+
+VTK_THREAD_RETURN_TYPE vtkBatchRemeshing::Worker(void* arg)
+{
+    vtkMultiThreader::ThreadInfo* Info = (vtkMultiThreader::ThreadInfo*)arg;
+    Pool* P = (Pool*)Info->UserData;
+    vtkBatchRemeshing* Batch = P->Batch;
+
+    std::unique_lock<std::mutex> Lock(P->Mutex);
+    while (!P->Waiting.empty()) {
+        // take the largest waiting job which fits, or wait for a running
+        // job to free its resources
+        std::vector<int>::iterator Next = P->Waiting.begin();
+        while ((Next != P->Waiting.end()) && !P->Fits(Batch->Jobs[*Next]))
+            Next++;
+        if (Next == P->Waiting.end()) {
+            P->JobFinished.wait(Lock);
+            continue;
+        }
+
+        Job& J = Batch->Jobs[*Next];
+        P->Waiting.erase(Next);
+        P->FreeThreads -= J.NumberOfThreads;
+        P->FreeMemory -= J.EstimatedMemory;
+        P->NumberOfRunningJobs++;
+        Lock.unlock();
+
+        double StartTime = vtkTimerLog::GetUniversalTime();
+        bool Success = Batch->ProcessJob(J);
+        double Time = vtkTimerLog::GetUniversalTime() - StartTime;
+
+        Lock.lock();
+        J.Status = Success ? JOB_DONE : JOB_FAILED;
+        J.Time = Time;
+        P->FreeThreads += J.NumberOfThreads;
+        P->FreeMemory += J.EstimatedMemory;
+        P->NumberOfRunningJobs--;
+        P->NumberOfFinishedJobs++;
+        if (Batch->ConsoleOutput) {
+            cout << "[" << P->NumberOfFinishedJobs << "/"
+                 << Batch->Jobs.size() << "] " << J.InputFile << " : "
+                 << (Success ? "done" : "FAILED") << " in " << Time
+                 << "s, " << J.NumberOfThreads << " thread(s)" << endl;
+        }
+        P->JobFinished.notify_all();
+    }
+    return (VTK_THREAD_RETURN_VALUE);
+}
+
+int vtkBatchRemeshing::Run()
+{
+    int PoolSize = this->NumberOfThreads;
+    if (PoolSize <= 0)
+        PoolSize = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    if (PoolSize > VTK_MAX_THREADS)
+        PoolSize = VTK_MAX_THREADS;
+
+    Pool P;
+    P.Batch = this;
+    for (int Id = 0; Id < (int)this->Jobs.size(); Id++) {
+        if (this->Jobs[Id].Status != JOB_PENDING)
+            continue;
+        this->EstimateJob(this->Jobs[Id], PoolSize);
+        P.Waiting.push_back(Id);
+    }
+    std::stable_sort(P.Waiting.begin(), P.Waiting.end(), [&](int A, int B) {
+        return (
+            this->Jobs[A].EstimatedMemory > this->Jobs[B].EstimatedMemory);
+    });
+    P.FreeThreads = PoolSize;
+    P.FreeMemory = this->MemoryLimit * 1048576.0;
+    P.NumberOfRunningJobs = 0;
+    P.NumberOfFinishedJobs = 0;
+
+    if (!P.Waiting.empty()) {
+        int NumberOfWorkers = std::min(PoolSize, (int)P.Waiting.size());
+        vtkMultiThreader* Threader = vtkMultiThreader::New();
+        Threader->SetNumberOfThreads(NumberOfWorkers);
+        Threader->SetSingleMethod(vtkBatchRemeshing::Worker, (void*)&P);
+        Threader->SingleMethodExecute();
+        Threader->Delete();
+    }
+
+    int NumberOfFailedJobs = 0;
+    for (int Id = 0; Id < (int)this->Jobs.size(); Id++) {
+        if (this->Jobs[Id].Status == JOB_FAILED)
+            NumberOfFailedJobs++;
+    }
+    return (NumberOfFailedJobs);
+}
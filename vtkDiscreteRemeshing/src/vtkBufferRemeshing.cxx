@@ -0,0 +1,212 @@
+/*=========================================================================
+
+  Program:   Remeshing of meshes stored in raw buffers
+  Module:    vtkBufferRemeshing.cxx
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+
+#include "vtkBufferRemeshing.h"
+#include "vtkIsotropicDiscreteRemeshing.h"
+
+vtkBufferRemeshing::vtkBufferRemeshing()
+{
+    this->InputPoints = 0;
+    this->IntTriangles = 0;
+    this->IdTriangles = 0;
+    this->NumberOfInputTriangles = 0;
+    this->NumberOfVertices = 1000;
+    this->Gradation = 0;
+    this->SubsamplingThreshold = 10;
+    this->InputReordering = vtkSurface::NO_REORDERING;
+    this->ConsoleOutput = 0;
+    this->Output.Points = 0;
+    this->Output.NumberOfPoints = 0;
+    this->Output.Triangles = 0;
+    this->Output.NumberOfTriangles = 0;
+    this->Output.Clustering = 0;
+    this->Output.NumberOfInputPoints = 0;
+}
+
+vtkBufferRemeshing::~vtkBufferRemeshing()
+{
+    if (this->InputPoints)
+        this->InputPoints->Delete();
+}
+
+void vtkBufferRemeshing::SetInputCoordinates(vtkDataArray* Coordinates)
+{
+    if (this->InputPoints)
+        this->InputPoints->Delete();
+    this->InputPoints = vtkPoints::New();
+    this->InputPoints->SetData(Coordinates);
+    Coordinates->Delete();
+}
+
+// the arrays wrap the buffer (save = 1) : VTK will neither reallocate nor
+// free it, and the remeshing only reads the input points
+void vtkBufferRemeshing::SetInputPoints(
+    const float* Points, vtkIdType NumberOfPoints)
+{
+    vtkFloatArray* Coordinates = vtkFloatArray::New();
+    Coordinates->SetNumberOfComponents(3);
+    Coordinates->SetArray(const_cast<float*>(Points), 3 * NumberOfPoints, 1);
+    this->SetInputCoordinates(Coordinates);
+}
+
+void vtkBufferRemeshing::SetInputPoints(
+    const double* Points, vtkIdType NumberOfPoints)
+{
+    vtkDoubleArray* Coordinates = vtkDoubleArray::New();
+    Coordinates->SetNumberOfComponents(3);
+    Coordinates->SetArray(const_cast<double*>(Points), 3 * NumberOfPoints, 1);
+    this->SetInputCoordinates(Coordinates);
+}
+
+void vtkBufferRemeshing::SetInputTriangles(
+    const int* Triangles, vtkIdType NumberOfTriangles)
+{
+    this->IntTriangles = Triangles;
+    this->IdTriangles = 0;
+    this->NumberOfInputTriangles = NumberOfTriangles;
+}
+
+void vtkBufferRemeshing::SetInputTriangles(
+    const vtkIdType* Triangles, vtkIdType NumberOfTriangles)
+{
+    this->IntTriangles = 0;
+    this->IdTriangles = Triangles;
+    this->NumberOfInputTriangles = NumberOfTriangles;
+}
+
+template <class IdType>
+bool vtkBufferRemeshing::CheckTriangles(const IdType* Triangles)
+{
+    vtkIdType NumberOfPoints = this->InputPoints->GetNumberOfPoints();
+    for (vtkIdType i = 0; i < 3 * this->NumberOfInputTriangles; i++) {
+        if ((Triangles[i] < 0) || ((vtkIdType)Triangles[i] >= NumberOfPoints))
+            return (false);
+    }
+    return (true);
+}
+
+bool vtkBufferRemeshing::Remesh()
+{
+    if (!this->InputPoints || (!this->IntTriangles && !this->IdTriangles) ||
+        (this->NumberOfInputTriangles == 0))
+        return (false);
+
+    vtkSurface* Mesh = vtkSurface::New();
+    if (this->IntTriangles) {
+        if (!this->CheckTriangles(this->IntTriangles)) {
+            Mesh->Delete();
+            return (false);
+        }
+        Mesh->CreateFromTriangles(
+            this->InputPoints, this->IntTriangles,
+            this->NumberOfInputTriangles);
+    } else {
+        if (!this->CheckTriangles(this->IdTriangles)) {
+            Mesh->Delete();
+            return (false);
+        }
+        Mesh->CreateFromTriangles(
+            this->InputPoints, this->IdTriangles,
+            this->NumberOfInputTriangles);
+    }
+
+    vtkIsotropicDiscreteRemeshing* Remesh =
+        vtkIsotropicDiscreteRemeshing::New();
+    Remesh->SetInput(Mesh);
+    Mesh->Delete();
+    Remesh->SetNumberOfClusters(this->NumberOfVertices);
+    Remesh->SetConsoleOutput(this->ConsoleOutput);
+    Remesh->SetSubsamplingThreshold(this->SubsamplingThreshold);
+    Remesh->SetInputReordering(this->InputReordering);
+    Remesh->GetMetric()->SetGradation(this->Gradation);
+    Remesh->Remesh();
+
+    // the output triangles, polygons being split in fans
+    vtkSurface* Remeshed = Remesh->GetOutput();
+    vtkIdType NumberOfPoints = Remeshed->GetNumberOfPoints();
+    vtkIdType NumberOfTriangles = 0;
+    vtkIdType NumberOfFaceVertices, *FaceVertices;
+    vtkIdType Face;
+    for (Face = 0; Face < Remeshed->GetNumberOfCells(); Face++) {
+        if (!Remeshed->IsFaceActive(Face))
+            continue;
+        Remeshed->GetFaceVertices(Face, NumberOfFaceVertices, FaceVertices);
+        NumberOfTriangles += NumberOfFaceVertices - 2;
+    }
+    vtkIdType NumberOfInputPoints = this->InputPoints->GetNumberOfPoints();
+
+    this->Block.resize(
+        3 * NumberOfPoints * sizeof(double) +
+        (3 * NumberOfTriangles + NumberOfInputPoints) * sizeof(vtkIdType));
+    double* Points = (double*)this->Block.data();
+    vtkIdType* Triangles = (vtkIdType*)(Points + 3 * NumberOfPoints);
+    vtkIdType* Clustering = Triangles + 3 * NumberOfTriangles;
+
+    for (vtkIdType Vertex = 0; Vertex < NumberOfPoints; Vertex++)
+        Remeshed->GetPoint(Vertex, Points + 3 * Vertex);
+
+    vtkIdType* Triangle = Triangles;
+    for (Face = 0; Face < Remeshed->GetNumberOfCells(); Face++) {
+        if (!Remeshed->IsFaceActive(Face))
+            continue;
+        Remeshed->GetFaceVertices(Face, NumberOfFaceVertices, FaceVertices);
+        for (vtkIdType j = 1; j < NumberOfFaceVertices - 1; j++) {
+            *Triangle++ = FaceVertices[0];
+            *Triangle++ = FaceVertices[j];
+            *Triangle++ = FaceVertices[j + 1];
+        }
+    }
+
+    // the input points are the first items, as a subdivision appends its
+    // new vertices, possibly after a reordering
+    vtkIntArray* Clusters = Remesh->GetClustering();
+    vtkIdTypeArray* Permutation = Remesh->GetInputPermutation();
+    for (vtkIdType Item = 0; Item < NumberOfInputPoints; Item++) {
+        vtkIdType Point = Permutation ? Permutation->GetValue(Item) : Item;
+        vtkIdType Cluster = Clusters->GetValue(Item);
+        if ((Cluster < 0) || (Cluster >= NumberOfPoints))
+            Cluster = -1;
+        Clustering[Point] = Cluster;
+    }
+
+    this->Output.Points = Points;
+    this->Output.NumberOfPoints = NumberOfPoints;
+    this->Output.Triangles = Triangles;
+    this->Output.NumberOfTriangles = NumberOfTriangles;
+    this->Output.Clustering = Clustering;
+    this->Output.NumberOfInputPoints = NumberOfInputPoints;
+
+    Remesh->Delete();
+    return (true);
+}
@@ -0,0 +1,179 @@
+/*=========================================================================
+
+  Program:   Cache of the inputs of repeated remeshings
+  Module:    vtkRemeshingCache.cxx
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+
+#include "vtkContentHash.h"
+#include "vtkRemeshingCache.h"
+
+vtkRemeshingCache::vtkRemeshingCache()
+{
+    this->MaximumSize = 1024 * 1048576.0;
+    this->Size = 0;
+    this->NumberOfHits = 0;
+    this->NumberOfMisses = 0;
+}
+
+vtkRemeshingCache::~vtkRemeshingCache() { this->Clear(); }
+
+void vtkRemeshingCache::SetMaximumSize(double M)
+{
+    this->MaximumSize = M * 1048576.0;
+    this->Trim();
+}
+
+void vtkRemeshingCache::Clear()
+{
+    std::list<Entry>::iterator Iterator;
+    for (Iterator = this->Entries.begin(); Iterator != this->Entries.end();
+         Iterator++)
+        Iterator->Object->UnRegister(0);
+    this->Entries.clear();
+    this->Index.clear();
+    this->Size = 0;
+}
+
+vtkObject* vtkRemeshingCache::Find(const EntryKey& Key)
+{
+    std::map<EntryKey, std::list<Entry>::iterator>::iterator Found =
+        this->Index.find(Key);
+    if (Found == this->Index.end()) {
+        this->NumberOfMisses++;
+        return (0);
+    }
+    this->NumberOfHits++;
+    this->Entries.splice(this->Entries.begin(), this->Entries, Found->second);
+    return (Found->second->Object);
+}
+
+void vtkRemeshingCache::Insert(
+    const EntryKey& Key, vtkObject* Object, double Size)
+{
+    Object->Register(0);
+    Entry NewEntry;
+    NewEntry.Key = Key;
+    NewEntry.Object = Object;
+    NewEntry.Size = Size;
+    this->Entries.push_front(NewEntry);
+    this->Index[Key] = this->Entries.begin();
+    this->Size += Size;
+    this->Trim();
+}
+
+void vtkRemeshingCache::Trim()
+{
+    // the most recent entry is kept even when it is larger than the cache
+    while ((this->Size > this->MaximumSize) && (this->Entries.size() > 1)) {
+        Entry& Oldest = this->Entries.back();
+        this->Size -= Oldest.Size;
+        Oldest.Object->UnRegister(0);
+        this->Index.erase(Oldest.Key);
+        this->Entries.pop_back();
+    }
+}
+
+vtkSurface* vtkRemeshingCache::GetMesh(
+    const char* FileName, int Reordering, unsigned long long& Key)
+{
+    vtkContentHash Hash;
+    if (!Hash.AddFile(FileName))
+        return (0);
+    Key = Hash.Get();
+
+    EntryKey MeshKey;
+    MeshKey.Hash = Key;
+    MeshKey.Type = MESH_ENTRY;
+    MeshKey.Parameters = Reordering;
+    vtkSurface* Mesh = (vtkSurface*)this->Find(MeshKey);
+    if (Mesh)
+        return (Mesh);
+
+    Mesh = vtkSurface::New();
+    Mesh->CreateFromFile(FileName);
+    Mesh->GetCellData()->Initialize();
+    if ((Mesh->GetNumberOfPoints() == 0) || (Mesh->GetNumberOfCells() == 0)) {
+        Mesh->Delete();
+        return (0);
+    }
+    if (Reordering != vtkSurface::NO_REORDERING)
+        Mesh->Reorder(Reordering);
+
+    // the polydata arrays, and the edges with their two vertices, two faces
+    // and their two references in the rings of their vertices
+    double Size = 1024.0 * Mesh->GetActualMemorySize() +
+                  6.0 * sizeof(vtkIdType) * Mesh->GetNumberOfEdges();
+    this->Insert(MeshKey, Mesh, Size);
+    Mesh->Delete();
+    return (Mesh);
+}
+
+vtkRemeshingCache::EntryKey vtkRemeshingCache::GetCurvatureKey(
+    unsigned long long Key,
+    int Reordering,
+    int ClusteringType,
+    int PrincipalDirections)
+{
+    EntryKey CurvatureKey;
+    CurvatureKey.Hash = Key;
+    CurvatureKey.Type = CURVATURE_ENTRY;
+    CurvatureKey.Parameters =
+        4 * Reordering + 2 * ClusteringType + (PrincipalDirections ? 1 : 0);
+    return (CurvatureKey);
+}
+
+vtkDataArrayCollection* vtkRemeshingCache::GetCurvature(
+    unsigned long long Key,
+    int Reordering,
+    int ClusteringType,
+    int PrincipalDirections)
+{
+    return ((vtkDataArrayCollection*)this->Find(GetCurvatureKey(
+        Key, Reordering, ClusteringType, PrincipalDirections)));
+}
+
+void vtkRemeshingCache::SetCurvature(
+    unsigned long long Key,
+    int Reordering,
+    int ClusteringType,
+    int PrincipalDirections,
+    vtkDataArrayCollection* Curvature)
+{
+    EntryKey CurvatureKey =
+        GetCurvatureKey(Key, Reordering, ClusteringType, PrincipalDirections);
+    if (!Curvature || this->Index.count(CurvatureKey))
+        return;
+
+    double Size = 0;
+    for (int i = 0; i < Curvature->GetNumberOfItems(); i++)
+        Size += 1024.0 * Curvature->GetItem(i)->GetActualMemorySize();
+    this->Insert(CurvatureKey, Curvature, Size);
+}
@@ -0,0 +1,151 @@
+/*=========================================================================
+
+Program:   Cached attributes test
+Module:    TestAttributeCache.cxx
+Language:  C++
+Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+// .NAME TestAttributeCache
+// .SECTION Description
+// Edits a mesh with cached attributes (moved vertices, flipped and bisected
+// edges, switched orientation), and checks that the incrementally updated
+// attributes are equal to a complete computation. Also checks that getting
+// the attributes of a clean mesh does not modify them.
+
+#include <cmath>
+#include <iostream>
+
+#include "vtkRandomTriangulation.h"
+#include "vtkSurface.h"
+
+using namespace std;
+
+// returns a copy of Array
+static vtkDoubleArray* Copy(vtkDoubleArray* Array)
+{
+    vtkDoubleArray* Result = vtkDoubleArray::New();
+    Result->DeepCopy(Array);
+    return (Result);
+}
+
+// compares the incrementally updated attribute with a complete computation,
+// and releases it. Returns 1 if they differ
+static int Compare(
+    const char* Name, vtkDoubleArray* Incremental, vtkDoubleArray* Full)
+{
+    int Failed = 0;
+    vtkIdType Size = Full->GetNumberOfTuples() * Full->GetNumberOfComponents();
+    if (Incremental->GetNumberOfTuples() != Full->GetNumberOfTuples()) {
+        cout << Name << " : " << Incremental->GetNumberOfTuples()
+             << " values instead of " << Full->GetNumberOfTuples() << endl;
+        Failed = 1;
+    } else {
+        for (vtkIdType i = 0; i < Size; i++) {
+            double Difference =
+                fabs(Incremental->GetValue(i) - Full->GetValue(i));
+            if (Difference > 1e-12 * (1 + fabs(Full->GetValue(i)))) {
+                cout << Name << " : value " << i << " is "
+                     << Incremental->GetValue(i) << " instead of "
+                     << Full->GetValue(i) << endl;
+                Failed = 1;
+                break;
+            }
+        }
+    }
+    Incremental->Delete();
+    return (Failed);
+}
+
+int main()
+{
+    vtkSurface* Mesh = vtkRandomTriangulation::BuildRandomTriangulation(
+        5000, 8);
+    int Failed = 0;
+
+    // the first calls compute the attributes, the next ones must leave them
+    // untouched
+    vtkDoubleArray* Arrays[4] = {
+        Mesh->GetTrianglesNormals(), Mesh->GetTrianglesAreas(),
+        Mesh->GetVerticesAreas(), Mesh->GetEdgeLengths()};
+    vtkMTimeType Times[4];
+    for (int i = 0; i < 4; i++)
+        Times[i] = Arrays[i]->GetMTime();
+    Mesh->GetTrianglesNormals();
+    Mesh->GetTrianglesAreas();
+    Mesh->GetVerticesAreas();
+    Mesh->GetEdgeLengths();
+    for (int i = 0; i < 4; i++) {
+        if (Arrays[i]->GetMTime() != Times[i]) {
+            cout << "Attribute " << i << " was modified on a clean mesh"
+                 << endl;
+            Failed = 1;
+        }
+    }
+
+    // local edits
+    double Point[3];
+    for (vtkIdType Vertex = 0; Vertex < Mesh->GetNumberOfPoints();
+         Vertex += 53) {
+        Mesh->GetPoint(Vertex, Point);
+        Point[0] += 0.01;
+        Point[2] -= 0.02;
+        Mesh->SetPointCoordinates(Vertex, Point);
+    }
+    for (vtkIdType Edge = 0; Edge < Mesh->GetNumberOfEdges(); Edge += 97)
+        Mesh->FlipEdge(Edge);
+    for (vtkIdType Edge = 11; Edge < Mesh->GetNumberOfEdges(); Edge += 503)
+        Mesh->BisectEdge(Edge);
+
+    vtkDoubleArray* Normals = Copy(Mesh->GetTrianglesNormals());
+    vtkDoubleArray* TrianglesAreas = Copy(Mesh->GetTrianglesAreas());
+    vtkDoubleArray* VerticesAreas = Copy(Mesh->GetVerticesAreas());
+    vtkDoubleArray* Lengths = Copy(Mesh->GetEdgeLengths());
+
+    Mesh->DeleteTrianglesNormals();
+    Mesh->DeleteTrianglesAreas();
+    Mesh->DeleteVerticesAreas();
+    Mesh->DeleteEdgeLengths();
+    Failed |= Compare("normals", Normals, Mesh->GetTrianglesNormals());
+    Failed |=
+        Compare("triangles areas", TrianglesAreas, Mesh->GetTrianglesAreas());
+    Failed |=
+        Compare("vertices areas", VerticesAreas, Mesh->GetVerticesAreas());
+    Failed |= Compare("edges lengths", Lengths, Mesh->GetEdgeLengths());
+
+    // all the faces are flipped
+    Mesh->SwitchOrientation();
+    Normals = Copy(Mesh->GetTrianglesNormals());
+    Mesh->DeleteTrianglesNormals();
+    Failed |= Compare(
+        "normals after switching the orientation", Normals,
+        Mesh->GetTrianglesNormals());
+    Mesh->Delete();
+
+    if (!Failed)
+        cout << "The updated attributes match a complete computation" << endl;
+    return (Failed);
+}
@@ -0,0 +1,179 @@
+/*=========================================================================
+
+Program:   Connected components test
+Module:    TestConnectedComponents.cxx
+Language:  C++
+Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+// .NAME TestConnectedComponents
+// .SECTION Description
+// Builds a mesh made of interleaved triangle strips and isolated vertices,
+// and checks that the components computed by the union-find, with one and
+// several threads, are the ones of a breadth-first search started from the
+// vertices by increasing Id. Also checks that the lists returned by
+// GetConnectedComponents() are sorted by Id.
+
+#include <iostream>
+#include <queue>
+#include <vector>
+
+#include "vtkSurface.h"
+
+using namespace std;
+
+// builds NumberOfStrips strips with interleaved vertices. The vertices
+// which are multiples of 101 are left isolated
+static vtkSurface* BuildStrips(vtkIdType NumberOfPoints, int NumberOfStrips)
+{
+    vtkSurface* Mesh = vtkSurface::New();
+    for (vtkIdType Vertex = 0; Vertex < NumberOfPoints; Vertex++)
+        Mesh->AddVertex(Vertex % 97, Vertex % 89, Vertex % 83);
+
+    for (int Strip = 0; Strip < NumberOfStrips; Strip++) {
+        vector<vtkIdType> Vertices;
+        for (vtkIdType Vertex = 0; Vertex < NumberOfPoints; Vertex++) {
+            if (((Vertex / 3) % NumberOfStrips == Strip) && (Vertex % 101))
+                Vertices.push_back(Vertex);
+        }
+        for (size_t i = 0; i + 2 < Vertices.size(); i++) {
+            if (i % 2)
+                Mesh->AddFace(Vertices[i + 1], Vertices[i], Vertices[i + 2]);
+            else
+                Mesh->AddFace(Vertices[i], Vertices[i + 1], Vertices[i + 2]);
+        }
+    }
+    return (Mesh);
+}
+
+// labels the components by breadth-first searches started from the
+// vertices by increasing Id
+static vtkIdType LabelComponents(vtkSurface* Mesh, vector<vtkIdType>& Labels)
+{
+    vtkIdType NumberOfComponents = 0;
+    Labels.assign(Mesh->GetNumberOfPoints(), -1);
+    for (vtkIdType Seed = 0; Seed < Mesh->GetNumberOfPoints(); Seed++) {
+        if (Labels[Seed] >= 0)
+            continue;
+        queue<vtkIdType> Queue;
+        Queue.push(Seed);
+        Labels[Seed] = NumberOfComponents;
+        while (Queue.size()) {
+            vtkIdType Vertex = Queue.front();
+            Queue.pop();
+            vtkIdType NumberOfEdges, *Edges, V1, V2;
+            Mesh->GetVertexNeighbourEdges(Vertex, NumberOfEdges, Edges);
+            for (vtkIdType i = 0; i < NumberOfEdges; i++) {
+                Mesh->GetEdgeVertices(Edges[i], V1, V2);
+                vtkIdType Neighbour = (V1 == Vertex) ? V2 : V1;
+                if (Labels[Neighbour] < 0) {
+                    Labels[Neighbour] = NumberOfComponents;
+                    Queue.push(Neighbour);
+                }
+            }
+        }
+        NumberOfComponents++;
+    }
+    return (NumberOfComponents);
+}
+
+// returns 1 if the labels and sizes computed with NumberOfThreads differ
+// from the reference
+static int CheckLabels(
+    vtkSurface* Mesh,
+    const vector<vtkIdType>& Reference,
+    vtkIdType NumberOfComponents,
+    int NumberOfThreads)
+{
+    vtkIdTypeArray* Labels = vtkIdTypeArray::New();
+    vtkIdTypeArray* Sizes = vtkIdTypeArray::New();
+    int Failed = 0;
+    if (Mesh->ComputeConnectedComponents(Labels, Sizes, NumberOfThreads) !=
+        NumberOfComponents) {
+        cout << NumberOfThreads << " thread(s) : wrong number of components"
+             << endl;
+        Failed = 1;
+    } else {
+        vector<vtkIdType> ReferenceSizes(NumberOfComponents, 0);
+        for (vtkIdType Vertex = 0; Vertex < Mesh->GetNumberOfPoints();
+             Vertex++) {
+            ReferenceSizes[Reference[Vertex]]++;
+            if (Labels->GetValue(Vertex) != Reference[Vertex]) {
+                cout << NumberOfThreads << " thread(s) : vertex " << Vertex
+                     << " has the label " << Labels->GetValue(Vertex)
+                     << " instead of " << Reference[Vertex] << endl;
+                Failed = 1;
+                break;
+            }
+        }
+        for (vtkIdType i = 0; !Failed && (i < NumberOfComponents); i++) {
+            if (Sizes->GetValue(i) != ReferenceSizes[i]) {
+                cout << NumberOfThreads << " thread(s) : component " << i
+                     << " has a wrong size" << endl;
+                Failed = 1;
+            }
+        }
+    }
+    Labels->Delete();
+    Sizes->Delete();
+    return (Failed);
+}
+
+int main()
+{
+    vtkSurface* Mesh = BuildStrips(20000, 5);
+    vector<vtkIdType> Reference;
+    vtkIdType NumberOfComponents = LabelComponents(Mesh, Reference);
+
+    int Failed = CheckLabels(Mesh, Reference, NumberOfComponents, 1);
+    Failed |= CheckLabels(Mesh, Reference, NumberOfComponents, 4);
+
+    vtkIdListCollection* Components = Mesh->GetConnectedComponents();
+    if (Components->GetNumberOfItems() != NumberOfComponents) {
+        cout << "GetConnectedComponents() : wrong number of components"
+             << endl;
+        Failed = 1;
+    } else {
+        for (vtkIdType i = 0; !Failed && (i < NumberOfComponents); i++) {
+            vtkIdList* Component = Components->GetItem(i);
+            for (vtkIdType j = 0; j < Component->GetNumberOfIds(); j++) {
+                vtkIdType Vertex = Component->GetId(j);
+                if ((Reference[Vertex] != i) ||
+                    ((j > 0) && (Vertex <= Component->GetId(j - 1)))) {
+                    cout << "GetConnectedComponents() : component " << i
+                         << " is wrong or not sorted by Id" << endl;
+                    Failed = 1;
+                    break;
+                }
+            }
+        }
+    }
+    Mesh->Delete();
+
+    if (!Failed)
+        cout << NumberOfComponents << " components, as expected" << endl;
+    return (Failed);
+}
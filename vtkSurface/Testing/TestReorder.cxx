@@ -0,0 +1,273 @@
+/*=========================================================================
+
+Program:   Reordering test
+Module:    TestReorder.cxx
+Language:  C++
+Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+// .NAME TestReorder
+// .SECTION Description
+// Reorders a mesh with deleted elements and point and cell data with each
+// method, checks that the permutations returned by Reorder() map the new
+// elements and data to the former ones, then restores the former order with
+// PermuteElements() and checks that the mesh is the one before reordering.
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <vtkCellData.h>
+#include <vtkPointData.h>
+
+#include "vtkRandomTriangulation.h"
+#include "vtkSurface.h"
+
+using namespace std;
+
+// copies Base, deletes some of its elements and adds an Id array to its
+// point and cell data
+static vtkSurface* BuildMesh(vtkSurface* Base)
+{
+    vtkSurface* Mesh = vtkSurface::New();
+    Mesh->CreateFromPolyData(Base);
+
+    // the faces around the vertex 100 (which deletes it with its edges),
+    // and every 37th face
+    vtkIdList* Faces = vtkIdList::New();
+    Mesh->GetVertexNeighbourFaces(100, Faces);
+    for (vtkIdType i = 0; i < Faces->GetNumberOfIds(); i++)
+        Mesh->DeleteFace(Faces->GetId(i));
+    Faces->Delete();
+    for (vtkIdType Face = 0; Face < Mesh->GetNumberOfCells(); Face += 37)
+        Mesh->DeleteFace(Face);
+
+    vtkIdTypeArray* PointIds = vtkIdTypeArray::New();
+    PointIds->SetName("PointIds");
+    PointIds->SetNumberOfValues(Mesh->GetNumberOfPoints());
+    for (vtkIdType Vertex = 0; Vertex < Mesh->GetNumberOfPoints(); Vertex++)
+        PointIds->SetValue(Vertex, Vertex);
+    Mesh->GetPointData()->AddArray(PointIds);
+    PointIds->Delete();
+
+    vtkIdTypeArray* CellIds = vtkIdTypeArray::New();
+    CellIds->SetName("CellIds");
+    CellIds->SetNumberOfValues(Mesh->GetNumberOfCells());
+    for (vtkIdType Face = 0; Face < Mesh->GetNumberOfCells(); Face++)
+        CellIds->SetValue(Face, Face);
+    Mesh->GetCellData()->AddArray(CellIds);
+    CellIds->Delete();
+    return (Mesh);
+}
+
+// returns the vertices of an edge, sorted
+static pair<vtkIdType, vtkIdType> GetSortedEdgeVertices(
+    vtkSurface* Mesh, vtkIdType Edge)
+{
+    vtkIdType V1, V2;
+    Mesh->GetEdgeVertices(Edge, V1, V2);
+    return (make_pair(min(V1, V2), max(V1, V2)));
+}
+
+// returns 1 if the element i of Mesh is not the element Ids[i] of
+// Reference, for the vertices (Points) and the faces (Cells), or if a
+// deleted face is followed by an active one while DeletedFacesLast is set
+static int CheckMapping(
+    vtkSurface* Mesh,
+    vtkSurface* Reference,
+    vtkIdTypeArray* Points,
+    vtkIdTypeArray* Cells,
+    bool DeletedFacesLast,
+    const char* Name)
+{
+    vtkIdTypeArray* PointIds = vtkIdTypeArray::SafeDownCast(
+        Mesh->GetPointData()->GetArray("PointIds"));
+    vtkIdTypeArray* CellIds = vtkIdTypeArray::SafeDownCast(
+        Mesh->GetCellData()->GetArray("CellIds"));
+    if (!PointIds || !CellIds) {
+        cout << Name << " : the data arrays were lost" << endl;
+        return (1);
+    }
+
+    double P1[3], P2[3];
+    for (vtkIdType Vertex = 0; Vertex < Mesh->GetNumberOfPoints(); Vertex++) {
+        vtkIdType Former = Points->GetValue(Vertex);
+        Mesh->GetPoint(Vertex, P1);
+        Reference->GetPoint(Former, P2);
+        if ((P1[0] != P2[0]) || (P1[1] != P2[1]) || (P1[2] != P2[2]) ||
+            (Mesh->IsVertexActive(Vertex) !=
+             Reference->IsVertexActive(Former)) ||
+            (PointIds->GetValue(Vertex) != Former)) {
+            cout << Name << " : vertex " << Vertex << " is not mapped" << endl;
+            return (1);
+        }
+    }
+
+    vtkIdType N1, N2, *Vertices1, *Vertices2;
+    bool Deleted = false;
+    for (vtkIdType Face = 0; Face < Mesh->GetNumberOfCells(); Face++) {
+        vtkIdType Former = Cells->GetValue(Face);
+        int Active = Mesh->IsFaceActive(Face);
+        bool Same = (Active == Reference->IsFaceActive(Former)) &&
+            (CellIds->GetValue(Face) == Former) && !(Active && Deleted);
+        if (Same && Active) {
+            Mesh->GetFaceVertices(Face, N1, Vertices1);
+            Reference->GetFaceVertices(Former, N2, Vertices2);
+            Same = (N1 == N2);
+            for (vtkIdType i = 0; Same && (i < N1); i++)
+                Same = (Points->GetValue(Vertices1[i]) == Vertices2[i]);
+        }
+        if (!Same) {
+            cout << Name << " : face " << Face << " is not mapped" << endl;
+            return (1);
+        }
+        Deleted = DeletedFacesLast && (Deleted || !Active);
+    }
+
+    // each active edge joins the images of a former edge, with the images
+    // of its faces
+    vtkIdType NumberOfActiveEdges = 0;
+    for (vtkIdType Edge = 0; Edge < Mesh->GetNumberOfEdges(); Edge++) {
+        if (!Mesh->IsEdgeActive(Edge))
+            continue;
+        NumberOfActiveEdges++;
+        vtkIdType V1, V2, F1, F2, F3, F4;
+        Mesh->GetEdgeVertices(Edge, V1, V2);
+        vtkIdType Former =
+            Reference->IsEdge(Points->GetValue(V1), Points->GetValue(V2));
+        bool Same = (Former >= 0);
+        if (Same) {
+            Mesh->GetEdgeFaces(Edge, F1, F2);
+            Reference->GetEdgeFaces(Former, F3, F4);
+            F1 = F1 < 0 ? -1 : Cells->GetValue(F1);
+            F2 = F2 < 0 ? -1 : Cells->GetValue(F2);
+            Same = ((F1 == F3) && (F2 == F4)) || ((F1 == F4) && (F2 == F3));
+        }
+        if (!Same) {
+            cout << Name << " : edge " << Edge << " is not mapped" << endl;
+            return (1);
+        }
+    }
+    for (vtkIdType Edge = 0; Edge < Reference->GetNumberOfEdges(); Edge++) {
+        if (Reference->IsEdgeActive(Edge))
+            NumberOfActiveEdges--;
+    }
+    if (NumberOfActiveEdges) {
+        cout << Name << " : wrong number of active edges" << endl;
+        return (1);
+    }
+    return (0);
+}
+
+// restores the former order of Mesh, given by the permutations of
+// Reorder(). The edges get the Ids of the edges of Reference with the same
+// vertices, and the deleted edges the Ids of the deleted edges of Reference
+static void RestoreOrder(
+    vtkSurface* Mesh,
+    vtkSurface* Reference,
+    vtkIdTypeArray* Points,
+    vtkIdTypeArray* Cells)
+{
+    vector<vtkIdType> NewEdgeIds(Mesh->GetNumberOfEdges());
+    vector<vtkIdType> DeletedEdges;
+    for (vtkIdType Edge = 0; Edge < Reference->GetNumberOfEdges(); Edge++) {
+        if (!Reference->IsEdgeActive(Edge))
+            DeletedEdges.push_back(Edge);
+    }
+    size_t NumberOfDeletedEdges = 0;
+    for (vtkIdType Edge = 0; Edge < Mesh->GetNumberOfEdges(); Edge++) {
+        if (Mesh->IsEdgeActive(Edge)) {
+            vtkIdType V1, V2;
+            Mesh->GetEdgeVertices(Edge, V1, V2);
+            NewEdgeIds[Edge] =
+                Reference->IsEdge(Points->GetValue(V1), Points->GetValue(V2));
+        } else
+            NewEdgeIds[Edge] = DeletedEdges[NumberOfDeletedEdges++];
+    }
+    Mesh->PermuteElements(
+        Points->GetPointer(0), Cells->GetPointer(0), NewEdgeIds.data());
+}
+
+// returns 1 if Mesh differs from Reference
+static int CheckRoundTrip(
+    vtkSurface* Mesh, vtkSurface* Reference, const char* Name)
+{
+    vtkIdTypeArray* Identity = vtkIdTypeArray::New();
+    vtkIdType Size =
+        max(Mesh->GetNumberOfPoints(), (vtkIdType)Mesh->GetNumberOfCells());
+    Identity->SetNumberOfValues(Size);
+    for (vtkIdType i = 0; i < Size; i++)
+        Identity->SetValue(i, i);
+    int Failed =
+        CheckMapping(Mesh, Reference, Identity, Identity, false, Name);
+    Identity->Delete();
+    if (Failed)
+        return (1);
+
+    for (vtkIdType Edge = 0; Edge < Mesh->GetNumberOfEdges(); Edge++) {
+        if ((Mesh->IsEdgeActive(Edge) != Reference->IsEdgeActive(Edge)) ||
+            (Mesh->IsEdgeActive(Edge) &&
+             (GetSortedEdgeVertices(Mesh, Edge) !=
+              GetSortedEdgeVertices(Reference, Edge)))) {
+            cout << Name << " : edge " << Edge << " was not restored" << endl;
+            return (1);
+        }
+    }
+    return (0);
+}
+
+int main()
+{
+    vtkSurface* Base = vtkRandomTriangulation::BuildRandomTriangulation(
+        5000, 8);
+    vtkSurface* Reference = BuildMesh(Base);
+
+    int Methods[3] = {
+        vtkSurface::MORTON_ORDER, vtkSurface::HILBERT_ORDER,
+        vtkSurface::CUTHILL_MCKEE_ORDER};
+    const char* Names[3] = {"Morton", "Hilbert", "Cuthill-McKee"};
+    int Failed = 0;
+    for (int i = 0; i < 3; i++) {
+        vtkSurface* Mesh = BuildMesh(Base);
+        vtkIdTypeArray* Points = vtkIdTypeArray::New();
+        vtkIdTypeArray* Cells = vtkIdTypeArray::New();
+        Mesh->Reorder(Methods[i], Points, Cells, 4);
+        if (!CheckMapping(Mesh, Reference, Points, Cells, true, Names[i])) {
+            RestoreOrder(Mesh, Reference, Points, Cells);
+            Failed |= CheckRoundTrip(Mesh, Reference, Names[i]);
+        } else
+            Failed = 1;
+        Points->Delete();
+        Cells->Delete();
+        Mesh->Delete();
+    }
+    Reference->Delete();
+    Base->Delete();
+
+    if (!Failed)
+        cout << "The reorderings were mapped and restored" << endl;
+    return (Failed);
+}
@@ -0,0 +1,159 @@
+/*=========================================================================
+
+Program:   Subdivision test
+Module:    TestSubdivision.cxx
+Language:  C++
+Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+// .NAME TestSubdivision
+// .SECTION Description
+// Subdivides a mesh with vtkSurface::Subdivide() and checks that the result
+// has the same vertices, faces, edges and rings as the subdivision built one
+// vertex and one face at a time with AddVertex() and AddFace().
+
+#include <iostream>
+
+#include "vtkRandomTriangulation.h"
+#include "vtkSurface.h"
+
+using namespace std;
+
+// subdivides Mesh with AddVertex() and AddFace()
+static vtkSurface* SubdivideIncrementally(vtkSurface* Mesh)
+{
+    vtkIdType NumberOfPoints = Mesh->GetNumberOfPoints();
+    vtkIdType NumberOfEdges = Mesh->GetNumberOfEdges();
+    vtkIdType NumberOfFaces = Mesh->GetNumberOfCells();
+    vtkSurface* Output = vtkSurface::New();
+    Output->Init(
+        NumberOfPoints + NumberOfEdges, 4 * NumberOfFaces,
+        2 * NumberOfEdges + 3 * NumberOfFaces);
+
+    double P[3], P1[3], P2[3];
+    for (vtkIdType Vertex = 0; Vertex < NumberOfPoints; Vertex++) {
+        Mesh->GetPoint(Vertex, P);
+        Output->AddVertex(P);
+    }
+
+    vtkIdType V1, V2, V3;
+    vtkIdType* MidPoints = new vtkIdType[NumberOfEdges];
+    for (vtkIdType Edge = 0; Edge < NumberOfEdges; Edge++) {
+        if (!Mesh->IsEdgeActive(Edge))
+            continue;
+        Mesh->GetEdgeVertices(Edge, V1, V2);
+        Mesh->GetPoint(V1, P1);
+        Mesh->GetPoint(V2, P2);
+        for (int j = 0; j < 3; j++)
+            P[j] = 0.5 * (P1[j] + P2[j]);
+        MidPoints[Edge] = Output->AddVertex(P);
+    }
+
+    for (vtkIdType Face = 0; Face < NumberOfFaces; Face++) {
+        if (!Mesh->IsFaceActive(Face))
+            continue;
+        Mesh->GetFaceVertices(Face, V1, V2, V3);
+        vtkIdType V4 = MidPoints[Mesh->IsEdge(V1, V2)];
+        vtkIdType V5 = MidPoints[Mesh->IsEdge(V2, V3)];
+        vtkIdType V6 = MidPoints[Mesh->IsEdge(V3, V1)];
+        Output->AddFace(V1, V4, V6);
+        Output->AddFace(V4, V2, V5);
+        Output->AddFace(V5, V3, V6);
+        Output->AddFace(V4, V5, V6);
+    }
+    delete[] MidPoints;
+    return (Output);
+}
+
+// returns 1 if the two meshes differ
+static int Compare(vtkSurface* Mesh, vtkSurface* Reference)
+{
+    if ((Mesh->GetNumberOfPoints() != Reference->GetNumberOfPoints()) ||
+        (Mesh->GetNumberOfCells() != Reference->GetNumberOfCells()) ||
+        (Mesh->GetNumberOfEdges() != Reference->GetNumberOfEdges())) {
+        cout << "The numbers of vertices, faces or edges differ" << endl;
+        return (1);
+    }
+
+    double P1[3], P2[3];
+    vtkIdType N1, N2, *List1, *List2;
+    for (vtkIdType Vertex = 0; Vertex < Mesh->GetNumberOfPoints(); Vertex++) {
+        Mesh->GetPoint(Vertex, P1);
+        Reference->GetPoint(Vertex, P2);
+        Mesh->GetVertexNeighbourEdges(Vertex, N1, List1);
+        Reference->GetVertexNeighbourEdges(Vertex, N2, List2);
+        bool Same = (P1[0] == P2[0]) && (P1[1] == P2[1]) &&
+            (P1[2] == P2[2]) && (N1 == N2);
+        for (vtkIdType i = 0; Same && (i < N1); i++)
+            Same = (List1[i] == List2[i]);
+        if (!Same) {
+            cout << "Vertex " << Vertex << " differs" << endl;
+            return (1);
+        }
+    }
+
+    for (vtkIdType Face = 0; Face < Mesh->GetNumberOfCells(); Face++) {
+        Mesh->GetFaceVertices(Face, N1, List1);
+        Reference->GetFaceVertices(Face, N2, List2);
+        bool Same = (N1 == N2);
+        for (vtkIdType i = 0; Same && (i < N1); i++)
+            Same = (List1[i] == List2[i]);
+        if (!Same) {
+            cout << "Face " << Face << " differs" << endl;
+            return (1);
+        }
+    }
+
+    vtkIdType V1, V2, V3, V4, F1, F2, F3, F4;
+    for (vtkIdType Edge = 0; Edge < Mesh->GetNumberOfEdges(); Edge++) {
+        Mesh->GetEdgeVertices(Edge, V1, V2);
+        Reference->GetEdgeVertices(Edge, V3, V4);
+        Mesh->GetEdgeFaces(Edge, F1, F2);
+        Reference->GetEdgeFaces(Edge, F3, F4);
+        if ((V1 != V3) || (V2 != V4) || (F1 != F3) || (F2 != F4)) {
+            cout << "Edge " << Edge << " differs" << endl;
+            return (1);
+        }
+    }
+    return (0);
+}
+
+int main()
+{
+    vtkSurface* Mesh = vtkRandomTriangulation::BuildRandomTriangulation(
+        2000, 8);
+    vtkSurface* Subdivided = Mesh->Subdivide();
+    vtkSurface* Reference = SubdivideIncrementally(Mesh);
+
+    int Failed = Compare(Subdivided, Reference);
+    Subdivided->Delete();
+    Reference->Delete();
+    Mesh->Delete();
+
+    if (!Failed)
+        cout << "The subdivision matches the incremental one" << endl;
+    return (Failed);
+}
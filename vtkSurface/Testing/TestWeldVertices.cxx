@@ -0,0 +1,129 @@
+/*=========================================================================
+
+Program:   Vertex welding test
+Module:    TestWeldVertices.cxx
+Language:  C++
+Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+// .NAME TestWeldVertices
+// .SECTION Description
+// Builds a triangle soup over a grid, where the copies of a grid vertex are
+// spread along a line so that only consecutive copies are closer than the
+// tolerance, and checks that WeldVertices() merges all the copies
+// (transitivity), with one and several threads, and that
+// CleanConnectivity() applies its tolerance relatively to the size of the
+// mesh.
+
+#include <iostream>
+#include <vector>
+
+#include "vtkSurface.h"
+
+using namespace std;
+
+static const int GridSize = 60;
+static const double Spacing = 100;
+static const double Tolerance = 1;
+
+// builds the soup. The k-th copy of a grid vertex is moved by
+// 0.8 x k x Tolerance along x
+static vtkSurface* BuildSoup()
+{
+    vtkSurface* Mesh = vtkSurface::New();
+    vector<int> NumberOfCopies(GridSize * GridSize, 0);
+    for (int i = 0; i < GridSize - 1; i++) {
+        for (int j = 0; j < GridSize - 1; j++) {
+            int Corners[2][3][2] = {
+                {{i, j}, {i + 1, j}, {i + 1, j + 1}},
+                {{i, j}, {i + 1, j + 1}, {i, j + 1}}};
+            for (int Triangle = 0; Triangle < 2; Triangle++) {
+                vtkIdType Vertices[3];
+                for (int k = 0; k < 3; k++) {
+                    int X = Corners[Triangle][k][0];
+                    int Y = Corners[Triangle][k][1];
+                    int& Copy = NumberOfCopies[X * GridSize + Y];
+                    Vertices[k] = Mesh->AddVertex(
+                        X * Spacing + 0.8 * Copy * Tolerance, Y * Spacing, 0);
+                    Copy++;
+                }
+                Mesh->AddFace(Vertices[0], Vertices[1], Vertices[2]);
+            }
+        }
+    }
+    return (Mesh);
+}
+
+// returns 1 if Welded is not the grid mesh, whose vertices lie on the grid
+static int CheckGrid(vtkSurface* Welded, const char* Name)
+{
+    if ((Welded->GetNumberOfPoints() != GridSize * GridSize) ||
+        (Welded->GetNumberOfCells() != 2 * (GridSize - 1) * (GridSize - 1))) {
+        cout << Name << " : " << Welded->GetNumberOfPoints() << " vertices and "
+             << Welded->GetNumberOfCells() << " faces instead of "
+             << GridSize * GridSize << " and "
+             << 2 * (GridSize - 1) * (GridSize - 1) << endl;
+        return (1);
+    }
+
+    // the merged vertices keep the coordinates of their first copy
+    double P[3];
+    for (vtkIdType Vertex = 0; Vertex < Welded->GetNumberOfPoints();
+         Vertex++) {
+        Welded->GetPoint(Vertex, P);
+        double X = P[0] / Spacing;
+        double Y = P[1] / Spacing;
+        if ((X != (int)X) || (Y != (int)Y) || (P[2] != 0)) {
+            cout << Name << " : vertex " << Vertex
+                 << " is not on the grid" << endl;
+            return (1);
+        }
+    }
+    return (0);
+}
+
+int main()
+{
+    vtkSurface* Soup = BuildSoup();
+
+    vtkSurface* Welded = Soup->WeldVertices(Tolerance, 1);
+    int Failed = CheckGrid(Welded, "1 thread");
+    Welded->Delete();
+
+    Welded = Soup->WeldVertices(Tolerance, 4);
+    Failed |= CheckGrid(Welded, "4 threads");
+    Welded->Delete();
+
+    // the tolerance of CleanConnectivity() is relative to the mesh size
+    Welded = Soup->CleanConnectivity(Tolerance / Soup->GetLength());
+    Failed |= CheckGrid(Welded, "CleanConnectivity");
+    Welded->Delete();
+    Soup->Delete();
+
+    if (!Failed)
+        cout << "The copies of the grid vertices were welded" << endl;
+    return (Failed);
+}
@@ -0,0 +1,246 @@
+/*=========================================================================
+
+  Program:   Binary checkpoints for the clustering
+  Module:    vtkClusteringCheckpoint.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#ifndef _VTKCLUSTERINGCHECKPOINT_H_
+#define _VTKCLUSTERINGCHECKPOINT_H_
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <vtkMultiThreader.h>
+
+/// A compact binary checkpoint. The state is first serialized into a memory
+/// buffer, which is then written to disk by a background thread, so that the
+/// caller is never stalled by the disk. The file is written under a temporary
+/// name, unique to the writing process and thread, and renamed once
+/// complete, so that an interrupted write never destroys the previous
+/// checkpoint, and concurrent writers of the same file never mix their data.
+/// The last complete write wins. The data is stored in the native byte
+/// order : checkpoints are not portable across architectures.
+class vtkClusteringCheckpoint
+{
+public:
+    /// Empties the buffer before serializing a new state
+    void Clear()
+    {
+        this->Buffer.clear();
+        this->Position = 0;
+    }
+
+    /// Appends Number values to the buffer
+    template <class T>
+    void Write(const T* Data, size_t Number)
+    {
+        size_t Size = this->Buffer.size();
+        this->Buffer.resize(Size + Number * sizeof(T));
+        if (Number)
+            memcpy(this->Buffer.data() + Size, Data, Number * sizeof(T));
+    }
+
+    template <class T>
+    void Write(const T& Value)
+    {
+        this->Write(&Value, 1);
+    }
+
+    /// Reads Number values from the buffer. Returns false when the buffer is
+    /// too short
+    template <class T>
+    bool Read(T* Data, size_t Number)
+    {
+        if (this->Position + Number * sizeof(T) > this->Buffer.size())
+            return (false);
+        if (Number)
+            memcpy(Data, this->Buffer.data() + this->Position,
+                Number * sizeof(T));
+        this->Position += Number * sizeof(T);
+        return (true);
+    }
+
+    template <class T>
+    bool Read(T& Value)
+    {
+        return (this->Read(&Value, 1));
+    }
+
+    /// Returns true while a background write is in progress
+    bool IsWriting() { return (this->Writing.load()); }
+
+    /// Starts writing the buffer to FileName in a background thread. Returns
+    /// false and does nothing when the previous write is not finished.
+    bool WriteInBackground(const char* FileName)
+    {
+        if (this->IsWriting())
+            return (false);
+
+        this->Wait();
+        this->FileName = FileName;
+        this->WriteBuffer.swap(this->Buffer);
+        this->Writing = true;
+        this->ThreadId = this->Threader->SpawnThread(
+            vtkClusteringCheckpoint::WriteThread, (void*)this);
+        if (this->ThreadId < 0) {
+            // no thread available : write synchronously
+            this->WriteFile();
+            this->Writing = false;
+        }
+        return (true);
+    }
+
+    /// Waits for the end of the background write, if any
+    void Wait()
+    {
+        if (this->ThreadId >= 0) {
+            this->Threader->TerminateThread(this->ThreadId);
+            this->ThreadId = -1;
+        }
+    }
+
+    /// Loads the whole file into the buffer. Returns false when the file
+    /// cannot be read
+    bool ReadFile(const char* FileName)
+    {
+        this->Clear();
+        FILE* File = fopen(FileName, "rb");
+        if (!File)
+            return (false);
+
+        char Chunk[65536];
+        size_t Size;
+        while ((Size = fread(Chunk, 1, sizeof(Chunk), File)) > 0)
+            this->Buffer.insert(this->Buffer.end(), Chunk, Chunk + Size);
+        bool Success = !ferror(File);
+        fclose(File);
+        return (Success);
+    }
+
+    /// Returns the status of the last write
+    bool GetWriteSuccess() { return (this->WriteSuccess); }
+
+    vtkClusteringCheckpoint()
+    {
+        this->Position = 0;
+        this->Writing = false;
+        this->WriteSuccess = true;
+        this->ThreadId = -1;
+        this->Threader = vtkMultiThreader::New();
+    }
+
+    ~vtkClusteringCheckpoint()
+    {
+        this->Wait();
+        this->Threader->Delete();
+    }
+
+private:
+    static VTK_THREAD_RETURN_TYPE WriteThread(void* arg)
+    {
+        vtkMultiThreader::ThreadInfo* Info = (vtkMultiThreader::ThreadInfo*)arg;
+        vtkClusteringCheckpoint* Checkpoint =
+            (vtkClusteringCheckpoint*)Info->UserData;
+        Checkpoint->WriteFile();
+        Checkpoint->Writing = false;
+        return (VTK_THREAD_RETURN_VALUE);
+    }
+
+    // returns FileName.tmp.<process id>.<thread id>
+    std::string GetTemporaryFileName()
+    {
+#ifdef _WIN32
+        int ProcessId = _getpid();
+#else
+        int ProcessId = (int)getpid();
+#endif
+        std::ostringstream Name;
+        Name << this->FileName << ".tmp." << ProcessId << "."
+             << std::hash<std::thread::id>()(std::this_thread::get_id());
+        return (Name.str());
+    }
+
+    void WriteFile()
+    {
+        std::string Temporary = this->GetTemporaryFileName();
+        FILE* File = fopen(Temporary.c_str(), "wb");
+        this->WriteSuccess = false;
+        if (!File)
+            return;
+
+        size_t Size = this->WriteBuffer.size();
+        bool Success = fwrite(this->WriteBuffer.data(), 1, Size, File) == Size;
+        Success = (fclose(File) == 0) && Success;
+        if (!Success) {
+            remove(Temporary.c_str());
+            return;
+        }
+
+        if (rename(Temporary.c_str(), this->FileName.c_str()) != 0) {
+            // some platforms do not replace existing files
+            remove(this->FileName.c_str());
+            if (rename(Temporary.c_str(), this->FileName.c_str()) != 0) {
+                remove(Temporary.c_str());
+                return;
+            }
+        }
+        this->WriteSuccess = true;
+    }
+
+    // the buffer being filled or read
+    std::vector<char> Buffer;
+
+    // the buffer being written by the background thread
+    std::vector<char> WriteBuffer;
+
+    // the reading position in Buffer
+    size_t Position;
+
+    std::string FileName;
+    std::atomic<bool> Writing;
+    std::atomic<bool> WriteSuccess;
+    vtkMultiThreader* Threader;
+    int ThreadId;
+
+    vtkClusteringCheckpoint(const vtkClusteringCheckpoint&);
+    void operator=(const vtkClusteringCheckpoint&);
+};
+
+#endif
@@ -0,0 +1,206 @@
+/*=========================================================================
+
+  Program:   Timings and counters of the clustering stages
+  Module:    vtkClusteringReport.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#ifndef _VTKCLUSTERINGREPORT_H_
+#define _VTKCLUSTERINGREPORT_H_
+
+#include <ctime>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include <vtkTimerLog.h>
+
+/// Records the wall time, CPU time, peak memory and counters of the stages of
+/// a clustering or remeshing run, and writes them as JSON. Stages can be
+/// nested : a stage started while an other one is running is its child.
+/// Stages are stored in their starting order.
+class vtkClusteringReport
+{
+public:
+    /// Removes all the recorded stages
+    void Clear()
+    {
+        this->Stages.clear();
+        this->OpenStages.clear();
+    }
+
+    /// Starts a new stage
+    void StartStage(const char* Name)
+    {
+        Stage NewStage;
+        NewStage.Name = Name;
+        NewStage.Depth = (int)this->OpenStages.size();
+        NewStage.WallTime = vtkTimerLog::GetUniversalTime();
+        NewStage.CPUTime = GetCPUTime();
+        NewStage.PeakMemory = 0;
+        this->OpenStages.push_back(this->Stages.size());
+        this->Stages.push_back(NewStage);
+    }
+
+    /// Stops the last started stage
+    void StopStage()
+    {
+        if (this->OpenStages.empty())
+            return;
+        Stage& Current = this->Stages[this->OpenStages.back()];
+        Current.WallTime = vtkTimerLog::GetUniversalTime() - Current.WallTime;
+        Current.CPUTime = GetCPUTime() - Current.CPUTime;
+        Current.PeakMemory = GetPeakMemory();
+        this->OpenStages.pop_back();
+    }
+
+    /// Sets a counter of the last started stage which is still running
+    void SetCounter(const char* Name, double Value)
+    {
+        if (this->OpenStages.empty())
+            return;
+        Stage& Current = this->Stages[this->OpenStages.back()];
+        for (size_t i = 0; i < Current.Counters.size(); i++) {
+            if (Current.Counters[i].first == Name) {
+                Current.Counters[i].second = Value;
+                return;
+            }
+        }
+        Current.Counters.push_back(std::make_pair(std::string(Name), Value));
+    }
+
+    /// Returns the number of recorded stages
+    int GetNumberOfStages() { return ((int)this->Stages.size()); }
+
+    /// Returns the name, depth and durations of a stage. Durations are only
+    /// valid once the stage is stopped
+    const char* GetStageName(int Id) { return (this->Stages[Id].Name.c_str()); }
+    int GetStageDepth(int Id) { return (this->Stages[Id].Depth); }
+    double GetStageWallTime(int Id) { return (this->Stages[Id].WallTime); }
+    double GetStageCPUTime(int Id) { return (this->Stages[Id].CPUTime); }
+
+    /// Writes the stages as a JSON document
+    void WriteJSON(std::ostream& Stream)
+    {
+        std::streamsize Precision = Stream.precision(15);
+        Stream << "{\n  \"stages\": [";
+        for (size_t i = 0; i < this->Stages.size(); i++) {
+            Stage& Current = this->Stages[i];
+            Stream << (i ? ",\n" : "\n") << "    {\"name\": \""
+                   << Escape(Current.Name) << "\", \"depth\": " << Current.Depth
+                   << ", \"wall_time\": " << Current.WallTime
+                   << ", \"cpu_time\": " << Current.CPUTime
+                   << ", \"peak_memory_kb\": " << Current.PeakMemory
+                   << ", \"counters\": {";
+            for (size_t j = 0; j < Current.Counters.size(); j++)
+                Stream << (j ? ", " : "") << "\""
+                       << Escape(Current.Counters[j].first)
+                       << "\": " << Current.Counters[j].second;
+            Stream << "}}";
+        }
+        Stream << "\n  ]\n}\n";
+        Stream.precision(Precision);
+    }
+
+    /// Writes the JSON document to a file. Returns false on failure
+    bool WriteJSON(const char* FileName)
+    {
+        std::ofstream File(FileName);
+        if (!File)
+            return (false);
+        this->WriteJSON(File);
+        return (bool)File;
+    }
+
+    /// Returns the CPU time used by the process (all threads), in seconds
+    static double GetCPUTime()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        struct rusage Usage;
+        getrusage(RUSAGE_SELF, &Usage);
+        return (Usage.ru_utime.tv_sec + Usage.ru_stime.tv_sec +
+                1e-6 * (Usage.ru_utime.tv_usec + Usage.ru_stime.tv_usec));
+#else
+        return ((double)clock() / CLOCKS_PER_SEC);
+#endif
+    }
+
+    /// Returns the peak resident memory of the process, in kilobytes
+    /// (-1 : unknown)
+    static double GetPeakMemory()
+    {
+#if defined(__APPLE__)
+        struct rusage Usage;
+        getrusage(RUSAGE_SELF, &Usage);
+        return (Usage.ru_maxrss / 1024.0);
+#elif defined(__unix__)
+        struct rusage Usage;
+        getrusage(RUSAGE_SELF, &Usage);
+        return ((double)Usage.ru_maxrss);
+#else
+        return (-1);
+#endif
+    }
+
+private:
+    struct Stage
+    {
+        std::string Name;
+        int Depth;
+
+        // start times while the stage is running, durations afterwards
+        double WallTime;
+        double CPUTime;
+
+        double PeakMemory;
+        std::vector<std::pair<std::string, double>> Counters;
+    };
+
+    static std::string Escape(const std::string& Text)
+    {
+        std::string Escaped;
+        for (size_t i = 0; i < Text.size(); i++) {
+            if ((Text[i] == '"') || (Text[i] == '\\'))
+                Escaped += '\\';
+            Escaped += Text[i];
+        }
+        return (Escaped);
+    }
+
+    std::vector<Stage> Stages;
+
+    // the indices of the running stages
+    std::vector<size_t> OpenStages;
+};
+
+#endif
@@ -0,0 +1,179 @@
+/*=========================================================================
+
+  Program:   Timeline traces of the threaded clustering
+  Module:    vtkClusteringTrace.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#ifndef _VTKCLUSTERINGTRACE_H_
+#define _VTKCLUSTERINGTRACE_H_
+
+#include <fstream>
+#include <ostream>
+#include <vector>
+
+#include <vtkTimerLog.h>
+
+/// Collects timeline events and writes them in the Chrome trace event
+/// format, which can be loaded in chrome://tracing or in Perfetto. Each
+/// thread records its events in its own buffer, so that recording does not
+/// need any lock, as long as a given thread Id is used by only one thread at
+/// a time. Event and argument names must be string literals : they are not
+/// copied.
+class vtkClusteringTrace
+{
+public:
+    /// Allocates the buffers of NumberOfThreads threads, removes all the
+    /// events and sets the time origin to now
+    void Allocate(int NumberOfThreads)
+    {
+        this->Threads.assign(NumberOfThreads, std::vector<Event>());
+        this->Origin = vtkTimerLog::GetUniversalTime();
+    }
+
+    /// Returns the current time, in seconds
+    static double GetTime() { return (vtkTimerLog::GetUniversalTime()); }
+
+    /// Records a span [Start, Stop] (in seconds, see GetTime()) executed by
+    /// Thread. Up to two named values can be attached to it
+    void AddSpan(
+        int Thread,
+        const char* Name,
+        double Start,
+        double Stop,
+        const char* Arg1 = 0,
+        double Value1 = 0,
+        const char* Arg2 = 0,
+        double Value2 = 0)
+    {
+        Event NewEvent = {Name, 'X', Start, Stop - Start, Arg1, Value1, Arg2,
+                          Value2};
+        this->Threads[Thread].push_back(NewEvent);
+    }
+
+    /// Records an instant marker
+    void AddMarker(
+        int Thread,
+        const char* Name,
+        const char* Arg1 = 0,
+        double Value1 = 0)
+    {
+        Event NewEvent = {Name, 'i', GetTime(), 0, Arg1, Value1, 0, 0};
+        this->Threads[Thread].push_back(NewEvent);
+    }
+
+    /// Records the values of a counter track (e.g. a queue size)
+    void AddCounter(
+        int Thread,
+        const char* Name,
+        const char* Arg1,
+        double Value1,
+        const char* Arg2 = 0,
+        double Value2 = 0)
+    {
+        Event NewEvent = {Name, 'C', GetTime(), 0, Arg1, Value1, Arg2, Value2};
+        this->Threads[Thread].push_back(NewEvent);
+    }
+
+    /// Sets the name displayed for a thread
+    void SetThreadName(int Thread, const char* Name)
+    {
+        Event NewEvent = {Name, 'M', this->Origin, 0, 0, 0, 0, 0};
+        this->Threads[Thread].push_back(NewEvent);
+    }
+
+    /// Writes the events as a JSON trace
+    void WriteJSON(std::ostream& Stream)
+    {
+        std::streamsize Precision = Stream.precision(15);
+        Stream << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+        bool First = true;
+        for (size_t Thread = 0; Thread < this->Threads.size(); Thread++) {
+            std::vector<Event>& Events = this->Threads[Thread];
+            for (size_t i = 0; i < Events.size(); i++) {
+                Event& E = Events[i];
+                Stream << (First ? "\n" : ",\n") << "{\"pid\": 0, \"tid\": "
+                       << Thread << ", \"ph\": \"" << E.Phase << "\", ";
+                First = false;
+                if (E.Phase == 'M') {
+                    Stream << "\"name\": \"thread_name\", \"args\": "
+                           << "{\"name\": \"" << E.Name << "\"}}";
+                    continue;
+                }
+
+                // times are in microseconds
+                Stream << "\"name\": \"" << E.Name
+                       << "\", \"ts\": " << 1e6 * (E.Time - this->Origin);
+                if (E.Phase == 'X')
+                    Stream << ", \"dur\": " << 1e6 * E.Duration;
+                if (E.Phase == 'i')
+                    Stream << ", \"s\": \"t\"";
+                Stream << ", \"args\": {";
+                if (E.Arg1)
+                    Stream << "\"" << E.Arg1 << "\": " << E.Value1;
+                if (E.Arg2)
+                    Stream << ", \"" << E.Arg2 << "\": " << E.Value2;
+                Stream << "}}";
+            }
+        }
+        Stream << "\n]}\n";
+        Stream.precision(Precision);
+    }
+
+    /// Writes the trace to a file. Returns false on failure
+    bool WriteJSON(const char* FileName)
+    {
+        std::ofstream File(FileName);
+        if (!File)
+            return (false);
+        this->WriteJSON(File);
+        return (bool)File;
+    }
+
+    vtkClusteringTrace() { this->Origin = GetTime(); }
+
+private:
+    struct Event
+    {
+        const char* Name;
+        char Phase;
+        double Time;
+        double Duration;
+        const char* Arg1;
+        double Value1;
+        const char* Arg2;
+        double Value2;
+    };
+
+    // the events of each thread
+    std::vector<std::vector<Event>> Threads;
+
+    // the time origin of the trace
+    double Origin;
+};
+
+#endif
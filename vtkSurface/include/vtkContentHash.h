@@ -0,0 +1,87 @@
+/*=========================================================================
+
+  Program:   64 bits hash of buffers and files
+  Module:    vtkContentHash.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#ifndef _VTKCONTENTHASH_H_
+#define _VTKCONTENTHASH_H_
+
+#include <cstddef>
+#include <cstdio>
+
+/// Computes the 64 bits FNV-1a hash of a sequence of bytes, given in one or
+/// several pieces. It is used to recognize identical inputs (files or
+/// meshes) across runs, not as a cryptographic hash.
+class vtkContentHash
+{
+public:
+    vtkContentHash() { this->Hash = 14695981039346656037ULL; }
+
+    /// Appends Size bytes to the hashed sequence
+    void Add(const void* Data, size_t Size)
+    {
+        const unsigned char* Bytes = (const unsigned char*)Data;
+        unsigned long long H = this->Hash;
+        for (size_t i = 0; i < Size; i++) {
+            H ^= Bytes[i];
+            H *= 1099511628211ULL;
+        }
+        this->Hash = H;
+    }
+
+    /// Appends a value to the hashed sequence
+    template <class T>
+    void AddValue(const T& Value)
+    {
+        this->Add(&Value, sizeof(T));
+    }
+
+    /// Appends the content of a file. Returns false if it cannot be read
+    bool AddFile(const char* FileName)
+    {
+        FILE* File = fopen(FileName, "rb");
+        if (!File)
+            return (false);
+        unsigned char Buffer[65536];
+        size_t Size;
+        while ((Size = fread(Buffer, 1, sizeof(Buffer), File)) > 0)
+            this->Add(Buffer, Size);
+        bool Success = !ferror(File);
+        fclose(File);
+        return (Success);
+    }
+
+    /// Returns the hash of the bytes added so far
+    unsigned long long Get() { return (this->Hash); }
+
+private:
+    unsigned long long Hash;
+};
+
+#endif
@@ -0,0 +1,208 @@
+#pragma once
+
+/*=========================================================================
+
+  Program:   Edge frontier for clustering
+  Module:    vtkEdgeFrontier.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <vtkType.h>
+
+/// The set of edges lying between two different clusters, stored as a double
+/// buffer of contiguous arrays. Edges are pushed during a minimization loop
+/// and become available for popping after Swap(), which removes duplicates
+/// and optionally sorts the edges by Id for better memory locality.
+/// The frontier can be split into several segments (one for each process
+/// of the threaded clustering). Each source (process) owns its own push
+/// buffer, so that pushing is thread-safe as long as a given source is
+/// used by only one thread at a time.
+template <typename EdgeType = vtkIdType>
+class vtkEdgeFrontier
+{
+public:
+    /// Allocates the duplicates bitmap for NumberOfEdges edges and
+    /// NumberOfSources push buffers. The frontier is emptied.
+    void Allocate(vtkIdType NumberOfEdges, int NumberOfSources = 1)
+    {
+        this->Bitmap.assign((NumberOfEdges + 63) / 64, 0);
+        this->PushBuffers.resize(NumberOfSources);
+        this->Clear();
+    }
+
+    /// Sets On/Off the sorting of the popped edges by Id (default : Off)
+    void SetSortEdges(bool Sort) { this->SortEdges = Sort; }
+    bool GetSortEdges() { return this->SortEdges; }
+
+    /// Adds an edge to the push buffer of Source
+    void Push(EdgeType Edge, int Source = 0)
+    {
+        this->PushBuffers[Source].push_back(Edge);
+    }
+
+    /// Moves the pushed edges to the pop buffer and removes duplicates (only
+    /// the first occurence of an edge is kept). When Layout is given, the
+    /// popped edges are split into NumberOfSegments segments, Layout[Edge]
+    /// being the segment of Edge. Within a segment, the edges keep their
+    /// pushing order, sources being visited in increasing order.
+    void Swap(const int* Layout = 0, int NumberOfSegments = 1);
+
+    /// Empties both push and pop buffers (memory is kept for reuse)
+    void Clear()
+    {
+        for (size_t i = 0; i < this->PushBuffers.size(); i++)
+            this->PushBuffers[i].clear();
+        this->PopBuffer.clear();
+        this->Offsets.assign(2, 0);
+    }
+
+    /// Returns the first popped edge of the given segment
+    const EdgeType* Begin(int Segment = 0) const
+    {
+        return this->PopBuffer.data() + this->Offsets[Segment];
+    }
+
+    /// Returns the end of the given segment
+    const EdgeType* End(int Segment = 0) const
+    {
+        return this->PopBuffer.data() + this->Offsets[Segment + 1];
+    }
+
+    /// Returns the number of edges available for popping
+    vtkIdType GetNumberOfPoppedEdges() const { return this->PopBuffer.size(); }
+
+    /// Returns the number of edges pushed since the last Swap()
+    vtkIdType GetNumberOfPushedEdges() const
+    {
+        vtkIdType Number = 0;
+        for (size_t i = 0; i < this->PushBuffers.size(); i++)
+            Number += this->PushBuffers[i].size();
+        return Number;
+    }
+
+    /// Copies the edges pushed since the last Swap() into Edges, sources
+    /// being visited in increasing order. Pushing them back to a single
+    /// source results in the same popped edges.
+    void GetPushedEdges(std::vector<EdgeType>& Edges) const
+    {
+        Edges.clear();
+        Edges.reserve(this->GetNumberOfPushedEdges());
+        for (size_t i = 0; i < this->PushBuffers.size(); i++)
+            Edges.insert(Edges.end(), this->PushBuffers[i].begin(),
+                this->PushBuffers[i].end());
+    }
+
+    vtkEdgeFrontier() { this->SortEdges = false; }
+
+private:
+    bool TestAndSet(EdgeType Edge)
+    {
+        uint64_t& Word = this->Bitmap[Edge >> 6];
+        uint64_t Mask = ((uint64_t)1) << (Edge & 63);
+        bool WasSet = (Word & Mask) != 0;
+        Word |= Mask;
+        return WasSet;
+    }
+
+    void Reset(EdgeType Edge)
+    {
+        this->Bitmap[Edge >> 6] &= ~(((uint64_t)1) << (Edge & 63));
+    }
+
+    // one bit per edge, set while the edge is being swapped
+    std::vector<uint64_t> Bitmap;
+
+    // one push buffer per source
+    std::vector<std::vector<EdgeType>> PushBuffers;
+
+    // the edges to pop, segment after segment
+    std::vector<EdgeType> PopBuffer;
+
+    // buffer used to split the edges into segments
+    std::vector<EdgeType> Scratch;
+
+    // start of each segment in PopBuffer (NumberOfSegments+1 values)
+    std::vector<vtkIdType> Offsets;
+
+    bool SortEdges;
+};
+
+template <typename EdgeType>
+void vtkEdgeFrontier<EdgeType>::Swap(const int* Layout, int NumberOfSegments)
+{
+    if (!Layout)
+        NumberOfSegments = 1;
+
+    std::vector<EdgeType>& Unique =
+        (NumberOfSegments == 1) ? this->PopBuffer : this->Scratch;
+    Unique.clear();
+    this->Offsets.assign(NumberOfSegments + 1, 0);
+
+    // remove duplicates, and count the edges of each segment
+    for (size_t Source = 0; Source < this->PushBuffers.size(); Source++) {
+        std::vector<EdgeType>& Buffer = this->PushBuffers[Source];
+        for (size_t i = 0; i < Buffer.size(); i++) {
+            EdgeType Edge = Buffer[i];
+            if (this->TestAndSet(Edge))
+                continue;
+            Unique.push_back(Edge);
+            if (NumberOfSegments > 1)
+                this->Offsets[Layout[Edge] + 1]++;
+        }
+        Buffer.clear();
+    }
+
+    for (size_t i = 0; i < Unique.size(); i++)
+        this->Reset(Unique[i]);
+
+    if (NumberOfSegments == 1)
+        this->Offsets[1] = Unique.size();
+    else {
+        // stable counting sort of the edges according to their segment
+        for (int Segment = 0; Segment < NumberOfSegments; Segment++)
+            this->Offsets[Segment + 1] += this->Offsets[Segment];
+
+        this->PopBuffer.resize(Unique.size());
+        std::vector<vtkIdType> Position(
+            this->Offsets.begin(), this->Offsets.end() - 1);
+        for (size_t i = 0; i < Unique.size(); i++) {
+            EdgeType Edge = Unique[i];
+            this->PopBuffer[Position[Layout[Edge]]++] = Edge;
+        }
+    }
+
+    if (this->SortEdges) {
+        for (int Segment = 0; Segment < NumberOfSegments; Segment++)
+            std::sort(
+                this->PopBuffer.begin() + this->Offsets[Segment],
+                this->PopBuffer.begin() + this->Offsets[Segment + 1]);
+    }
+}
@@ -0,0 +1,167 @@
+/*=========================================================================
+
+  Program:   Per-face quantities computed in parallel
+  Module:    vtkFaceQuantities.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#ifndef _VTKFACEQUANTITIES_H_
+#define _VTKFACEQUANTITIES_H_
+
+#include <vector>
+
+#include <vtkIdList.h>
+#include <vtkTriangle.h>
+
+#include "vtkParallelFor.h"
+#include "vtkSurfaceBase.h"
+
+/// Computes the areas, unit normals and quadrics of the faces of a mesh once,
+/// in parallel, so that quantities defined on vertices can be gathered from
+/// the adjacent faces instead of being recomputed for each incident face.
+/// Only read-only accessors of the mesh are used, so that the gathering
+/// methods can be called concurrently, with one work list per thread.
+class vtkFaceQuantities
+{
+public:
+    /// Computes the areas of the faces of Mesh and, on demand, their unit
+    /// normals and their quadrics (9 coefficients, as
+    /// vtkQuadricTools::AddTriangleQuadric()). Areas are valid for polygons,
+    /// normals and quadrics only for triangles.
+    void Compute(
+        vtkSurfaceBase* Mesh,
+        bool ComputeNormals = false,
+        bool ComputeQuadrics = false,
+        int NumberOfThreads = 0)
+    {
+        vtkIdType NumberOfFaces = Mesh->GetNumberOfCells();
+        this->Areas.resize(NumberOfFaces);
+        this->Normals.resize(ComputeNormals ? 3 * NumberOfFaces : 0);
+        this->Quadrics.resize(ComputeQuadrics ? 9 * NumberOfFaces : 0);
+
+        auto ComputeFaces = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+            vtkIdType NumberOfVertices, *Vertices;
+            double P1[3], P2[3], P3[3];
+            double Quadric[4][4];
+            for (vtkIdType Face = Begin; Face < End; Face++) {
+                this->Areas[Face] = ComputeArea(Mesh, Face);
+
+                if (!ComputeNormals && !ComputeQuadrics)
+                    continue;
+
+                Mesh->GetFaceVertices(Face, NumberOfVertices, Vertices);
+                Mesh->GetPoint(Vertices[0], P1);
+                Mesh->GetPoint(Vertices[1], P2);
+                Mesh->GetPoint(Vertices[2], P3);
+                if (ComputeNormals)
+                    vtkTriangle::ComputeNormal(
+                        P1, P2, P3, &this->Normals[3 * Face]);
+
+                if (ComputeQuadrics) {
+                    vtkTriangle::ComputeQuadric(P1, P2, P3, Quadric);
+                    double* Q = &this->Quadrics[9 * Face];
+                    Q[0] = Quadric[0][0];
+                    Q[1] = Quadric[0][1];
+                    Q[2] = Quadric[0][2];
+                    Q[3] = Quadric[0][3];
+                    Q[4] = Quadric[1][1];
+                    Q[5] = Quadric[1][2];
+                    Q[6] = Quadric[1][3];
+                    Q[7] = Quadric[2][2];
+                    Q[8] = Quadric[2][3];
+                }
+            }
+        };
+        vtkParallelFor::Execute(NumberOfFaces, ComputeFaces, NumberOfThreads);
+    }
+
+    /// Computes the area of a face of Mesh, with the same fan decomposition
+    /// as vtkSurface::GetFaceArea()
+    static double ComputeArea(vtkSurfaceBase* Mesh, vtkIdType Face)
+    {
+        vtkIdType NumberOfVertices, *Vertices;
+        double P1[3], P2[3], P3[3];
+        Mesh->GetFaceVertices(Face, NumberOfVertices, Vertices);
+        Mesh->GetPoint(Vertices[0], P1);
+        double Area = 0;
+        for (vtkIdType j = 0; j < NumberOfVertices - 2; j++) {
+            Mesh->GetPoint(Vertices[j + 1], P2);
+            Mesh->GetPoint(Vertices[j + 2], P3);
+            Area += vtkTriangle::TriangleArea(P1, P2, P3);
+        }
+        return (Area);
+    }
+
+    /// Returns the area of a face
+    double GetArea(vtkIdType Face) { return (this->Areas[Face]); }
+
+    /// Returns the unit normal of a face
+    double* GetNormal(vtkIdType Face) { return (&this->Normals[3 * Face]); }
+
+    /// Returns the quadric of a face
+    double* GetQuadric(vtkIdType Face) { return (&this->Quadrics[9 * Face]); }
+
+    /// Returns the area associated to a vertex, i.e. the sum of the areas of
+    /// its adjacent faces divided by their number of vertices. The result is
+    /// the same as vtkSurface::GetVertexArea(). FList is a work list.
+    double GetVertexArea(
+        vtkSurfaceBase* Mesh, vtkIdType Vertex, vtkIdList* FList)
+    {
+        vtkIdType NumberOfVertices, *Vertices;
+        double Area = 0;
+        Mesh->GetVertexNeighbourFaces(Vertex, FList);
+        for (vtkIdType i = 0; i < FList->GetNumberOfIds(); i++) {
+            vtkIdType Face = FList->GetId(i);
+            Mesh->GetFaceVertices(Face, NumberOfVertices, Vertices);
+            Area += this->Areas[Face] / (double)NumberOfVertices;
+        }
+        return (Area);
+    }
+
+    /// Adds the quadrics of the faces adjacent to Vertex to Quadric.
+    /// FList is a work list.
+    void AddVertexQuadric(
+        vtkSurfaceBase* Mesh,
+        vtkIdType Vertex,
+        vtkIdList* FList,
+        double* Quadric)
+    {
+        Mesh->GetVertexNeighbourFaces(Vertex, FList);
+        for (vtkIdType i = 0; i < FList->GetNumberOfIds(); i++) {
+            double* Q = this->GetQuadric(FList->GetId(i));
+            for (int j = 0; j < 9; j++)
+                Quadric[j] += Q[j];
+        }
+    }
+
+private:
+    std::vector<double> Areas;
+    std::vector<double> Normals;
+    std::vector<double> Quadrics;
+};
+
+#endif
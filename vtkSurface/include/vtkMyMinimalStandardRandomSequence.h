@@ -83,6 +83,19 @@ public:
     // Move to the next number in the random sequence.
     virtual void Next();
 
+    // Description:
+    // Move Steps numbers forward in the random sequence. This is equivalent
+    // to Steps calls to Next(), but is done in O(log(Steps)) operations.
+    void Skip(vtkIdType Steps);
+
+    // Description:
+    // Counter-based access to the sequence: returns the seed obtained after
+    // Steps calls to Next() from the given (valid) seed. As the result only
+    // depends on Seed and Steps, independent streams (e.g. one per item) can
+    // be evaluated in parallel and in any order. The values of a sequence are
+    // all different for Steps in [0, 2147483645].
+    static int GetSeedAt(int Seed, vtkIdType Steps);
+
     // Description:
     // Convenient method to return a value in a specific range from the
     // range [0,1. There is an initial implementation that can be overridden
@@ -0,0 +1,120 @@
+/*=========================================================================
+
+  Program:   Parallel loops with vtkMultiThreader
+  Module:    vtkParallelFor.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#ifndef _VTKPARALLELFOR_H_
+#define _VTKPARALLELFOR_H_
+
+#include <vtkMultiThreader.h>
+
+/// Runs a loop over the range [0, Size) with a vtkMultiThreader. The range is
+/// split into contiguous chunks, one for each thread, and the function
+/// object is called once for each chunk as Function(Begin, End, Chunk).
+/// Chunks are numbered by increasing Begin, so that results stored per chunk
+/// can be merged in a deterministic order. Small ranges are processed in the
+/// calling thread.
+class vtkParallelFor
+{
+public:
+    /// Returns the number of chunks used to process Size items with
+    /// NumberOfThreads threads (0 : default number of threads of
+    /// vtkMultiThreader)
+    static int GetNumberOfChunks(vtkIdType Size, int NumberOfThreads = 0)
+    {
+        if (NumberOfThreads <= 0)
+            NumberOfThreads =
+                vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+        if (NumberOfThreads > VTK_MAX_THREADS)
+            NumberOfThreads = VTK_MAX_THREADS;
+
+        // do not start threads for tiny chunks
+        vtkIdType MaximumNumberOfChunks = Size / 1024;
+        if (MaximumNumberOfChunks < NumberOfThreads)
+            NumberOfThreads = (int)MaximumNumberOfChunks;
+        if (NumberOfThreads < 1)
+            NumberOfThreads = 1;
+        return (NumberOfThreads);
+    }
+
+    /// Executes Function on all the chunks of [0, Size)
+    template <class FunctionType>
+    static void Execute(
+        vtkIdType Size, FunctionType& Function, int NumberOfThreads = 0)
+    {
+        int NumberOfChunks = GetNumberOfChunks(Size, NumberOfThreads);
+        if (NumberOfChunks == 1) {
+            Function(0, Size, 0);
+            return;
+        }
+
+        Context<FunctionType> Loop;
+        Loop.Function = &Function;
+        Loop.Size = Size;
+        Loop.NumberOfChunks = NumberOfChunks;
+
+        vtkMultiThreader* Threader = vtkMultiThreader::New();
+        Threader->SetNumberOfThreads(NumberOfChunks);
+        Threader->SetSingleMethod(ExecuteChunk<FunctionType>, (void*)&Loop);
+        Threader->SingleMethodExecute();
+        Threader->Delete();
+    }
+
+    /// Returns the first item of a chunk
+    static vtkIdType GetChunkBegin(
+        vtkIdType Size, int Chunk, int NumberOfChunks)
+    {
+        return (Size * Chunk / NumberOfChunks);
+    }
+
+private:
+    template <class FunctionType>
+    struct Context
+    {
+        FunctionType* Function;
+        vtkIdType Size;
+        int NumberOfChunks;
+    };
+
+    template <class FunctionType>
+    static VTK_THREAD_RETURN_TYPE ExecuteChunk(void* arg)
+    {
+        vtkMultiThreader::ThreadInfo* Info = (vtkMultiThreader::ThreadInfo*)arg;
+        Context<FunctionType>* Loop = (Context<FunctionType>*)Info->UserData;
+        int Chunk = Info->ThreadID;
+
+        (*Loop->Function)(
+            GetChunkBegin(Loop->Size, Chunk, Loop->NumberOfChunks),
+            GetChunkBegin(Loop->Size, Chunk + 1, Loop->NumberOfChunks),
+            Chunk);
+        return (VTK_THREAD_RETURN_VALUE);
+    }
+};
+
+#endif
@@ -38,6 +38,11 @@ public:
     /// 2: plane made of 4 different regions with different densities
     /// 3 : half pipe
     /// 4 : half pipe cut on one corner
+    /// 5 : subdivided cube bent into a half pipe
+    /// 6 : Delaunay triangulation of a subdivided triangle
+    /// 7 : square subdivided NumberOfPoints times
+    /// 8 : bumpy torus with about NumberOfPoints vertices and twice as many
+    /// faces, regular and deterministic (useful for benchmarks)
     static vtkRandomTriangulation* New();
 
     static vtkSurface* BuildRandomTriangulation(int NumberOfPoints, int Type);
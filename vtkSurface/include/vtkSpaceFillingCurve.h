@@ -0,0 +1,131 @@
+/*=========================================================================
+
+  Program:   Space filling curves over a bounding box
+  Module:    vtkSpaceFillingCurve.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#ifndef _VTKSPACEFILLINGCURVE_H_
+#define _VTKSPACEFILLINGCURVE_H_
+
+/// Computes the position of points along a Morton (Z-order) or a Hilbert
+/// curve covering a bounding box. Coordinates are quantized on 21 bits per
+/// axis, with the same step on the three axes, so that keys fit in 63 bits.
+/// Sorting points by their keys gives an order where points close in space
+/// are mostly close in the order, the Hilbert curve having no long jumps.
+class vtkSpaceFillingCurve
+{
+public:
+    /// Sets the box covered by the curve (xmin, xmax, ymin, ymax, zmin, zmax)
+    void SetBounds(const double* Bounds)
+    {
+        double Extent = 0;
+        for (int i = 0; i < 3; i++) {
+            this->Origin[i] = Bounds[2 * i];
+            if (Bounds[2 * i + 1] - Bounds[2 * i] > Extent)
+                Extent = Bounds[2 * i + 1] - Bounds[2 * i];
+        }
+        this->Scale = Extent > 0 ? (double)MaximumCoordinate / Extent : 0;
+    }
+
+    /// Returns the key of P along the Morton curve
+    unsigned long long GetMortonKey(const double* P)
+    {
+        unsigned int X[3];
+        this->Quantize(P, X);
+        return (Interleave(X));
+    }
+
+    /// Returns the key of P along the Hilbert curve
+    unsigned long long GetHilbertKey(const double* P)
+    {
+        unsigned int X[3];
+        this->Quantize(P, X);
+
+        // transposes the coordinates into the Hilbert index (J. Skilling,
+        // "Programming the Hilbert curve", AIP Conference Proceedings, 2004)
+        unsigned int M = 1U << (Bits - 1), Q, T;
+        for (Q = M; Q > 1; Q >>= 1) {
+            unsigned int Mask = Q - 1;
+            for (int i = 0; i < 3; i++) {
+                if (X[i] & Q)
+                    X[0] ^= Mask;
+                else {
+                    T = (X[0] ^ X[i]) & Mask;
+                    X[0] ^= T;
+                    X[i] ^= T;
+                }
+            }
+        }
+
+        // Gray encoding
+        for (int i = 1; i < 3; i++)
+            X[i] ^= X[i - 1];
+        T = 0;
+        for (Q = M; Q > 1; Q >>= 1) {
+            if (X[2] & Q)
+                T ^= Q - 1;
+        }
+        for (int i = 0; i < 3; i++)
+            X[i] ^= T;
+
+        return (Interleave(X));
+    }
+
+private:
+    static const int Bits = 21;
+    static const unsigned int MaximumCoordinate = (1U << Bits) - 1;
+
+    // the lowest corner of the box and the quantization scale
+    double Origin[3];
+    double Scale;
+
+    void Quantize(const double* P, unsigned int* X)
+    {
+        for (int i = 0; i < 3; i++) {
+            double Coordinate = (P[i] - this->Origin[i]) * this->Scale;
+            if (Coordinate < 0)
+                Coordinate = 0;
+            if (Coordinate > MaximumCoordinate)
+                Coordinate = MaximumCoordinate;
+            X[i] = (unsigned int)Coordinate;
+        }
+    }
+
+    // interleaves the bits of the coordinates, most significant first
+    static unsigned long long Interleave(const unsigned int* X)
+    {
+        unsigned long long Key = 0;
+        for (int Bit = Bits - 1; Bit >= 0; Bit--) {
+            for (int i = 0; i < 3; i++)
+                Key = (Key << 1) | ((X[i] >> Bit) & 1);
+        }
+        return (Key);
+    }
+};
+
+#endif
@@ -0,0 +1,158 @@
+/*=========================================================================
+
+  Program:   Uniform spatial hash of a set of points
+  Module:    vtkSpatialHash.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#ifndef _VTKSPATIALHASH_H_
+#define _VTKSPATIALHASH_H_
+
+#include <cmath>
+#include <vector>
+
+#include <vtkPoints.h>
+
+#include "vtkParallelFor.h"
+
+/// Sorts points into the cells of a uniform grid, which are hashed into a
+/// table with about one bucket per point, so that the memory used does not
+/// depend on the extent of the grid. Points sharing a bucket are stored
+/// contiguously. As different cells can share a bucket, the points returned
+/// for a cell must still be tested against the query.
+class vtkSpatialHash
+{
+public:
+    /// Hashes Points into cells of size CellSize. The cells of the points
+    /// are computed in parallel.
+    void Build(vtkPoints* Points, double CellSize, int NumberOfThreads = 0)
+    {
+        vtkIdType NumberOfPoints = Points->GetNumberOfPoints();
+        this->CellSize = CellSize;
+        this->NumberOfBuckets = NumberOfPoints > 0 ? NumberOfPoints : 1;
+        this->PointsBuckets.resize(NumberOfPoints);
+
+        auto HashPoints = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+            double P[3];
+            long long Cell[3];
+            for (vtkIdType Id = Begin; Id < End; Id++) {
+                Points->GetPoint(Id, P);
+                this->GetCell(P, Cell);
+                this->PointsBuckets[Id] = this->GetBucket(Cell);
+            }
+        };
+        vtkParallelFor::Execute(NumberOfPoints, HashPoints, NumberOfThreads);
+
+        // counting sort of the points by bucket, keeping their order
+        this->Offsets.assign(this->NumberOfBuckets + 1, 0);
+        for (vtkIdType Id = 0; Id < NumberOfPoints; Id++)
+            this->Offsets[this->PointsBuckets[Id] + 1]++;
+        for (vtkIdType Bucket = 0; Bucket < this->NumberOfBuckets; Bucket++)
+            this->Offsets[Bucket + 1] += this->Offsets[Bucket];
+        this->Ids.resize(NumberOfPoints);
+        std::vector<vtkIdType> Positions(
+            this->Offsets.begin(), this->Offsets.end() - 1);
+        for (vtkIdType Id = 0; Id < NumberOfPoints; Id++)
+            this->Ids[Positions[this->PointsBuckets[Id]]++] = Id;
+    }
+
+    /// Returns the grid cell containing P
+    void GetCell(const double* P, long long* Cell)
+    {
+        for (int i = 0; i < 3; i++)
+            Cell[i] = (long long)std::floor(P[i] / this->CellSize);
+    }
+
+    /// Returns the bucket of a grid cell
+    vtkIdType GetBucket(const long long* Cell)
+    {
+        unsigned long long X = (unsigned long long)Cell[0];
+        unsigned long long Y = (unsigned long long)Cell[1];
+        unsigned long long Z = (unsigned long long)Cell[2];
+        unsigned long long Key =
+            (X * 73856093ULL) ^ (Y * 19349663ULL) ^ (Z * 83492791ULL);
+        return ((vtkIdType)(Key % (unsigned long long)this->NumberOfBuckets));
+    }
+
+    /// Returns the bucket of a point
+    vtkIdType GetPointBucket(vtkIdType Id) { return (this->PointsBuckets[Id]); }
+
+    /// Returns the number of buckets
+    vtkIdType GetNumberOfBuckets() { return (this->NumberOfBuckets); }
+
+    /// Returns the points of a bucket
+    void GetBucketPoints(
+        vtkIdType Bucket, vtkIdType& NumberOfIds, const vtkIdType*& BucketIds)
+    {
+        NumberOfIds = this->Offsets[Bucket + 1] - this->Offsets[Bucket];
+        BucketIds = this->Ids.data() + this->Offsets[Bucket];
+    }
+
+    /// Calls Function(Bucket) for the distinct buckets of the 27 cells
+    /// around P, i.e. the buckets which may contain points closer than
+    /// CellSize to P
+    template <class FunctionType>
+    void ForEachNeighbourBucket(const double* P, FunctionType& Function)
+    {
+        long long Cell[3], Neighbour[3];
+        vtkIdType Buckets[27];
+        int NumberOfBuckets = 0;
+        this->GetCell(P, Cell);
+        for (int i = -1; i < 2; i++) {
+            for (int j = -1; j < 2; j++) {
+                for (int k = -1; k < 2; k++) {
+                    Neighbour[0] = Cell[0] + i;
+                    Neighbour[1] = Cell[1] + j;
+                    Neighbour[2] = Cell[2] + k;
+                    vtkIdType Bucket = this->GetBucket(Neighbour);
+                    bool Visited = false;
+                    for (int l = 0; l < NumberOfBuckets; l++) {
+                        if (Buckets[l] == Bucket)
+                            Visited = true;
+                    }
+                    if (Visited)
+                        continue;
+                    Buckets[NumberOfBuckets++] = Bucket;
+                    Function(Bucket);
+                }
+            }
+        }
+    }
+
+private:
+    double CellSize;
+    vtkIdType NumberOfBuckets;
+
+    // the bucket of each point
+    std::vector<vtkIdType> PointsBuckets;
+
+    // the points, sorted by bucket, and the first point of each bucket
+    std::vector<vtkIdType> Ids;
+    std::vector<vtkIdType> Offsets;
+};
+
+#endif
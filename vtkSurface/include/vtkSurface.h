@@ -33,6 +33,7 @@
 #ifndef __vtkSurface_h
 #define __vtkSurface_h
 #include <sstream>
+#include <vector>
 #include <vtkCell.h>
 #include <vtkCommand.h>
 #include <vtkDoubleArray.h>
@@ -42,6 +43,7 @@
 #include <vtkIntArray.h>
 #include <vtkPointData.h>
 #include <vtkPolyData.h>
+#include <vtkTimeStamp.h>
 #include "vtkSurfaceBase.h"
 
 /**
@@ -51,6 +53,19 @@
  * from a file, compute its properties, subdivide etc.... See vtkSurfaceBase.h
  * for core functionnalities
  *
+ * The attributes returned by GetTrianglesNormals(), GetTrianglesAreas(),
+ * GetVerticesAreas(), GetEdgeLengths() and ComputeSharpVertices() are cached.
+ * Each call updates the cached array: it is recomputed in parallel when the
+ * points or the cells were modified globally (their modification time is
+ * newer than the array), and only around the elements modified by local
+ * edits (SetPointCoordinates(), FlipEdge(), AddFace()...) otherwise. Their
+ * NumberOfThreads argument bounds the threads used by the update (0 :
+ * default number of threads of vtkMultiThreader). Points edited directly
+ * through GetPoints() require a call to GetPoints()->Modified(). A call on a
+ * mesh which was not modified since the last update returns the cached
+ * array without writing anything, but the updates themselves are not
+ * thread-safe : threads sharing a mesh must not edit it, and its attributes
+ * must be computed before the threads start.
  */
 class VTK_EXPORT vtkSurface : public vtkSurfaceBase
 {
@@ -68,12 +83,33 @@ public:
     /// Recusrsively splits the edges longer than Ratio*AverageLength
     void SplitLongEdges(double Ratio);
 
-    /// returns a mesh which is a linear subdivision of this
-    vtkSurface* Subdivide(vtkIntArray* Parent1 = 0, vtkIntArray* Parent2 = 0);
+    /// returns a mesh which is a linear subdivision of this, built with
+    /// NumberOfThreads threads (0 : default number of threads of
+    /// vtkMultiThreader)
+    vtkSurface* Subdivide(
+        vtkIntArray* Parent1 = 0,
+        vtkIntArray* Parent2 = 0,
+        int NumberOfThreads = 0);
 
     /// subdivide the mesh (in place)
     void SubdivideInPlace(vtkIntArray* Parent1 = 0, vtkIntArray* Parent2 = 0);
 
+    /// returns a mesh where only the triangles larger than MaximumArea are
+    /// subdivided (1 to 4), their neighbours being split in 2 or 3 triangles
+    /// to keep the mesh conforming. The process is repeated until no triangle
+    /// is larger than MaximumArea, or for at most MaximumNumberOfPasses.
+    /// The vertices of this mesh keep their ids. Parent1 and Parent2 store the
+    /// two parents of each vertex (new vertices are edge middles, and their
+    /// parents always have smaller ids). FacesParent stores the face of this
+    /// mesh containing each output face. Deleted faces of this mesh are not
+    /// copied.
+    vtkSurface* SubdivideAdaptively(
+        double MaximumArea,
+        vtkIntArray* Parent1 = 0,
+        vtkIntArray* Parent2 = 0,
+        vtkIntArray* FacesParent = 0,
+        int MaximumNumberOfPasses = 10);
+
     /// copy to stream the connectivity and geometric properties of the mesh
     void GetMeshProperties(std::stringstream& stream);
 
@@ -94,7 +130,7 @@ public:
     double GetEdgeLength(vtkIdType Edge);
 
     /// returns the normals of the mesh triangles
-    vtkDoubleArray* GetTrianglesNormals();
+    vtkDoubleArray* GetTrianglesNormals(int NumberOfThreads = 0);
     void DeleteTrianglesNormals();
 
     // returns the area of a given cell and its barycenter
@@ -102,7 +138,7 @@ public:
         vtkIdType CellId, double& Area, double* Baricenter);
 
     /// Computes the Triangles Areas
-    vtkDoubleArray* GetTrianglesAreas();
+    vtkDoubleArray* GetTrianglesAreas(int NumberOfThreads = 0);
     void DeleteTrianglesAreas();
 
     /// Returns the area of the Face
@@ -120,27 +156,77 @@ public:
     /// Returns the euclidian distance between the vertices V1 and V2
     double GetDistanceBetweenVertices(vtkIdType V1, vtkIdType V2);
 
-    /// Builds a 1 connected component mesh from the mesh in two steps:
+    /// Builds a 1 connected component mesh from the mesh in three steps:
     /// First: merge the points which are closer than the given relative
-    /// tolerance Second : add fictive edges between unconnected components
+    /// tolerance (WeldVertices()) Second : repair the topology
+    /// (RepairTopology()) Third : add fictive edges between unconnected
+    /// components, shortest first
     vtkSurface* CleanConnectivity(double tolerance);
 
+    /// returns a mesh where the points closer than Tolerance are merged,
+    /// using a parallel uniform spatial hash. Merging is transitive, and each
+    /// merged vertex keeps the coordinates of its point with the smallest Id.
+    /// Faces are rebuilt with the merged vertices, without the faces which
+    /// degenerate, and points not used by any face are removed
+    vtkSurface* WeldVertices(double Tolerance, int NumberOfThreads = 0);
+
     /// Computes the area of Vertex (it will actually compute the area of the
     /// Surrounding cells divided by their respective number of vertices)
     double GetVertexArea(vtkIdType Vertex);
 
     /// Computes the Vertices Areas with respect to their surrounding cells
-    vtkDoubleArray* GetVerticesAreas();
+    vtkDoubleArray* GetVerticesAreas(int NumberOfThreads = 0);
     void DeleteVerticesAreas();
 
     /// Computes the Mesh Edges Lengths in an array
-    vtkDoubleArray* GetEdgeLengths();
+    vtkDoubleArray* GetEdgeLengths(int NumberOfThreads = 0);
     void DeleteEdgeLengths();
 
+    /// The orders available for Reorder()
+    enum ReorderingMethod
+    {
+        NO_REORDERING = 0,
+        MORTON_ORDER,
+        HILBERT_ORDER,
+        CUTHILL_MCKEE_ORDER
+    };
+
+    /// Renumbers the vertices, faces and edges so that neighbour elements
+    /// are mostly close in memory. With MORTON_ORDER and HILBERT_ORDER, the
+    /// vertices and the faces follow the curve through their coordinates
+    /// and centroids. With CUTHILL_MCKEE_ORDER, the vertices follow a reverse
+    /// Cuthill-McKee order of the edges graph, and the faces the order of
+    /// their first vertex. Edges follow the order of their vertices, and
+    /// deleted elements are moved to the end. Point and cell data arrays are
+    /// permuted accordingly, and the cached attributes are deleted. If given,
+    /// PointsPermutation (CellsPermutation) receives, for each new vertex
+    /// (face), its former Id.
+    void Reorder(
+        int Method = HILBERT_ORDER,
+        vtkIdTypeArray* PointsPermutation = 0,
+        vtkIdTypeArray* CellsPermutation = 0,
+        int NumberOfThreads = 0);
+
     /// Computes the connected components of the mesh
     vtkIdListCollection* GetConnectedComponents();
     void DeleteConnectedComponents();
 
+    /// Computes the connected components of the mesh with a parallel
+    /// union-find on the edges. Labels receives the component of each vertex,
+    /// in [0, NumberOfComponents), and Sizes (optional) the number of
+    /// vertices of each component. Components are numbered by increasing
+    /// smallest vertex Id, as in GetConnectedComponents(). Returns the number
+    /// of components
+    vtkIdType ComputeConnectedComponents(
+        vtkIdTypeArray* Labels,
+        vtkIdTypeArray* Sizes = 0,
+        int NumberOfThreads = 0);
+
+    /// returns a vtkSurface made of the vertices labeled Component and of
+    /// their faces (Labels is computed by ComputeConnectedComponents())
+    vtkSurface* ExtractConnectedComponent(
+        vtkIdTypeArray* Labels, vtkIdType Component);
+
     /// returns a vtkSurface made of the biggest connected component
     vtkSurface* GetBiggestConnectedComponent();
 
@@ -173,8 +259,11 @@ public:
     /// (quantization parameters must be given
     void QuantizeCoordinates(double Factor, double Tx, double Ty, double Tz);
 
-    /// Computes the list of sharp vertices
-    void ComputeSharpVertices(double treshold);
+    /// Computes the list of sharp vertices : vertices on a boundary, or with
+    /// an adjacent edge where the sine of the angle between the normals of
+    /// the two faces is larger than treshold. The list is also set as the
+    /// point scalars
+    void ComputeSharpVertices(double treshold, int NumberOfThreads = 0);
 
     /// Returns 1 if v is a sharp vertex
     /// Otherwise Returns 0.
@@ -236,6 +325,62 @@ private:
 
     vtkDoubleArray* EdgeLengths;
 
+    /// The elements carrying cached attributes
+    enum AttributeDomain
+    {
+        VERTEX_ATTRIBUTE,
+        FACE_ATTRIBUTE,
+        EDGE_ATTRIBUTE
+    };
+
+    /// The state of a cached attribute : time of its last update, and
+    /// position reached in the modifications log (-1 : needs a complete
+    /// computation)
+    struct AttributeState
+    {
+        vtkTimeStamp UpdateTime;
+        vtkIdType LogPosition;
+    };
+
+    AttributeState SharpVerticesState;
+    AttributeState VerticesAreasState;
+    AttributeState TrianglesAreasState;
+    AttributeState TrianglesNormalsState;
+    AttributeState EdgeLengthsState;
+
+    /// the treshold used for the current SharpVertices
+    double SharpVerticesTreshold;
+
+    /// Returns the number of elements of Domain
+    vtkIdType GetNumberOfElements(int Domain);
+
+    /// Returns the last time the points or the cells were modified globally
+    vtkMTimeType GetGeometryMTime();
+
+    /// Collects in Ids the elements of Domain whose attribute depends on the
+    /// elements modified since the update described by State, and the
+    /// elements with Ids larger or equal to FirstNewElement. Returns false
+    /// when all elements have to be recomputed
+    bool GetDirtyElements(
+        AttributeState& State,
+        int Domain,
+        vtkIdType FirstNewElement,
+        std::vector<vtkIdType>& Ids);
+
+    /// Resizes Array to the number of elements of Domain and computes the
+    /// values of its dirty elements (or of all elements) in parallel with
+    /// NumberOfThreads threads, with Compute(Values, Id, WorkList)
+    template <class ArrayType, class ComputeType>
+    void UpdateAttribute(
+        ArrayType* Array,
+        AttributeState& State,
+        int Domain,
+        ComputeType& Compute,
+        int NumberOfThreads);
+
+    /// Enables the modifications log while attributes are cached
+    void UpdateModificationsLog();
+
     /// parameters used for quantization
     double Tx;
     double Ty;
@@ -34,6 +34,7 @@
 #define __vtkSurfaceBase_h
 
 #include <queue>
+#include <vector>
 
 #include <vtkBitArray.h>
 #include <vtkCell.h>
@@ -79,6 +80,47 @@ public:
     /// Embeds a vtkPolyData into a vtkSurfaceBase object.
     void CreateFromPolyData(vtkPolyData* input);
 
+    /// Fills this (empty) object with the triangles given as NumberOfTriangles
+    /// x 3 vertex Ids, without intermediate vtkPolyData. Points is used as
+    /// is, so that it can wrap a buffer owned by the caller. The triangles
+    /// are written into the cell array in parallel, as its layout differs
+    /// from the flat Triangles buffer.
+    void CreateFromTriangles(
+        vtkPoints* Points,
+        const vtkIdType* Triangles,
+        vtkIdType NumberOfTriangles,
+        int NumberOfThreads = 0);
+    void CreateFromTriangles(
+        vtkPoints* Points,
+        const int* Triangles,
+        vtkIdType NumberOfTriangles,
+        int NumberOfThreads = 0);
+
+    /// Fills this (empty) object with the subdivision of the triangular mesh
+    /// Input, where each edge is split at its midpoint and each triangle into
+    /// four. The points, cells and adjacency arrays are written directly and
+    /// in parallel, with the same vertex, face and edge numbering and the
+    /// same rings as successive AddVertex() and AddFace() calls on a
+    /// consistently oriented input. Parent1 and Parent2 receive the parents
+    /// of the new vertices, as in vtkSurface::Subdivide()
+    void CreateFromSubdivision(
+        vtkSurfaceBase* Input,
+        vtkIntArray* Parent1 = 0,
+        vtkIntArray* Parent2 = 0,
+        int NumberOfThreads = 0);
+
+    /// Renumbers the vertices, faces and edges of the mesh : vertex (face,
+    /// edge) i gets the Id NewVertexIds[i] (NewFaceIds[i], NewEdgeIds[i]).
+    /// Each array must be a permutation of the Ids of its elements, deleted
+    /// elements included. The point and cell data arrays are permuted
+    /// accordingly, and replaced rather than modified, as they may be shared
+    /// with other datasets.
+    void PermuteElements(
+        const vtkIdType* NewVertexIds,
+        const vtkIdType* NewFaceIds,
+        const vtkIdType* NewEdgeIds,
+        int NumberOfThreads = 0);
+
     /// Set memory allocation in the vtkSurfaceBase object for further Cells
     /// and points insertion (this is not mandatory, and maybe useless)
     void Init(int numPoints, int numFaces, int numEdges);
@@ -140,6 +182,13 @@ public:
     /// are free and is CleanVertices and CleanEdges are set to 1
     void DeleteFace(vtkIdType f1);
 
+    /// Deletes the faces which break the topology: degenerate faces (with
+    /// repeated vertices), duplicated faces (with the same vertices as a face
+    /// with a smaller Id) and the faces making edges non-manifold (only the
+    /// two adjacent faces with the smallest Ids are kept). Returns the number
+    /// of deleted faces
+    int RepairTopology();
+
     /// Deletes the free edge e1 and possibly its vertices if they are free.
     /// free means not connected to any higher order element
     void DeleteEdge(vtkIdType e1);
@@ -308,6 +357,29 @@ public:
     /// OK
     bool CheckStructure();
 
+    /// Enables or disables the log of the vertices and faces modified by the
+    /// local editing methods (SetPointCoordinates(), AddVertex(), AddFace(),
+    /// DeleteFace(), FlipEdge(), BisectEdge()...). vtkSurface enables it
+    /// while attributes are cached, to update them around the modifications
+    /// only. Disabling the log clears it.
+    void SetModificationsLog(bool Enable);
+
+    /// Returns the position of the end of the modifications log
+    vtkIdType GetModificationsLogEnd()
+    {
+        return (this->ModificationsLogStart + this->ModificationsLog.size());
+    }
+
+    /// Appends to Vertices and Faces the vertices and faces modified since
+    /// the log position Start (with repetitions). The vertices of the
+    /// modified faces are included. Returns false when the log does not
+    /// reach back to Start, i.e. when it was disabled or too many elements
+    /// were modified since Start.
+    bool GetModifications(
+        vtkIdType Start,
+        std::vector<vtkIdType>& Vertices,
+        std::vector<vtkIdType>& Faces);
+
 protected:
     /// the constructor
     vtkSurfaceBase();
@@ -316,6 +388,17 @@ protected:
     ~vtkSurfaceBase();
 
 private:
+    /// builds the edges and vertices rings of the polygons, once the points
+    /// and cells are set
+    void BuildTopology();
+
+    /// fills the cells with triangles, as CreateFromTriangles()
+    template <class IdType>
+    void SetTriangles(
+        const IdType* Triangles,
+        vtkIdType NumberOfTriangles,
+        int NumberOfThreads);
+
     /// adds an edge (v1,v2) to the vtkSurface, with possibly an adjacent face
     /// f1
     vtkIdType AddEdge(vtkIdType v1, vtkIdType v2, vtkIdType f1);
@@ -346,6 +429,27 @@ private:
     /// uneffective if CleanVertices is set to 0
     void CleanVertex(vtkIdType Vertex);
 
+    /// logs a modified vertex, if the modifications log is enabled
+    void LogVertex(vtkIdType Vertex);
+
+    /// logs a modified face and its vertices, if the modifications log is
+    /// enabled
+    void LogFace(vtkIdType Face);
+
+    /// appends an entry to the modifications log, which is emptied when it
+    /// becomes too large
+    void AppendToLog(vtkIdType Entry);
+
+    /// the log of the modified vertices (entry 2 * Id) and faces (entry
+    /// 2 * Id + 1)
+    std::vector<vtkIdType> ModificationsLog;
+
+    /// the position of the first entry of ModificationsLog since the creation
+    /// of the object
+    vtkIdType ModificationsLogStart;
+
+    bool ModificationsLogEnabled;
+
     ///=true if we keep orientation of the surface
     bool OrientedSurface;
 
@@ -432,7 +536,15 @@ inline void vtkSurfaceBase::SetFace(
     vertices[0] = v1;
     vertices[1] = v2;
     vertices[2] = v3;
+    this->LogFace(f1);
     this->ReplaceCell(f1, 3, vertices);
+    this->LogFace(f1);
+}
+
+inline void vtkSurfaceBase::LogVertex(vtkIdType Vertex)
+{
+    if (this->ModificationsLogEnabled)
+        this->AppendToLog(2 * Vertex);
 }
 
 // ** METHODE GetThirdPoint
@@ -562,6 +674,7 @@ inline bool vtkSurfaceBase::IsEdgeManifold(const vtkIdType& Edge)
 inline void vtkSurfaceBase::SetPointCoordinates(vtkIdType Point, double* x)
 {
     this->Points->SetPoint(Point, x);
+    this->LogVertex(Point);
 }
 
 inline vtkIdType vtkSurfaceBase::GetFirstEdge(const vtkIdType& v1)
@@ -33,8 +33,12 @@
 * ------------------------------------------------------------------------ */
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <queue>
 #include <random>
+#include <string>
+#include <vector>
 
 #include <vtkBitArray.h>
 #include <vtkCellData.h>
@@ -43,13 +47,24 @@
 #include <vtkMath.h>
 #include <vtkTimerLog.h>
 
+#include "vtkClusteringCheckpoint.h"
+#include "vtkClusteringReport.h"
+#include "vtkEdgeFrontier.h"
+#include "vtkMyMinimalStandardRandomSequence.h"
+#include "vtkParallelFor.h"
+#include "vtkUnionFind.h"
+
 /// A Class to process uniform clustering, Implemented from the paper:
 /// "Approximated Centroidal Voronoi Diagrams for Uniform Polygonal Mesh
 /// Coarsening" [Valette & Chassery, Eurographics 2004] NOTE : this is a pure
 /// abstract class, only derived class can be used. See vtkSurfaceClustering for
 /// a working example
+/// When Derived is given (it must be the most derived class), the queries
+/// made by the minimization loops (GetEdgeItems, ConnexityConstraintProblem,
+/// AddItemRingToProcess) are statically dispatched to Derived, so that they
+/// can be inlined. With the default (void), the virtual methods are called.
 
-template <class Metric, typename EdgeType = vtkIdType>
+template <class Metric, typename EdgeType = vtkIdType, class Derived = void>
 class vtkUniformClustering : public vtkObject
 {
 public:
@@ -137,9 +152,103 @@ public:
         return (this->ClustersSizes->GetValue(Cluster));
     };
 
+    /// Sets On/Off the sorting of the boundary edges by Id before each loop.
+    /// This improves memory locality but changes the processing order.
+    /// Default : Off
+    void SetSortFrontier(bool Sort) { this->Frontier.SetSortEdges(Sort); }
+
+    /// Sets the number of threads used by the parallel parts of the
+    /// clustering (cleaning, and minimization for the threaded version).
+    /// By default, the number of threads is the number of CPUS
+    void SetNumberOfThreads(int N) { this->NumberOfThreads = N; }
+
+    /// returns the number of threads used for the clustering.
+    int GetNumberOfThreads() { return (this->NumberOfThreads); }
+
+    /// Sets On/Off the deterministic mode. When On, the result only depends
+    /// on the input and the parameters, not on the platform nor on the number
+    /// of threads. Default : 0 (Off)
+    void SetDeterministic(int D) { this->Deterministic = D; }
+    int GetDeterministic() { return (this->Deterministic); }
+
+    /// Sets the file where the state of the minimization is periodically
+    /// saved. The file is written in the background, without stalling the
+    /// minimization. Default : none (no checkpoints)
+    void SetCheckpointFile(const char* FileName)
+    {
+        this->CheckpointFile = FileName ? FileName : "";
+    }
+
+    /// Sets the minimum delay (in seconds) between two checkpoints.
+    /// Default : 60
+    void SetCheckpointInterval(double Interval)
+    {
+        this->CheckpointInterval = Interval;
+    }
+
+    /// Sets On/Off resuming from the checkpoint file when it exists. The
+    /// resumed run gives the same result as an uninterrupted one, provided
+    /// that the input and the parameters are the same. Default : 0 (Off)
+    void SetResumeFromCheckpoint(int Resume)
+    {
+        this->ResumeFromCheckpoint = Resume;
+    }
+
+    /// Sets the time budget of the clustering, in seconds. When it is
+    /// exhausted, the minimization stops cleanly and the current clustering,
+    /// cleaned to connected clusters, is returned. Default : 0 (no budget)
+    void SetMaximumTime(double Time) { this->MaximumTime = Time; }
+
+    /// Sets the minimum relative energy improvement of a loop. The
+    /// minimization stops when the loops improve the energy less than that,
+    /// on average since the previous energy sample. Default : 0 (no
+    /// threshold)
+    void SetMinimumEnergyImprovement(double Improvement)
+    {
+        this->MinimumEnergyImprovement = Improvement;
+    }
+
+    /// Sets the number of loops between two samples of the global energy
+    /// for the MinimumEnergyImprovement threshold, as computing it visits
+    /// all the clusters. Default : 5
+    void SetBudgetEnergyInterval(int Interval)
+    {
+        this->BudgetEnergyInterval = Interval > 0 ? Interval : 1;
+    }
+
+    /// Returns 1 when the last clustering was stopped by the budget
+    int GetBudgetExhausted() { return (this->BudgetExhausted); }
+
+    /// Returns the energy of the clustering at the end of the last
+    /// minimization, or when it was stopped by the budget
+    double GetFinalEnergy() { return (this->FinalEnergy); }
+
+    /// Returns the estimated energy decrease that was left when the
+    /// clustering was stopped by the budget (-1 : unknown). It is
+    /// extrapolated from the decreases of the last loops
+    double GetEnergyGap() { return (this->EnergyGap); }
+
+    /// Sets the report where the timings and counters of the clustering
+    /// stages and loops are recorded. The report is not owned by the
+    /// clustering. Default : 0 (no report)
+    void SetReport(vtkClusteringReport* Report) { this->Report = Report; }
+    vtkClusteringReport* GetReport() { return (this->Report); }
+
+    /// Sets the number of loops between two samples of the global energy in
+    /// the report, as computing it visits all the clusters. 0 disables the
+    /// samples. Default : 10
+    void SetReportEnergyInterval(int Interval)
+    {
+        this->ReportEnergyInterval = Interval;
+    }
+
 protected:
-    /// virtual function derived in the threaded version.
-    virtual void SwapQueues(){};
+    /// makes the edges pushed during the last loop available for the next
+    /// one. Derived in the threaded version.
+    virtual void SwapQueues() { this->Frontier.Swap(); };
+
+    /// adds an edge to the edges to process during the next loop
+    void AddEdgeToProcess(EdgeType Edge) { this->Frontier.Push(Edge); }
 
     /// Virtual method that can be overcharged in derived classes when speed is
     /// an issue
@@ -173,6 +282,25 @@ protected:
     /// Method to build the metric (pure virtual function)
     virtual void BuildMetric() = 0;
 
+    /// statically dispatched versions of the queries used in the minimization
+    /// loops. They fall back to the virtual methods when Derived is void
+    void DispatchGetEdgeItems(EdgeType Edge, vtkIdType& I1, vtkIdType& I2)
+    {
+        this->DispatchGetEdgeItems(Edge, I1, I2, (Derived*)0);
+    }
+
+    int DispatchConnexityConstraintProblem(
+        vtkIdType Item, EdgeType Edge, vtkIdType Cluster, vtkIdType Cluster2)
+    {
+        return this->DispatchConnexityConstraintProblem(
+            Item, Edge, Cluster, Cluster2, (Derived*)0);
+    }
+
+    void DispatchAddItemRingToProcess(vtkIdType Item)
+    {
+        this->DispatchAddItemRingToProcess(Item, (Derived*)0);
+    }
+
     /// Method mostly usefull when clustering volumes with boundaries
     /// constraints : this method returns whether an item is on the boundary
     /// between objects the method should return -1 when the item is not on a
@@ -208,7 +336,8 @@ protected:
     /// re-computes the number of items in each cluster
     void ReComputeClustersSize();
 
-    /// re-computes the statistics of the clustering
+    /// re-computes the statistics of the clustering. Clusters are processed
+    /// in parallel, and the result does not depend on the number of threads
     void ReComputeStatistics();
 
     /// the maximum number of convergences.
@@ -228,6 +357,11 @@ protected:
     /// Picks the initial samples
     void InitSamples(vtkIdList* List);
 
+    /// shuffles Items predictably. In deterministic mode, the result does not
+    /// depend on Generator, but only on the Stream number
+    void ShuffleItems(
+        int* Items, int NumberOfItems, std::mt19937& Generator, int Stream);
+
     /// a independent method to randomly initialize regions according to the
     /// weights
     virtual void ComputeInitialRandomSampling(
@@ -253,18 +387,97 @@ protected:
     /// detects the clusters made of several disconnected components
     /// their number is the returned integer. for each of these clusters
     /// only the component with the biggest area is kept. The other components
-    /// are reset to the NULL cluster.
+    /// are reset to the NULL cluster. The components are computed in parallel
+    /// with a union-find forest.
     int CleanClustering();
 
-    // assigns the Items belonging to the NULL to other clusters, with a greedy
-    // algorithm
+    // assigns the Items belonging to the NULL to other clusters, by
+    // propagating the clusters labels inside the holes, one ring at a time.
+    // As with the minimization, an item only leaves the NULL cluster when
+    // ConnexityConstraintProblem() allows it
     void FillHolesInClustering(vtkIntArray* Clustering);
 
     /// allocates the needed memory
     void Allocate();
 
-    /// the queue containing the edges between two clusters
-    std::queue<EdgeType> EdgeQueue;
+    /// The number of threads (0 : number of CPUS)
+    int NumberOfThreads;
+
+    /// deterministic mode flag
+    int Deterministic;
+
+    /// the edges between two clusters
+    vtkEdgeFrontier<EdgeType> Frontier;
+
+    /// serializes the minimization state and writes it to CheckpointFile in
+    /// the background. Nothing is done when the previous checkpoint is still
+    /// being written, or when CheckpointInterval has not elapsed.
+    void SaveCheckpoint();
+
+    /// restores the minimization state from CheckpointFile. Returns 0 when
+    /// the file is missing or does not match the current input. Derived in
+    /// the threaded version, which also restores its pool of processes
+    virtual int LoadCheckpoint();
+
+    /// fills Signature with the values identifying the clustered input.
+    /// Resuming is only possible when the signatures match
+    virtual void GetCheckpointSignature(std::vector<vtkTypeInt64>& Signature);
+
+    /// the checkpoint file name (empty : no checkpoints)
+    std::string CheckpointFile;
+
+    /// the minimum delay between two checkpoints
+    double CheckpointInterval;
+
+    /// the time of the last checkpoint
+    double LastCheckpointTime;
+
+    /// resume flag
+    int ResumeFromCheckpoint;
+
+    /// set when the state was restored from a checkpoint, so that
+    /// MinimizeEnergy() does not reinitialize it
+    int Resumed;
+
+    /// set while checkpoints can be taken (only during the first
+    /// minimization of ProcessClustering())
+    int CheckpointsActive;
+
+    /// the checkpoint buffer and writer
+    vtkClusteringCheckpoint Checkpoint;
+
+    /// the report, possibly null
+    vtkClusteringReport* Report;
+
+    /// the number of loops between two energy samples of the report
+    int ReportEnergyInterval;
+
+    /// report helpers, which do nothing when no report is set
+    void StartStage(const char* Name)
+    {
+        if (this->Report)
+            this->Report->StartStage(Name);
+    }
+
+    void StopStage()
+    {
+        if (this->Report)
+            this->Report->StopStage();
+    }
+
+    void SetStageCounter(const char* Name, double Value)
+    {
+        if (this->Report)
+            this->Report->SetCounter(Name, Value);
+    }
+
+    /// the number of edges skipped during the current loop because none of
+    /// their clusters was modified during the previous loop
+    vtkIdType NumberOfSkippedEdges;
+
+    /// the number of moves rejected during the current loop because they
+    /// would disconnect or empty a cluster
+    vtkIdType NumberOfConnexityRejects;
 
     /// re-compute the list of edges between two different clusters (usefull
     /// after cleaning, initialization...)
@@ -284,13 +497,6 @@ protected:
     /// the array containing the number of items inside each cluster
     vtkIntArray* ClustersSizes;
 
-    /// array containing the last time an edge was visited (usefull to remove
-    /// duplicate entries in the queue)
-    unsigned char* EdgesLastLoop;
-
-    /// value to keep a relative notion of NumberOfloops
-    unsigned char RelativeNumberOfLoops;
-
     /// array containing the last time a cluster was modified (usefull for speed
     /// improvement)
     int* ClustersLastModification;
@@ -316,9 +522,63 @@ protected:
     /// The clustering start time is stored here
     double StartTime;
 
-    /// returns the global energy value, also computes the difference between
-    /// last time it was computed
-    long double ComputeGlobalEnergy();
+    /// returns the global energy value, using compensated summation. The
+    /// clusters are summed in parallel by fixed blocks, so that the result
+    /// does not depend on the number of threads. When UpToDate is true, the
+    /// energies of the non-empty clusters are recomputed from the
+    /// accumulators instead of using the stored values (the energy of an
+    /// empty cluster cannot be computed, its stored value is used)
+    long double ComputeGlobalEnergy(bool UpToDate = false);
+
+    /// adds Value to Sum with Neumaier compensated summation, the rounding
+    /// errors being accumulated in Compensation
+    static void AddCompensated(
+        long double& Sum, long double& Compensation, long double Value)
+    {
+        long double NewSum = Sum + Value;
+        if (std::fabs(Sum) >= std::fabs(Value))
+            Compensation += (Sum - NewSum) + Value;
+        else
+            Compensation += (Value - NewSum) + Sum;
+        Sum = NewSum;
+    }
+
+    /// returns 1 when the time budget is exhausted. When SampleEnergy is
+    /// true, Energy is the current global energy : the energy history is
+    /// updated, and 1 is also returned when the energy improvement per loop
+    /// since the previous sample is below MinimumEnergyImprovement
+    int IsBudgetExhausted(bool SampleEnergy, long double Energy);
+
+    /// stops the minimization before convergence : the clustering is
+    /// cleaned so that each cluster is connected, and the energy gap is
+    /// estimated
+    void StopMinimization();
+
+    /// the maximum duration of the clustering, in seconds (0 : no limit)
+    double MaximumTime;
+
+    /// the minimum relative energy improvement of a loop (0 : no limit)
+    double MinimumEnergyImprovement;
+
+    /// the number of loops between two energy samples of the budget
+    int BudgetEnergyInterval;
+
+    /// set when the minimization was stopped by the budget
+    int BudgetExhausted;
+
+    /// the energy of the clustering when it was stopped
+    double FinalEnergy;
+
+    /// the estimated energy decrease left when it was stopped
+    double EnergyGap;
+
+    /// the last energy sample, the loop it was computed at, and the last
+    /// two energy decreases between samples. Only computed when an energy
+    /// threshold is set
+    long double LastEnergy;
+    int LastEnergyLoop;
+    long double LastDecreases[2];
+    int NumberOfEnergySamples;
 
     // this flag determines whether the clustering will be performed first with
     // unconstrained metric and then with constrained metric (this makes the
@@ -330,16 +590,65 @@ protected:
 
     // an array to define freezed clusters
     vtkBitArray* IsClusterFreezed;
+
+private:
+    // overloads selected when Derived is void : virtual calls
+    void DispatchGetEdgeItems(
+        EdgeType Edge, vtkIdType& I1, vtkIdType& I2, void*)
+    {
+        this->GetEdgeItems(Edge, I1, I2);
+    }
+
+    int DispatchConnexityConstraintProblem(
+        vtkIdType Item,
+        EdgeType Edge,
+        vtkIdType Cluster,
+        vtkIdType Cluster2,
+        void*)
+    {
+        return this->ConnexityConstraintProblem(Item, Edge, Cluster, Cluster2);
+    }
+
+    void DispatchAddItemRingToProcess(vtkIdType Item, void*)
+    {
+        this->AddItemRingToProcess(Item);
+    }
+
+    // overloads selected when Derived is a class : qualified (non virtual)
+    // calls to the implementations visible from Derived
+    template <class D>
+    void DispatchGetEdgeItems(EdgeType Edge, vtkIdType& I1, vtkIdType& I2, D*)
+    {
+        static_cast<D*>(this)->D::GetEdgeItems(Edge, I1, I2);
+    }
+
+    template <class D>
+    int DispatchConnexityConstraintProblem(
+        vtkIdType Item,
+        EdgeType Edge,
+        vtkIdType Cluster,
+        vtkIdType Cluster2,
+        D*)
+    {
+        return static_cast<D*>(this)->D::ConnexityConstraintProblem(
+            Item, Edge, Cluster, Cluster2);
+    }
+
+    template <class D>
+    void DispatchAddItemRingToProcess(vtkIdType Item, D*)
+    {
+        static_cast<D*>(this)->D::AddItemRingToProcess(Item);
+    }
 };
 
-template <class Metric, class EdgeType>
-vtkIntArray* vtkUniformClustering<Metric, EdgeType>::GetClustering()
+template <class Metric, class EdgeType, class Derived>
+vtkIntArray* vtkUniformClustering<Metric, EdgeType, Derived>::GetClustering()
 {
     return (this->Clustering);
 }
 
-template <class Metric, class EdgeType>
-void vtkUniformClustering<Metric, EdgeType>::SetInitialClustering(
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::SetInitialClustering(
     vtkIntArray* Clust)
 {
     this->InitialSamplingType = 2;
@@ -347,17 +656,17 @@ void vtkUniformClustering<Metric, EdgeType>::SetInitialClustering(
     InitialClustering->Register(this);
 }
 
-template <class Metric, class EdgeType>
-void vtkUniformClustering<Metric, EdgeType>::AddItemRingToProcess(
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::AddItemRingToProcess(
     vtkIdType Item)
 {
     this->GetItemEdges(Item, this->EdgeList);
     for (int i = 0; i < this->EdgeList->GetNumberOfIds(); i++)
-        this->EdgeQueue.push(this->EdgeList->GetId(i));
+        this->Frontier.Push(this->EdgeList->GetId(i));
 }
 
-template <class Metric, class EdgeType>
-void vtkUniformClustering<Metric, EdgeType>::ReComputeClustersSize()
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::ReComputeClustersSize()
 {
     for (vtkIdType i = 0; i != this->NumberOfClusters; i++) {
         this->ClustersSizes->SetValue(i, 0);
@@ -375,240 +684,449 @@ void vtkUniformClustering<Metric, EdgeType>::ReComputeClustersSize()
     }
 }
 
-template <class Metric, class EdgeType>
-void vtkUniformClustering<Metric, EdgeType>::ReComputeStatistics()
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::ReComputeStatistics()
 {
+    typedef vtkUniformClustering<Metric, EdgeType, Derived> Self;
     this->ReComputeClustersSize();
-    for (vtkIdType i = 0; i != this->NumberOfClusters; i++)
-        this->MetricContext.ResetCluster(Clusters + i);
 
+    // Sort the items by cluster, keeping the items order inside each
+    // cluster. Each cluster is then accumulated by a single thread, in the
+    // same order as a sequential traversal of the items, so that the
+    // statistics do not depend on the number of threads
+    int NumberOfClusters = this->NumberOfClusters;
+    std::vector<vtkIdType> Offsets(NumberOfClusters + 1);
+    Offsets[0] = 0;
+    for (int i = 0; i < NumberOfClusters; i++)
+        Offsets[i + 1] = Offsets[i] + this->ClustersSizes->GetValue(i);
+
+    std::vector<vtkIdType> Positions(Offsets.begin(), Offsets.end() - 1);
+    std::vector<vtkIdType> Items(Offsets[NumberOfClusters]);
+
+    // the items out of range were reported by ReComputeClustersSize()
     for (vtkIdType i = 0; i != this->GetNumberOfItems(); i++) {
         vtkIdType Cluster = this->Clustering->GetValue(i);
-        if ((Cluster >= 0) && (Cluster < this->NumberOfClusters))
-            this->MetricContext.AddItemToCluster(i, this->Clusters + Cluster);
-        else {
-            if (Cluster != this->NumberOfClusters)
-                cout << "Warning! : item " << i << " belongs to cluster "
-                     << Cluster << endl;
-        }
+        if ((Cluster >= 0) && (Cluster < NumberOfClusters))
+            Items[Positions[Cluster]++] = i;
     }
+
+    struct Accumulation
+    {
+        Self* Clustering;
+        vtkIdType* Offsets;
+        vtkIdType* Items;
+
+        void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+        {
+            Metric& Context = this->Clustering->MetricContext;
+            vtkIdType NumberOfActiveClusters =
+                this->Clustering->NumberOfClusters -
+                this->Clustering->NumberOfSpareClusters;
+
+            for (vtkIdType i = Begin; i < End; i++) {
+                typename Metric::Cluster* Cluster =
+                    this->Clustering->Clusters + i;
+                Context.ResetCluster(Cluster);
+                for (vtkIdType j = this->Offsets[i]; j < this->Offsets[i + 1];
+                     j++)
+                    Context.AddItemToCluster(this->Items[j], Cluster);
+
+                if (i < NumberOfActiveClusters) {
+                    Context.ComputeClusterCentroid(Cluster);
+                    Context.ComputeClusterEnergy(Cluster);
+                }
+            }
+        }
+    };
+
+    Accumulation Accumulate;
+    Accumulate.Clustering = this;
+    Accumulate.Offsets = Offsets.data();
+    Accumulate.Items = Items.data();
+    vtkParallelFor::Execute(
+        NumberOfClusters, Accumulate, this->NumberOfThreads);
+
     for (vtkIdType i = 0;
          i != this->NumberOfClusters - this->NumberOfSpareClusters; i++) {
-
-        this->MetricContext.ComputeClusterCentroid(Clusters + i);
-        this->MetricContext.ComputeClusterEnergy(Clusters + i);
         if (this->ClustersSizes->GetValue(i) == 0)
             cout << "Cluster " << i << " is empty!" << endl;
     }
 }
 
-template <class Metric, class EdgeType>
-int vtkUniformClustering<Metric, EdgeType>::CleanClustering()
+template <class Metric, class EdgeType, class Derived>
+int vtkUniformClustering<Metric, EdgeType, Derived>::CleanClustering()
 {
-    int i, j, l;
-    int Number, Type, Size;
-    vtkIdList** Clusters;
-    char* Visited;
-    vtkIdType* VisitedCluster;
-    int* Sizes;
-    vtkIdType I1, I2;
-
-    std::queue<int> Queue;
-    Clusters = new vtkIdList*[this->NumberOfClusters];
-    Sizes = new int[this->NumberOfClusters];
-    Visited = new char[this->GetNumberOfItems()];
-    VisitedCluster = new vtkIdType[this->NumberOfClusters];
-    Number = 0;
-
-    vtkIdList* IList = vtkIdList::New();
-
-    // Detect clusters that	have several connected components
-    for (i = 0; i < this->GetNumberOfItems(); i++)
-        Visited[i] = 0;
-    for (i = 0; i < this->NumberOfClusters; i++) {
-        Clusters[i] = 0;
-        Sizes[i] = 0;
-        VisitedCluster[i] = 0;
-    }
-
-    for (i = 0; i < this->GetNumberOfItems(); i++) {
-        while (Queue.empty() == 0)
-            Queue.pop();
-
-        if ((Visited[i] == 0) &&
-            (this->Clustering->GetValue(i) != this->NumberOfClusters)) {
-            Size = 0;
-            Queue.push(i);
-            Type = this->Clustering->GetValue(i);
-            while (Queue.empty() == 0) {
-                I1 = Queue.front();
-                Queue.pop();
-                if (Visited[I1] == 0) {
-                    if (this->GetItemType(I1) != 0)
-                        Size++;
-                    Visited[I1] = 1;
-
-                    this->GetItemNeighbours(I1, IList);
-
-                    for (j = 0; j < IList->GetNumberOfIds(); j++) {
-                        I2 = IList->GetId(j);
-                        if ((Visited[I2] == 0) &&
-                            (this->Clustering->GetValue(I2) == Type))
-                            Queue.push(I2);
-                    }
+    typedef vtkUniformClustering<Metric, EdgeType, Derived> Self;
+    vtkIdType NumberOfItems = this->GetNumberOfItems();
+    int NumberOfClusters = this->NumberOfClusters;
+
+    // the connected components are labeled with a union-find forest :
+    // the root of a component is its smallest item
+    vtkUnionFind Components;
+    Components.Allocate(NumberOfItems);
+
+    // for each root, the size of its component (-1 : component to reset)
+    std::atomic<int>* ComponentsSizes = new std::atomic<int>[NumberOfItems];
+
+    // for each cluster, its number of components
+    std::atomic<int>* ClustersComponents =
+        new std::atomic<int>[NumberOfClusters];
+    for (int i = 0; i < NumberOfClusters; i++)
+        ClustersComponents[i] = 0;
+
+    // Merge the neighbour items belonging to the same cluster
+    struct Linking
+    {
+        Self* Clustering;
+        vtkUnionFind* Components;
+        std::atomic<int>* ComponentsSizes;
+
+        void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+        {
+            int* Values = this->Clustering->Clustering->GetPointer(0);
+            int NullCluster = this->Clustering->NumberOfClusters;
+            vtkIdList* IList = vtkIdList::New();
+            for (vtkIdType I1 = Begin; I1 < End; I1++) {
+                this->ComponentsSizes[I1].store(0, std::memory_order_relaxed);
+                int Cluster = Values[I1];
+                if ((Cluster < 0) || (Cluster >= NullCluster))
+                    continue;
+                this->Clustering->GetItemNeighbours(I1, IList);
+                for (vtkIdType j = 0; j < IList->GetNumberOfIds(); j++) {
+                    vtkIdType I2 = IList->GetId(j);
+                    if (Values[I2] == Cluster)
+                        this->Components->Union(I1, I2);
                 }
             }
-            if (Type != this->NumberOfClusters) {
-                if (VisitedCluster[Type] == 0) {
-                    // first connected component
-                    VisitedCluster[Type] = i;
-                    Sizes[Type] = Size;
-                } else {
-                    // The cluster has an other	connected component
-                    if (Clusters[Type] == 0) {
-                        Clusters[Type] = vtkIdList::New();
-                        Clusters[Type]->InsertNextId(VisitedCluster[Type]);
-                        Clusters[Type]->InsertNextId(Sizes[Type]);
-                    }
-                    Clusters[Type]->InsertNextId(i);
-                    Clusters[Type]->InsertNextId(Size);
-                }
+            IList->Delete();
+        }
+    };
+
+    // Compute the components sizes and count the components of each cluster
+    struct Counting
+    {
+        Self* Clustering;
+        vtkUnionFind* Components;
+        std::atomic<int>* ComponentsSizes;
+        std::atomic<int>* ClustersComponents;
+
+        void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+        {
+            int* Values = this->Clustering->Clustering->GetPointer(0);
+            int NullCluster = this->Clustering->NumberOfClusters;
+            for (vtkIdType Item = Begin; Item < End; Item++) {
+                int Cluster = Values[Item];
+                if ((Cluster < 0) || (Cluster >= NullCluster))
+                    continue;
+                vtkIdType Root = this->Components->Find(Item);
+                if (this->Clustering->GetItemType(Item) != 0)
+                    this->ComponentsSizes[Root].fetch_add(1);
+                if (Root == Item)
+                    this->ClustersComponents[Cluster].fetch_add(1);
             }
         }
+    };
+
+    Linking Link;
+    Link.Clustering = this;
+    Link.Components = &Components;
+    Link.ComponentsSizes = ComponentsSizes;
+
+    Counting Count;
+    Count.Clustering = this;
+    Count.Components = &Components;
+    Count.ComponentsSizes = ComponentsSizes;
+    Count.ClustersComponents = ClustersComponents;
+
+    vtkParallelFor::Execute(NumberOfItems, Link, this->NumberOfThreads);
+    vtkParallelFor::Execute(NumberOfItems, Count, this->NumberOfThreads);
+
+    // Flat table of the components of each cluster. Only the clusters with
+    // several components are stored
+    std::vector<vtkIdType> Offsets(NumberOfClusters + 1, 0);
+    for (int i = 0; i < NumberOfClusters; i++) {
+        int NumberOfComponents = ClustersComponents[i];
+        Offsets[i + 1] =
+            Offsets[i] + ((NumberOfComponents > 1) ? NumberOfComponents : 0);
+        ClustersComponents[i] = 0;
     }
+    std::vector<vtkIdType> Table(Offsets[NumberOfClusters]);
 
-    for (i = 0; i < this->GetNumberOfItems(); i++)
-        Visited[i] = 0;
-
-    // Reset the smallest unconnected components to	NULLCLUSTER
-    int Sizemax, Imax = 0;
-    for (i = 0; i < this->NumberOfClusters; i++) {
-        if ((Clusters[i] != 0) && (this->IsClusterCleanable(i))) {
-            Number++;
-            Sizemax = 0;
-            // Detect for each cluster,	the	biggest	connected component;
-            for (j = 0; j < Clusters[i]->GetNumberOfIds() / 2; j++) {
-                if (Sizemax < Clusters[i]->GetId(2 * j + 1)) {
-                    Sizemax = Clusters[i]->GetId(2 * j + 1);
-                    Imax = j;
-                }
+    struct Filling
+    {
+        Self* Clustering;
+        vtkUnionFind* Components;
+        std::atomic<int>* ClustersComponents;
+        vtkIdType* Offsets;
+        vtkIdType* Table;
+
+        void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+        {
+            int* Values = this->Clustering->Clustering->GetPointer(0);
+            int NullCluster = this->Clustering->NumberOfClusters;
+            for (vtkIdType Item = Begin; Item < End; Item++) {
+                int Cluster = Values[Item];
+                if ((Cluster < 0) || (Cluster >= NullCluster) ||
+                    (this->Offsets[Cluster] == this->Offsets[Cluster + 1]) ||
+                    (this->Components->Find(Item) != Item))
+                    continue;
+                int Position = this->ClustersComponents[Cluster].fetch_add(1);
+                this->Table[this->Offsets[Cluster] + Position] = Item;
             }
+        }
+    };
 
-            // Reset the smallest components to	-1
-            for (j = 0; j < Clusters[i]->GetNumberOfIds() / 2; j++) {
-                if (j != Imax) {
-                    while (Queue.empty() == 0)
-                        Queue.pop();
-                    Queue.push(Clusters[i]->GetId(2 * j));
-                    Type =
-                        this->Clustering->GetValue(Clusters[i]->GetId(2 * j));
-                    while (Queue.empty() == 0) {
-                        I1 = Queue.front();
-                        Queue.pop();
-                        if (Visited[I1] == 0) {
-                            Visited[I1] = 1;
-                            this->Clustering->SetValue(
-                                I1, this->NumberOfClusters);
-                            this->GetItemNeighbours(I1, IList);
-                            for (l = 0; l < IList->GetNumberOfIds(); l++) {
-                                I2 = IList->GetId(l);
-                                if (this->Clustering->GetValue(I2) == Type)
-                                    Queue.push(I2);
-                            }
-                        }
-                    }
-                }
-            }
-            Clusters[i]->Delete();
-        } else {
-            if (Clusters[i] != 0)
-                Clusters[i]->Delete();
+    Filling Fill;
+    Fill.Clustering = this;
+    Fill.Components = &Components;
+    Fill.ClustersComponents = ClustersComponents;
+    Fill.Offsets = Offsets.data();
+    Fill.Table = Table.data();
+    if (Table.size())
+        vtkParallelFor::Execute(NumberOfItems, Fill, this->NumberOfThreads);
+
+    // For each cluster with several components, keep only the biggest one.
+    // Components are sorted by root to get the same choice as a sequential
+    // traversal of the items
+    int Number = 0;
+    for (int i = 0; i < NumberOfClusters; i++) {
+        if ((Offsets[i] == Offsets[i + 1]) || !this->IsClusterCleanable(i))
+            continue;
+        Number++;
+        std::sort(Table.begin() + Offsets[i], Table.begin() + Offsets[i + 1]);
+
+        vtkIdType Biggest = Table[Offsets[i]];
+        for (vtkIdType j = Offsets[i] + 1; j < Offsets[i + 1]; j++) {
+            if (ComponentsSizes[Table[j]] > ComponentsSizes[Biggest])
+                Biggest = Table[j];
+        }
+
+        for (vtkIdType j = Offsets[i]; j < Offsets[i + 1]; j++) {
+            if (Table[j] != Biggest)
+                ComponentsSizes[Table[j]] = -1;
         }
     }
 
-    delete[] Clusters;
-    delete[] Visited;
-    delete[] VisitedCluster;
-    delete[] Sizes;
-    IList->Delete();
+    // Reset the smallest components to NULLCLUSTER
+    struct Resetting
+    {
+        Self* Clustering;
+        vtkUnionFind* Components;
+        std::atomic<int>* ComponentsSizes;
+
+        void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+        {
+            int* Values = this->Clustering->Clustering->GetPointer(0);
+            int NullCluster = this->Clustering->NumberOfClusters;
+            for (vtkIdType Item = Begin; Item < End; Item++) {
+                int Cluster = Values[Item];
+                if ((Cluster < 0) || (Cluster >= NullCluster))
+                    continue;
+                if (this->ComponentsSizes[this->Components->Find(Item)] < 0)
+                    Values[Item] = NullCluster;
+            }
+        }
+    };
+
+    Resetting Reset;
+    Reset.Clustering = this;
+    Reset.Components = &Components;
+    Reset.ComponentsSizes = ComponentsSizes;
+    if (Number)
+        vtkParallelFor::Execute(NumberOfItems, Reset, this->NumberOfThreads);
 
+    delete[] ComponentsSizes;
+    delete[] ClustersComponents;
     return (Number);
 }
 
-template <class Metric, class EdgeType>
-void vtkUniformClustering<Metric, EdgeType>::FillHolesInClustering(
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::FillHolesInClustering(
     vtkIntArray* Clustering)
 {
-    std::queue<int> IQueue;
-    vtkIdType i;
-    int Cluster1, Cluster2;
-    vtkIdType I1, I2;
-    int Edge;
-    int TempValue;
-    int InitialNumberOfProblems = 0, NumberOfProblems;
-
-    for (i = 0; i < this->GetNumberOfItems(); i++) {
-        Cluster1 = Clustering->GetValue(i);
-        if ((Cluster1 < 0) || (Cluster1 >= this->NumberOfClusters))
-            InitialNumberOfProblems++;
-    }
+    typedef vtkUniformClustering<Metric, EdgeType, Derived> Self;
+    vtkIdType NumberOfItems = this->GetNumberOfItems();
+
+    // A hole item belongs to the NULL cluster. At each iteration, the hole
+    // items adjacent to a valid cluster (the front) take the cluster of
+    // their first valid neighbour, unless leaving the NULL cluster breaks
+    // the connexity constraint, and their hole neighbours form the next
+    // front. The neighbour clusters are searched in parallel, but the labels
+    // are checked and written one item at a time, in Id order, as the check
+    // depends on the labels of the ring. An item rejected by the check
+    // enters a later front again when one of its neighbours is labelled. The
+    // result does not depend on the number of threads
+    struct Propagation
+    {
+        Self* Clustering;
+        int* Values;
+        int NullCluster;
 
-    for (i = 0; i < this->GetNumberOfEdges(); i++) {
-        this->GetEdgeItems(i, I1, I2);
-        if ((I2 >= 0) && (I1 >= 0)) {
-            Cluster1 = Clustering->GetValue(I1);
-            Cluster2 = Clustering->GetValue(I2);
-            if ((Cluster1 < 0) || (Cluster1 >= this->NumberOfClusters)) {
-                if ((Cluster2 >= 0) && (Cluster2 < this->NumberOfClusters))
-                    IQueue.push(i);
-            } else {
-                if ((Cluster2 < 0) || (Cluster2 >= this->NumberOfClusters))
-                    IQueue.push(i);
+        // 1 for the items of the next front
+        unsigned char* InFront;
+
+        // the current front, its candidate labels and the edges joining the
+        // front items to their labelled neighbours
+        vtkIdType* Front;
+        int* Labels;
+        EdgeType* Edges;
+
+        // 0 : count problems and detect the first front
+        // 1 : search the candidate labels of the front items
+        int Step;
+
+        // items found by each chunk
+        std::vector<vtkIdType>* ChunksItems;
+
+        // number of items without valid cluster, for each chunk
+        vtkIdType* ChunksProblems;
+
+        bool IsValid(int Cluster)
+        {
+            return ((Cluster >= 0) && (Cluster < this->NullCluster));
+        }
+
+        // returns the cluster of the other item of Edge, or NullCluster
+        int GetEdgeCluster(vtkIdType Item, EdgeType Edge)
+        {
+            vtkIdType I1, I2;
+            this->Clustering->GetEdgeItems(Edge, I1, I2);
+            if ((I1 < 0) || (I2 < 0))
+                return (this->NullCluster);
+            int Cluster = this->Values[I1 == Item ? I2 : I1];
+            return (this->IsValid(Cluster) ? Cluster : this->NullCluster);
+        }
+
+        void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+        {
+            vtkIdList* IList = vtkIdList::New();
+            std::vector<vtkIdType>& Items = this->ChunksItems[Chunk];
+            Items.clear();
+
+            for (vtkIdType i = Begin; i < End; i++) {
+                if (this->Step == 0) {
+                    this->InFront[i] = 0;
+                    if (!this->IsValid(this->Values[i]))
+                        this->ChunksProblems[Chunk]++;
+                    if (this->Values[i] == this->NullCluster) {
+                        this->Clustering->GetItemNeighbours(i, IList);
+                        for (vtkIdType j = 0; j < IList->GetNumberOfIds();
+                             j++) {
+                            if (this->IsValid(
+                                    this->Values[IList->GetId(j)])) {
+                                this->InFront[i] = 1;
+                                Items.push_back(i);
+                                break;
+                            }
+                        }
+                    }
+                } else {
+                    vtkIdType Item = this->Front[i];
+                    this->Clustering->GetItemEdges(Item, IList);
+                    this->Labels[i] = this->NullCluster;
+                    for (vtkIdType j = 0; j < IList->GetNumberOfIds();
+                         j++) {
+                        this->Edges[i] = IList->GetId(j);
+                        this->Labels[i] =
+                            this->GetEdgeCluster(Item, this->Edges[i]);
+                        if (this->IsValid(this->Labels[i]))
+                            break;
+                    }
+                }
             }
+            IList->Delete();
         }
+    };
+
+    unsigned char* InFront = new unsigned char[NumberOfItems];
+    std::vector<std::vector<vtkIdType>> ChunksItems(
+        vtkParallelFor::GetNumberOfChunks(
+            NumberOfItems, this->NumberOfThreads));
+    std::vector<vtkIdType> ChunksProblems(ChunksItems.size(), 0);
+    std::vector<vtkIdType> Front, NextFront;
+    std::vector<int> Labels;
+    std::vector<EdgeType> Edges;
+
+    Propagation Propagate;
+    Propagate.Clustering = this;
+    Propagate.Values = Clustering->GetPointer(0);
+    Propagate.NullCluster = this->NumberOfClusters;
+    Propagate.InFront = InFront;
+    Propagate.ChunksItems = ChunksItems.data();
+    Propagate.ChunksProblems = ChunksProblems.data();
+
+    Propagate.Step = 0;
+    vtkParallelFor::Execute(NumberOfItems, Propagate, this->NumberOfThreads);
+
+    vtkIdType InitialNumberOfProblems = 0;
+    for (size_t Chunk = 0; Chunk < ChunksProblems.size(); Chunk++) {
+        InitialNumberOfProblems += ChunksProblems[Chunk];
+        NextFront.insert(
+            NextFront.end(), ChunksItems[Chunk].begin(),
+            ChunksItems[Chunk].end());
     }
+    vtkIdType NumberOfProblems = InitialNumberOfProblems;
 
+    vtkIdList* IList = vtkIdList::New();
     vtkIdList* EList = vtkIdList::New();
-
-    while (IQueue.size() != 0) {
-        Edge = IQueue.front();
-        IQueue.pop();
-        this->GetEdgeItems(Edge, I1, I2);
-        if ((I1 >= 0) && (I2 >= 0)) {
-            Cluster1 = Clustering->GetValue(I1);
-            Cluster2 = Clustering->GetValue(I2);
-
-            if (Cluster1 == this->NumberOfClusters) {
-                TempValue = I1;
-                I1 = I2;
-                I2 = TempValue;
-                Cluster1 = Cluster2;
-                Cluster2 = this->NumberOfClusters;
+    while (NextFront.size()) {
+        Front.swap(NextFront);
+        NextFront.clear();
+        std::sort(Front.begin(), Front.end());
+        vtkIdType FrontSize = Front.size();
+        Labels.resize(FrontSize);
+        Edges.resize(FrontSize);
+
+        Propagate.Front = Front.data();
+        Propagate.Labels = Labels.data();
+        Propagate.Edges = Edges.data();
+        Propagate.Step = 1;
+        vtkParallelFor::Execute(FrontSize, Propagate, this->NumberOfThreads);
+
+        for (vtkIdType i = 0; i < FrontSize; i++) {
+            vtkIdType Item = Front[i];
+            InFront[Item] = 0;
+
+            // the first candidate was found before the labels of this front
+            // were written. When it breaks the constraint, the other
+            // neighbours are tried with the current labels
+            int Label = Labels[i];
+            EdgeType Edge = Edges[i];
+            if (Propagate.IsValid(Label) &&
+                this->ConnexityConstraintProblem(
+                    Item, Edge, Propagate.NullCluster, Label)) {
+                this->GetItemEdges(Item, EList);
+                Label = Propagate.NullCluster;
+                for (vtkIdType j = 0; j < EList->GetNumberOfIds(); j++) {
+                    Edge = EList->GetId(j);
+                    int Cluster = Propagate.GetEdgeCluster(Item, Edge);
+                    if (Propagate.IsValid(Cluster) &&
+                        !this->ConnexityConstraintProblem(
+                            Item, Edge, Propagate.NullCluster, Cluster)) {
+                        Label = Cluster;
+                        break;
+                    }
+                }
             }
-
-            if ((Cluster1 != this->NumberOfClusters) &&
-                (Cluster2 == this->NumberOfClusters) &&
-                (this->ConnexityConstraintProblem(
-                     I2, Edge, Cluster2, Cluster1) == 0)) {
-                Clustering->SetValue(I2, Cluster1);
-                this->GetItemEdges(I2, EList);
-                int j;
-                for (j = 0; j < EList->GetNumberOfIds(); j++) {
-                    IQueue.push(EList->GetId(j));
+            if (!Propagate.IsValid(Label))
+                continue;
+
+            Propagate.Values[Item] = Label;
+            NumberOfProblems--;
+            this->GetItemNeighbours(Item, IList);
+            for (vtkIdType j = 0; j < IList->GetNumberOfIds(); j++) {
+                vtkIdType Neighbour = IList->GetId(j);
+                if ((Propagate.Values[Neighbour] == Propagate.NullCluster) &&
+                    !InFront[Neighbour]) {
+                    InFront[Neighbour] = 1;
+                    NextFront.push_back(Neighbour);
                 }
             }
         }
     }
-
+    IList->Delete();
     EList->Delete();
-    EList = 0;
-    NumberOfProblems = 0;
-
-    for (i = 0; i < this->GetNumberOfItems(); i++) {
-        Cluster1 = Clustering->GetValue(i);
-        if ((Cluster1 < 0) || (Cluster1 >= this->NumberOfClusters))
-            NumberOfProblems++;
-    }
+    delete[] InFront;
 
     if ((this->ConsoleOutput > 0) && (NumberOfProblems > 0))
         cout << endl
@@ -618,14 +1136,13 @@ void vtkUniformClustering<Metric, EdgeType>::FillHolesInClustering(
              << " Problems" << endl;
 }
 
-template <class Metric, class EdgeType>
-void vtkUniformClustering<Metric, EdgeType>::FillQueuesFromClustering()
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::FillQueuesFromClustering()
 {
     vtkIdType Cluster1, Cluster2;
     vtkIdType I1, I2;
 
-    while (this->EdgeQueue.size())
-        this->EdgeQueue.pop();
+    this->Frontier.Clear();
 
     for (int i = 0; i < this->GetNumberOfEdges(); i++) {
         this->GetEdgeItems(i, I1, I2);
@@ -633,14 +1150,13 @@ void vtkUniformClustering<Metric, EdgeType>::FillQueuesFromClustering()
             Cluster1 = this->Clustering->GetValue(I1);
             Cluster2 = this->Clustering->GetValue(I2);
             if (Cluster1 != Cluster2)
-                this->EdgeQueue.push(i);
+                this->Frontier.Push(i);
         }
     }
-    this->EdgeQueue.push(-1);
 }
 
-template <class Metric, class EdgeType>
-vtkIntArray* vtkUniformClustering<Metric, EdgeType>::ProcessClustering(
+template <class Metric, class EdgeType, class Derived>
+vtkIntArray* vtkUniformClustering<Metric, EdgeType, Derived>::ProcessClustering(
     vtkIdList* List)
 {
     vtkTimerLog* Timer = vtkTimerLog::New();
@@ -651,21 +1167,42 @@ vtkIntArray* vtkUniformClustering<Metric, EdgeType>::ProcessClustering(
     }
 
     this->Init();
-    this->InitSamples(List);
+    this->NumberOfConvergences = 0;
+    this->BudgetExhausted = 0;
+    this->EnergyGap = -1;
+    this->Resumed = 0;
+    if (this->ResumeFromCheckpoint && !this->CheckpointFile.empty())
+        this->Resumed = this->LoadCheckpoint();
+
+    if (!this->Resumed) {
+        this->StartStage("initialization");
+        this->InitSamples(List);
+        this->StopStage();
+    } else if (this->ConsoleOutput)
+        cout << "Resuming from " << this->CheckpointFile << " at loop "
+             << this->NumberOfLoops << endl;
 
     if (this->ConsoleOutput)
         cout << "Clustering......" << endl;
 
     if (this->UnconstrainedInitializationFlag) {
-        if (this->ConsoleOutput)
-            cout << "Performing unconstrained initialization" << endl;
-        this->MetricContext.SetConstrainedClustering(0);
+        if (this->NumberOfConvergences == 0) {
+            if (this->ConsoleOutput)
+                cout << "Performing unconstrained initialization" << endl;
+            this->MetricContext.SetConstrainedClustering(0);
+        } else
+            this->MetricContext.SetConstrainedClustering(1);
     }
 
     this->StartTime = Timer->GetUniversalTime();
+    this->LastCheckpointTime = this->StartTime;
     Timer->StartTimer();
-    this->NumberOfConvergences = 0;
+    this->CheckpointsActive = 1;
+    this->StartStage("minimization");
     this->MinimizeEnergy();
+    this->StopStage();
+    this->CheckpointsActive = 0;
+    this->Checkpoint.Wait();
     Timer->StopTimer();
 
     if (this->ConsoleOutput != 0) {
@@ -678,31 +1215,192 @@ vtkIntArray* vtkUniformClustering<Metric, EdgeType>::ProcessClustering(
     return (this->Clustering);
 }
 
-template <class Metric, class EdgeType>
-void vtkUniformClustering<Metric, EdgeType>::SetAllClustersToModified()
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::SetAllClustersToModified()
 {
     for (int i = 0; i < this->NumberOfClusters; i++)
         this->ClustersLastModification[i] = this->NumberOfLoops;
 }
 
-template <class Metric, class EdgeType>
-void vtkUniformClustering<Metric, EdgeType>::MinimizeEnergy()
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::GetCheckpointSignature(
+    std::vector<vtkTypeInt64>& Signature)
+{
+    Signature.push_back(this->GetNumberOfItems());
+    Signature.push_back(this->GetNumberOfEdges());
+    Signature.push_back(this->NumberOfClusters);
+    Signature.push_back(this->NumberOfSpareClusters);
+    Signature.push_back(sizeof(EdgeType));
+    Signature.push_back(sizeof(typename Metric::Cluster));
+}
+
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::SaveCheckpoint()
+{
+    if (this->CheckpointFile.empty() || !this->CheckpointsActive)
+        return;
+
+    // never wait for the disk : skip this checkpoint if the previous one is
+    // still being written
+    double Time = vtkTimerLog::GetUniversalTime();
+    if ((Time - this->LastCheckpointTime < this->CheckpointInterval) ||
+        this->Checkpoint.IsWriting())
+        return;
+    this->LastCheckpointTime = Time;
+
+    vtkClusteringCheckpoint& Buffer = this->Checkpoint;
+    Buffer.Clear();
+    Buffer.Write("ACVDCKPT", 8);
+    Buffer.Write((vtkTypeInt32)1);
+
+    std::vector<vtkTypeInt64> Signature;
+    this->GetCheckpointSignature(Signature);
+    Buffer.Write((vtkTypeInt64)Signature.size());
+    Buffer.Write(Signature.data(), Signature.size());
+
+    Buffer.Write((vtkTypeInt32)this->NumberOfLoops);
+    Buffer.Write((vtkTypeInt32)this->NumberOfConvergences);
+    Buffer.Write((vtkTypeInt32)this->ConnexityConstraint);
+
+    int NumberOfClusters = this->NumberOfClusters;
+    Buffer.Write(this->Clustering->GetPointer(0), this->GetNumberOfItems());
+    Buffer.Write(this->ClustersSizes->GetPointer(0), NumberOfClusters);
+    Buffer.Write(this->ClustersLastModification, NumberOfClusters);
+    for (int i = 0; i < NumberOfClusters; i++)
+        Buffer.Write((char)this->IsClusterFreezed->GetValue(i));
+    Buffer.Write(this->Clusters, NumberOfClusters);
+
+    // the edges to process during the next loop
+    std::vector<EdgeType> Edges;
+    this->Frontier.GetPushedEdges(Edges);
+    Buffer.Write((vtkTypeInt64)Edges.size());
+    Buffer.Write(Edges.data(), Edges.size());
+
+    Buffer.WriteInBackground(this->CheckpointFile.c_str());
+}
+
+template <class Metric, class EdgeType, class Derived>
+int vtkUniformClustering<Metric, EdgeType, Derived>::LoadCheckpoint()
+{
+    vtkClusteringCheckpoint& Buffer = this->Checkpoint;
+    Buffer.Wait();
+    if (!Buffer.ReadFile(this->CheckpointFile.c_str()))
+        return (0);
+
+    char Magic[8];
+    vtkTypeInt32 Version;
+    vtkTypeInt64 SignatureSize;
+    std::vector<vtkTypeInt64> Signature, FileSignature;
+    this->GetCheckpointSignature(Signature);
+    if (!Buffer.Read(Magic, 8) || strncmp(Magic, "ACVDCKPT", 8) ||
+        !Buffer.Read(Version) || (Version != 1) ||
+        !Buffer.Read(SignatureSize) ||
+        (SignatureSize != (vtkTypeInt64)Signature.size())) {
+        cout << this->CheckpointFile << " is not a valid checkpoint" << endl;
+        return (0);
+    }
+
+    FileSignature.resize(SignatureSize);
+    if (!Buffer.Read(FileSignature.data(), SignatureSize) ||
+        (FileSignature != Signature)) {
+        cout << this->CheckpointFile
+             << " does not match the current input, ignoring it" << endl;
+        return (0);
+    }
+
+    vtkTypeInt32 NumberOfLoops, NumberOfConvergences, ConnexityConstraint;
+    int NumberOfClusters = this->NumberOfClusters;
+    std::vector<char> Freezed(NumberOfClusters);
+    std::vector<EdgeType> Edges;
+    vtkTypeInt64 NumberOfEdges;
+    bool Success = Buffer.Read(NumberOfLoops) &&
+        Buffer.Read(NumberOfConvergences) && Buffer.Read(ConnexityConstraint) &&
+        Buffer.Read(
+            this->Clustering->GetPointer(0), this->GetNumberOfItems()) &&
+        Buffer.Read(this->ClustersSizes->GetPointer(0), NumberOfClusters) &&
+        Buffer.Read(this->ClustersLastModification, NumberOfClusters) &&
+        Buffer.Read(Freezed.data(), NumberOfClusters) &&
+        Buffer.Read(this->Clusters, NumberOfClusters) &&
+        Buffer.Read(NumberOfEdges);
+    if (Success) {
+        Edges.resize(NumberOfEdges);
+        Success = Buffer.Read(Edges.data(), NumberOfEdges);
+    }
+    Buffer.Clear();
+
+    if (!Success) {
+        cout << this->CheckpointFile << " is truncated" << endl;
+        return (0);
+    }
+
+    this->NumberOfLoops = NumberOfLoops;
+    this->NumberOfConvergences = NumberOfConvergences;
+    this->ConnexityConstraint = ConnexityConstraint;
+    for (int i = 0; i < NumberOfClusters; i++)
+        this->IsClusterFreezed->SetValue(i, Freezed[i]);
+
+    // pushing all the edges to the first source gives the same order as the
+    // one of the interrupted run
+    this->Frontier.Clear();
+    for (size_t i = 0; i < Edges.size(); i++)
+        this->Frontier.Push(Edges[i]);
+
+    return (1);
+}
+
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::MinimizeEnergy()
 {
     int NumberOfModifications;
     int NumberOfDisconnectedClusters;
 
-    this->FillHolesInClustering(this->Clustering);
-    this->FillQueuesFromClustering();
-    this->ReComputeStatistics();
-    this->SetAllClustersToModified();
+    if (!this->Resumed) {
+        this->StartStage("statistics");
+        this->FillHolesInClustering(this->Clustering);
+        this->FillQueuesFromClustering();
+        this->ReComputeStatistics();
+        this->SetAllClustersToModified();
+        this->StopStage();
+    }
+    this->Resumed = 0;
+    this->NumberOfEnergySamples = 0;
     vtkTimerLog* Timer = vtkTimerLog::New();
 
     while (1) {
+        this->SaveCheckpoint();
+        this->StartStage("loop");
         Timer->StartTimer();
         this->SwapQueues();
+        this->NumberOfSkippedEdges = 0;
+        this->NumberOfConnexityRejects = 0;
         NumberOfModifications = this->ProcessOneLoop();
         Timer->StopTimer();
 
+        // the global energy is computed at most once per loop, and only
+        // every few loops for the report and for the budget
+        bool ReportEnergy = this->Report &&
+            (this->ReportEnergyInterval > 0) &&
+            (this->NumberOfLoops % this->ReportEnergyInterval == 0);
+        bool SampleEnergy = NumberOfModifications &&
+            (this->MinimumEnergyImprovement > 0) &&
+            (this->NumberOfLoops % this->BudgetEnergyInterval == 0);
+        long double Energy = 0;
+        if (ReportEnergy || SampleEnergy)
+            Energy = this->ComputeGlobalEnergy(true);
+
+        if (this->Report) {
+            this->SetStageCounter("loop", this->NumberOfLoops);
+            this->SetStageCounter("modifications", NumberOfModifications);
+            this->SetStageCounter(
+                "popped_edges", this->Frontier.GetNumberOfPoppedEdges());
+            this->SetStageCounter("skipped_edges", this->NumberOfSkippedEdges);
+            this->SetStageCounter(
+                "connexity_rejects", this->NumberOfConnexityRejects);
+            if (ReportEnergy)
+                this->SetStageCounter("energy", (double)Energy);
+            this->StopStage();
+        }
+
         if (this->ConsoleOutput > 1) {
             cout << (char)13;
             if (this->ConnexityConstraint == 1)
@@ -714,13 +1412,12 @@ void vtkUniformClustering<Metric, EdgeType>::MinimizeEnergy()
                  << std::flush;
         }
         this->NumberOfLoops++;
-        if (this->RelativeNumberOfLoops == 255) {
-            //	reset the EdgesLastLoop array to cope with overflow
-            for (int i = 0; i < this->GetNumberOfEdges(); i++)
-                this->EdgesLastLoop[i] = 0;
-            this->RelativeNumberOfLoops = 1;
-        } else
-            this->RelativeNumberOfLoops++;
+
+        if (NumberOfModifications &&
+            this->IsBudgetExhausted(SampleEnergy, Energy)) {
+            this->StopMinimization();
+            break;
+        }
 
         if ((NumberOfModifications == 0) ||
             (this->NumberOfLoops > this->MaxNumberOfLoops) ||
@@ -737,10 +1434,15 @@ void vtkUniformClustering<Metric, EdgeType>::MinimizeEnergy()
             }
             this->ConnexityConstraint = 1;
             NumberOfConvergences++;
+            this->NumberOfEnergySamples = 0;
 
+            this->StartStage("cleanup");
             NumberOfDisconnectedClusters = this->CleanClustering();
             this->FillHolesInClustering(this->Clustering);
             this->ReComputeClustersSize();
+            this->SetStageCounter(
+                "disconnected_clusters", NumberOfDisconnectedClusters);
+            this->StopStage();
 
             if (this->ConsoleOutput)
                 cout << endl
@@ -772,11 +1474,95 @@ void vtkUniformClustering<Metric, EdgeType>::MinimizeEnergy()
             this->SetAllClustersToModified();
         }
     }
+    if (!this->BudgetExhausted)
+        this->FinalEnergy = (double)this->ComputeGlobalEnergy(true);
     Timer->Delete();
 }
 
-template <class Metric, class EdgeType>
-int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoop()
+template <class Metric, class EdgeType, class Derived>
+int vtkUniformClustering<Metric, EdgeType, Derived>::IsBudgetExhausted(
+    bool SampleEnergy, long double Energy)
+{
+    long double Improvement = 1;
+    if (SampleEnergy) {
+        if (this->NumberOfEnergySamples > 0) {
+            long double Decrease = this->LastEnergy - Energy;
+            this->LastDecreases[0] = this->LastDecreases[1];
+            this->LastDecreases[1] = Decrease;
+            if (this->LastEnergy != 0)
+                Improvement = Decrease / std::fabs(this->LastEnergy) /
+                    (this->NumberOfLoops - this->LastEnergyLoop);
+        }
+        this->LastEnergy = Energy;
+        this->LastEnergyLoop = this->NumberOfLoops;
+        this->NumberOfEnergySamples++;
+    }
+
+    if ((this->MaximumTime > 0) &&
+        (vtkTimerLog::GetUniversalTime() - this->StartTime >
+         this->MaximumTime)) {
+        if (this->ConsoleOutput)
+            cout << endl << "Time budget exhausted" << endl;
+        return (1);
+    }
+
+    if (SampleEnergy && (this->NumberOfEnergySamples > 1) &&
+        (Improvement < this->MinimumEnergyImprovement)) {
+        if (this->ConsoleOutput)
+            cout << endl
+                 << "Energy improvement " << (double)Improvement
+                 << " below threshold" << endl;
+        return (1);
+    }
+    return (0);
+}
+
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::StopMinimization()
+{
+    this->BudgetExhausted = 1;
+    if (this->UnconstrainedInitializationFlag &&
+        (this->NumberOfConvergences == 0))
+        this->MetricContext.SetConstrainedClustering(1);
+
+    // keep only connected clusters, as after a convergence
+    this->ConnexityConstraint = 1;
+    this->StartStage("cleanup");
+    int NumberOfDisconnectedClusters = this->CleanClustering();
+    this->FillHolesInClustering(this->Clustering);
+    this->ReComputeClustersSize();
+    this->ReComputeStatistics();
+    this->SetStageCounter(
+        "disconnected_clusters", NumberOfDisconnectedClusters);
+    this->StopStage();
+    this->FinalEnergy = (double)this->ComputeGlobalEnergy();
+
+    // extrapolate the remaining decrease assuming the energy decreases
+    // geometrically, as observed during the last loops
+    this->EnergyGap = -1;
+    if ((this->NumberOfEnergySamples > 2) && (this->LastDecreases[0] > 0) &&
+        (this->LastDecreases[1] >= 0)) {
+        long double Ratio = this->LastDecreases[1] / this->LastDecreases[0];
+        if (Ratio < 1)
+            this->EnergyGap =
+                (double)(this->LastDecreases[1] * Ratio / (1 - Ratio));
+    }
+
+    if (this->ConsoleOutput) {
+        cout << "Minimization stopped after " << this->NumberOfLoops
+             << " loops, " << NumberOfDisconnectedClusters
+             << " disconnected classes cleaned" << endl;
+        cout << "Final energy : " << this->FinalEnergy
+             << ", estimated energy gap : ";
+        if (this->EnergyGap < 0)
+            cout << "unknown" << endl;
+        else
+            cout << this->EnergyGap << endl;
+    }
+}
+
+template <class Metric, class EdgeType, class Derived>
+int vtkUniformClustering<Metric, EdgeType, Derived>::ProcessOneLoop()
 {
     if (this->MinimizeUsingEnergy)
         return (this->ProcessOneLoopWithDistances());
@@ -799,19 +1585,15 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoop()
     volatile double Try11, Try12, Try21, Try22, Try31, Try32;
 
     int NumberOfModifications = 0;
-    while (1) {
-        Edge = this->EdgeQueue.front();
-        this->EdgeQueue.pop();
-
-        if (Edge == -1)
-            break;
-
-        this->GetEdgeItems(Edge, I1, I2);
+    vtkIdType NumberOfSkippedEdges = 0;
+    vtkIdType NumberOfConnexityRejects = 0;
+    // the frontier contains no duplicates, so each edge is visited once
+    const EdgeType* End = this->Frontier.End();
+    for (const EdgeType* It = this->Frontier.Begin(); It != End; It++) {
+        Edge = *It;
+        this->DispatchGetEdgeItems(Edge, I1, I2);
 
-        // Check if	this edge was not already visited.
-        if ((this->EdgesLastLoop[Edge] != this->RelativeNumberOfLoops) &&
-            (I2 >= 0)) {
-            this->EdgesLastLoop[Edge] = this->RelativeNumberOfLoops;
+        if (I2 >= 0) {
             {
                 Val1 = this->Clustering->GetValue(I1);
                 Val2 = this->Clustering->GetValue(I2);
@@ -827,7 +1609,7 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoop()
                         this->MetricContext.ComputeClusterEnergy(
                             this->Clusters + Val2);
                         (*this->ClustersSizes->GetPointer(Val2))++;
-                        this->AddItemRingToProcess(I1);
+                        this->DispatchAddItemRingToProcess(I1);
                         NumberOfModifications++;
                         this->Clustering->SetValue(I1, Val2);
                         this->ClustersLastModification[Val2] =
@@ -842,7 +1624,7 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoop()
                         this->MetricContext.ComputeClusterEnergy(
                             this->Clusters + Val1);
                         (*this->ClustersSizes->GetPointer(Val1))++;
-                        this->AddItemRingToProcess(I2);
+                        this->DispatchAddItemRingToProcess(I2);
                         NumberOfModifications++;
                         this->Clustering->SetValue(I2, Val1);
                         this->ClustersLastModification[Val1] =
@@ -873,10 +1655,12 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoop()
 
                         // Compute the energy when setting I1 to the same
                         // cluster as I2;
-                        if ((*Size1 == 1) || (this->ConnexityConstraintProblem(
-                                                  I1, Edge, Val1, Val2) == 1))
+                        if ((*Size1 == 1) ||
+                            (this->DispatchConnexityConstraintProblem(
+                                 I1, Edge, Val1, Val2) == 1)) {
                             Try2 = 100000000.0;
-                        else {
+                            NumberOfConnexityRejects++;
+                        } else {
                             this->MetricContext.Sub(Cluster1, I1, Cluster21);
                             this->MetricContext.Add(Cluster2, I1, Cluster22);
                             this->MetricContext.ComputeClusterCentroid(
@@ -894,10 +1678,12 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoop()
 
                         // Compute the energy when setting I2 to the same
                         // cluster as I1;
-                        if ((*Size2 == 1) || (this->ConnexityConstraintProblem(
-                                                  I2, Edge, Val2, Val1) == 1))
+                        if ((*Size2 == 1) ||
+                            (this->DispatchConnexityConstraintProblem(
+                                 I2, Edge, Val2, Val1) == 1)) {
                             Try3 = 1000000000.0;
-                        else {
+                            NumberOfConnexityRejects++;
+                        } else {
                             this->MetricContext.Sub(Cluster2, I2, Cluster32);
                             this->MetricContext.Add(Cluster1, I2, Cluster31);
                             this->MetricContext.ComputeClusterCentroid(
@@ -923,7 +1709,7 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoop()
                         switch (Result) {
                             case (1):
                                 // Don't	do anything!
-                                this->EdgeQueue.push(Edge);
+                                this->Frontier.Push(Edge);
                                 break;
 
                             case (2):
@@ -935,7 +1721,7 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoop()
                                     Cluster21, Cluster1);
                                 this->MetricContext.DeepCopy(
                                     Cluster22, Cluster2);
-                                this->AddItemRingToProcess(I1);
+                                this->DispatchAddItemRingToProcess(I1);
                                 NumberOfModifications++;
                                 this->ClustersLastModification[Val1] =
                                     this->NumberOfLoops;
@@ -952,7 +1738,7 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoop()
                                     Cluster31, Cluster1);
                                 this->MetricContext.DeepCopy(
                                     Cluster32, Cluster2);
-                                this->AddItemRingToProcess(I2);
+                                this->DispatchAddItemRingToProcess(I2);
                                 NumberOfModifications++;
                                 this->ClustersLastModification[Val1] =
                                     this->NumberOfLoops;
@@ -962,22 +1748,25 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoop()
                         }
                     } else {
                         // Don't	do anything!
-                        this->EdgeQueue.push(Edge);
+                        this->Frontier.Push(Edge);
+                        NumberOfSkippedEdges++;
                     }
                 }
             }
         }
     }
-    this->EdgeQueue.push(-1);
     delete Cluster21;
     delete Cluster22;
     delete Cluster31;
     delete Cluster32;
+    this->NumberOfSkippedEdges += NumberOfSkippedEdges;
+    this->NumberOfConnexityRejects += NumberOfConnexityRejects;
     return (NumberOfModifications);
 }
 
-template <class Metric, class EdgeType>
-int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoopWithDistances()
+template <class Metric, class EdgeType, class Derived>
+int vtkUniformClustering<Metric, EdgeType, Derived>::
+    ProcessOneLoopWithDistances()
 {
     vtkIdType Edge, I1, I2;
     int Val1, Val2, *Size1, *Size2;
@@ -985,19 +1774,15 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoopWithDistances()
     typename Metric::Cluster *Cluster1, *Cluster2;
 
     int NumberOfModifications = 0;
-    while (1) {
-        Edge = this->EdgeQueue.front();
-        this->EdgeQueue.pop();
+    vtkIdType NumberOfSkippedEdges = 0;
+    vtkIdType NumberOfConnexityRejects = 0;
+    // the frontier contains no duplicates, so each edge is visited once
+    const EdgeType* End = this->Frontier.End();
+    for (const EdgeType* It = this->Frontier.Begin(); It != End; It++) {
+        Edge = *It;
+        this->DispatchGetEdgeItems(Edge, I1, I2);
 
-        if (Edge == -1)
-            break;
-
-        this->GetEdgeItems(Edge, I1, I2);
-
-        // Check if	this edge was not already visited.
-        if ((this->EdgesLastLoop[Edge] != this->RelativeNumberOfLoops) &&
-            (I2 >= 0)) {
-            this->EdgesLastLoop[Edge] = this->RelativeNumberOfLoops;
+        if (I2 >= 0) {
             {
                 Val1 = this->Clustering->GetValue(I1);
                 Val2 = this->Clustering->GetValue(I2);
@@ -1011,7 +1796,7 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoopWithDistances()
                         this->MetricContext.ComputeClusterCentroid(
                             this->Clusters + Val2);
                         (*this->ClustersSizes->GetPointer(Val2))++;
-                        this->AddItemRingToProcess(I1);
+                        this->DispatchAddItemRingToProcess(I1);
                         NumberOfModifications++;
                         this->Clustering->SetValue(I1, Val2);
                         this->ClustersLastModification[Val2] =
@@ -1025,7 +1810,7 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoopWithDistances()
                             this->MetricContext.ComputeClusterCentroid(
                                 this->Clusters + Val1);
                             (*this->ClustersSizes->GetPointer(Val1))++;
-                            this->AddItemRingToProcess(I2);
+                            this->DispatchAddItemRingToProcess(I2);
                             NumberOfModifications++;
                             this->Clustering->SetValue(I2, Val1);
                             this->ClustersLastModification[Val1] =
@@ -1062,7 +1847,7 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoopWithDistances()
                                 // Compute the energy when setting I1 to the
                                 // same cluster as I2;
                                 if ((*Size1 != 1) &&
-                                    (this->ConnexityConstraintProblem(
+                                    (this->DispatchConnexityConstraintProblem(
                                          I1, Edge, Val1, Val2) == 0)) {
                                     //		this->MetricContext.GetItemCoordinates(I1,P);
                                     this->GetItemCoordinates(I1, P);
@@ -1078,16 +1863,17 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoopWithDistances()
                                         this->MetricContext
                                             .SubstractItemFromCluster(
                                                 I1, Cluster1);
-                                        this->AddItemRingToProcess(I1);
+                                        this->DispatchAddItemRingToProcess(I1);
                                         NumberOfModifications++;
                                         this->ClustersLastModification[Val1] =
                                             this->NumberOfLoops;
                                         this->ClustersLastModification[Val2] =
                                             this->NumberOfLoops;
                                     }
-                                }
+                                } else
+                                    NumberOfConnexityRejects++;
                                 if ((*Size2 != 1) &&
-                                    (this->ConnexityConstraintProblem(
+                                    (this->DispatchConnexityConstraintProblem(
                                          I2, Edge, Val2, Val1) == 0) &&
                                     (Result != 2)) {
                                     // Compute the energy when setting I2 to the
@@ -1106,19 +1892,21 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoopWithDistances()
                                         this->MetricContext
                                             .SubstractItemFromCluster(
                                                 I2, Cluster2);
-                                        this->AddItemRingToProcess(I2);
+                                        this->DispatchAddItemRingToProcess(I2);
                                         NumberOfModifications++;
                                         this->ClustersLastModification[Val1] =
                                             this->NumberOfLoops;
                                         this->ClustersLastModification[Val2] =
                                             this->NumberOfLoops;
                                     }
-                                }
+                                } else if (Result != 2)
+                                    NumberOfConnexityRejects++;
                                 if (Result == 1)
-                                    this->EdgeQueue.push(Edge);
+                                    this->Frontier.Push(Edge);
                             } else {
                                 // Don't	do anything!
-                                this->EdgeQueue.push(Edge);
+                                this->Frontier.Push(Edge);
+                                NumberOfSkippedEdges++;
                             }
                         }
                     }
@@ -1126,12 +1914,14 @@ int vtkUniformClustering<Metric, EdgeType>::ProcessOneLoopWithDistances()
             }
         }
     }
-    this->EdgeQueue.push(-1);
+    this->NumberOfSkippedEdges += NumberOfSkippedEdges;
+    this->NumberOfConnexityRejects += NumberOfConnexityRejects;
     return (NumberOfModifications);
 }
 
-template <class Metric, class EdgeType>
-void vtkUniformClustering<Metric, EdgeType>::InitSamples(vtkIdList* List)
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::InitSamples(
+    vtkIdList* List)
 {
     vtkMath* CRan = vtkMath::New();
     CRan->RandomSeed(5000);
@@ -1189,9 +1979,51 @@ void vtkUniformClustering<Metric, EdgeType>::InitSamples(vtkIdList* List)
     CRan->Delete();
 }
 
-template <class Metric, class EdgeType>
-void vtkUniformClustering<Metric, EdgeType>::ComputeInitialRandomSampling(
-    vtkIdList* List, vtkIntArray* Sampling, int NumberOfRegions)
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::ShuffleItems(
+    int* Items, int NumberOfItems, std::mt19937& Generator, int Stream)
+{
+    if (!this->Deterministic) {
+        std::shuffle(Items, Items + NumberOfItems, Generator);
+        return;
+    }
+
+    // std::shuffle differs between standard libraries : sort the items
+    // according to random keys. The key of an item only depends on its Id
+    // and on the stream, and two items never get the same key
+    struct Keying
+    {
+        int* Items;
+        int Seed;
+        std::pair<int, int>* Keys;
+
+        void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+        {
+            for (vtkIdType i = Begin; i < End; i++) {
+                int Item = this->Items[i];
+                this->Keys[i] = std::make_pair(
+                    vtkMyMinimalStandardRandomSequence::GetSeedAt(
+                        this->Seed, Item + 1),
+                    Item);
+            }
+        }
+    };
+
+    std::vector<std::pair<int, int>> Keys(NumberOfItems);
+    Keying Key;
+    Key.Items = Items;
+    Key.Seed = Stream + 1;
+    Key.Keys = Keys.data();
+    vtkParallelFor::Execute(NumberOfItems, Key, this->NumberOfThreads);
+    std::sort(Keys.begin(), Keys.end());
+    for (int i = 0; i < NumberOfItems; i++)
+        Items[i] = Keys[i].second;
+}
+
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::
+    ComputeInitialRandomSampling(
+        vtkIdList* List, vtkIntArray* Sampling, int NumberOfRegions)
 {
     for (int i = 0; i < this->GetNumberOfItems(); i++)
         Sampling->SetValue(i, this->NumberOfClusters);
@@ -1210,7 +2042,7 @@ void vtkUniformClustering<Metric, EdgeType>::ComputeInitialRandomSampling(
     for (int i = 0; i < NumberOfRemainingItems; i++) {
         Items[i] = i;
     }
-    std::shuffle(Items, Items + NumberOfRemainingItems, g);
+    this->ShuffleItems(Items, NumberOfRemainingItems, g, 0);
 
     // compute total weight
     double SWeights = 0;
@@ -1276,7 +2108,7 @@ void vtkUniformClustering<Metric, EdgeType>::ComputeInitialRandomSampling(
         Items[i] = i;
     }
 
-    std::shuffle(Items, Items + NumberOfItems, g);
+    this->ShuffleItems(Items, NumberOfItems, g, 1);
     FirstItem = 0;
     while (NumberOfRemainingRegions > 0) {
         Found = false;
@@ -1301,39 +2133,79 @@ void vtkUniformClustering<Metric, EdgeType>::ComputeInitialRandomSampling(
     }
 }
 
-template <class Metric, class EdgeType>
-long double vtkUniformClustering<Metric, EdgeType>::ComputeGlobalEnergy()
+template <class Metric, class EdgeType, class Derived>
+long double
+vtkUniformClustering<Metric, EdgeType, Derived>::ComputeGlobalEnergy(
+    bool UpToDate)
 {
-    // Global Energy is computed in two steps to improve precision
-    int i;
-    long double Energy = 0;
-    int NumberOfBins = (int)sqrt((double)this->NumberOfClusters);
-    int Bin = 0;
-    int BinCount = 0;
-    long double* Bins = new long double[NumberOfBins];
-
-    for (i = 0; i < NumberOfBins; i++)
-        Bins[i] = 0;
-
-    for (i = 0; i < this->NumberOfClusters; i++) {
-        Bins[Bin] += (long double)this->MetricContext.GetClusterEnergy(
-            this->Clusters + i);
-        BinCount++;
-        if (BinCount == NumberOfBins) {
-            if (Bin < NumberOfBins - 1)
-                Bin++;
+    typedef vtkUniformClustering<Metric, EdgeType, Derived> Self;
+
+    // The clusters are split into blocks of fixed size, whatever the number
+    // of threads. Each block is summed by the thread whose chunk contains
+    // its first cluster, and the partial sums are merged in the blocks
+    // order : the result only depends on the clusters energies
+    vtkIdType BlockSize = 256;
+    vtkIdType NumberOfClusters = this->NumberOfClusters;
+    vtkIdType NumberOfBlocks = (NumberOfClusters + BlockSize - 1) / BlockSize;
+
+    struct Summation
+    {
+        Self* Clustering;
+        bool UpToDate;
+        vtkIdType BlockSize;
+        long double* Sums;
+        long double* Compensations;
+
+        void operator()(vtkIdType Begin, vtkIdType End, int Chunk)
+        {
+            Metric& Context = this->Clustering->MetricContext;
+            vtkIdType NumberOfClusters = this->Clustering->NumberOfClusters;
+            vtkIdType Size = this->BlockSize;
+            for (vtkIdType Block = (Begin + Size - 1) / Size;
+                 Block * Size < End; Block++) {
+                vtkIdType Last = (Block + 1) * Size;
+                if (Last > NumberOfClusters)
+                    Last = NumberOfClusters;
+
+                long double Energy = 0;
+                long double Compensation = 0;
+                for (vtkIdType i = Block * Size; i < Last; i++) {
+                    typename Metric::Cluster Cluster =
+                        this->Clustering->Clusters[i];
+                    if (this->UpToDate &&
+                        (this->Clustering->ClustersSizes->GetValue(i) > 0))
+                        Context.ComputeClusterEnergy(&Cluster);
+                    Self::AddCompensated(
+                        Energy, Compensation,
+                        (long double)Context.GetClusterEnergy(&Cluster));
+                }
+                this->Sums[Block] = Energy;
+                this->Compensations[Block] = Compensation;
+            }
         }
-    }
+    };
 
-    for (i = 0; i < NumberOfBins; i++)
-        Energy += Bins[i];
+    std::vector<long double> Sums(NumberOfBlocks);
+    std::vector<long double> Compensations(NumberOfBlocks);
+    Summation Sum;
+    Sum.Clustering = this;
+    Sum.UpToDate = UpToDate;
+    Sum.BlockSize = BlockSize;
+    Sum.Sums = Sums.data();
+    Sum.Compensations = Compensations.data();
+    vtkParallelFor::Execute(NumberOfClusters, Sum, this->NumberOfThreads);
 
-    delete[] Bins;
-    return (Energy);
+    long double Energy = 0;
+    long double Compensation = 0;
+    for (vtkIdType Block = 0; Block < NumberOfBlocks; Block++) {
+        Self::AddCompensated(Energy, Compensation, Sums[Block]);
+        Compensation += Compensations[Block];
+    }
+    return (Energy + Compensation);
 }
 
-template <class Metric, class EdgeType>
-void vtkUniformClustering<Metric, EdgeType>::Allocate()
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::Allocate()
 {
     this->ClustersSizes = vtkIntArray::New();
     this->ClustersSizes->SetNumberOfValues(this->NumberOfClusters);
@@ -1343,40 +2215,34 @@ void vtkUniformClustering<Metric, EdgeType>::Allocate()
 
     this->ClustersLastModification = new int[this->NumberOfClusters];
 
-    this->EdgesLastLoop = new unsigned char[this->GetNumberOfEdges()];
+    this->Frontier.Allocate(this->GetNumberOfEdges());
 
     this->IsClusterFreezed = vtkBitArray::New();
     this->IsClusterFreezed->SetNumberOfValues(this->NumberOfClusters);
 }
 
-template <class Metric, class EdgeType>
-void vtkUniformClustering<Metric, EdgeType>::Init()
+template <class Metric, class EdgeType, class Derived>
+void vtkUniformClustering<Metric, EdgeType, Derived>::Init()
 {
     this->Allocate();
+    this->StartStage("metric build");
     this->BuildMetric();
+    this->StopStage();
 
     for (vtkIdType i = 0; i < this->NumberOfClusters; i++) {
         this->ClustersSizes->SetValue(i, 0);
         this->IsClusterFreezed->SetValue(i, 0);
     }
 
-    while (this->EdgeQueue.size())
-        this->EdgeQueue.pop();
-
-    for (vtkIdType i = 0; i < this->GetNumberOfEdges(); i++)
-        this->EdgesLastLoop[i] = 0;
-
-    this->RelativeNumberOfLoops = 1;
     this->NumberOfLoops = 0;
 }
 
-template <class Metric, class EdgeType>
-vtkUniformClustering<Metric, EdgeType>::vtkUniformClustering()
+template <class Metric, class EdgeType, class Derived>
+vtkUniformClustering<Metric, EdgeType, Derived>::vtkUniformClustering()
 {
     this->Clustering = 0;
     this->InitialClustering = 0;
     this->ClustersSizes = 0;
-    this->EdgesLastLoop = 0;
     this->ClustersLastModification = 0;
     this->ConsoleOutput = 0;
     this->MaxNumberOfConvergences = 1000000000;
@@ -1392,10 +2258,29 @@ vtkUniformClustering<Metric, EdgeType>::vtkUniformClustering()
     this->IsClusterFreezed = 0;
     this->MinNumberOfSpareClusters = 0;
     this->MinimizeUsingEnergy = false;
+    this->NumberOfThreads = 0;
+    this->Deterministic = 0;
+    this->CheckpointInterval = 60;
+    this->LastCheckpointTime = 0;
+    this->ResumeFromCheckpoint = 0;
+    this->Resumed = 0;
+    this->CheckpointsActive = 0;
+    this->MaximumTime = 0;
+    this->MinimumEnergyImprovement = 0;
+    this->BudgetEnergyInterval = 5;
+    this->BudgetExhausted = 0;
+    this->FinalEnergy = 0;
+    this->EnergyGap = -1;
+    this->LastEnergyLoop = 0;
+    this->NumberOfEnergySamples = 0;
+    this->Report = 0;
+    this->ReportEnergyInterval = 10;
+    this->NumberOfSkippedEdges = 0;
+    this->NumberOfConnexityRejects = 0;
 }
 
-template <class Metric, class EdgeType>
-vtkUniformClustering<Metric, EdgeType>::~vtkUniformClustering()
+template <class Metric, class EdgeType, class Derived>
+vtkUniformClustering<Metric, EdgeType, Derived>::~vtkUniformClustering()
 {
     if (this->Clustering)
         this->Clustering->Delete();
@@ -1409,15 +2294,9 @@ vtkUniformClustering<Metric, EdgeType>::~vtkUniformClustering()
     if (this->IsClusterFreezed)
         this->IsClusterFreezed->Delete();
 
-    if (this->EdgesLastLoop)
-        delete[] this->EdgesLastLoop;
-
     if (this->ClustersLastModification)
         delete[] this->ClustersLastModification;
 
-    while (this->EdgeQueue.size())
-        this->EdgeQueue.pop();
-
     if (this->Clusters)
         delete[] this->Clusters;
 
@@ -0,0 +1,123 @@
+/*=========================================================================
+
+  Program:   Concurrent union-find forest
+  Module:    vtkUnionFind.h
+  Language:  C++
+  Date:      2026/10
+
+=========================================================================*/
+
+/* ---------------------------------------------------------------------
+
+* Copyright (c) CREATIS-LRMN (Centre de Recherche en Imagerie Medicale)
+* Author : Sebastien Valette
+*
+*  This software is governed by the CeCILL-B license under French law and
+*  abiding by the rules of distribution of free software. You can  use,
+*  modify and/ or redistribute the software under the terms of the CeCILL-B
+*  license as circulated by CEA, CNRS and INRIA at the following URL
+*  http://www.cecill.info/licences/Licence_CeCILL-B_V1-en.html
+*  or in the file LICENSE.txt.
+*
+*  As a counterpart to the access to the source code and  rights to copy,
+*  modify and redistribute granted by the license, users are provided only
+*  with a limited warranty  and the software's author,  the holder of the
+*  economic rights,  and the successive licensors  have only  limited
+*  liability.
+*
+*  The fact that you are presently reading this means that you have had
+*  knowledge of the CeCILL-B license and that you accept its terms.
+* ------------------------------------------------------------------------ */
+
+#ifndef _VTKUNIONFIND_H_
+#define _VTKUNIONFIND_H_
+
+#include <atomic>
+
+#include <vtkType.h>
+
+/// A union-find (disjoint sets) forest over the Ids [0, Size). Union() and
+/// Find() can be called concurrently by several threads. A root is always
+/// linked below a smaller root, so that once all the unions are done, the
+/// root of each set is its smallest Id, whatever the order of the unions.
+class vtkUnionFind
+{
+public:
+    /// Allocates the forest and makes each Id a singleton
+    void Allocate(vtkIdType Size)
+    {
+        if (Size != this->Size) {
+            delete[] this->Parents;
+            this->Parents = new std::atomic<vtkIdType>[Size];
+            this->Size = Size;
+        }
+        this->Reset(0, Size);
+    }
+
+    /// Makes each Id in [Begin, End) a singleton. Can be used to initialize
+    /// the forest in parallel
+    void Reset(vtkIdType Begin, vtkIdType End)
+    {
+        for (vtkIdType Id = Begin; Id < End; Id++)
+            this->Parents[Id].store(Id, std::memory_order_relaxed);
+    }
+
+    /// Returns the root of the set containing Id
+    vtkIdType Find(vtkIdType Id)
+    {
+        while (true) {
+            vtkIdType Parent = this->Parents[Id].load();
+            if (Parent == Id)
+                return (Id);
+
+            // path halving : a parent is only replaced by one of its
+            // ancestors, which is safe under concurrent updates
+            vtkIdType GrandParent = this->Parents[Parent].load();
+            if (GrandParent != Parent)
+                this->Parents[Id].compare_exchange_weak(Parent, GrandParent);
+            Id = GrandParent;
+        }
+    }
+
+    /// Merges the sets containing Id1 and Id2
+    void Union(vtkIdType Id1, vtkIdType Id2)
+    {
+        while (true) {
+            Id1 = this->Find(Id1);
+            Id2 = this->Find(Id2);
+            if (Id1 == Id2)
+                return;
+            if (Id1 < Id2) {
+                vtkIdType Temp = Id1;
+                Id1 = Id2;
+                Id2 = Temp;
+            }
+
+            // link the biggest root below the smallest one, unless an other
+            // thread modified it in between
+            vtkIdType Expected = Id1;
+            if (this->Parents[Id1].compare_exchange_strong(Expected, Id2))
+                return;
+        }
+    }
+
+    /// Returns the number of Ids
+    vtkIdType GetSize() { return (this->Size); }
+
+    vtkUnionFind()
+    {
+        this->Parents = 0;
+        this->Size = 0;
+    }
+
+    ~vtkUnionFind() { delete[] this->Parents; }
+
+private:
+    std::atomic<vtkIdType>* Parents;
+    vtkIdType Size;
+
+    vtkUnionFind(const vtkUnionFind&);
+    void operator=(const vtkUnionFind&);
+};
+
+#endif
@@ -685,7 +685,8 @@ vtkPolyData* vtkCurvatureMeasure::GetPrincipalDirectionsPolyData()
     Lines->SetPoints(Points);
     Points->Delete();
 
-    vtkDoubleArray* EdgesLength = this->Input->GetEdgeLengths();
+    vtkDoubleArray* EdgesLength =
+        this->Input->GetEdgeLengths(this->NumberOfThreads);
 
     double AverageLength = 0;
     for (i = 0; i < this->Input->GetNumberOfEdges(); i++) {
@@ -83,6 +83,30 @@ void vtkMyMinimalStandardRandomSequence::Next()
     }
 }
 
+// ----------------------------------------------------------------------------
+void vtkMyMinimalStandardRandomSequence::Skip(vtkIdType Steps)
+{
+    this->Seed = GetSeedAt(this->Seed, Steps);
+}
+
+// ----------------------------------------------------------------------------
+int vtkMyMinimalStandardRandomSequence::GetSeedAt(int Seed, vtkIdType Steps)
+{
+    assert("pre: positive_steps" && Steps >= 0);
+
+    // Seed*A^Steps mod M, the power being computed by repeated squaring.
+    // All the products fit in 64 bits as the operands are below 2^31
+    vtkTypeUInt64 Result = Seed;
+    vtkTypeUInt64 Power = VTK_K_A;
+    while (Steps > 0) {
+        if (Steps & 1)
+            Result = (Result * Power) % VTK_K_M;
+        Power = (Power * Power) % VTK_K_M;
+        Steps >>= 1;
+    }
+    return static_cast<int>(Result);
+}
+
 // ----------------------------------------------------------------------------
 double vtkMyMinimalStandardRandomSequence::GetRangeValue(
     double rangeMin, double rangeMax)
@@ -46,6 +46,42 @@ vtkRandomTriangulation::~vtkRandomTriangulation() {}
 vtkSurface* vtkRandomTriangulation::BuildRandomTriangulation(
     int NumberOfPoints, int Type)
 {
+    if (Type == 8) {
+        // regular grid on a bumpy torus, slightly jittered so that the
+        // clustering does not meet exact ties. Each grid vertex gives two
+        // faces.
+        int NV = (int)sqrt(NumberOfPoints / 3.0);
+        if (NV < 3)
+            NV = 3;
+        int NU = NumberOfPoints / NV;
+        if (NU < 3)
+            NU = 3;
+
+        vtkSurface* Mesh = vtkSurface::New();
+        Mesh->Init(NU * NV, 2 * NU * NV, 3 * NU * NV);
+        vtkMath::RandomSeed(1000);
+        double TwoPi = 2 * vtkMath::Pi();
+        for (int i = 0; i < NU; i++) {
+            for (int j = 0; j < NV; j++) {
+                double U = TwoPi * (i + 0.25 * vtkMath::Random()) / NU;
+                double V = TwoPi * (j + 0.25 * vtkMath::Random()) / NV;
+                double R = 0.3 + 0.05 * sin(7 * U) * sin(5 * V);
+                Mesh->AddVertex(
+                    (1 + R * cos(V)) * cos(U), (1 + R * cos(V)) * sin(U),
+                    R * sin(V));
+            }
+        }
+        for (int i = 0; i < NU; i++) {
+            int i2 = (i + 1) % NU;
+            for (int j = 0; j < NV; j++) {
+                int j2 = (j + 1) % NV;
+                Mesh->AddFace(i * NV + j, i2 * NV + j, i2 * NV + j2);
+                Mesh->AddFace(i * NV + j, i2 * NV + j2, i * NV + j2);
+            }
+        }
+        return (Mesh);
+    }
+
     if (Type == 7) {
         vtkSurface* Mesh = vtkSurface::New();
         Mesh->AddVertex(0, 0, 0);
@@ -20,74 +20,94 @@
 *  knowledge of the CeCILL-B license and that you accept its terms.
 * ------------------------------------------------------------------------ */
 
+#include <algorithm>
 #include <sstream>
+#include <utility>
+#include <vector>
 #include <math.h>
 #include <vtkCellData.h>
-#include <vtkCleanPolyData.h>
-#include <vtkDelaunay3D.h>
 #include <vtkDoubleArray.h>
-#include <vtkEdgeTable.h>
 #include <vtkMath.h>
 #include <vtkObjectFactory.h>
-#include <vtkPriorityQueue.h>
 #include <vtkTriangle.h>
-#include <vtkUnstructuredGrid.h>
 
+#include "vtkFaceQuantities.h"
+#include "vtkParallelFor.h"
+#include "vtkSpaceFillingCurve.h"
+#include "vtkSpatialHash.h"
 #include "vtkSurface.h"
+#include "vtkUnionFind.h"
 #include "vtkVolumeProperties.h"
 
 vtkSurface* vtkSurface::GetBiggestConnectedComponent()
 {
-    vtkIdListCollection* Collection = this->GetConnectedComponents();
-
-    // get the biggest component vertices
-    vtkIdType Id;
-    int Max = 0;
-    for (int i = 0; i < Collection->GetNumberOfItems(); i++) {
-        int Size = Collection->GetItem(i)->GetNumberOfIds();
-        if (Size > Max) {
-            Max = Size;
-            Id = i;
-        }
+    vtkIdTypeArray* Labels = vtkIdTypeArray::New();
+    vtkIdTypeArray* Sizes = vtkIdTypeArray::New();
+    vtkIdType NumberOfComponents =
+        this->ComputeConnectedComponents(Labels, Sizes);
+
+    // get the biggest component
+    vtkIdType Biggest = 0;
+    for (vtkIdType i = 1; i < NumberOfComponents; i++) {
+        if (Sizes->GetValue(i) > Sizes->GetValue(Biggest))
+            Biggest = i;
     }
 
-    vtkIdList* List = Collection->GetItem(Id);
+    vtkSurface* NewMesh = this->ExtractConnectedComponent(Labels, Biggest);
+    Labels->Delete();
+    Sizes->Delete();
+    return (NewMesh);
+}
 
-    vtkIdType* Ids = new vtkIdType[this->GetNumberOfPoints()];
+vtkSurface* vtkSurface::ExtractConnectedComponent(
+    vtkIdTypeArray* Labels, vtkIdType Component)
+{
+    vtkIdType NumberOfPoints = this->GetNumberOfPoints();
+    vtkIdType NumberOfCells = this->GetNumberOfCells();
+    vtkIdType* Ids = new vtkIdType[NumberOfPoints];
+    vtkIdType NumberOfNewPoints = 0;
+    vtkIdType NumberOfNewCells = 0;
+    vtkIdType *pts, npts;
 
-    for (vtkIdType i = 0; i < this->GetNumberOfPoints(); i++)
-        Ids[i] = -1;
+    // faces are kept when their first vertex belongs to the component, as
+    // their other vertices are connected to it
+    for (vtkIdType i = 0; i < NumberOfPoints; i++) {
+        if (Labels->GetValue(i) == Component)
+            NumberOfNewPoints++;
+    }
+    for (vtkIdType i = 0; i < NumberOfCells; i++) {
+        if (this->IsFaceActive(i)) {
+            this->GetCellPoints(i, npts, pts);
+            if (Labels->GetValue(pts[0]) == Component)
+                NumberOfNewCells++;
+        }
+    }
 
     vtkSurface* NewMesh = vtkSurface::New();
+    NewMesh->Init(
+        NumberOfNewPoints,
+        NumberOfNewCells,
+        NumberOfNewPoints + NumberOfNewCells + 1000);
+
     double Point[3];
-    for (vtkIdType i = 0; i < List->GetNumberOfIds(); i++) {
-        vtkIdType PtId = List->GetId(i);
-        this->GetPoint(PtId, Point);
-        Ids[PtId] = NewMesh->AddVertex(Point);
+    for (vtkIdType i = 0; i < NumberOfPoints; i++) {
+        if (Labels->GetValue(i) == Component) {
+            this->GetPoint(i, Point);
+            Ids[i] = NewMesh->AddVertex(Point);
+        } else
+            Ids[i] = -1;
     }
 
-    int NumCells = this->GetNumberOfCells();
-    vtkIdType *pts, npts;
     vtkIdType NewVertices[1000];
-
-    for (vtkIdType i = 0; i < NumCells; i++) {
+    for (vtkIdType i = 0; i < NumberOfCells; i++) {
+        if (!this->IsFaceActive(i))
+            continue;
         this->GetCellPoints(i, npts, pts);
-        bool keep = true;
+        if (Labels->GetValue(pts[0]) != Component)
+            continue;
         for (int j = 0; j < npts; j++)
-            if (Ids[pts[j]] < 0)
-                keep = false;
-
-        if (keep) {
-            for (int j = 0; j < npts; j++) {
-                vtkIdType NewVertex = Ids[pts[j]];
-                if (NewVertex < 0) {
-                    cout << "Error in GetBiggestConnectedComponent()" << endl;
-                    exit(1);
-                }
-                NewVertices[j] = NewVertex;
-            }
-            NewMesh->AddPolygon(npts, NewVertices);
-        }
+            NewVertices[j] = Ids[pts[j]];
+        NewMesh->AddPolygon(npts, NewVertices);
     }
 
     delete[] Ids;
@@ -400,71 +420,11 @@ void vtkSurface::SplitLongEdges(double Ratio)
     this->Modified();
     FList->Delete();
 }
-vtkSurface* vtkSurface::Subdivide(vtkIntArray* Parent1, vtkIntArray* Parent2)
+vtkSurface* vtkSurface::Subdivide(
+    vtkIntArray* Parent1, vtkIntArray* Parent2, int NumberOfThreads)
 {
-    vtkIntArray* EdgesChildren = vtkIntArray::New();
-    vtkIdType NumEdges = this->GetNumberOfEdges();
-    vtkIdType NumPoints = this->GetNumberOfPoints();
-    vtkIdType NumFaces = this->GetNumberOfCells();
-    vtkIdType i;
-
-    EdgesChildren->SetNumberOfValues(NumEdges);
-
     vtkSurface* Output = vtkSurface::New();
-    Output->Init(
-        NumPoints + NumEdges, 4 * NumFaces, 2 * NumEdges + 3 * NumFaces);
-
-    if (Parent1) {
-        Parent1->Resize(NumPoints + NumEdges);
-        Parent2->Resize(NumPoints + NumEdges);
-    }
-
-    double P[3], P1[3], P2[3];
-    vtkIdType V1, V2, V3;
-
-    // copy the old points
-    for (i = 0; i < NumPoints; i++) {
-        this->GetPoint(i, P);
-        Output->AddVertex(P);
-    }
-
-    // create the new points (middle of each edge)
-    for (i = 0; i < NumEdges; i++) {
-        if (this->IsEdgeActive(i)) {
-            this->GetEdgeVertices(i, V1, V2);
-            this->GetPoint(V1, P1);
-            this->GetPoint(V2, P2);
-
-            P[0] = 0.5 * (P1[0] + P2[0]);
-            P[1] = 0.5 * (P1[1] + P2[1]);
-            P[2] = 0.5 * (P1[2] + P2[2]);
-
-            V3 = Output->AddVertex(P);
-
-            EdgesChildren->SetValue(i, V3);
-            if (Parent1) {
-                Parent1->SetValue(V3, V1);
-                Parent2->SetValue(V3, V2);
-            }
-        }
-    }
-
-    // create the new cells
-    int V4, V5, V6;
-    for (i = 0; i < NumFaces; i++) {
-        if (this->IsFaceActive(i)) {
-            this->GetFaceVertices(i, V1, V2, V3);
-            V4 = EdgesChildren->GetValue(this->IsEdge(V1, V2));
-            V5 = EdgesChildren->GetValue(this->IsEdge(V2, V3));
-            V6 = EdgesChildren->GetValue(this->IsEdge(V3, V1));
-
-            Output->AddFace(V1, V4, V6);
-            Output->AddFace(V4, V2, V5);
-            Output->AddFace(V5, V3, V6);
-            Output->AddFace(V4, V5, V6);
-        }
-    }
-    EdgesChildren->Delete();
+    Output->CreateFromSubdivision(this, Parent1, Parent2, NumberOfThreads);
     return Output;
 }
 
@@ -536,6 +496,181 @@ void vtkSurface::SubdivideInPlace(vtkIntArray* Parent1, vtkIntArray* Parent2)
     this->SetCleanEdges(BackupCleanEdges);
 }
 
+static void SetTriangle(
+    vtkIdType* Triangle, vtkIdType v1, vtkIdType v2, vtkIdType v3)
+{
+    Triangle[0] = v1;
+    Triangle[1] = v2;
+    Triangle[2] = v3;
+}
+
+// replaces Face by the given triangles, which inherit its parent
+static void SplitFace(
+    vtkSurface* Mesh,
+    vtkIdType Face,
+    int NumberOfChildren,
+    vtkIdType Children[][3],
+    vtkIntArray* FacesParent)
+{
+    vtkIdType Parent = FacesParent ? FacesParent->GetValue(Face) : 0;
+    Mesh->DeleteFace(Face);
+    for (int i = 0; i < NumberOfChildren; i++) {
+        vtkIdType Child =
+            Mesh->AddFace(Children[i][0], Children[i][1], Children[i][2]);
+        if (FacesParent)
+            FacesParent->InsertValue(Child, Parent);
+    }
+}
+
+vtkSurface* vtkSurface::SubdivideAdaptively(
+    double MaximumArea,
+    vtkIntArray* Parent1,
+    vtkIntArray* Parent2,
+    vtkIntArray* FacesParent,
+    int MaximumNumberOfPasses)
+{
+    vtkIdType NumPoints = this->GetNumberOfPoints();
+    vtkIdType NumFaces = this->GetNumberOfCells();
+    vtkIdType i;
+    int j;
+
+    vtkSurface* Output = vtkSurface::New();
+    Output->Init(NumPoints, NumFaces, this->GetNumberOfEdges());
+
+    // prevent the vertices deletion when spliting faces
+    Output->SetCleanVertices(0);
+    Output->SetCleanEdges(1);
+
+    if (Parent1) {
+        Parent1->SetNumberOfValues(NumPoints);
+        Parent2->SetNumberOfValues(NumPoints);
+    }
+    if (FacesParent)
+        FacesParent->Reset();
+
+    double P[3], P1[3], P2[3], P3[3];
+    vtkIdType V[3], M[3];
+
+    // copy the mesh. Original vertices are their own parents
+    for (i = 0; i < NumPoints; i++) {
+        this->GetPoint(i, P);
+        Output->AddVertex(P);
+        if (Parent1) {
+            Parent1->SetValue(i, i);
+            Parent2->SetValue(i, i);
+        }
+    }
+    // deleted faces are not copied, so the output faces are renumbered
+    for (i = 0; i < NumFaces; i++) {
+        if (!this->IsFaceActive(i))
+            continue;
+        this->GetFaceVertices(i, V[0], V[1], V[2]);
+        vtkIdType Face = Output->AddFace(V[0], V[1], V[2]);
+        if (FacesParent)
+            FacesParent->InsertValue(Face, i);
+    }
+
+    for (int Pass = 0; Pass < MaximumNumberOfPasses; Pass++) {
+        // create the middles of the edges of the triangles which are too large
+        vtkIdType NumEdges = Output->GetNumberOfEdges();
+        NumFaces = Output->GetNumberOfCells();
+        std::vector<vtkIdType> EdgesMiddles(NumEdges, -1);
+        bool Split = false;
+        for (i = 0; i < NumFaces; i++) {
+            if (!Output->IsFaceActive(i))
+                continue;
+            Output->GetFaceVertices(i, V[0], V[1], V[2]);
+            Output->GetPoint(V[0], P1);
+            Output->GetPoint(V[1], P2);
+            Output->GetPoint(V[2], P3);
+            if (vtkTriangle::TriangleArea(P1, P2, P3) <= MaximumArea)
+                continue;
+
+            Split = true;
+            for (j = 0; j < 3; j++) {
+                vtkIdType Edge = Output->IsEdge(V[j], V[(j + 1) % 3]);
+                if (EdgesMiddles[Edge] >= 0)
+                    continue;
+                Output->GetPoint(V[j], P1);
+                Output->GetPoint(V[(j + 1) % 3], P2);
+                P[0] = 0.5 * (P1[0] + P2[0]);
+                P[1] = 0.5 * (P1[1] + P2[1]);
+                P[2] = 0.5 * (P1[2] + P2[2]);
+                EdgesMiddles[Edge] = Output->AddVertex(P);
+                if (Parent1) {
+                    Parent1->InsertValue(EdgesMiddles[Edge], V[j]);
+                    Parent2->InsertValue(EdgesMiddles[Edge], V[(j + 1) % 3]);
+                }
+            }
+        }
+        if (!Split)
+            break;
+
+        // collect the faces to split before modifying the connectivity, as
+        // the ids of deleted edges are reused
+        std::vector<vtkIdType> SplitFaces;
+        for (i = 0; i < NumFaces; i++) {
+            if (!Output->IsFaceActive(i))
+                continue;
+            Output->GetFaceVertices(i, V[0], V[1], V[2]);
+            int NumberOfMiddles = 0;
+            for (j = 0; j < 3; j++) {
+                M[j] = EdgesMiddles[Output->IsEdge(V[j], V[(j + 1) % 3])];
+                if (M[j] >= 0)
+                    NumberOfMiddles++;
+            }
+            if (NumberOfMiddles == 0)
+                continue;
+            SplitFaces.push_back(i);
+            for (j = 0; j < 3; j++) {
+                SplitFaces.push_back(V[j]);
+                SplitFaces.push_back(M[j]);
+            }
+        }
+
+        // split the faces. M[j] is the middle of the edge V[j] V[j+1]
+        for (size_t k = 0; k < SplitFaces.size(); k += 7) {
+            vtkIdType Face = SplitFaces[k];
+            int NumberOfMiddles = 0;
+            for (j = 0; j < 3; j++) {
+                V[j] = SplitFaces[k + 1 + 2 * j];
+                M[j] = SplitFaces[k + 2 + 2 * j];
+                if (M[j] >= 0)
+                    NumberOfMiddles++;
+            }
+
+            vtkIdType Children[4][3];
+            if (NumberOfMiddles == 3) {
+                SetTriangle(Children[0], V[0], M[0], M[2]);
+                SetTriangle(Children[1], M[0], V[1], M[1]);
+                SetTriangle(Children[2], M[1], V[2], M[2]);
+                SetTriangle(Children[3], M[0], M[1], M[2]);
+                SplitFace(Output, Face, 4, Children, FacesParent);
+            } else if (NumberOfMiddles == 1) {
+                // the split edge is V[j] V[j+1]
+                for (j = 0; M[j] < 0; j++)
+                    ;
+                vtkIdType a = V[j], b = V[(j + 1) % 3], c = V[(j + 2) % 3];
+                SetTriangle(Children[0], a, M[j], c);
+                SetTriangle(Children[1], M[j], b, c);
+                SplitFace(Output, Face, 2, Children, FacesParent);
+            } else {
+                // the edge V[j] V[j+1] is not split, the two split edges
+                // share the vertex a
+                for (j = 0; M[j] >= 0; j++)
+                    ;
+                vtkIdType a = V[(j + 2) % 3], b = V[j], c = V[(j + 1) % 3];
+                vtkIdType Mab = M[(j + 2) % 3], Mca = M[(j + 1) % 3];
+                SetTriangle(Children[0], a, Mab, Mca);
+                SetTriangle(Children[1], Mab, b, c);
+                SetTriangle(Children[2], c, Mca, Mab);
+                SplitFace(Output, Face, 3, Children, FacesParent);
+            }
+        }
+    }
+    return Output;
+}
+
 void vtkSurface::DisplayMeshProperties()
 {
     std::stringstream Str;
@@ -607,10 +742,10 @@ void vtkSurface::GetMeshProperties(std::stringstream& stream)
         stream << NumberOfEmptySlots << " edges cells are not used (not active)"
                << endl;
 
-    vtkIdListCollection* Components = this->GetConnectedComponents();
-    stream << "The mesh has " << Components->GetNumberOfItems()
+    vtkIdTypeArray* Labels = vtkIdTypeArray::New();
+    stream << "The mesh has " << this->ComputeConnectedComponents(Labels)
            << " connected components" << endl;
-    this->DeleteConnectedComponents();
+    Labels->Delete();
 
     stream << " Valences entropy: " << this->GetValenceEntropy() << endl;
     double a, b, c, number;
@@ -721,247 +856,483 @@ double vtkSurface::GetDistanceBetweenVertices(vtkIdType V1, vtkIdType V2)
     return (sqrt(vtkMath::Distance2BetweenPoints(P1, P2)));
 }
 
-vtkSurface* vtkSurface::CleanConnectivity(double tolerance)
+vtkSurface* vtkSurface::WeldVertices(double Tolerance, int NumberOfThreads)
 {
+    vtkIdType NumberOfPoints = this->GetNumberOfPoints();
+    vtkUnionFind Forest;
+    Forest.Allocate(NumberOfPoints);
+
+    // the cells are as large as the tolerance, so that points to merge are
+    // in neighbour cells. Coincident points share a cell whatever its size.
+    double CellSize = Tolerance;
+    if (CellSize <= 0)
+        CellSize = this->GetLength() / sqrt((double)NumberOfPoints + 1);
+    if (CellSize <= 0)
+        CellSize = 1;
+    vtkSpatialHash Hash;
+    Hash.Build(this->GetPoints(), CellSize, NumberOfThreads);
+
+    // merge each point with the smaller points within the tolerance. The
+    // merged sets do not depend on the order of the unions.
+    double Tolerance2 = Tolerance * Tolerance;
+    auto MergePoints = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        double P1[3], P2[3];
+        vtkIdType V1;
+        auto MergeBucket = [&](vtkIdType Bucket) {
+            vtkIdType NumberOfIds;
+            const vtkIdType* Ids;
+            Hash.GetBucketPoints(Bucket, NumberOfIds, Ids);
+            for (vtkIdType i = 0; (i < NumberOfIds) && (Ids[i] < V1); i++) {
+                this->GetPoint(Ids[i], P2);
+                if (vtkMath::Distance2BetweenPoints(P1, P2) <= Tolerance2)
+                    Forest.Union(V1, Ids[i]);
+            }
+        };
+        for (V1 = Begin; V1 < End; V1++) {
+            this->GetPoint(V1, P1);
+            Hash.ForEachNeighbourBucket(P1, MergeBucket);
+        }
+    };
+    vtkParallelFor::Execute(NumberOfPoints, MergePoints, NumberOfThreads);
 
-    vtkIdList *VList1, *VList2, *VList;
-    vtkIdType V1, V2, Type1, Type2, Edge;
-    int NumberOfComponents;
-    int NumberOfTetras;
-    int i, j, k;
-    vtkSurface* CleanedMesh;
-    vtkPolyData* Draft = vtkPolyData::New();
-    Draft->DeepCopy(this);
-    vtkIdList* EdgesVertices = vtkIdList::New();
-    VList = vtkIdList::New();
-
-    double Bounds[6];
-    double P1[3], P2[3];
-    this->GetBounds(Bounds);
-    for (i = 0; i < 3; i++) {
-        P1[i] = Bounds[2 * i];
-        P2[i] = Bounds[2 * i + 1];
+    // each merged vertex keeps the coordinates of its smallest point. Points
+    // which are not used by any face are removed.
+    std::vector<vtkIdType> NewIds(NumberOfPoints, -1);
+    vtkIdType NumberOfVertices, *Vertices;
+    for (vtkIdType Face = 0; Face < this->GetNumberOfCells(); Face++) {
+        if (!this->IsFaceActive(Face))
+            continue;
+        this->GetFaceVertices(Face, NumberOfVertices, Vertices);
+        for (vtkIdType i = 0; i < NumberOfVertices; i++)
+            NewIds[Forest.Find(Vertices[i])] = 0;
     }
-    double BBoxDiag = sqrt(vtkMath::Distance2BetweenPoints(P1, P2));
 
-    // Here we merge the points within the relative tolerance together
-    vtkCleanPolyData* Cleaner = vtkCleanPolyData::New();
-    Cleaner->SetInputData(this);
-    Cleaner->SetTolerance(tolerance * BBoxDiag);
-    Cleaner->Update();
-
-    CleanedMesh = vtkSurface::New();
-    CleanedMesh->CreateFromPolyData(Cleaner->GetOutput());
-    Cleaner->Delete();
-
-    // Here is the delaunay triangulation of the resulting points
-
-    vtkDelaunay3D* Delaunay = vtkDelaunay3D::New();
-    Delaunay->SetInputData(CleanedMesh);
-
-    vtkIdListCollection* Components;
-    Components = CleanedMesh->GetConnectedComponents();
-    NumberOfComponents = Components->GetNumberOfItems();
-    Delaunay->SetDebug(0);
-
-    Delaunay->Update();
-
-    vtkUnstructuredGrid* Tetras = Delaunay->GetOutput();
-    NumberOfTetras = Tetras->GetNumberOfCells();
-    cout << NumberOfTetras << " Tetras" << endl;
-    cout << Tetras->GetNumberOfPoints() << " Points in the tetras" << endl;
-
-    // Create an array containing for each vertex the index of its component;
-    vtkIntArray* VerticesComponent = vtkIntArray::New();
-    VerticesComponent->SetNumberOfValues(CleanedMesh->GetNumberOfPoints());
-    for (i = 0; i < NumberOfComponents; i++) {
-        VList1 = Components->GetItem(i);
-        for (j = 0; j < VList1->GetNumberOfIds(); j++) {
-            VerticesComponent->SetValue(VList1->GetId(j), i);
-            V1 = VList1->GetId(j);
+    vtkPoints* NewPoints = vtkPoints::New();
+    NewPoints->SetDataType(this->GetPoints()->GetDataType());
+    double P[3];
+    for (vtkIdType Vertex = 0; Vertex < NumberOfPoints; Vertex++) {
+        if (NewIds[Vertex] == 0) {
+            this->GetPoint(Vertex, P);
+            NewIds[Vertex] = NewPoints->InsertNextPoint(P);
         }
     }
 
-    // Create a table for all the edges
-
-    vtkEdgeTable* Edges = vtkEdgeTable::New();
-    Edges->InitEdgeInsertion(CleanedMesh->GetNumberOfPoints(), 1);
-
-    for (i = 0; i < Tetras->GetNumberOfCells(); i++) {
-        Tetras->GetCellPoints(i, VList);
-        for (j = 0; j < VList->GetNumberOfIds() - 1; j++) {
-            V1 = VList->GetId(j);
-            for (k = j + 1; k < VList->GetNumberOfIds(); k++) {
-                V2 = VList->GetId(k);
-                Edge = Edges->IsEdge(V1, V2);
-                if (Edge < 0) {
-                    Edges->InsertEdge(V1, V2);
-                }
-            }
+    // rebuild the faces with the merged vertices. Consecutive repeated
+    // vertices are removed, and faces left with less than 3 vertices
+    vtkCellArray* NewPolys = vtkCellArray::New();
+    NewPolys->Allocate(4 * this->GetNumberOfCells());
+    std::vector<vtkIdType> NewFace;
+    for (vtkIdType Face = 0; Face < this->GetNumberOfCells(); Face++) {
+        if (!this->IsFaceActive(Face))
+            continue;
+        this->GetFaceVertices(Face, NumberOfVertices, Vertices);
+        NewFace.clear();
+        for (vtkIdType i = 0; i < NumberOfVertices; i++) {
+            vtkIdType Vertex = NewIds[Forest.Find(Vertices[i])];
+            if (NewFace.empty() || (NewFace.back() != Vertex))
+                NewFace.push_back(Vertex);
         }
+        while ((NewFace.size() > 1) && (NewFace.back() == NewFace.front()))
+            NewFace.pop_back();
+        if (NewFace.size() >= 3)
+            NewPolys->InsertNextCell(NewFace.size(), NewFace.data());
     }
-    cout << Edges->GetNumberOfEdges() << " edges for the tetraedral mesh"
-         << endl;
-
-    // Push the edges into a Priority queue and store the edges vertices in
-    // EdgesVertices
 
-    vtkPriorityQueue* Queue = vtkPriorityQueue::New();
-    Queue->Allocate(Edges->GetNumberOfEdges());
+    vtkPolyData* Welded = vtkPolyData::New();
+    Welded->SetPoints(NewPoints);
+    Welded->SetPolys(NewPolys);
+    NewPoints->Delete();
+    NewPolys->Delete();
 
-    EdgesVertices->SetNumberOfIds(Edges->GetNumberOfEdges() * 2);
-    Edges->InitTraversal();
-    Edge = Edges->GetNextEdge(V1, V2);
+    vtkSurface* Output = vtkSurface::New();
+    Output->CreateFromPolyData(Welded);
+    Welded->Delete();
+    return (Output);
+}
 
-#ifdef DISPLAYMESHCLEANING
-    vtkPolyData* EdgesP = vtkPolyData::New();
-    EdgesP->SetPoints(this->GetPoints());
-    EdgesP->Allocate(Edges->GetNumberOfEdges());
-    vtkPolyData* EdgesP2 = vtkPolyData::New();
-    EdgesP2->SetPoints(this->GetPoints());
-    EdgesP2->Allocate(Edges->GetNumberOfEdges());
+// Links the connected components of Mesh with edges, shortest first. The
+// candidate edges join one representative vertex of each component in each
+// cell of a uniform grid to the representatives of the other components in
+// the neighbour cells. The cells are enlarged until a single component
+// remains.
+static void LinkComponents(vtkSurface* Mesh, int NumberOfThreads)
+{
+    vtkIdTypeArray* Labels = vtkIdTypeArray::New();
+    vtkIdType NumberOfComponents = Mesh->ComputeConnectedComponents(
+        Labels, 0, NumberOfThreads);
+    vtkIdType* Label = Labels->GetPointer(0);
+    vtkUnionFind Components;
+    Components.Allocate(NumberOfComponents);
+
+    typedef std::pair<double, std::pair<vtkIdType, vtkIdType>> Candidate;
+    std::vector<vtkIdType> Representatives;
+    std::vector<vtkIdType> RepresentativesComponents;
+    std::vector<vtkIdType> Offsets;
+    vtkSpatialHash Hash;
+    double CellSize =
+        Mesh->GetLength() / sqrt((double)Mesh->GetNumberOfPoints() + 1);
+    if (CellSize <= 0)
+        CellSize = 1;
 
-    vtkIdList* vl = vtkIdList::New();
-    vl->SetNumberOfIds(2);
-#endif
-    while (Edge >= 0) {
-        Queue->Insert(CleanedMesh->GetDistanceBetweenVertices(V1, V2), Edge);
-        EdgesVertices->SetId(2 * Edge, V1);
-        EdgesVertices->SetId(2 * Edge + 1, V2);
-#ifdef DISPLAYMESHCLEANING
-        vl->SetId(0, V1);
-        vl->SetId(1, V2);
-        EdgesP->InsertNextCell(VTK_LINE, vl);
-#endif
-        Edge = Edges->GetNextEdge(V1, V2);
-    }
-
-    // pop the edges to connect unconnected components;
     while (NumberOfComponents > 1) {
-        Edge = Queue->Pop();
-        if (Edge < 0) {
-            cout << "***************PROBLEM*******************,"
-                 << NumberOfComponents << " remaining components" << endl;
-            break;
+        Hash.Build(Mesh->GetPoints(), CellSize, NumberOfThreads);
+
+        // one representative for each component in each bucket
+        Representatives.clear();
+        RepresentativesComponents.clear();
+        Offsets.assign(1, 0);
+        for (vtkIdType Bucket = 0; Bucket < Hash.GetNumberOfBuckets();
+             Bucket++) {
+            vtkIdType NumberOfIds;
+            const vtkIdType* Ids;
+            Hash.GetBucketPoints(Bucket, NumberOfIds, Ids);
+            for (vtkIdType i = 0; i < NumberOfIds; i++) {
+                vtkIdType Component = Components.Find(Label[Ids[i]]);
+                vtkIdType j = Offsets.back();
+                while ((j < (vtkIdType)Representatives.size()) &&
+                       (RepresentativesComponents[j] != Component))
+                    j++;
+                if (j == (vtkIdType)Representatives.size()) {
+                    Representatives.push_back(Ids[i]);
+                    RepresentativesComponents.push_back(Component);
+                }
+            }
+            Offsets.push_back(Representatives.size());
         }
-        V1 = EdgesVertices->GetId(2 * Edge);
-        V2 = EdgesVertices->GetId(2 * Edge + 1);
-
-#ifdef DISPLAYMESHCLEANING
-
-        vl->SetId(0, V1);
-        vl->SetId(1, V2);
-        EdgesP2->InsertNextCell(VTK_LINE, vl);
-
-#endif
-
-        Type1 = VerticesComponent->GetValue(V1);
-        Type2 = VerticesComponent->GetValue(V2);
-        if ((CleanedMesh->IsEdge(V1, V2) < 0) && (Type1 != Type2) &&
-            (V1 != V2)) {
-            CleanedMesh->AddEdge(V1, V2);
-            VList1 = Components->GetItem(Type1);
-            VList2 = Components->GetItem(Type2);
-            for (i = 0; i < VList2->GetNumberOfIds(); i++) {
-                VerticesComponent->SetValue(VList2->GetId(i), Type1);
-                VList1->InsertNextId(VList2->GetId(i));
+
+        // candidate edges, gathered by chunk
+        vtkIdType NumberOfRepresentatives = Representatives.size();
+        std::vector<std::vector<Candidate>> ChunksCandidates(
+            vtkParallelFor::GetNumberOfChunks(
+                NumberOfRepresentatives, NumberOfThreads));
+        auto FindCandidates = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+            double P1[3], P2[3];
+            vtkIdType i;
+            auto AddBucket = [&](vtkIdType Bucket) {
+                for (vtkIdType j = Offsets[Bucket]; j < Offsets[Bucket + 1];
+                     j++) {
+                    if ((j <= i) || (RepresentativesComponents[j] ==
+                                     RepresentativesComponents[i]))
+                        continue;
+                    Mesh->GetPoint(Representatives[j], P2);
+                    Candidate NewCandidate;
+                    NewCandidate.first =
+                        vtkMath::Distance2BetweenPoints(P1, P2);
+                    NewCandidate.second.first = Representatives[i];
+                    NewCandidate.second.second = Representatives[j];
+                    ChunksCandidates[Chunk].push_back(NewCandidate);
+                }
+            };
+            for (i = Begin; i < End; i++) {
+                Mesh->GetPoint(Representatives[i], P1);
+                Hash.ForEachNeighbourBucket(P1, AddBucket);
             }
+        };
+        vtkParallelFor::Execute(
+            NumberOfRepresentatives, FindCandidates, NumberOfThreads);
+
+        std::vector<Candidate> Candidates;
+        for (size_t Chunk = 0; Chunk < ChunksCandidates.size(); Chunk++)
+            Candidates.insert(
+                Candidates.end(),
+                ChunksCandidates[Chunk].begin(),
+                ChunksCandidates[Chunk].end());
+        std::sort(Candidates.begin(), Candidates.end());
+
+        for (size_t i = 0; i < Candidates.size(); i++) {
+            vtkIdType V1 = Candidates[i].second.first;
+            vtkIdType V2 = Candidates[i].second.second;
+            vtkIdType Component1 = Components.Find(Label[V1]);
+            vtkIdType Component2 = Components.Find(Label[V2]);
+            if (Component1 == Component2)
+                continue;
+            Mesh->AddEdge(V1, V2);
+            Components.Union(Component1, Component2);
             NumberOfComponents--;
         }
+        CellSize *= 2;
     }
+    Labels->Delete();
+}
 
-#ifdef DISPLAYMESHCLEANING
-    RenderWindow* Window = RenderWindow::New();
-    Window->SetInputEdges(EdgesP);
-    Window->SetInputData(this);
-    Window->Render();
-    Window->SetWindowName("1");
-    Window->Interact();
+vtkSurface* vtkSurface::CleanConnectivity(double tolerance)
+{
+    // Here we merge the points within the relative tolerance together
+    vtkSurface* CleanedMesh =
+        this->WeldVertices(tolerance * this->GetLength());
+
+    // Then the topology is repaired and the remaining connected components
+    // are linked with fictive edges
+    if (CleanedMesh->RepairTopology())
+        CleanedMesh->CheckNormals();
+    LinkComponents(CleanedMesh, 0);
+    return (CleanedMesh);
+}
 
-    RenderWindow* Window2 = RenderWindow::New();
-    Window2->SetInputData(EdgesP2);
-    Window2->SetInputData(this);
-    Window2->Render();
-    Window2->SetWindowName("2");
-    Window2->AttachToRenderWindow(Window);
-    Window2->Interact();
+// sorts the Ids by increasing key, and returns the new Id of each element
+static void SortByKeys(
+    std::vector<std::pair<unsigned long long, vtkIdType>>& Keys,
+    std::vector<vtkIdType>& NewIds)
+{
+    std::sort(Keys.begin(), Keys.end());
+    NewIds.resize(Keys.size());
+    for (size_t i = 0; i < Keys.size(); i++)
+        NewIds[Keys[i].second] = i;
+}
 
-    RenderWindow* Window3 = RenderWindow::New();
-    Window3->SetInputData(CleanedMesh);
-    Window3->DisplayInputEdges();
-    Window3->Render();
-    Window3->SetWindowName("3");
-    Window3->AttachToRenderWindow(Window);
-    Window3->Interact();
+// returns the order of the vertices as a reverse Cuthill-McKee
+// traversal : each connected component is traversed breadth first from a
+// vertex of minimal valence, neighbours being visited by increasing valence
+static void GetCuthillMcKeeOrder(
+    vtkSurface* Mesh, std::vector<vtkIdType>& NewIds)
+{
+    vtkIdType NumberOfPoints = Mesh->GetNumberOfPoints();
+    std::vector<std::pair<unsigned long long, vtkIdType>> Valences(
+        NumberOfPoints);
+    for (vtkIdType Vertex = 0; Vertex < NumberOfPoints; Vertex++) {
+        Valences[Vertex].first = Mesh->GetValence(Vertex);
+        Valences[Vertex].second = Vertex;
+    }
 
-#endif
+    std::vector<vtkIdType> Order;
+    Order.reserve(NumberOfPoints);
+    std::vector<char> Visited(NumberOfPoints, 0);
+    std::vector<std::pair<unsigned long long, vtkIdType>> Neighbours;
+    vtkIdList* List = vtkIdList::New();
+    std::vector<std::pair<unsigned long long, vtkIdType>> Starts(Valences);
+    std::sort(Starts.begin(), Starts.end());
+    for (vtkIdType i = 0; i < NumberOfPoints; i++) {
+        vtkIdType Start = Starts[i].second;
+        if (Visited[Start] || !Mesh->IsVertexActive(Start))
+            continue;
+        Visited[Start] = 1;
+        Order.push_back(Start);
+        for (size_t Position = Order.size() - 1; Position < Order.size();
+             Position++) {
+            Mesh->GetVertexNeighbours(Order[Position], List);
+            Neighbours.clear();
+            for (vtkIdType j = 0; j < List->GetNumberOfIds(); j++) {
+                vtkIdType Neighbour = List->GetId(j);
+                if (!Visited[Neighbour]) {
+                    Visited[Neighbour] = 1;
+                    Neighbours.push_back(Valences[Neighbour]);
+                }
+            }
+            std::sort(Neighbours.begin(), Neighbours.end());
+            for (size_t j = 0; j < Neighbours.size(); j++)
+                Order.push_back(Neighbours[j].second);
+        }
+    }
+    List->Delete();
+
+    // reversed, deleted vertices last
+    vtkIdType NumberOfOrderedPoints = Order.size();
+    NewIds.assign(NumberOfPoints, -1);
+    for (vtkIdType i = 0; i < NumberOfOrderedPoints; i++)
+        NewIds[Order[i]] = NumberOfOrderedPoints - 1 - i;
+    vtkIdType Id = NumberOfOrderedPoints;
+    for (vtkIdType Vertex = 0; Vertex < NumberOfPoints; Vertex++) {
+        if (NewIds[Vertex] < 0)
+            NewIds[Vertex] = Id++;
+    }
+}
 
-    CleanedMesh->DeleteEdgeLengths();
-    CleanedMesh->DeleteConnectedComponents();
+void vtkSurface::Reorder(
+    int Method,
+    vtkIdTypeArray* PointsPermutation,
+    vtkIdTypeArray* CellsPermutation,
+    int NumberOfThreads)
+{
+    vtkIdType NumberOfPoints = this->GetNumberOfPoints();
+    vtkIdType NumberOfFaces = this->GetNumberOfCells();
+    vtkIdType NumberOfEdges = this->GetNumberOfEdges();
+    const unsigned long long Last = ~0ULL;
+    std::vector<std::pair<unsigned long long, vtkIdType>> Keys;
+    std::vector<vtkIdType> NewVertexIds, NewFaceIds, NewEdgeIds;
 
-    Queue->Delete();
+    double Bounds[6];
+    vtkSpaceFillingCurve Curve;
+    this->ComputeBounds();
+    this->GetBounds(Bounds);
+    Curve.SetBounds(Bounds);
+    auto GetCurveKey = [&](const double* P) {
+        if (Method == MORTON_ORDER)
+            return (Curve.GetMortonKey(P));
+        return (Curve.GetHilbertKey(P));
+    };
+
+    // vertices
+    if (Method == CUTHILL_MCKEE_ORDER)
+        GetCuthillMcKeeOrder(this, NewVertexIds);
+    else {
+        Keys.resize(NumberOfPoints);
+        auto ComputeKeys = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+            double P[3];
+            for (vtkIdType Vertex = Begin; Vertex < End; Vertex++) {
+                this->GetPoint(Vertex, P);
+                Keys[Vertex].first =
+                    this->IsVertexActive(Vertex) ? GetCurveKey(P) : Last;
+                Keys[Vertex].second = Vertex;
+            }
+        };
+        vtkParallelFor::Execute(NumberOfPoints, ComputeKeys, NumberOfThreads);
+        SortByKeys(Keys, NewVertexIds);
+    }
 
-    Edges->Delete();
-    Delaunay->Delete();
-    VerticesComponent->Delete();
-    cout << "pro" << endl;
+    // faces
+    Keys.resize(NumberOfFaces);
+    auto ComputeFacesKeys = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        vtkIdType NumberOfVertices, *Vertices;
+        double P[3], Centroid[3];
+        for (vtkIdType Face = Begin; Face < End; Face++) {
+            Keys[Face].second = Face;
+            Keys[Face].first = Last;
+            if (!this->IsFaceActive(Face))
+                continue;
+            this->GetFaceVertices(Face, NumberOfVertices, Vertices);
+            if (Method == CUTHILL_MCKEE_ORDER) {
+                for (vtkIdType j = 0; j < NumberOfVertices; j++) {
+                    unsigned long long Key = NewVertexIds[Vertices[j]];
+                    if (Key < Keys[Face].first)
+                        Keys[Face].first = Key;
+                }
+                continue;
+            }
+            Centroid[0] = Centroid[1] = Centroid[2] = 0;
+            for (vtkIdType j = 0; j < NumberOfVertices; j++) {
+                this->GetPoint(Vertices[j], P);
+                for (int k = 0; k < 3; k++)
+                    Centroid[k] += P[k] / (double)NumberOfVertices;
+            }
+            Keys[Face].first = GetCurveKey(Centroid);
+        }
+    };
+    vtkParallelFor::Execute(NumberOfFaces, ComputeFacesKeys, NumberOfThreads);
+    SortByKeys(Keys, NewFaceIds);
+
+    // edges, by their first and second new vertices
+    Keys.resize(NumberOfEdges);
+    auto ComputeEdgesKeys = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        vtkIdType V1, V2;
+        for (vtkIdType Edge = Begin; Edge < End; Edge++) {
+            Keys[Edge].second = Edge;
+            Keys[Edge].first = Last;
+            if (!this->IsEdgeActive(Edge))
+                continue;
+            this->GetEdgeVertices(Edge, V1, V2);
+            V1 = NewVertexIds[V1];
+            V2 = NewVertexIds[V2];
+            if (V1 > V2)
+                std::swap(V1, V2);
+            Keys[Edge].first = (unsigned long long)V1 * NumberOfPoints + V2;
+        }
+    };
+    vtkParallelFor::Execute(NumberOfEdges, ComputeEdgesKeys, NumberOfThreads);
+    SortByKeys(Keys, NewEdgeIds);
 
-    return (CleanedMesh);
+    // the cached attributes would be recomputed anyway, and the sharp
+    // vertices are also the point scalars
+    this->DeleteEdgeLengths();
+    this->DeleteSharpVertices();
+    this->DeleteTrianglesAreas();
+    this->DeleteTrianglesNormals();
+    this->DeleteConnectedComponents();
+    this->DeleteVerticesAreas();
+
+    this->PermuteElements(
+        NewVertexIds.data(), NewFaceIds.data(), NewEdgeIds.data(),
+        NumberOfThreads);
+
+    if (PointsPermutation) {
+        PointsPermutation->SetNumberOfValues(NumberOfPoints);
+        for (vtkIdType Vertex = 0; Vertex < NumberOfPoints; Vertex++)
+            PointsPermutation->SetValue(NewVertexIds[Vertex], Vertex);
+    }
+    if (CellsPermutation) {
+        CellsPermutation->SetNumberOfValues(NumberOfFaces);
+        for (vtkIdType Face = 0; Face < NumberOfFaces; Face++)
+            CellsPermutation->SetValue(NewFaceIds[Face], Face);
+    }
 }
 
 // Compute the connected components of the mesh (It is based on vertices and
 // edges So it works also with non manifold meshes)
 vtkIdListCollection* vtkSurface::GetConnectedComponents()
 {
-
     if (this->ConnectedComponents)
         return (this->ConnectedComponents);
-    int i, j;
-    vtkIdType v1, v2;
 
-    std::queue<int> VQueue;
-    int* Visited = new int[this->GetNumberOfPoints()];
-    vtkIdList* Component;
-    vtkIdList* VList = vtkIdList::New();
+    vtkIdTypeArray* Labels = vtkIdTypeArray::New();
+    vtkIdTypeArray* Sizes = vtkIdTypeArray::New();
+    vtkIdType NumberOfComponents =
+        this->ComputeConnectedComponents(Labels, Sizes);
+
+    // dispatch the vertices, by increasing Id
     this->ConnectedComponents = vtkIdListCollection::New();
+    std::vector<vtkIdType*> Components(NumberOfComponents);
+    for (vtkIdType i = 0; i < NumberOfComponents; i++) {
+        vtkIdList* Component = vtkIdList::New();
+        Component->SetNumberOfIds(Sizes->GetValue(i));
+        Components[i] = Component->GetPointer(0);
+        this->ConnectedComponents->AddItem(Component);
+        Component->Delete();
+    }
+    for (vtkIdType i = 0; i < this->GetNumberOfPoints(); i++)
+        *Components[Labels->GetValue(i)]++ = i;
 
-    for (i = 0; i < this->GetNumberOfPoints(); i++)
-        Visited[i] = 0;
+    Labels->Delete();
+    Sizes->Delete();
+    return (this->ConnectedComponents);
+}
 
-    for (i = 0; i < this->GetNumberOfPoints(); i++) {
-        if (Visited[i] == 0) {
-            // a new component is detected
-            VQueue.push(i);
-            Component = vtkIdList::New();
-            //			Component->Allocate(this->GetNumberOfPoints());
-
-            while (VQueue.size()) {
-                v1 = VQueue.front();
-                if (Visited[v1] == 0) {
-                    Component->InsertNextId(v1);
-
-                    Visited[v1]++;
-                    this->GetVertexNeighbours(v1, VList);
-                    for (j = 0; j < VList->GetNumberOfIds(); j++) {
-                        v2 = VList->GetId(j);
-                        if (Visited[v2] == 0)
-                            VQueue.push(v2);
-                    }
-                }
-                VQueue.pop();
+vtkIdType vtkSurface::ComputeConnectedComponents(
+    vtkIdTypeArray* Labels, vtkIdTypeArray* Sizes, int NumberOfThreads)
+{
+    vtkIdType NumberOfPoints = this->GetNumberOfPoints();
+    vtkUnionFind Forest;
+    Forest.Allocate(NumberOfPoints);
+
+    auto MergeEdges = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        vtkIdType V1, V2;
+        for (vtkIdType Edge = Begin; Edge < End; Edge++) {
+            if (this->IsEdgeActive(Edge)) {
+                this->GetEdgeVertices(Edge, V1, V2);
+                Forest.Union(V1, V2);
             }
-
-            // Compute barycenter of region, create a new node in the PolyData
-
-            Component->Squeeze();
-            this->ConnectedComponents->AddItem(Component);
-            Component->Delete();
+        }
+    };
+    vtkParallelFor::Execute(
+        this->GetNumberOfEdges(), MergeEdges, NumberOfThreads);
+
+    Labels->SetNumberOfValues(NumberOfPoints);
+    vtkIdType* Label = Labels->GetPointer(0);
+    auto FindRoots = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        for (vtkIdType Vertex = Begin; Vertex < End; Vertex++)
+            Label[Vertex] = Forest.Find(Vertex);
+    };
+    vtkParallelFor::Execute(NumberOfPoints, FindRoots, NumberOfThreads);
+
+    // the root of each component is its smallest vertex, which is labeled
+    // before the other vertices of the component
+    vtkIdType NumberOfComponents = 0;
+    std::vector<vtkIdType> ComponentsSizes;
+    for (vtkIdType Vertex = 0; Vertex < NumberOfPoints; Vertex++) {
+        vtkIdType Root = Label[Vertex];
+        if (Root == Vertex) {
+            Label[Vertex] = NumberOfComponents++;
+            ComponentsSizes.push_back(1);
+        } else {
+            Label[Vertex] = Label[Root];
+            ComponentsSizes[Label[Vertex]]++;
         }
     }
 
-    VList->Delete();
-    delete[] Visited;
-    return (this->ConnectedComponents);
+    if (Sizes) {
+        Sizes->SetNumberOfValues(NumberOfComponents);
+        for (vtkIdType i = 0; i < NumberOfComponents; i++)
+            Sizes->SetValue(i, ComponentsSizes[i]);
+    }
+    return (NumberOfComponents);
 }
 
 void vtkSurface::DeleteConnectedComponents()
@@ -972,75 +1343,216 @@ void vtkSurface::DeleteConnectedComponents()
     }
 };
 
-// Compute the Edges Lenghts
-vtkDoubleArray* vtkSurface::GetEdgeLengths()
+vtkIdType vtkSurface::GetNumberOfElements(int Domain)
 {
-    vtkIdType i, v1, v2;
-    if (this->EdgeLengths)
-        return (this->EdgeLengths);
-
-    this->EdgeLengths = vtkDoubleArray::New();
-    this->EdgeLengths->SetNumberOfValues(this->GetNumberOfEdges());
-    for (i = 0; i < this->GetNumberOfEdges(); i++) {
-        this->GetEdgeVertices(i, v1, v2);
-        this->EdgeLengths->SetValue(
-            i, this->GetDistanceBetweenVertices(v1, v2));
+    switch (Domain) {
+    case VERTEX_ATTRIBUTE:
+        return (this->GetNumberOfPoints());
+    case FACE_ATTRIBUTE:
+        return (this->GetNumberOfCells());
+    default:
+        return (this->GetNumberOfEdges());
     }
-    return (this->EdgeLengths);
 }
-vtkDoubleArray* vtkSurface::GetTrianglesAreas()
+
+vtkMTimeType vtkSurface::GetGeometryMTime()
 {
-    int i;
-    vtkIdType v1, v2, v3;
-    double P1[3], P2[3], P3[3];
+    // the point data is not included, as it holds the sharp vertices
+    vtkMTimeType Time = this->vtkObject::GetMTime();
+    if (this->GetPoints() && (this->GetPoints()->GetMTime() > Time))
+        Time = this->GetPoints()->GetMTime();
+    if (this->GetPolys() && (this->GetPolys()->GetMTime() > Time))
+        Time = this->GetPolys()->GetMTime();
+    return (Time);
+}
 
-    if (this->TrianglesAreas)
-        return (this->TrianglesAreas);
+bool vtkSurface::GetDirtyElements(
+    AttributeState& State,
+    int Domain,
+    vtkIdType FirstNewElement,
+    std::vector<vtkIdType>& Ids)
+{
+    if ((State.LogPosition < 0) ||
+        (this->GetGeometryMTime() > State.UpdateTime.GetMTime()))
+        return (false);
+
+    std::vector<vtkIdType> Vertices, Faces;
+    if (!this->GetModifications(State.LogPosition, Vertices, Faces))
+        return (false);
+
+    vtkIdType NumberOfElements = this->GetNumberOfElements(Domain);
+    if (Vertices.empty() && Faces.empty()) {
+        for (vtkIdType Id = FirstNewElement; Id < NumberOfElements; Id++)
+            Ids.push_back(Id);
+        return (true);
+    }
 
-    this->TrianglesAreas = vtkDoubleArray::New();
-    this->TrianglesAreas->SetNumberOfValues(this->GetNumberOfCells());
+    std::vector<char> Dirty(NumberOfElements, 0);
+    auto Mark = [&](vtkIdType Id) {
+        if ((Id < NumberOfElements) && !Dirty[Id]) {
+            Dirty[Id] = 1;
+            Ids.push_back(Id);
+        }
+    };
 
-    for (i = 0; i < this->GetNumberOfCells(); i++) {
+    for (vtkIdType Id = FirstNewElement; Id < NumberOfElements; Id++)
+        Mark(Id);
 
-        this->GetFaceVertices(i, v1, v2, v3);
-        this->GetPointCoordinates(v1, P1);
-        this->GetPointCoordinates(v2, P2);
-        this->GetPointCoordinates(v3, P3);
-        double a, b, c;
-        a = vtkMath::Distance2BetweenPoints(P1, P2);
-        b = vtkMath::Distance2BetweenPoints(P2, P3);
-        c = vtkMath::Distance2BetweenPoints(P3, P1);
-        this->TrianglesAreas->SetValue(
-            i, (0.25 *
-                sqrt(fabs((double)4.0 * a * c - (a - b + c) * (a - b + c)))));
+    // the vertices of the modified faces are logged with them, so that the
+    // modified faces only matter for face attributes
+    if (Domain == FACE_ATTRIBUTE) {
+        for (size_t i = 0; i < Faces.size(); i++)
+            Mark(Faces[i]);
     }
 
-    return (this->TrianglesAreas);
+    vtkIdList* List = vtkIdList::New();
+    vtkIdType NumberOfVertices, *FaceVertices;
+    for (size_t i = 0; i < Vertices.size(); i++) {
+        vtkIdType Vertex = Vertices[i];
+        if (Vertex >= this->GetNumberOfPoints())
+            continue;
+
+        if (Domain == EDGE_ATTRIBUTE) {
+            this->GetVertexNeighbourEdges(Vertex, List);
+            for (vtkIdType j = 0; j < List->GetNumberOfIds(); j++)
+                Mark(List->GetId(j));
+            continue;
+        }
+
+        // a vertex attribute depends on the adjacent faces
+        if (Domain == VERTEX_ATTRIBUTE)
+            Mark(Vertex);
+        this->GetVertexNeighbourFaces(Vertex, List);
+        for (vtkIdType j = 0; j < List->GetNumberOfIds(); j++) {
+            vtkIdType Face = List->GetId(j);
+            if (Domain == FACE_ATTRIBUTE) {
+                Mark(Face);
+                continue;
+            }
+            this->GetFaceVertices(Face, NumberOfVertices, FaceVertices);
+            for (vtkIdType k = 0; k < NumberOfVertices; k++)
+                Mark(FaceVertices[k]);
+        }
+    }
+    List->Delete();
+    return (true);
 }
 
-vtkDoubleArray* vtkSurface::GetTrianglesNormals()
+template <class ArrayType, class ComputeType>
+void vtkSurface::UpdateAttribute(
+    ArrayType* Array,
+    AttributeState& State,
+    int Domain,
+    ComputeType& Compute,
+    int NumberOfThreads)
 {
-    int i;
-    vtkIdType v1, v2, v3;
-    double P1[3], P2[3], P3[3], N[3];
+    vtkIdType NumberOfElements = this->GetNumberOfElements(Domain);
+    vtkIdType OldNumberOfElements = Array->GetNumberOfTuples();
+    if (OldNumberOfElements > NumberOfElements)
+        OldNumberOfElements = NumberOfElements;
+
+    std::vector<vtkIdType> Ids;
+    bool Partial =
+        this->GetDirtyElements(State, Domain, OldNumberOfElements, Ids);
+
+    // a clean attribute is returned as it is, without touching the array or
+    // the state
+    if (Partial && Ids.empty() &&
+        (Array->GetNumberOfTuples() == NumberOfElements))
+        return;
+
+    Array->SetNumberOfTuples(NumberOfElements);
+
+    auto ComputeElements = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        vtkIdList* List = vtkIdList::New();
+        auto* Values = Array->GetPointer(0);
+        for (vtkIdType i = Begin; i < End; i++)
+            Compute(Values, Partial ? Ids[i] : i, List);
+        List->Delete();
+    };
+    vtkParallelFor::Execute(
+        Partial ? (vtkIdType)Ids.size() : NumberOfElements, ComputeElements,
+        NumberOfThreads);
+
+    if (!Partial || Ids.size())
+        Array->Modified();
+    State.UpdateTime.Modified();
+    State.LogPosition = this->GetModificationsLogEnd();
+}
 
-    if (this->TrianglesNormals)
-        return (this->TrianglesNormals);
+void vtkSurface::UpdateModificationsLog()
+{
+    this->SetModificationsLog(
+        this->SharpVertices || this->VerticesAreas || this->TrianglesAreas ||
+        this->TrianglesNormals || this->EdgeLengths);
+}
 
-    this->TrianglesNormals = vtkDoubleArray::New();
-    this->TrianglesNormals->SetNumberOfComponents(3);
-    this->TrianglesNormals->SetNumberOfTuples(this->GetNumberOfCells());
+// Compute the Edges Lenghts
+vtkDoubleArray* vtkSurface::GetEdgeLengths(int NumberOfThreads)
+{
+    if (!this->EdgeLengths) {
+        this->EdgeLengths = vtkDoubleArray::New();
+        this->UpdateModificationsLog();
+    }
 
-    for (i = 0; i < this->GetNumberOfCells(); i++) {
+    auto ComputeLength = [this](double* Lengths, vtkIdType Edge, vtkIdList*) {
+        vtkIdType v1, v2;
+        this->GetEdgeVertices(Edge, v1, v2);
+        Lengths[Edge] = this->GetDistanceBetweenVertices(v1, v2);
+    };
+    this->UpdateAttribute(
+        this->EdgeLengths, this->EdgeLengthsState, EDGE_ATTRIBUTE,
+        ComputeLength, NumberOfThreads);
+    return (this->EdgeLengths);
+}
 
-        this->GetFaceVertices(i, v1, v2, v3);
-        this->GetPointCoordinates(v1, P1);
-        this->GetPointCoordinates(v2, P2);
-        this->GetPointCoordinates(v3, P3);
-        vtkTriangle::ComputeNormal(P1, P2, P3, N);
-        this->TrianglesNormals->SetTuple(i, N);
+vtkDoubleArray* vtkSurface::GetTrianglesAreas(int NumberOfThreads)
+{
+    if (!this->TrianglesAreas) {
+        this->TrianglesAreas = vtkDoubleArray::New();
+        this->UpdateModificationsLog();
     }
 
+    auto ComputeArea = [this](double* Areas, vtkIdType Face, vtkIdList*) {
+        vtkIdType NumberOfVertices, *Vertices;
+        double P1[3], P2[3], P3[3];
+        this->GetFaceVertices(Face, NumberOfVertices, Vertices);
+        this->GetPointCoordinates(Vertices[0], P1);
+        this->GetPointCoordinates(Vertices[1], P2);
+        this->GetPointCoordinates(Vertices[2], P3);
+        double a, b, c;
+        a = vtkMath::Distance2BetweenPoints(P1, P2);
+        b = vtkMath::Distance2BetweenPoints(P2, P3);
+        c = vtkMath::Distance2BetweenPoints(P3, P1);
+        Areas[Face] =
+            0.25 * sqrt(fabs((double)4.0 * a * c - (a - b + c) * (a - b + c)));
+    };
+    this->UpdateAttribute(
+        this->TrianglesAreas, this->TrianglesAreasState, FACE_ATTRIBUTE,
+        ComputeArea, NumberOfThreads);
+    return (this->TrianglesAreas);
+}
+
+vtkDoubleArray* vtkSurface::GetTrianglesNormals(int NumberOfThreads)
+{
+    if (!this->TrianglesNormals) {
+        this->TrianglesNormals = vtkDoubleArray::New();
+        this->TrianglesNormals->SetNumberOfComponents(3);
+        this->UpdateModificationsLog();
+    }
+
+    auto ComputeNormal = [this](double* Normals, vtkIdType Face, vtkIdList*) {
+        vtkIdType NumberOfVertices, *Vertices;
+        double P1[3], P2[3], P3[3];
+        this->GetFaceVertices(Face, NumberOfVertices, Vertices);
+        this->GetPointCoordinates(Vertices[0], P1);
+        this->GetPointCoordinates(Vertices[1], P2);
+        this->GetPointCoordinates(Vertices[2], P3);
+        vtkTriangle::ComputeNormal(P1, P2, P3, Normals + 3 * Face);
+    };
+    this->UpdateAttribute(
+        this->TrianglesNormals, this->TrianglesNormalsState, FACE_ATTRIBUTE,
+        ComputeNormal, NumberOfThreads);
     return (this->TrianglesNormals);
 }
 
@@ -1086,21 +1598,29 @@ double vtkSurface::GetVertexArea(vtkIdType Vertex)
     return (Area);
 }
 
-vtkDoubleArray* vtkSurface::GetVerticesAreas()
+vtkDoubleArray* vtkSurface::GetVerticesAreas(int NumberOfThreads)
 {
-
-    if (this->VerticesAreas)
-        return (this->VerticesAreas);
-
-    this->VerticesAreas = vtkDoubleArray::New();
-    this->VerticesAreas->SetNumberOfValues(this->GetNumberOfPoints());
-
-    vtkIdType i;
-
-    for (i = 0; i < this->GetNumberOfPoints(); i++) {
-        this->VerticesAreas->SetValue(i, this->GetVertexArea(i));
+    if (!this->VerticesAreas) {
+        this->VerticesAreas = vtkDoubleArray::New();
+        this->UpdateModificationsLog();
     }
 
+    auto ComputeArea = [this](
+                           double* Areas, vtkIdType Vertex, vtkIdList* FList) {
+        vtkIdType NumberOfVertices, *Vertices;
+        double Area = 0;
+        this->GetVertexNeighbourFaces(Vertex, FList);
+        for (vtkIdType i = 0; i < FList->GetNumberOfIds(); i++) {
+            vtkIdType Face = FList->GetId(i);
+            this->GetFaceVertices(Face, NumberOfVertices, Vertices);
+            Area += vtkFaceQuantities::ComputeArea(this, Face) /
+                (double)NumberOfVertices;
+        }
+        Areas[Vertex] = Area;
+    };
+    this->UpdateAttribute(
+        this->VerticesAreas, this->VerticesAreasState, VERTEX_ATTRIBUTE,
+        ComputeArea, NumberOfThreads);
     return (this->VerticesAreas);
 }
 
@@ -1304,99 +1824,48 @@ vtkPolyData* vtkSurface::GetVerticesPolyData()
 
 // ****************************************************************
 // ****************************************************************
-void vtkSurface::ComputeSharpVertices(double treshold)
+void vtkSurface::ComputeSharpVertices(double treshold, int NumberOfThreads)
 {
+    vtkDoubleArray* FacesNormals = this->GetTrianglesNormals(NumberOfThreads);
 
-    // test first
-    if (this->SharpVertices)
-        return;
-
-    double p1[3];
-    double p2[3];
-    double p3[3];
-    double v1[3];
-    double v2[3];
-    double v3[3];
-    double n;
-
-    vtkIdType i;
-    vtkIdType s1;
-    vtkIdType s2;
-    vtkIdType s3;
-    vtkIdType f1;
-    vtkIdType f2;
-    vtkIdType j;
-    bool ok;
-
-    vtkPoints* points = this->GetPoints();
-
-    vtkDoubleArray* FacesNormals = vtkDoubleArray::New();
-    FacesNormals->SetNumberOfComponents(3);
-    FacesNormals->SetNumberOfTuples(this->GetNumberOfCells());
-
-    for (i = 0; i < this->GetNumberOfCells(); i++) {
-        this->GetFaceVertices(i, s1, s2, s3);
-        points->GetPoint(s1, p1);
-        points->GetPoint(s2, p2);
-        points->GetPoint(s3, p3);
-
-        for (j = 0; j < 3; j++) {
-            v1[j] = p2[j] - p1[j];
-            v2[j] = p3[j] - p1[j];
-        }
-
-        v3[0] = v1[1] * v2[2] - v1[2] * v2[1];
-        v3[1] = v1[2] * v2[0] - v1[0] * v2[2];
-        v3[2] = v1[0] * v2[1] - v1[1] * v2[0];
-
-        n = 1.0 / sqrt(v3[0] * v3[0] + v3[1] * v3[1] + v3[2] * v3[2]);
-
-        v3[0] *= n;
-        v3[1] *= n;
-        v3[2] *= n;
-
-        FacesNormals->SetTuple(i, v3);
+    if (!this->SharpVertices) {
+        this->SharpVertices = vtkIntArray::New();
+        this->UpdateModificationsLog();
+    }
+    if (treshold != this->SharpVerticesTreshold) {
+        this->SharpVerticesState.LogPosition = -1;
+        this->SharpVerticesTreshold = treshold;
     }
 
-    this->SharpVertices = vtkIntArray::New();
-    this->SharpVertices->SetNumberOfValues(this->GetNumberOfPoints());
-
-    vtkIdList* vlist = vtkIdList::New();
-
-    for (i = 0; i < this->GetNumberOfPoints(); i++) {
-        ok = 0;
-        this->GetVertexNeighbourEdges(i, vlist);
-        for (j = 0; j < vlist->GetNumberOfIds(); j++) {
-            this->GetEdgeFaces(vlist->GetId(j), f1, f2);
-            if (f2 >= 0) {
-                FacesNormals->GetTuple(f1, v1);
-                FacesNormals->GetTuple(f2, v2);
-
-                v3[0] = v1[1] * v2[2] - v1[2] * v2[1];
-                v3[1] = v1[2] * v2[0] - v1[0] * v2[2];
-                v3[2] = v1[0] * v2[1] - v1[1] * v2[0];
-
-                n = sqrt(v3[0] * v3[0] + v3[1] * v3[1] + v3[2] * v3[2]);
-
-                if (n > treshold) {
-                    j = 10000;
-                    ok = 1;
-                }
-
-            } else {
-                j = 10000;
-                ok = 1;
+    auto ComputeSharp = [&](int* Sharp, vtkIdType Vertex, vtkIdList* EList) {
+        double* Normals = FacesNormals->GetPointer(0);
+        double Cross[3];
+        vtkIdType f1, f2;
+        int IsSharp = 0;
+        this->GetVertexNeighbourEdges(Vertex, EList);
+        for (vtkIdType j = 0; j < EList->GetNumberOfIds(); j++) {
+            this->GetEdgeFaces(EList->GetId(j), f1, f2);
+            if (f2 < 0) {
+                IsSharp = 1;
+                break;
+            }
+            vtkMath::Cross(Normals + 3 * f1, Normals + 3 * f2, Cross);
+            if (vtkMath::Norm(Cross) > treshold) {
+                IsSharp = 1;
+                break;
             }
         }
-        this->SharpVertices->SetValue(i, ok);
+        Sharp[Vertex] = IsSharp;
+    };
+    this->UpdateAttribute(
+        this->SharpVertices, this->SharpVerticesState, VERTEX_ATTRIBUTE,
+        ComputeSharp, NumberOfThreads);
+
+    if (this->GetPointData()->GetScalars() != this->SharpVertices) {
+        if (this->GetPointData()->GetScalars() != NULL)
+            this->GetPointData()->GetScalars()->Delete();
+        this->GetPointData()->SetScalars(this->SharpVertices);
     }
-
-    if (this->GetPointData()->GetScalars() != NULL)
-        this->GetPointData()->GetScalars()->Delete();
-    this->GetPointData()->SetScalars(this->SharpVertices);
-
-    FacesNormals->Delete();
-    vlist->Delete();
 }
 // ****************************************************************
 
@@ -1406,6 +1875,8 @@ void vtkSurface::DeleteSharpVertices()
         this->SharpVertices->Delete();
         this->SharpVertices = 0;
         this->GetPointData()->SetScalars(0);
+        this->SharpVerticesState.LogPosition = -1;
+        this->UpdateModificationsLog();
     }
 };
 
@@ -1414,6 +1885,8 @@ void vtkSurface::DeleteVerticesAreas()
     if (this->VerticesAreas) {
         this->VerticesAreas->Delete();
         this->VerticesAreas = 0;
+        this->VerticesAreasState.LogPosition = -1;
+        this->UpdateModificationsLog();
     }
 };
 void vtkSurface::DeleteEdgeLengths()
@@ -1421,6 +1894,8 @@ void vtkSurface::DeleteEdgeLengths()
     if (this->EdgeLengths) {
         this->EdgeLengths->Delete();
         this->EdgeLengths = 0;
+        this->EdgeLengthsState.LogPosition = -1;
+        this->UpdateModificationsLog();
     }
 };
 void vtkSurface::DeleteTrianglesAreas()
@@ -1428,6 +1903,8 @@ void vtkSurface::DeleteTrianglesAreas()
     if (this->TrianglesAreas) {
         this->TrianglesAreas->Delete();
         this->TrianglesAreas = 0;
+        this->TrianglesAreasState.LogPosition = -1;
+        this->UpdateModificationsLog();
     }
 };
 void vtkSurface::DeleteTrianglesNormals()
@@ -1435,6 +1912,8 @@ void vtkSurface::DeleteTrianglesNormals()
     if (this->TrianglesNormals) {
         this->TrianglesNormals->Delete();
         this->TrianglesNormals = 0;
+        this->TrianglesNormalsState.LogPosition = -1;
+        this->UpdateModificationsLog();
     }
 };
 
@@ -1591,6 +2070,13 @@ vtkSurface::vtkSurface() : vtkSurfaceBase()
 
     this->EdgeLengths = 0;
     this->ConnectedComponents = 0;
+
+    this->SharpVerticesState.LogPosition = -1;
+    this->VerticesAreasState.LogPosition = -1;
+    this->TrianglesAreasState.LogPosition = -1;
+    this->TrianglesNormalsState.LogPosition = -1;
+    this->EdgeLengthsState.LogPosition = -1;
+    this->SharpVerticesTreshold = 0;
 }
 
 // ****************************************************************
@@ -20,14 +20,20 @@
 *  knowledge of the CeCILL-B license and that you accept its terms.
 * ------------------------------------------------------------------------ */
 
+#include <algorithm>
 #include <stack>
+#include <vector>
 #include <assert.h>
 #include <vtkCellArray.h>
 #include <vtkCellData.h>
+#include <vtkCellTypes.h>
 #include <vtkIdListCollection.h>
 #include <vtkMath.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkUnsignedCharArray.h>
 
+#include "vtkParallelFor.h"
 #include "vtkSurfaceBase.h"
 
 int vtkSurfaceBase::GetEdgeNumberOfAdjacentFaces(vtkIdType Edge)
@@ -116,7 +122,9 @@ void vtkSurfaceBase::ChangeFaceVertex(
     Neighbours[0] = Vertices[(Index + 1) % NumberOfVertices];
     Neighbours[1] = Vertices[(Index + NumberOfVertices - 1) % NumberOfVertices];
 
+    this->LogFace(Face);
     Vertices[Index] = NewVertex;
+    this->LogVertex(NewVertex);
 
     for (int i = 0; i < 2; i++) {
         vtkIdType Edge = this->IsEdge(OldVertex, Neighbours[i]);
@@ -243,6 +251,9 @@ void vtkSurfaceBase::SwitchOrientation()
 
     this->CheckNormals();
     delete[] Vertices2;
+
+    // all the faces are flipped : the cached attributes are recomputed
+    this->Modified();
 }
 
 void vtkSurfaceBase::SQueeze()
@@ -361,6 +372,7 @@ void vtkSurfaceBase::ConquerOrientationFromFace(vtkIdType Face)
                         Face2[j] = Face2[NumberOfPoints2 - 1 - j];
                         Face2[NumberOfPoints2 - 1 - j] = v1;
                     }
+                    this->LogFace(f2);
                 }
 
                 this->VisitedPolygons->SetValue(f2, 1);
@@ -524,6 +536,7 @@ void vtkSurfaceBase::DeleteFace(vtkIdType f1)
     // test whether the face was already deleted
     if (this->IsFaceActive(f1) == 0)
         return;
+    this->LogFace(f1);
 
     vtkIdType NumberOfPoints, *Points, Loc;
     Loc = this->Cells->GetCellLocation(f1);
@@ -532,6 +545,9 @@ void vtkSurfaceBase::DeleteFace(vtkIdType f1)
 
     this->Polys->GetCell(Loc, NumberOfPoints, Points);
     for (i = 0; i < NumberOfPoints; i++) {
+        // degenerate faces have no edge between repeated vertices
+        if (Points[i] == Points[(i + 1) % NumberOfPoints])
+            continue;
         Edge = this->IsEdge(Points[i], Points[(i + 1) % NumberOfPoints]);
         this->DeleteFaceInRing(f1, Edge);
         this->CleanEdge(Edge);
@@ -544,6 +560,147 @@ void vtkSurfaceBase::DeleteFace(vtkIdType f1)
     this->CellsGarbage[NumberOfPoints].push(f1);
     this->ActivePolygons->SetValue(f1, 0);
 }
+// returns true if the two faces have the same vertices
+static bool HaveSameVertices(
+    vtkIdType NumberOfVertices1,
+    vtkIdType* Vertices1,
+    vtkIdType NumberOfVertices2,
+    vtkIdType* Vertices2)
+{
+    if (NumberOfVertices1 != NumberOfVertices2)
+        return (false);
+    for (vtkIdType i = 0; i < NumberOfVertices1; i++) {
+        vtkIdType j = 0;
+        while ((j < NumberOfVertices2) && (Vertices2[j] != Vertices1[i]))
+            j++;
+        if (j == NumberOfVertices2)
+            return (false);
+    }
+    return (true);
+}
+
+int vtkSurfaceBase::RepairTopology()
+{
+    int NumberOfDeletedFaces = 0;
+    vtkIdType NumberOfVertices, *Vertices;
+    vtkIdType NumberOfVertices2, *Vertices2;
+    vtkIdList* FList = vtkIdList::New();
+
+    // degenerate faces, with repeated vertices
+    for (vtkIdType Face = 0; Face < this->GetNumberOfCells(); Face++) {
+        if (!this->IsFaceActive(Face))
+            continue;
+        this->GetFaceVertices(Face, NumberOfVertices, Vertices);
+        bool Degenerate = NumberOfVertices < 3;
+        for (vtkIdType i = 0; i < NumberOfVertices; i++) {
+            for (vtkIdType j = i + 1; j < NumberOfVertices; j++) {
+                if (Vertices[i] == Vertices[j])
+                    Degenerate = true;
+            }
+        }
+        if (Degenerate) {
+            this->DeleteFace(Face);
+            NumberOfDeletedFaces++;
+        }
+    }
+
+    // duplicated faces : the faces sharing the first edge of a face are
+    // compared to it, and the face with the highest Id is deleted
+    for (vtkIdType Face = 0; Face < this->GetNumberOfCells(); Face++) {
+        if (!this->IsFaceActive(Face))
+            continue;
+        this->GetFaceVertices(Face, NumberOfVertices, Vertices);
+        this->GetEdgeFaces(this->IsEdge(Vertices[0], Vertices[1]), FList);
+        for (vtkIdType i = 0; i < FList->GetNumberOfIds(); i++) {
+            vtkIdType Other = FList->GetId(i);
+            if (Other >= Face)
+                continue;
+            this->GetFaceVertices(Other, NumberOfVertices2, Vertices2);
+            if (HaveSameVertices(
+                    NumberOfVertices, Vertices, NumberOfVertices2, Vertices2)) {
+                this->DeleteFace(Face);
+                NumberOfDeletedFaces++;
+                break;
+            }
+        }
+    }
+
+    // non-manifold edges : only the two adjacent faces with the smallest Ids
+    // are kept
+    for (vtkIdType Edge = 0; Edge < this->NumberOfEdges; Edge++) {
+        if (!this->IsEdgeActive(Edge) || !this->EdgesNonManifoldFaces[Edge])
+            continue;
+        this->GetEdgeFaces(Edge, FList);
+        FList->Sort();
+        for (vtkIdType i = 2; i < FList->GetNumberOfIds(); i++) {
+            this->DeleteFace(FList->GetId(i));
+            NumberOfDeletedFaces++;
+        }
+    }
+
+    FList->Delete();
+    if (NumberOfDeletedFaces)
+        this->Modified();
+    return (NumberOfDeletedFaces);
+}
+
+void vtkSurfaceBase::SetModificationsLog(bool Enable)
+{
+    if (!Enable) {
+        this->ModificationsLogStart += this->ModificationsLog.size();
+        this->ModificationsLog.clear();
+        this->ModificationsLog.shrink_to_fit();
+    }
+    this->ModificationsLogEnabled = Enable;
+}
+
+bool vtkSurfaceBase::GetModifications(
+    vtkIdType Start,
+    std::vector<vtkIdType>& Vertices,
+    std::vector<vtkIdType>& Faces)
+{
+    if (!this->ModificationsLogEnabled || (Start < this->ModificationsLogStart))
+        return (false);
+
+    for (vtkIdType i = Start - this->ModificationsLogStart;
+         i < (vtkIdType)this->ModificationsLog.size();
+         i++) {
+        vtkIdType Entry = this->ModificationsLog[i];
+        if (Entry % 2)
+            Faces.push_back(Entry / 2);
+        else
+            Vertices.push_back(Entry / 2);
+    }
+    return (true);
+}
+
+void vtkSurfaceBase::LogFace(vtkIdType Face)
+{
+    if (!this->ModificationsLogEnabled)
+        return;
+
+    vtkIdType NumberOfVertices, *Vertices;
+    this->GetFaceVertices(Face, NumberOfVertices, Vertices);
+    this->AppendToLog(2 * Face + 1);
+    for (vtkIdType i = 0; i < NumberOfVertices; i++)
+        this->AppendToLog(2 * Vertices[i]);
+}
+
+void vtkSurfaceBase::AppendToLog(vtkIdType Entry)
+{
+    // beyond this size, updating the modified elements only is not worth it:
+    // the log is emptied, and everything will be recomputed
+    size_t MaximumSize =
+        (this->GetNumberOfPoints() + this->GetNumberOfCells()) / 8;
+    if (MaximumSize < 1024)
+        MaximumSize = 1024;
+    if (this->ModificationsLog.size() >= MaximumSize) {
+        this->ModificationsLogStart += this->ModificationsLog.size();
+        this->ModificationsLog.clear();
+    }
+    this->ModificationsLog.push_back(Entry);
+}
+
 void vtkSurfaceBase::CleanEdge(vtkIdType Edge)
 {
     if (this->CleanEdges == 0)
@@ -1125,6 +1282,7 @@ vtkIdType vtkSurfaceBase::AddVertex(double x, double y, double z)
         }
         this->VerticesAttributes[v1][VERTEX_NUMBER_OF_EDGES] = 0;
         this->ActiveVertices->SetValue(v1, 1);
+        this->LogVertex(v1);
         return (v1);
     } else {
         v1 = this->VerticesGarbage.front();
@@ -1132,6 +1290,7 @@ vtkIdType vtkSurfaceBase::AddVertex(double x, double y, double z)
         this->VerticesAttributes[v1][VERTEX_NUMBER_OF_EDGES] = 0;
         this->GetPoints()->SetPoint(v1, x, y, z);
         this->ActiveVertices->SetValue(v1, 1);
+        this->LogVertex(v1);
         return (v1);
     }
 }
@@ -1188,6 +1347,12 @@ vtkIdType vtkSurfaceBase::AddEdge(vtkIdType v1, vtkIdType v2, vtkIdType f1)
 
     this->InsertEdgeInRing(edge, v1);
     this->InsertEdgeInRing(edge, v2);
+
+    // edges created with a face are logged with it
+    if (f1 < 0) {
+        this->LogVertex(v1);
+        this->LogVertex(v2);
+    }
     return (edge);
 }
 
@@ -1271,6 +1436,7 @@ vtkIdType vtkSurfaceBase::AddPolygon(int NumberOfVertices, vtkIdType* Vertices)
     if (this->OrientedSurface) {
         this->ConquerOrientationFromFace(face);
     }
+    this->LogFace(face);
     return (face);
 }
 
@@ -1402,6 +1568,16 @@ void vtkSurfaceBase::Init(int numPoints, int numFaces, int numEdges)
     this->AllocatePolygonsAttributes(numFaces);
 }
 
+// sets the vertices of a triangle in a legacy cell array
+static void SetTriangleCell(
+    vtkIdType* Cell, vtkIdType v1, vtkIdType v2, vtkIdType v3)
+{
+    Cell[0] = 3;
+    Cell[1] = v1;
+    Cell[2] = v2;
+    Cell[3] = v3;
+}
+
 // ****************************************************************
 // ****************************************************************
 // fonction CreateFromPolyData
@@ -1410,9 +1586,6 @@ void vtkSurfaceBase::Init(int numPoints, int numFaces, int numEdges)
 // et cree le tableau d'arretes
 void vtkSurfaceBase::CreateFromPolyData(vtkPolyData* input)
 {
-    vtkIdType i, j, v1, v2;
-    vtkIdType NumberOfVertices, *Vertices;
-
     // just copy the polydata in input
     this->ShallowCopy(input);
 
@@ -1429,6 +1602,70 @@ void vtkSurfaceBase::CreateFromPolyData(vtkPolyData* input)
         this->BuildCells();
     }
 
+    this->BuildTopology();
+}
+
+template <class IdType>
+void vtkSurfaceBase::SetTriangles(
+    const IdType* Triangles, vtkIdType NumberOfTriangles, int NumberOfThreads)
+{
+    vtkIdTypeArray* Connectivity = vtkIdTypeArray::New();
+    Connectivity->SetNumberOfValues(4 * NumberOfTriangles);
+    vtkUnsignedCharArray* Types = vtkUnsignedCharArray::New();
+    Types->SetNumberOfValues(NumberOfTriangles);
+    vtkIdTypeArray* Locations = vtkIdTypeArray::New();
+    Locations->SetNumberOfValues(NumberOfTriangles);
+
+    auto CopyTriangles = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        vtkIdType* Cells = Connectivity->GetPointer(0);
+        unsigned char* CellsTypes = Types->GetPointer(0);
+        vtkIdType* CellsLocations = Locations->GetPointer(0);
+        for (vtkIdType Face = Begin; Face < End; Face++) {
+            SetTriangleCell(
+                Cells + 4 * Face, Triangles[3 * Face],
+                Triangles[3 * Face + 1], Triangles[3 * Face + 2]);
+            CellsTypes[Face] = VTK_TRIANGLE;
+            CellsLocations[Face] = 4 * Face;
+        }
+    };
+    vtkParallelFor::Execute(NumberOfTriangles, CopyTriangles, NumberOfThreads);
+
+    vtkCellArray* Polys = vtkCellArray::New();
+    Polys->SetCells(NumberOfTriangles, Connectivity);
+    this->SetPolys(Polys);
+    Polys->Delete();
+    this->Cells->SetCellTypes(NumberOfTriangles, Types, Locations);
+    Connectivity->Delete();
+    Types->Delete();
+    Locations->Delete();
+}
+
+void vtkSurfaceBase::CreateFromTriangles(
+    vtkPoints* Points,
+    const vtkIdType* Triangles,
+    vtkIdType NumberOfTriangles,
+    int NumberOfThreads)
+{
+    this->SetPoints(Points);
+    this->SetTriangles(Triangles, NumberOfTriangles, NumberOfThreads);
+    this->BuildTopology();
+}
+
+void vtkSurfaceBase::CreateFromTriangles(
+    vtkPoints* Points,
+    const int* Triangles,
+    vtkIdType NumberOfTriangles,
+    int NumberOfThreads)
+{
+    this->SetPoints(Points);
+    this->SetTriangles(Triangles, NumberOfTriangles, NumberOfThreads);
+    this->BuildTopology();
+}
+
+void vtkSurfaceBase::BuildTopology()
+{
+    vtkIdType i, j, v1, v2;
+    vtkIdType NumberOfVertices, *Vertices;
     vtkIdType numPoints = this->GetNumberOfPoints();
     vtkIdType numFaces = this->GetNumberOfCells();
 
@@ -1465,6 +1702,520 @@ void vtkSurfaceBase::CreateFromPolyData(vtkPolyData* input)
     }
 }
 
+// returns the ring of a vertex, reallocated if it has less than
+// NumberOfEdges slots
+static vtkIdType* ReserveRing(vtkIdType*& Ring, vtkIdType NumberOfEdges)
+{
+    if (Ring[VERTEX_NUMBER_OF_EDGES_SLOTS] < NumberOfEdges) {
+        delete[] Ring;
+        Ring = new vtkIdType[VERTEX_EDGES + NumberOfEdges];
+        Ring[VERTEX_NUMBER_OF_EDGES_SLOTS] = NumberOfEdges;
+    }
+    Ring[VERTEX_NUMBER_OF_EDGES] = NumberOfEdges;
+    return (Ring + VERTEX_EDGES);
+}
+
+void vtkSurfaceBase::CreateFromSubdivision(
+    vtkSurfaceBase* Input,
+    vtkIntArray* Parent1,
+    vtkIntArray* Parent2,
+    int NumberOfThreads)
+{
+    vtkIdType NumberOfInputPoints = Input->GetNumberOfPoints();
+    vtkIdType NumberOfInputEdges = Input->GetNumberOfEdges();
+    vtkIdType NumberOfInputFaces = Input->GetNumberOfCells();
+
+    // compact indices of the active input edges and faces. The midpoint of
+    // the edge of index k is the vertex NumberOfInputPoints + k, and the
+    // children of the face of index k are the faces 4k to 4k + 3
+    std::vector<vtkIdType> EdgesIndices(NumberOfInputEdges, -1);
+    std::vector<vtkIdType> FacesIndices(NumberOfInputFaces, -1);
+    vtkIdType NumberOfMidPoints = 0;
+    vtkIdType NumberOfParentFaces = 0;
+    for (vtkIdType Edge = 0; Edge < NumberOfInputEdges; Edge++) {
+        if (Input->IsEdgeActive(Edge))
+            EdgesIndices[Edge] = NumberOfMidPoints++;
+    }
+    for (vtkIdType Face = 0; Face < NumberOfInputFaces; Face++) {
+        if (Input->IsFaceActive(Face))
+            FacesIndices[Face] = NumberOfParentFaces++;
+    }
+
+    // the active faces of each input edge, by increasing Id, which is the
+    // order in which the former AddFace() sequence reached them
+    std::vector<std::vector<vtkIdType>> EdgesFaces(NumberOfInputEdges);
+    auto SortEdgesFaces = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        vtkIdList* FList = vtkIdList::New();
+        for (vtkIdType Edge = Begin; Edge < End; Edge++) {
+            if (EdgesIndices[Edge] < 0)
+                continue;
+            Input->GetEdgeFaces(Edge, FList);
+            std::vector<vtkIdType>& Faces = EdgesFaces[Edge];
+            for (vtkIdType i = 0; i < FList->GetNumberOfIds(); i++) {
+                vtkIdType Face = FList->GetId(i);
+                if ((Face >= 0) && (FacesIndices[Face] >= 0))
+                    Faces.push_back(Face);
+            }
+            std::sort(Faces.begin(), Faces.end());
+        }
+        FList->Delete();
+    };
+    vtkParallelFor::Execute(
+        NumberOfInputEdges, SortEdgesFaces, NumberOfThreads);
+
+    // the input edges of each parent face. The children of an input edge
+    // are created by its first face, so that the face of index k creates
+    // its three inner edges and the children of the edges it reaches first,
+    // starting at the edge FacesFirstEdges[k]
+    std::vector<vtkIdType> FacesEdges(3 * NumberOfParentFaces);
+    std::vector<vtkIdType> FacesFirstEdges(NumberOfParentFaces + 1);
+    auto CountEdges = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        vtkIdType NumberOfVertices, *Vertices;
+        for (vtkIdType Face = Begin; Face < End; Face++) {
+            vtkIdType Index = FacesIndices[Face];
+            if (Index < 0)
+                continue;
+            Input->GetFaceVertices(Face, NumberOfVertices, Vertices);
+            vtkIdType* Edges = &FacesEdges[3 * Index];
+            vtkIdType NumberOfNewEdges = 3;
+            for (int j = 0; j < 3; j++) {
+                Edges[j] = Input->IsEdge(Vertices[j], Vertices[(j + 1) % 3]);
+                if (EdgesFaces[Edges[j]][0] == Face)
+                    NumberOfNewEdges += 2;
+            }
+            FacesFirstEdges[Index + 1] = NumberOfNewEdges;
+        }
+    };
+    vtkParallelFor::Execute(NumberOfInputFaces, CountEdges, NumberOfThreads);
+    FacesFirstEdges[0] = 0;
+    for (vtkIdType Index = 0; Index < NumberOfParentFaces; Index++)
+        FacesFirstEdges[Index + 1] += FacesFirstEdges[Index];
+
+    vtkIdType NumberOfPoints = NumberOfInputPoints + NumberOfMidPoints;
+    vtkIdType NumberOfFaces = 4 * NumberOfParentFaces;
+    vtkIdType NumberOfEdges = FacesFirstEdges[NumberOfParentFaces];
+
+    this->Init(NumberOfPoints, NumberOfFaces, NumberOfEdges);
+    this->GetPoints()->SetNumberOfPoints(NumberOfPoints);
+    this->NumberOfEdges = NumberOfEdges;
+    this->FirstTime = false;
+
+    if (Parent1) {
+        Parent1->Resize(NumberOfInputPoints + NumberOfInputEdges);
+        Parent2->Resize(NumberOfInputPoints + NumberOfInputEdges);
+    }
+
+    vtkIdType* EdgesVertex1 = this->Vertex1->GetPointer(0);
+    vtkIdType* EdgesVertex2 = this->Vertex2->GetPointer(0);
+    vtkIdType* EdgesPoly1 = this->Poly1->GetPointer(0);
+    vtkIdType* EdgesPoly2 = this->Poly2->GetPointer(0);
+
+    vtkIdTypeArray* Connectivity = vtkIdTypeArray::New();
+    Connectivity->SetNumberOfValues(4 * NumberOfFaces);
+    vtkUnsignedCharArray* Types = vtkUnsignedCharArray::New();
+    Types->SetNumberOfValues(NumberOfFaces);
+    vtkIdTypeArray* Locations = vtkIdTypeArray::New();
+    Locations->SetNumberOfValues(NumberOfFaces);
+
+    // the children of each input edge : the one containing its first vertex,
+    // then the one containing its second vertex
+    std::vector<vtkIdType> EdgesChildren(2 * NumberOfInputEdges, -1);
+
+    // the inner edges of each parent face. The inner edge j separates the
+    // central face from the child face j
+    std::vector<vtkIdType> FacesInnerEdges(3 * NumberOfParentFaces);
+
+    auto CopyPoints = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        double P[3];
+        for (vtkIdType Vertex = Begin; Vertex < End; Vertex++) {
+            Input->GetPoint(Vertex, P);
+            this->Points->SetPoint(Vertex, P);
+        }
+    };
+    vtkParallelFor::Execute(NumberOfInputPoints, CopyPoints, NumberOfThreads);
+
+    // children faces and new edges, in the order of the former AddFace()
+    // sequence : the child faces (V1, M1, M3), (M1, V2, M2), (M2, V3, M3)
+    // and (M1, M2, M3), where Mj is the midpoint of the edge (Vj, Vj+1)
+    auto SplitFaces = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        vtkIdType NumberOfVertices, *Vertices, MidPoints[3];
+        vtkIdType* Cells = Connectivity->GetPointer(0);
+        unsigned char* CellsTypes = Types->GetPointer(0);
+        vtkIdType* CellsLocations = Locations->GetPointer(0);
+        for (vtkIdType Face = Begin; Face < End; Face++) {
+            vtkIdType Index = FacesIndices[Face];
+            if (Index < 0)
+                continue;
+            Input->GetFaceVertices(Face, NumberOfVertices, Vertices);
+            vtkIdType* Edges = &FacesEdges[3 * Index];
+            for (int j = 0; j < 3; j++)
+                MidPoints[j] = NumberOfInputPoints + EdgesIndices[Edges[j]];
+
+            vtkIdType* Cell = Cells + 16 * Index;
+            SetTriangleCell(Cell, Vertices[0], MidPoints[0], MidPoints[2]);
+            SetTriangleCell(Cell + 4, MidPoints[0], Vertices[1], MidPoints[1]);
+            SetTriangleCell(Cell + 8, MidPoints[1], Vertices[2], MidPoints[2]);
+            SetTriangleCell(
+                Cell + 12, MidPoints[0], MidPoints[1], MidPoints[2]);
+            for (int j = 0; j < 4; j++) {
+                CellsTypes[4 * Index + j] = VTK_TRIANGLE;
+                CellsLocations[4 * Index + j] = 16 * Index + 4 * j;
+            }
+
+            // the edges of the first three child faces, in the order of
+            // AddFace(). Each one is given by its vertices, its child face,
+            // and the input edge it halves (-1 : inner edge) and the input
+            // vertex it contains
+            const vtkIdType NewEdges[9][5] = {
+                {Vertices[0], MidPoints[0], 0, Edges[0], Vertices[0]},
+                {MidPoints[0], MidPoints[2], 0, -1, 0},
+                {MidPoints[2], Vertices[0], 0, Edges[2], Vertices[0]},
+                {MidPoints[0], Vertices[1], 1, Edges[0], Vertices[1]},
+                {Vertices[1], MidPoints[1], 1, Edges[1], Vertices[1]},
+                {MidPoints[1], MidPoints[0], 1, -1, 1},
+                {MidPoints[1], Vertices[2], 2, Edges[1], Vertices[2]},
+                {Vertices[2], MidPoints[2], 2, Edges[2], Vertices[2]},
+                {MidPoints[2], MidPoints[1], 2, -1, 2}};
+
+            vtkIdType Edge = FacesFirstEdges[Index];
+            for (int j = 0; j < 9; j++) {
+                vtkIdType InputEdge = NewEdges[j][3];
+                if (InputEdge < 0) {
+                    FacesInnerEdges[3 * Index + NewEdges[j][4]] = Edge;
+                    EdgesPoly2[Edge] = 4 * Index + 3;
+                } else {
+                    if (EdgesFaces[InputEdge][0] != Face)
+                        continue;
+                    int Child =
+                        Input->Vertex1->GetValue(InputEdge) == NewEdges[j][4]
+                        ? 0
+                        : 1;
+                    EdgesChildren[2 * InputEdge + Child] = Edge;
+                }
+                EdgesVertex1[Edge] = NewEdges[j][0];
+                EdgesVertex2[Edge] = NewEdges[j][1];
+                EdgesPoly1[Edge] = 4 * Index + NewEdges[j][2];
+                this->EdgesNonManifoldFaces[Edge] = 0;
+                Edge++;
+            }
+        }
+    };
+    vtkParallelFor::Execute(NumberOfInputFaces, SplitFaces, NumberOfThreads);
+
+    // returns the child of the input face which contains the input vertex
+    auto GetChildFace = [&](vtkIdType Face, vtkIdType Vertex) {
+        vtkIdType NumberOfVertices, *Vertices;
+        Input->GetFaceVertices(Face, NumberOfVertices, Vertices);
+        int Corner = 0;
+        while (Vertices[Corner] != Vertex)
+            Corner++;
+        return (4 * FacesIndices[Face] + Corner);
+    };
+
+    // midpoints, second faces of the children edges and rings of the
+    // midpoints. As edges were appended to the rings when created, the
+    // rings are sorted by increasing edge Id
+    auto SplitEdges = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        double P[3], P1[3], P2[3];
+        for (vtkIdType Edge = Begin; Edge < End; Edge++) {
+            vtkIdType Index = EdgesIndices[Edge];
+            if (Index < 0)
+                continue;
+            vtkIdType V1 = Input->Vertex1->GetValue(Edge);
+            vtkIdType V2 = Input->Vertex2->GetValue(Edge);
+            vtkIdType MidPoint = NumberOfInputPoints + Index;
+            Input->GetPoint(V1, P1);
+            Input->GetPoint(V2, P2);
+            for (int j = 0; j < 3; j++)
+                P[j] = 0.5 * (P1[j] + P2[j]);
+            this->Points->SetPoint(MidPoint, P);
+            if (Parent1) {
+                Parent1->SetValue(MidPoint, V1);
+                Parent2->SetValue(MidPoint, V2);
+            }
+
+            // edges without adjacent faces have no children
+            std::vector<vtkIdType>& Faces = EdgesFaces[Edge];
+            vtkIdType NumberOfEdgeFaces = Faces.size();
+            if (NumberOfEdgeFaces == 0) {
+                this->VerticesAttributes[MidPoint][VERTEX_NUMBER_OF_EDGES] = 0;
+                continue;
+            }
+
+            vtkIdType* Children = &EdgesChildren[2 * Edge];
+            EdgesPoly2[Children[0]] =
+                NumberOfEdgeFaces > 1 ? GetChildFace(Faces[1], V1) : -1;
+            EdgesPoly2[Children[1]] =
+                NumberOfEdgeFaces > 1 ? GetChildFace(Faces[1], V2) : -1;
+
+            // the midpoint is adjacent to its two children edges and to two
+            // inner edges of each adjacent face
+            vtkIdType* Ring = ReserveRing(
+                this->VerticesAttributes[MidPoint], 2 + 2 * NumberOfEdgeFaces);
+            Ring[0] = Children[0];
+            Ring[1] = Children[1];
+            for (vtkIdType i = 0; i < NumberOfEdgeFaces; i++) {
+                vtkIdType FaceIndex = FacesIndices[Faces[i]];
+                vtkIdType* Edges = &FacesEdges[3 * FaceIndex];
+                int Position = 0;
+                while (Edges[Position] != Edge)
+                    Position++;
+                vtkIdType* InnerEdges = &FacesInnerEdges[3 * FaceIndex];
+                Ring[2 + 2 * i] = InnerEdges[Position];
+                Ring[3 + 2 * i] = InnerEdges[(Position + 1) % 3];
+            }
+            std::sort(Ring, Ring + 2 + 2 * NumberOfEdgeFaces);
+        }
+    };
+    vtkParallelFor::Execute(NumberOfInputEdges, SplitEdges, NumberOfThreads);
+
+    // the ring of an input vertex contains one child of each input edge
+    auto BuildRings = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        vtkIdType NumberOfVertexEdges, *InputEdges;
+        for (vtkIdType Vertex = Begin; Vertex < End; Vertex++) {
+            Input->GetVertexNeighbourEdges(
+                Vertex, NumberOfVertexEdges, InputEdges);
+            vtkIdType NumberOfRingEdges = 0;
+            for (vtkIdType i = 0; i < NumberOfVertexEdges; i++) {
+                if (EdgesChildren[2 * InputEdges[i]] >= 0)
+                    NumberOfRingEdges++;
+            }
+            vtkIdType* Ring = ReserveRing(
+                this->VerticesAttributes[Vertex], NumberOfRingEdges);
+            vtkIdType* RingEdge = Ring;
+            for (vtkIdType i = 0; i < NumberOfVertexEdges; i++) {
+                vtkIdType Edge = InputEdges[i];
+                if (EdgesChildren[2 * Edge] < 0)
+                    continue;
+                int Child = Input->Vertex1->GetValue(Edge) == Vertex ? 0 : 1;
+                *RingEdge++ = EdgesChildren[2 * Edge + Child];
+            }
+            std::sort(Ring, Ring + NumberOfRingEdges);
+        }
+    };
+    vtkParallelFor::Execute(NumberOfInputPoints, BuildRings, NumberOfThreads);
+
+    vtkCellArray* Polys = vtkCellArray::New();
+    Polys->SetCells(NumberOfFaces, Connectivity);
+    this->SetPolys(Polys);
+    Polys->Delete();
+    this->Cells->SetCellTypes(NumberOfFaces, Types, Locations);
+    Connectivity->Delete();
+    Types->Delete();
+    Locations->Delete();
+
+    // the remaining faces of non-manifold edges, and the flags
+    for (vtkIdType Edge = 0; Edge < NumberOfInputEdges; Edge++) {
+        std::vector<vtkIdType>& Faces = EdgesFaces[Edge];
+        if (Faces.size() < 3)
+            continue;
+        for (int Child = 0; Child < 2; Child++) {
+            vtkIdType Vertex = Child ? Input->Vertex2->GetValue(Edge)
+                                     : Input->Vertex1->GetValue(Edge);
+            vtkIdList* List = vtkIdList::New();
+            for (size_t i = 2; i < Faces.size(); i++)
+                List->InsertNextId(GetChildFace(Faces[i], Vertex));
+            this->EdgesNonManifoldFaces[EdgesChildren[2 * Edge + Child]] =
+                List;
+        }
+    }
+    for (vtkIdType Vertex = 0; Vertex < NumberOfPoints; Vertex++)
+        this->ActiveVertices->SetValue(Vertex, 1);
+    for (vtkIdType Edge = 0; Edge < NumberOfEdges; Edge++)
+        this->ActiveEdges->SetValue(Edge, 1);
+    for (vtkIdType Face = 0; Face < NumberOfFaces; Face++) {
+        this->ActivePolygons->SetValue(Face, 1);
+        this->VisitedPolygons->SetValue(Face, 1);
+    }
+    this->Modified();
+}
+
+// replaces the tuples of Data, tuple i moving to NewIds[i]
+static void PermuteAttributes(
+    vtkDataSetAttributes* Data,
+    vtkIdType NumberOfTuples,
+    const vtkIdType* NewIds)
+{
+    if (Data->GetNumberOfArrays() == 0)
+        return;
+
+    vtkDataSetAttributes* Permuted = Data->NewInstance();
+    Permuted->CopyAllOn();
+    Permuted->CopyAllocate(Data, NumberOfTuples);
+    for (vtkIdType Id = 0; Id < NumberOfTuples; Id++)
+        Permuted->CopyData(Data, Id, NewIds[Id]);
+    Data->ShallowCopy(Permuted);
+    Permuted->Delete();
+}
+
+// renumbers the ids of a queue
+template <class QueueType>
+static void PermuteQueue(QueueType& Queue, const vtkIdType* NewIds)
+{
+    for (size_t i = Queue.size(); i > 0; i--) {
+        Queue.push(NewIds[Queue.front()]);
+        Queue.pop();
+    }
+}
+
+void vtkSurfaceBase::PermuteElements(
+    const vtkIdType* NewVertexIds,
+    const vtkIdType* NewFaceIds,
+    const vtkIdType* NewEdgeIds,
+    int NumberOfThreads)
+{
+    vtkIdType NumberOfPoints = this->GetNumberOfPoints();
+    vtkIdType NumberOfFaces = this->GetNumberOfCells();
+    vtkIdType NumberOfEdges = this->NumberOfEdges;
+    vtkIdType i;
+
+    // points
+    vtkPoints* Points = vtkPoints::New();
+    Points->SetDataType(this->Points->GetDataType());
+    Points->SetNumberOfPoints(NumberOfPoints);
+    auto MovePoints = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        double P[3];
+        for (vtkIdType Vertex = Begin; Vertex < End; Vertex++) {
+            this->Points->GetPoint(Vertex, P);
+            Points->SetPoint(NewVertexIds[Vertex], P);
+        }
+    };
+    vtkParallelFor::Execute(NumberOfPoints, MovePoints, NumberOfThreads);
+    this->SetPoints(Points);
+    Points->Delete();
+
+    // cells, in the legacy layout, with their new vertices
+    std::vector<vtkIdType> OldFaceIds(NumberOfFaces);
+    for (i = 0; i < NumberOfFaces; i++)
+        OldFaceIds[NewFaceIds[i]] = i;
+
+    std::vector<vtkIdType> Offsets(NumberOfFaces + 1);
+    Offsets[0] = 0;
+    for (i = 0; i < NumberOfFaces; i++) {
+        vtkIdType NumberOfVertices, *Vertices;
+        this->GetFaceVertices(OldFaceIds[i], NumberOfVertices, Vertices);
+        Offsets[i + 1] = Offsets[i] + NumberOfVertices + 1;
+    }
+
+    vtkIdTypeArray* Connectivity = vtkIdTypeArray::New();
+    Connectivity->SetNumberOfValues(Offsets[NumberOfFaces]);
+    vtkUnsignedCharArray* Types = vtkUnsignedCharArray::New();
+    Types->SetNumberOfValues(NumberOfFaces);
+    vtkIdTypeArray* Locations = vtkIdTypeArray::New();
+    Locations->SetNumberOfValues(NumberOfFaces);
+
+    auto MoveFaces = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        vtkIdType NumberOfVertices, *Vertices;
+        vtkIdType* Cells = Connectivity->GetPointer(0);
+        unsigned char* CellsTypes = Types->GetPointer(0);
+        vtkIdType* CellsLocations = Locations->GetPointer(0);
+        for (vtkIdType Face = Begin; Face < End; Face++) {
+            vtkIdType OldFace = OldFaceIds[Face];
+            this->GetFaceVertices(OldFace, NumberOfVertices, Vertices);
+            vtkIdType* Cell = Cells + Offsets[Face];
+            Cell[0] = NumberOfVertices;
+            for (vtkIdType j = 0; j < NumberOfVertices; j++)
+                Cell[j + 1] = NewVertexIds[Vertices[j]];
+            CellsTypes[Face] = this->Cells->GetCellType(OldFace);
+            CellsLocations[Face] = Offsets[Face];
+        }
+    };
+    vtkParallelFor::Execute(NumberOfFaces, MoveFaces, NumberOfThreads);
+
+    vtkCellArray* Polys = vtkCellArray::New();
+    Polys->SetCells(NumberOfFaces, Connectivity);
+    this->SetPolys(Polys);
+    Polys->Delete();
+    this->Cells->SetCellTypes(NumberOfFaces, Types, Locations);
+    Connectivity->Delete();
+    Types->Delete();
+    Locations->Delete();
+
+    PermuteAttributes(this->GetPointData(), NumberOfPoints, NewVertexIds);
+    PermuteAttributes(this->GetCellData(), NumberOfFaces, NewFaceIds);
+
+    // edges
+    std::vector<vtkIdType> EdgesData(4 * NumberOfEdges);
+    std::vector<vtkIdList*> NonManifoldFaces(NumberOfEdges);
+    vtkIdType* EdgesVertex1 = this->Vertex1->GetPointer(0);
+    vtkIdType* EdgesVertex2 = this->Vertex2->GetPointer(0);
+    vtkIdType* EdgesPoly1 = this->Poly1->GetPointer(0);
+    vtkIdType* EdgesPoly2 = this->Poly2->GetPointer(0);
+    for (i = 0; i < NumberOfEdges; i++) {
+        EdgesData[4 * i] = EdgesVertex1[i];
+        EdgesData[4 * i + 1] = EdgesVertex2[i];
+        EdgesData[4 * i + 2] = EdgesPoly1[i];
+        EdgesData[4 * i + 3] = EdgesPoly2[i];
+        NonManifoldFaces[i] = this->EdgesNonManifoldFaces[i];
+    }
+
+    auto MoveEdges = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        for (vtkIdType Edge = Begin; Edge < End; Edge++) {
+            vtkIdType NewEdge = NewEdgeIds[Edge];
+            vtkIdType* Data = &EdgesData[4 * Edge];
+            EdgesVertex1[NewEdge] = Data[0] < 0 ? -1 : NewVertexIds[Data[0]];
+            EdgesVertex2[NewEdge] = Data[1] < 0 ? -1 : NewVertexIds[Data[1]];
+            EdgesPoly1[NewEdge] = Data[2] < 0 ? -1 : NewFaceIds[Data[2]];
+            EdgesPoly2[NewEdge] = Data[3] < 0 ? -1 : NewFaceIds[Data[3]];
+
+            vtkIdList* List = NonManifoldFaces[Edge];
+            this->EdgesNonManifoldFaces[NewEdge] = List;
+            if (List) {
+                for (vtkIdType j = 0; j < List->GetNumberOfIds(); j++)
+                    List->SetId(j, NewFaceIds[List->GetId(j)]);
+            }
+        }
+    };
+    vtkParallelFor::Execute(NumberOfEdges, MoveEdges, NumberOfThreads);
+
+    // vertices rings, which only move, with their new edges
+    std::vector<vtkIdType*> Rings(
+        this->VerticesAttributes, this->VerticesAttributes + NumberOfPoints);
+    auto MoveRings = [&](vtkIdType Begin, vtkIdType End, int Chunk) {
+        for (vtkIdType Vertex = Begin; Vertex < End; Vertex++) {
+            vtkIdType* Ring = Rings[Vertex];
+            this->VerticesAttributes[NewVertexIds[Vertex]] = Ring;
+            vtkIdType* Edges = Ring + VERTEX_EDGES;
+            for (vtkIdType j = 0; j < Ring[VERTEX_NUMBER_OF_EDGES]; j++)
+                Edges[j] = NewEdgeIds[Edges[j]];
+        }
+    };
+    vtkParallelFor::Execute(NumberOfPoints, MoveRings, NumberOfThreads);
+
+    // flags and garbage collectors
+    std::vector<char> Flags(NumberOfPoints);
+    for (i = 0; i < NumberOfPoints; i++)
+        Flags[NewVertexIds[i]] = (char)this->ActiveVertices->GetValue(i);
+    for (i = 0; i < NumberOfPoints; i++)
+        this->ActiveVertices->SetValue(i, Flags[i]);
+
+    Flags.resize(2 * NumberOfFaces);
+    for (i = 0; i < NumberOfFaces; i++) {
+        Flags[2 * NewFaceIds[i]] = (char)this->ActivePolygons->GetValue(i);
+        Flags[2 * NewFaceIds[i] + 1] = (char)this->VisitedPolygons->GetValue(i);
+    }
+    for (i = 0; i < NumberOfFaces; i++) {
+        this->ActivePolygons->SetValue(i, Flags[2 * i]);
+        this->VisitedPolygons->SetValue(i, Flags[2 * i + 1]);
+    }
+
+    Flags.resize(NumberOfEdges);
+    for (i = 0; i < NumberOfEdges; i++)
+        Flags[NewEdgeIds[i]] = (char)this->ActiveEdges->GetValue(i);
+    for (i = 0; i < NumberOfEdges; i++)
+        this->ActiveEdges->SetValue(i, Flags[i]);
+
+    PermuteQueue(this->VerticesGarbage, NewVertexIds);
+    for (i = 0; i < MAXCELLSIZE; i++)
+        PermuteQueue(this->CellsGarbage[i], NewFaceIds);
+    PermuteQueue(this->EdgesGarbage, NewEdgeIds);
+
+    // all ids changed : the logged modifications are meaningless now
+    this->ModificationsLogStart += this->ModificationsLog.size();
+    this->ModificationsLog.clear();
+    this->Modified();
+}
+
 vtkSurfaceBase::vtkSurfaceBase()
 {
     this->FirstTime = true;
@@ -1494,6 +2245,9 @@ vtkSurfaceBase::vtkSurfaceBase()
     this->CleanEdges = 1;
     this->CleanVertices = 0;
 
+    this->ModificationsLogStart = 0;
+    this->ModificationsLogEnabled = false;
+
     this->Init(50, 100, 150);
 }
 